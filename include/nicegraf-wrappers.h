@@ -101,6 +101,7 @@ NGF_POD_TYPE_ALIAS(clear)
 NGF_POD_TYPE_ALIAS(attachment_load_op)
 NGF_POD_TYPE_ALIAS(attachment_store_op)
 NGF_POD_TYPE_ALIAS(render_pass_info)
+NGF_POD_TYPE_ALIAS(render_pass_resource)
 NGF_POD_TYPE_ALIAS(xfer_pass_info)
 NGF_POD_TYPE_ALIAS(compute_pass_info)
 NGF_POD_TYPE_ALIAS(buffer_storage_type)
@@ -264,6 +265,20 @@ static inline void cmd_bind_compute_resources(
   ngf_cmd_bind_compute_resources(enc, bind_operations, nbind_operations);
 }
 
+static inline error cmd_use_resources(
+    unowned_render_encoder      enc,
+    const render_pass_resource* resources,
+    uint32_t                    nresources) noexcept {
+  return ngf_cmd_use_resources(enc, resources, nresources);
+}
+
+static inline error cmd_use_compute_resources(
+    unowned_compute_encoder     enc,
+    const render_pass_resource* resources,
+    uint32_t                    nresources) noexcept {
+  return ngf_cmd_use_compute_resources(enc, resources, nresources);
+}
+
 static inline void cmd_bind_attrib_buffer(
     unowned_render_encoder enc,
     unowned_buffer         vbuf,
@@ -289,6 +304,44 @@ static inline void cmd_draw(
   ngf_cmd_draw(enc, indexed, first_element, nelements, ninstances);
 }
 
+static inline void
+cmd_draw_ext(unowned_render_encoder enc, bool indexed, const ngf_draw_info& draw) noexcept {
+  ngf_cmd_draw_ext(enc, indexed, &draw);
+}
+
+static inline void cmd_multi_draw(
+    unowned_render_encoder enc,
+    bool                   indexed,
+    const ngf_draw_info*   draws,
+    uint32_t               ndraws) noexcept {
+  ngf_cmd_multi_draw(enc, indexed, draws, ndraws);
+}
+
+static inline void cmd_draw_indirect(
+    unowned_render_encoder enc,
+    unowned_buffer         args_buf,
+    size_t                 offset,
+    uint32_t               ndraws,
+    uint32_t               stride = 0u) noexcept {
+  ngf_cmd_draw_indirect(enc, args_buf, offset, ndraws, stride);
+}
+
+static inline void cmd_draw_indexed_indirect(
+    unowned_render_encoder enc,
+    unowned_buffer         args_buf,
+    size_t                 offset,
+    uint32_t               ndraws,
+    uint32_t               stride = 0u) noexcept {
+  ngf_cmd_draw_indexed_indirect(enc, args_buf, offset, ndraws, stride);
+}
+
+static inline error cmd_execute_secondary_cmd_buffers(
+    unowned_render_encoder    enc,
+    uint32_t                  nbuffers,
+    const unowned_cmd_buffer* bufs) noexcept {
+  return ngf_cmd_execute_secondary_cmd_buffers(enc, nbuffers, bufs);
+}
+
 static inline void cmd_dispatch(
     unowned_compute_encoder enc,
     uint32_t                x_threadgroups,
@@ -297,6 +350,13 @@ static inline void cmd_dispatch(
   ngf_cmd_dispatch(enc, x_threadgroups, y_threadgroups, z_threadgroups);
 }
 
+static inline void cmd_dispatch_indirect(
+    unowned_compute_encoder enc,
+    unowned_buffer          args_buf,
+    size_t                  offset) noexcept {
+  ngf_cmd_dispatch_indirect(enc, args_buf, offset);
+}
+
 static inline void cmd_copy_buffer(
     unowned_xfer_encoder enc,
     unowned_buffer       src,
@@ -665,6 +725,17 @@ class render_encoder {
         &enc_);
   }
 
+  /**
+   * Creates a new render encoder for the given secondary command buffer. Has the same semantics as
+   * \ref ngf_cmd_begin_secondary_render_pass.
+   *
+   * @param cmd_buf The secondary command buffer to create a new render encoder for.
+   * @param primary_enc The encoder of the render pass in the primary command buffer.
+   */
+  explicit render_encoder(unowned_cmd_buffer cmd_buf, unowned_render_encoder primary_enc) {
+    ngf_cmd_begin_secondary_render_pass(cmd_buf, primary_enc, &enc_);
+  }
+
   /**
    * Finishes the wrapped render pass.
    */
@@ -1083,4 +1154,36 @@ template<typename T> class uniform_multibuffer {
   uint32_t nframes_                = 0;
 };
 
+/**
+ * \ingroup ngf_wrappers
+ *
+ * A convenience class for structured uniform data that changes between draws within a frame, such
+ * as per-object constants. Each write goes into a new region of transient memory owned by the
+ * current frame (see \ref ngf_uniform_alloc), so the bind op obtained after a write remains valid
+ * for the rest of the frame.
+ */
+template<typename T> class transient_uniform {
+  public:
+  ngf_error write(const T& data) {
+    NGF_RETURN_IF_ERROR(ngf_uniform_alloc(sizeof(T), &region_));
+    memcpy(region_.data, (const void*)&data, sizeof(T));
+    ngf_upload_end(&region_);
+    return NGF_ERROR_OK;
+  }
+
+  resource_bind_op bind_op(uint32_t set, uint32_t binding) const {
+    resource_bind_op op {};
+    op.type               = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+    op.target_binding     = binding;
+    op.target_set         = set;
+    op.info.buffer.buffer = region_.buffer;
+    op.info.buffer.offset = region_.offset;
+    op.info.buffer.range  = region_.size;
+    return op;
+  }
+
+  private:
+  ngf_upload_region region_ {};
+};
+
 }  // namespace ngf
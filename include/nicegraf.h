@@ -329,6 +329,10 @@ typedef enum ngf_error {
   /** \ingroup ngf
    * The routine did not complete successfully. */
   NGF_ERROR_OPERATION_FAILED,
+
+  /** \ingroup ngf
+   * The operation did not complete within the given time limit. */
+  NGF_ERROR_TIMEOUT,
   /*..add new errors above this line */
 } ngf_error;
 
@@ -1375,6 +1379,25 @@ typedef struct ngf_graphics_pipeline_info {
                             NGF_BLEND_FACTOR_ONE_MINUS_CONSTANT_ALPHA . */
 
   const char* debug_name;
+
+  /**
+   * A bitmask of descriptor set indices. On devices that support push descriptors, the lowest set
+   * flagged in this mask gets its descriptors pushed directly into the command buffer when bound,
+   * instead of being allocated and written from a descriptor pool. This is best suited for small,
+   * frequently updated sets. Sets that can't be pushed (for example, because they have too many
+   * descriptors) are bound normally. Zero means no sets are pushed.
+   */
+  uint32_t push_descriptor_sets;
+
+  /**
+   * A bitmask of descriptor set indices whose descriptors may be left unwritten. By default, every
+   * descriptor that isn't bound with \ref ngf_cmd_bind_resources is pointed at a dummy resource, so
+   * that none are left undefined. On devices that support partially bound descriptor bindings, the
+   * descriptors in the sets flagged in this mask are only written when they are bound, which saves
+   * CPU time for sets with many descriptors. The shaders must then not access any descriptor in
+   * those sets that hasn't been bound. Zero means no sets are partially bound.
+   */
+  uint32_t partially_bound_sets;
 } ngf_graphics_pipeline_info;
 
 /**
@@ -1399,6 +1422,18 @@ typedef struct ngf_compute_pipeline_info {
   const ngf_specialization_info*
       spec_info; /**< Specifies the value of  specialization consts used by this pipeline. */
   const char* debug_name;
+
+  /**
+   * A bitmask of descriptor set indices to update with push descriptors, if the device supports
+   * them. See \ref ngf_graphics_pipeline_info::push_descriptor_sets.
+   */
+  uint32_t push_descriptor_sets;
+
+  /**
+   * A bitmask of descriptor set indices whose descriptors may be left unwritten. See
+   * \ref ngf_graphics_pipeline_info::partially_bound_sets.
+   */
+  uint32_t partially_bound_sets;
 } ngf_compute_pipeline_info;
 
 /**
@@ -1412,6 +1447,34 @@ typedef struct ngf_compute_pipeline_info {
  */
 typedef struct ngf_compute_pipeline_t* ngf_compute_pipeline;
 
+/**
+ * The job function type. See \ref ngf_job_dispatcher for details.
+ */
+typedef void (*ngf_job_callback)(void* job_data, uint32_t job_idx);
+
+/**
+ * @struct ngf_job_dispatcher
+ * \ingroup ngf
+ *
+ * Allows nicegraf to spread work across the application's own worker threads.
+ *
+ * See also: \ref ngf_create_graphics_pipelines and \ref ngf_create_compute_pipelines.
+ */
+typedef struct ngf_job_dispatcher {
+  /**
+   * This callback shall invoke `job(job_data, i)` exactly once for each `i` in the range
+   * [0, `njobs`), and return only after all of the invocations have completed. The invocations
+   * may happen in any order, on any thread (including the calling thread) and concurrently with
+   * each other. `userdata` is the pointer from the \ref ngf_job_dispatcher::userdata field.
+   */
+  void (*dispatch)(ngf_job_callback job, void* job_data, uint32_t njobs, void* userdata);
+
+  /**
+   * Arbitrary pointer that will be passed as-is to the dispatch callback.
+   */
+  void* userdata;
+} ngf_job_dispatcher;
+
 /**
  * @enum ngf_descriptor_type
  * \ingroup ngf
@@ -1949,6 +2012,20 @@ typedef struct ngf_render_pass_info {
    * The rest of the buffer's elements are ignored.
    */
   const ngf_clear* clears;
+
+  /**
+   * This field may be NULL, in which case the render pass is recorded in the default mode. Some
+   * back-ends (i.e. Vulkan) then have to buffer up the pass's commands until the pass ends, in
+   * order to determine which barriers need to be issued before it begins.
+   *
+   * Otherwise, it shall point to a list of all the resources that are accessed by the commands
+   * within the pass (excluding the render target's attachments), and the pass is recorded in
+   * "immediate" mode: the required barriers are issued at the start of the pass, and subsequent
+   * commands are recorded directly, without being buffered up. Accessing a resource that is not on
+   * the list within an immediate mode pass results in undefined behavior. Back-ends that always
+   * record commands directly ignore this field.
+   */
+  const struct ngf_render_pass_resources* declared_resources;
 } ngf_render_pass_info;
 
 /**
@@ -2067,7 +2144,12 @@ typedef enum ngf_buffer_usage {
 
   NGF_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT = 0x80,
   NGF_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT = 0x100,
-  NGF_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT = 0x200
+  NGF_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT = 0x200,
+
+  /**
+   * \ingroup ngf
+   * The buffer may be used as the source of arguments for indirect draws and dispatches. */
+  NGF_BUFFER_USAGE_INDIRECT_BUFFER = 0x400
 
 } ngf_buffer_usage;
 
@@ -2090,6 +2172,76 @@ typedef struct ngf_buffer_info {
  */
 typedef struct ngf_buffer_t* ngf_buffer;
 
+/**
+ * @enum ngf_render_resource_usage
+ * \ingroup ngf
+ *
+ * Describes how a resource declared up front for a render pass (see \ref
+ * ngf_render_pass_info::declared_resources) is accessed by the commands within the pass.
+ */
+typedef enum ngf_render_resource_usage {
+  /** The buffer is bound as a vertex attribute buffer. */
+  NGF_RENDER_RESOURCE_USAGE_ATTRIB_BUFFER = 0,
+
+  /** The buffer is bound as an index buffer. */
+  NGF_RENDER_RESOURCE_USAGE_INDEX_BUFFER,
+
+  /** The buffer is read by shaders as a uniform buffer. */
+  NGF_RENDER_RESOURCE_USAGE_UNIFORM_BUFFER,
+
+  /** The buffer is read, or both read and written, by shaders as a storage buffer. */
+  NGF_RENDER_RESOURCE_USAGE_STORAGE_BUFFER,
+
+  /** The buffer is read by shaders through a texel buffer view. */
+  NGF_RENDER_RESOURCE_USAGE_TEXEL_BUFFER,
+
+  /** The image is sampled, or read, by shaders. */
+  NGF_RENDER_RESOURCE_USAGE_IMAGE,
+
+  /** The buffer is the source of arguments for indirect draws. */
+  NGF_RENDER_RESOURCE_USAGE_INDIRECT_BUFFER,
+
+  NGF_RENDER_RESOURCE_USAGE_COUNT
+} ngf_render_resource_usage;
+
+/**
+ * @struct ngf_render_pass_resource
+ * \ingroup ngf
+ *
+ * A resource accessed by the commands within a render pass, along with the manner in which it is
+ * accessed.
+ */
+typedef struct ngf_render_pass_resource {
+  ngf_render_resource_usage usage; /**< How the resource is accessed within the pass. */
+
+  /**
+   * The buffer being accessed. Used for all usages except \ref NGF_RENDER_RESOURCE_USAGE_IMAGE.
+   * For texel buffers, this is the buffer that the texel buffer view was created from.
+   */
+  ngf_buffer buffer;
+
+  /**
+   * The image being accessed. Used only for \ref NGF_RENDER_RESOURCE_USAGE_IMAGE. For image views,
+   * this is the image that the view was created from.
+   */
+  ngf_image image;
+} ngf_render_pass_resource;
+
+/**
+ * @struct ngf_render_pass_resources
+ * \ingroup ngf
+ * A list of resources accessed within a render pass.
+ */
+typedef struct ngf_render_pass_resources {
+  /**
+   * Pointer to a contiguous array of \ref ngf_render_pass_resources::nresources \ref
+   * ngf_render_pass_resource objects.
+   */
+  const ngf_render_pass_resource* resources;
+
+  uint32_t nresources; /**< The number of resources in the list. */
+} ngf_render_pass_resources;
+
 /**
  * @struct ngf_buffer_slice
  * \ingroup ngf
@@ -2278,6 +2430,35 @@ typedef struct ngf_swapchain_info {
  */
 typedef struct ngf_context_t* ngf_context;
 
+/**
+ * @struct ngf_descriptor_pool_info
+ * \ingroup ngf
+ * Controls how a context sizes the pools that descriptor sets are allocated from.
+ *
+ * This is only relevant to backends that allocate descriptor sets from pools (i.e. Vulkan), and is
+ * ignored elsewhere.
+ */
+typedef struct ngf_descriptor_pool_info {
+  /**
+   * Maximum number of descriptor sets that may be allocated from a single pool.
+   */
+  uint32_t sets_per_pool;
+
+  /**
+   * Number of descriptors of each type that a single pool can provide, indexed by
+   * \ref ngf_descriptor_type. Types set to zero get no capacity beyond what is required by the
+   * descriptor set that caused the pool to be created.
+   */
+  uint32_t descriptors_per_pool[NGF_DESCRIPTOR_TYPE_COUNT];
+
+  /**
+   * When true, the capacities above are only used until the context has observed a frame's worth
+   * of descriptor usage. After that, new pools are sized based on the highest per-type usage seen
+   * in recent frames, and pools that turned out too small for a frame are consolidated into one.
+   */
+  bool adaptive;
+} ngf_descriptor_pool_info;
+
 /**
  * @struct ngf_context_info
  * \ingroup ngf
@@ -2296,15 +2477,101 @@ typedef struct ngf_context_info {
    * (such as buffers and images) created within the given context, and vice versa Can be NULL.
    */
   const ngf_context shared_context;
+
+  /**
+   * Configures the sizing of descriptor pools. Can be NULL, in which case pools initially have
+   * room for 100 sets and 100 descriptors of each type, and adapt to the observed usage
+   * afterwards.
+   */
+  const ngf_descriptor_pool_info* descriptor_pool_info;
+
+  /**
+   * Size, in bytes, of the staging buffer that \ref ngf_upload_alloc suballocates from in each
+   * frame. Zero selects the default size of 8 MiB.
+   */
+  size_t upload_buffer_size;
+
+  /**
+   * Maximum number of timestamps that can be written with \ref ngf_cmd_write_timestamp in each
+   * frame. Zero selects the default of 256.
+   */
+  uint32_t max_timestamp_queries;
+
+  /**
+   * Maximum number of queries of each \ref ngf_query_type that can be made in each frame with
+   * \ref ngf_cmd_begin_query and \ref ngf_cmd_begin_compute_query. Zero selects the default of
+   * 256.
+   */
+  uint32_t max_queries;
 } ngf_context_info;
 
+/**
+ * @enum ngf_cmd_buffer_level
+ * \ingroup ngf
+ * Enumerates the levels of command buffers.
+ */
+typedef enum ngf_cmd_buffer_level {
+  /**
+   * Primary command buffers are submitted for execution directly, via \ref ngf_submit_cmd_buffers.
+   */
+  NGF_CMD_BUFFER_LEVEL_PRIMARY = 0,
+
+  /**
+   * Secondary command buffers each record a part of a render pass that has been begun in a primary
+   * command buffer, and are executed by that primary command buffer. Different secondary command
+   * buffers may be recorded concurrently on different threads. See
+   * \ref ngf_cmd_begin_secondary_render_pass for details.
+   */
+  NGF_CMD_BUFFER_LEVEL_SECONDARY,
+
+  NGF_CMD_BUFFER_LEVEL_COUNT
+} ngf_cmd_buffer_level;
+
+/**
+ * @enum ngf_queue_type
+ * \ingroup ngf
+ * Enumerates the types of GPU queues that command buffers may execute on.
+ */
+typedef enum ngf_queue_type {
+  /**
+   * The graphics queue supports all types of commands. This is where presentation happens.
+   */
+  NGF_QUEUE_TYPE_GRAPHICS = 0,
+
+  /**
+   * The compute queue supports compute and transfer commands, but not render passes. On devices
+   * that report \ref ngf_device_capabilities::supports_async_compute, work submitted to it can
+   * execute concurrently with the graphics queue. On other devices, it executes on the graphics
+   * queue.
+   */
+  NGF_QUEUE_TYPE_COMPUTE,
+
+  /**
+   * The transfer queue supports transfer passes only, except for mipmap generation. It is meant for
+   * streaming in resources in the background: on devices that report
+   * \ref ngf_device_capabilities::supports_async_transfer, uploads submitted to it can execute
+   * concurrently with other work, and resources are handed over to other queues once they're used
+   * there. On other devices, it executes on the graphics queue. Use
+   * \ref ngf_is_frame_transfer_complete to find out when uploads have finished.
+   */
+  NGF_QUEUE_TYPE_TRANSFER,
+
+  NGF_QUEUE_TYPE_COUNT
+} ngf_queue_type;
+
 /**
  * @struct ngf_cmd_buffer_info
  * \ingroup ngf
  * Information about a command buffer.
  */
 typedef struct ngf_cmd_buffer_info {
-  uint32_t reserved;
+  ngf_cmd_buffer_level level; /**< The level of the command buffer. */
+
+  /**
+   * The type of queue that the command buffer shall execute on. Secondary command buffers must
+   * use \ref NGF_QUEUE_TYPE_GRAPHICS.
+   */
+  ngf_queue_type queue;
 } ngf_cmd_buffer_info;
 
 /**
@@ -2381,6 +2648,39 @@ typedef uintptr_t ngf_frame_token;
  */
 #define NGF_DEVICE_LIMIT_UNKNOWN (~0u)
 
+/**
+ * @enum ngf_bindless_resource_type
+ * \ingroup ngf
+ *
+ * Kinds of resources that can be placed into the bindless resource heap.
+ *
+ * Shaders access the heap through a descriptor set whose bindings are all runtime-sized arrays.
+ * Each kind of resource lives in its own array, at the binding number equal to the corresponding
+ * enumerator's value, and is looked up by the index returned when the resource was registered.
+ * For example, in GLSL:
+ *
+ * ```
+ * layout(set = 1, binding = 0) uniform texture2D heap_images[];
+ * layout(set = 1, binding = 1) uniform sampler heap_samplers[];
+ * layout(set = 1, binding = 2) readonly buffer heap_buffers { uint data[]; } heap_buffers[];
+ * ```
+ *
+ * Shaders may declare only a subset of the bindings, and may alias the image binding with
+ * different image types.
+ */
+typedef enum ngf_bindless_resource_type {
+  /** A sampled image. */
+  NGF_BINDLESS_RESOURCE_IMAGE = 0,
+
+  /** A sampler. */
+  NGF_BINDLESS_RESOURCE_SAMPLER,
+
+  /** A region of a storage buffer. */
+  NGF_BINDLESS_RESOURCE_STORAGE_BUFFER,
+
+  NGF_BINDLESS_RESOURCE_TYPE_COUNT
+} ngf_bindless_resource_type;
+
 /**
  * @struct ngf_device_capabilities
  * \ingroup ngf
@@ -2563,8 +2863,112 @@ typedef struct ngf_device_capabilities {
    */
   bool supports_inline_raytracing;
 
+  /**
+   * Indicates whether the device has a dedicated compute queue, so that command buffers created
+   * for \ref NGF_QUEUE_TYPE_COMPUTE can execute concurrently with graphics work.
+   */
+  bool supports_async_compute;
+
+  /**
+   * Indicates whether the device has a dedicated transfer queue, so that command buffers created
+   * for \ref NGF_QUEUE_TYPE_TRANSFER can execute concurrently with other work.
+   */
+  bool supports_async_transfer;
+
+  /**
+   * Indicates whether GPU timestamps can be written with \ref ngf_cmd_write_timestamp into
+   * command buffers for \ref NGF_QUEUE_TYPE_GRAPHICS.
+   */
+  bool supports_timestamp_queries;
+
+  /**
+   * Indicates whether queries of type \ref NGF_QUERY_TYPE_PIPELINE_STATISTICS are supported in
+   * command buffers for \ref NGF_QUEUE_TYPE_GRAPHICS.
+   */
+  bool supports_pipeline_statistics_queries;
+
+  /**
+   * The maximum number of draws that may be issued by a single call to
+   * \ref ngf_cmd_draw_indirect or \ref ngf_cmd_draw_indexed_indirect. This is 1 on devices that
+   * don't support issuing several indirect draws at once.
+   */
+  uint32_t max_draw_indirect_count;
+
+  /**
+   * Indicates whether resources can be placed into the bindless resource heap (see
+   * \ref ngf_register_bindless_image).
+   */
+  bool supports_bindless_resources;
+
+  /**
+   * The number of slots available in the bindless resource heap for each
+   * \ref ngf_bindless_resource_type. All zeros if bindless resources aren't supported.
+   */
+  uint32_t max_bindless_resources[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+
 } ngf_device_capabilities;
 
+/**
+ * @struct ngf_descriptor_set_cache_stats
+ * \ingroup ngf
+ *
+ * Counters describing how often resource bindings were serviced by reusing a descriptor set
+ * written earlier in the same frame. See \ref ngf_get_descriptor_set_cache_stats.
+ */
+typedef struct ngf_descriptor_set_cache_stats {
+  /**
+   * Number of times a previously written descriptor set with identical contents was reused.
+   */
+  uint64_t hits;
+
+  /**
+   * Number of times a new descriptor set had to be allocated and written.
+   */
+  uint64_t misses;
+} ngf_descriptor_set_cache_stats;
+
+/**
+ * @struct ngf_descriptor_pool_stats
+ * \ingroup ngf
+ *
+ * Describes descriptor pool usage over the course of a single frame. See
+ * \ref ngf_get_descriptor_pool_stats.
+ */
+typedef struct ngf_descriptor_pool_stats {
+  /**
+   * Number of descriptor pools that had to be created during the frame.
+   */
+  uint32_t npools_created;
+
+  /**
+   * Total number of descriptor pools that were in use by the frame, including ones created during
+   * earlier frames.
+   */
+  uint32_t npools;
+
+  /**
+   * Number of descriptor sets allocated during the frame.
+   */
+  uint32_t nsets_allocated;
+
+  /**
+   * Combined descriptor set capacity of all pools used by the frame.
+   */
+  uint32_t set_capacity;
+
+  /**
+   * Number of descriptors of each type allocated during the frame, indexed by
+   * \ref ngf_descriptor_type.
+   */
+  uint32_t ndescriptors_allocated[NGF_DESCRIPTOR_TYPE_COUNT];
+
+  /**
+   * Combined per-type descriptor capacity of all pools used by the frame, indexed by
+   * \ref ngf_descriptor_type.
+   */
+  uint32_t descriptor_capacity[NGF_DESCRIPTOR_TYPE_COUNT];
+} ngf_descriptor_pool_stats;
+
 /**
  * Maximum length of a device's name.
  * \ingroup ngf
@@ -2729,6 +3133,59 @@ ngf_error ngf_begin_frame(ngf_frame_token* token) NGF_NOEXCEPT;
  */
 ngf_error ngf_end_frame(ngf_frame_token token) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Checks, without blocking, whether the GPU has finished executing all the work submitted during
+ * the given frame.
+ *
+ * Once a frame is complete, any resources that it has accessed may be reused or overwritten by the
+ * host. This makes it possible to recycle resources such as streaming buffers as soon as the GPU
+ * is done with them, instead of assuming the maximum number of frames in flight worth of latency.
+ *
+ * Not supported on Metal, where this always returns false.
+ *
+ * @param token A frame token generated by \ref ngf_begin_frame on the calling thread's context.
+ * @return true if the frame has been ended and has finished executing, false otherwise.
+ */
+bool ngf_is_frame_complete(ngf_frame_token token) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Blocks until the GPU has finished executing all the work submitted during the given frame, or
+ * until the given amount of time has passed.
+ *
+ * Not supported on Metal, where this returns \ref NGF_ERROR_INVALID_OPERATION.
+ *
+ * @param token A frame token generated by \ref ngf_begin_frame on the calling thread's context.
+ *              The frame must have been ended with \ref ngf_end_frame.
+ * @param timeout_ns The maximum amount of time to wait, in nanoseconds. Zero makes the call return
+ *                   immediately, and UINT64_MAX makes it wait for as long as necessary.
+ * @return \ref NGF_ERROR_OK if the frame has finished executing, \ref NGF_ERROR_TIMEOUT if it
+ *         didn't finish in time, and \ref NGF_ERROR_INVALID_OPERATION if the token is not valid
+ *         for the calling thread's context or the frame hasn't been ended yet.
+ */
+ngf_error ngf_wait_frame(ngf_frame_token token, uint64_t timeout_ns) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Checks, without blocking, whether the GPU has finished executing all the command buffers for
+ * \ref NGF_QUEUE_TYPE_TRANSFER that were submitted during the given frame.
+ *
+ * Resources uploaded by those command buffers can be used by other queues without waiting once
+ * this returns true. Using them earlier is valid too, but makes the other queue wait for the
+ * uploads to finish.
+ *
+ * Not supported on Metal, where this always returns false.
+ *
+ * @param token A frame token generated by \ref ngf_begin_frame on the calling thread's context.
+ * @return true if the frame has been ended and its transfer work has finished executing, false
+ *         otherwise.
+ */
+bool ngf_is_frame_transfer_complete(ngf_frame_token token) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -2750,6 +3207,34 @@ ngf_error ngf_get_current_swapchain_image(ngf_frame_token token, ngf_image* resu
  */
 const ngf_device_capabilities* ngf_get_device_capabilities(void) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Retrieves the descriptor set cache counters for the context that is current on the calling
+ * thread. The counters are cumulative over the lifetime of the context.
+ *
+ * Backends that do not use descriptor sets report zero for all counters.
+ *
+ * @param stats Pointer to where the counters shall be written.
+ * @return \ref NGF_ERROR_INVALID_OPERATION if no context is present on the calling thread.
+ */
+ngf_error ngf_get_descriptor_set_cache_stats(ngf_descriptor_set_cache_stats* stats) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Reports descriptor pool usage for the context that is current on the calling thread.
+ *
+ * Usage is only known once a frame's descriptor pools have been recycled, which happens when
+ * \ref ngf_begin_frame reuses that frame's resources. The reported numbers therefore describe the
+ * most recent frame to have been recycled, which lags behind the current frame by the maximum
+ * number of frames in flight. Backends that don't use descriptor pools report zeros.
+ *
+ * @param stats Pointer to where the statistics shall be written.
+ * @return \ref NGF_ERROR_INVALID_OPERATION if no context is present on the calling thread.
+ */
+ngf_error ngf_get_descriptor_pool_stats(ngf_descriptor_pool_stats* stats) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -2775,6 +3260,11 @@ void ngf_destroy_shader_stage(ngf_shader_stage stage) NGF_NOEXCEPT;
  *
  * Creates a new graphics pipeline object.
  *
+ * On the Vulkan backend, pipeline objects may be created (and destroyed) from any thread,
+ * including threads that do not have a current context, as long as the host memory allocation
+ * callbacks supplied to \ref ngf_initialize are thread-safe. Other backends require a current
+ * context on the calling thread.
+ *
  * @param info Information required to construct the graphics pipeline object.
  * @param result Pointer to where the handle to the newly created object will be returned.
  */
@@ -2782,6 +3272,31 @@ ngf_error ngf_create_graphics_pipeline(
     const ngf_graphics_pipeline_info* info,
     ngf_graphics_pipeline*            result) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Creates several graphics pipeline objects at once, optionally spreading the work across the
+ * application's worker threads.
+ *
+ * The `i`-th pipeline is created from `infos[i]` and its handle is written to `results[i]`. If
+ * `dispatcher` is not NULL, the pipelines are created by jobs submitted through it, otherwise
+ * they are created one after another on the calling thread. This function returns only after all
+ * of the pipelines have been created.
+ *
+ * If creating any of the pipelines fails, the ones that were created successfully are destroyed,
+ * all entries of `results` are set to NULL and the first encountered error is returned.
+ *
+ * @param npipelines Number of pipelines to create.
+ * @param infos Pointer to an array of `npipelines` pipeline descriptions.
+ * @param results Pointer to an array of `npipelines` handles that will receive the new objects.
+ * @param dispatcher Job dispatcher used to parallelize the work, or NULL.
+ */
+ngf_error ngf_create_graphics_pipelines(
+    uint32_t                          npipelines,
+    const ngf_graphics_pipeline_info* infos,
+    ngf_graphics_pipeline*            results,
+    const ngf_job_dispatcher*         dispatcher) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -2803,6 +3318,26 @@ ngf_error ngf_create_compute_pipeline(
     const ngf_compute_pipeline_info* info,
     ngf_compute_pipeline*            result) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Creates several compute pipeline objects at once, optionally spreading the work across the
+ * application's worker threads.
+ *
+ * This function behaves exactly like \ref ngf_create_graphics_pipelines, but for compute
+ * pipelines.
+ *
+ * @param npipelines Number of pipelines to create.
+ * @param infos Pointer to an array of `npipelines` pipeline descriptions.
+ * @param results Pointer to an array of `npipelines` handles that will receive the new objects.
+ * @param dispatcher Job dispatcher used to parallelize the work, or NULL.
+ */
+ngf_error ngf_create_compute_pipelines(
+    uint32_t                         npipelines,
+    const ngf_compute_pipeline_info* infos,
+    ngf_compute_pipeline*            results,
+    const ngf_job_dispatcher*        dispatcher) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -2812,6 +3347,47 @@ ngf_error ngf_create_compute_pipeline(
  */
 void ngf_destroy_compute_pipeline(ngf_compute_pipeline pipeline) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Serializes the contents of the device-wide pipeline cache.
+ *
+ * nicegraf keeps a single pipeline cache for the rendering device, which is used by all graphics
+ * and compute pipelines created with \ref ngf_create_graphics_pipeline and
+ * \ref ngf_create_compute_pipeline. The serialized data may be stored by the application and fed
+ * back to \ref ngf_pipeline_cache_load in subsequent runs, to avoid recompiling pipelines from
+ * scratch.
+ *
+ * If `data` is NULL, the size of the buffer required to hold the serialized cache is written
+ * into `size`. Otherwise, `size` must point to the size of the buffer pointed to by `data`, and
+ * it shall be updated with the number of bytes actually written.
+ *
+ * @param data Pointer to the buffer that will receive the serialized cache, or NULL.
+ * @param size Pointer to the size of the buffer, in bytes.
+ * @return \ref NGF_ERROR_INVALID_SIZE if the buffer is too small to hold the serialized data.
+ */
+ngf_error ngf_pipeline_cache_serialize(void* data, size_t* size) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Loads data previously obtained with \ref ngf_pipeline_cache_serialize into the device-wide
+ * pipeline cache. Pipelines created after this call may be retrieved from the cache instead of
+ * being compiled.
+ *
+ * The data is checked against the vendor, device and driver of the current rendering device. If
+ * it was produced by a different device or driver version, it is ignored and
+ * \ref NGF_ERROR_INVALID_OPERATION is returned. This is not a fatal error: pipelines will simply
+ * be compiled as usual, and the application may overwrite the stale data with a freshly
+ * serialized cache.
+ *
+ * This function must not be called while pipelines are being created on other threads.
+ *
+ * @param data Pointer to the serialized cache data.
+ * @param size Size of the serialized cache data, in bytes.
+ */
+ngf_error ngf_pipeline_cache_load(const void* data, size_t size) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -2977,6 +3553,73 @@ void ngf_buffer_flush_range(ngf_buffer buf, size_t offset, size_t size) NGF_NOEX
  */
 void ngf_buffer_unmap(ngf_buffer buf) NGF_NOEXCEPT;
 
+/**
+ * @struct ngf_upload_region
+ * \ingroup ngf
+ * A region of staging memory obtained from \ref ngf_upload_alloc.
+ */
+typedef struct ngf_upload_region {
+  void*      data;   /**< Host pointer to the start of the region, for writing the data into. */
+  ngf_buffer buffer; /**< The buffer to use as the source of transfer commands. */
+  size_t     offset; /**< Offset of the region from the start of `buffer`, in bytes. */
+  size_t     size;   /**< Size of the region, in bytes. */
+} ngf_upload_region;
+
+/**
+ * \ingroup ngf
+ *
+ * Allocates a region of persistently mapped staging memory, for uploading data to buffers and
+ * images with transfer commands.
+ *
+ * Regions are suballocated from a staging buffer owned by the current frame, which is recycled
+ * once the frame has finished executing, so no buffers have to be created for individual uploads.
+ * Requests that don't fit into the remaining space of the frame's staging buffer get a dedicated
+ * buffer instead, which is destroyed along with the frame.
+ *
+ * The region may only be used by commands submitted during the current frame. Once the data has
+ * been written, call \ref ngf_upload_end before submitting the commands that read it.
+ *
+ * Not supported on Metal, where this returns \ref NGF_ERROR_INVALID_OPERATION. The same applies
+ * to \ref ngf_uniform_alloc.
+ *
+ * @param size The size of the region, in bytes.
+ * @param alignment The required alignment of the region's offset, in bytes. Must be a power of two,
+ *                  or zero. Offsets are always aligned to at least 16 bytes.
+ * @param region Receives the description of the allocated region.
+ */
+ngf_error
+ngf_upload_alloc(size_t size, size_t alignment, ngf_upload_region* region) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Makes the data written by the host into a region obtained from \ref ngf_upload_alloc visible to
+ * subsequently submitted commands.
+ *
+ * @param region The region that has been written.
+ */
+void ngf_upload_end(const ngf_upload_region* region) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Allocates a region of transient uniform data that is only valid for the current frame, such as
+ * per-draw or per-object constants.
+ *
+ * This works like \ref ngf_upload_alloc, except that the region's offset satisfies
+ * \ref ngf_device_capabilities::uniform_buffer_offset_alignment, so the region can be bound
+ * directly with \ref NGF_DESCRIPTOR_UNIFORM_BUFFER, using the region's buffer, offset and size.
+ * Regions allocated within the same frame usually share a buffer. On backends that support it,
+ * binding another region of the same size to a binding then only changes the offset at which the
+ * buffer is bound, without writing any new descriptors.
+ *
+ * Call \ref ngf_upload_end once the data has been written.
+ *
+ * @param size The size of the region, in bytes.
+ * @param region Receives the description of the allocated region.
+ */
+ngf_error ngf_uniform_alloc(size_t size, ngf_upload_region* region) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  * Creates a new texel buffer view object.
@@ -3041,6 +3684,8 @@ ngf_error ngf_set_compute_bytes(ngf_compute_encoder enc, const void* data, size_
  * nicegraf's internal hazard-tracking operations may be omitted for it, improving CPU
  * performance. Performing any modifying operations on a resource that had previously been
  * marked as "read-only" results in undefined behaviour.
+ * Read-only resources are also not transferred between queues, so on devices that support async
+ * compute, they should only be accessed by command buffers of a single \ref ngf_queue_type.
  * 
  * @param img A pointer to an array of handles to images, which are to be marked as read-only.
  * @param nimgs The number of images to be marked as read-only.
@@ -3098,12 +3743,37 @@ ngf_error ngf_start_cmd_buffer(ngf_cmd_buffer buf, ngf_frame_token token) NGF_NO
  * All command buffers must be in the "awaiting submission" state, and shall be transitioned to the
  * "submitted" state.
  *
+ * Command buffers submitted to the same queue execute in submission order. Command buffers
+ * submitted to different queues may execute concurrently, unless one of them accesses a resource
+ * that was last accessed by the other one, in which case it waits for the other one to finish.
+ * Any other dependencies between queues have to be declared with
+ * \ref ngf_cmd_buffer_add_dependency.
+ *
  * @param nbuffers The number of command buffers being submitted for execution.
  * @param bufs A pointer to a contiguous array of \ref nbuffers handles to command buffer objects to
  *             be submitted for execution.
  */
 ngf_error ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer* bufs) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Makes a command buffer wait for all the work submitted to the queue of another command buffer
+ * up to and including that command buffer, before it starts executing.
+ *
+ * Dependencies on command buffers that execute on the same queue are always satisfied, and have no
+ * effect. Dependencies arising from accesses to the same resources are tracked automatically, so
+ * this is only needed for dependencies that nicegraf can't see, such as accesses to resources
+ * marked with \ref ngf_mark_read_only.
+ *
+ * @param buf The command buffer that shall wait. Must be in the "recording" or "awaiting
+ *            submission" state.
+ * @param dependency The command buffer to wait for. Must be submitted within the same frame as
+ *                   `buf`, before it.
+ */
+ngf_error
+ngf_cmd_buffer_add_dependency(ngf_cmd_buffer buf, ngf_cmd_buffer dependency) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -3163,6 +3833,69 @@ ngf_error ngf_cmd_begin_render_pass_simple(
     uint32_t            clear_stencil,
     ngf_render_encoder* enc) NGF_NOEXCEPT;
 
+/**
+ * \ingroup ngf
+ *
+ * Begins recording a part of a render pass into a secondary command buffer.
+ *
+ * This makes it possible to split the commands of a single large render pass between several
+ * threads. The render pass is begun as usual, with \ref ngf_cmd_begin_render_pass, in a primary
+ * command buffer. Each worker thread then begins a secondary render pass for the resulting encoder
+ * in its own secondary command buffer, records commands with the returned encoder, and finishes
+ * with \ref ngf_cmd_end_render_pass. Finally, the thread that owns the primary command buffer
+ * executes the secondary command buffers in the desired order with
+ * \ref ngf_cmd_execute_secondary_cmd_buffers, before ending the pass.
+ *
+ * Each worker thread must have its own context current, created as shared with the context of the
+ * primary command buffer. The secondary command buffer must have been created with
+ * \ref NGF_CMD_BUFFER_LEVEL_SECONDARY and started for the same frame as the primary command buffer.
+ * A secondary command buffer may record only a single render pass per frame. Secondary render
+ * passes don't inherit any state, such as the bound pipeline or the viewport, from the primary.
+ *
+ * The primary encoder must not be used for recording commands while the secondary render pass is
+ * being recorded, and the render pass must not have been begun in immediate mode (see
+ * \ref ngf_render_pass_info::declared_resources).
+ *
+ * Secondary render passes are not supported on Metal, where this returns
+ * \ref NGF_ERROR_INVALID_OPERATION.
+ *
+ * @param buf The secondary command buffer to record into. Must be in the "ready" state, shall be
+ *            transitioned to the "recording" state.
+ * @param primary_enc The encoder of the render pass in the primary command buffer.
+ * @param enc Pointer to memory into which a handle to a render encoder will be returned.
+ */
+ngf_error ngf_cmd_begin_secondary_render_pass(
+    ngf_cmd_buffer      buf,
+    ngf_render_encoder  primary_enc,
+    ngf_render_encoder* enc) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Executes secondary command buffers within a render pass.
+ *
+ * The secondary command buffers shall execute in the order in which they are given. Resource
+ * hazards are resolved in the same order, as if the commands from all of the secondary command
+ * buffers had been recorded sequentially into the primary command buffer.
+ *
+ * Once secondary command buffers have been executed within a render pass, no other commands may be
+ * recorded into it with the primary encoder, other than executing more secondary command buffers.
+ * Likewise, secondary command buffers can't be executed within a pass that has had other commands
+ * recorded into it.
+ *
+ * Not supported on Metal, where this returns \ref NGF_ERROR_INVALID_OPERATION.
+ *
+ * @param enc The encoder of the render pass in the primary command buffer.
+ * @param nbuffers The number of secondary command buffers to execute.
+ * @param bufs Pointer to an array of \ref nbuffers handles to secondary command buffers. Each of
+ *             them must have finished recording a secondary render pass for `enc`, and shall be
+ *             transitioned to the "submitted" state.
+ */
+ngf_error ngf_cmd_execute_secondary_cmd_buffers(
+    ngf_render_encoder    enc,
+    uint32_t              nbuffers,
+    const ngf_cmd_buffer* bufs) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -3390,6 +4123,64 @@ void ngf_cmd_draw(
     uint32_t           nelements,
     uint32_t           ninstances) NGF_NOEXCEPT;
 
+/**
+ * @struct ngf_draw_info
+ * \ingroup ngf
+ *
+ * Parameters of a single draw executed with \ref ngf_cmd_draw_ext or \ref ngf_cmd_multi_draw.
+ */
+typedef struct ngf_draw_info {
+  /**
+   * Offset of the first vertex, or for indexed draws, of the first index within the bound index
+   * buffer.
+   */
+  uint32_t first_element;
+
+  uint32_t nelements; /**< Number of vertices or indices to process. */
+
+  /**
+   * Value added to each index before fetching the vertex, which allows several meshes to share the
+   * same vertex and index buffers. Ignored for non-indexed draws.
+   */
+  int32_t base_vertex;
+
+  uint32_t ninstances;     /**< Number of instances (use `1` for regular non-instanced draws). */
+  uint32_t first_instance; /**< Index of the first instance. */
+} ngf_draw_info;
+
+/**
+ * \ingroup ngf
+ *
+ * Executes a draw, same as \ref ngf_cmd_draw, but additionally allows specifying the base vertex
+ * and the first instance.
+ *
+ * @param enc The render encoder to record the command into.
+ * @param indexed Indicates whether the draw uses an index buffer or not.
+ * @param draw Parameters of the draw.
+ */
+void ngf_cmd_draw_ext(ngf_render_encoder enc, bool indexed, const ngf_draw_info* draw)
+    NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Executes several draws with the same pipeline and resource bindings. This is equivalent to
+ * calling \ref ngf_cmd_draw_ext for each element of the array, but has lower overhead. Where
+ * supported, consecutive draws with the same instance parameters are submitted to the GPU with a
+ * single command.
+ *
+ * @param enc The render encoder to record the command into.
+ * @param indexed Indicates whether the draws use an index buffer or not.
+ * @param draws Pointer to a contiguous array of `ndraws` draw parameter structures. The array may
+ *              be reused or freed as soon as this function returns.
+ * @param ndraws Number of draws to execute.
+ */
+void ngf_cmd_multi_draw(
+    ngf_render_encoder   enc,
+    bool                 indexed,
+    const ngf_draw_info* draws,
+    uint32_t             ndraws) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -3407,6 +4198,100 @@ void ngf_cmd_dispatch(
     uint32_t            y_threadgroups,
     uint32_t            z_threadgroups) NGF_NOEXCEPT;
 
+/**
+ * @struct ngf_draw_indirect_args
+ * \ingroup ngf
+ *
+ * Layout of the arguments read from the argument buffer by \ref ngf_cmd_draw_indirect.
+ */
+typedef struct ngf_draw_indirect_args {
+  uint32_t nvertices;      /**< Number of vertices to process. */
+  uint32_t ninstances;     /**< Number of instances. */
+  uint32_t first_vertex;   /**< Offset of the first vertex. */
+  uint32_t first_instance; /**< Index of the first instance. */
+} ngf_draw_indirect_args;
+
+/**
+ * @struct ngf_draw_indexed_indirect_args
+ * \ingroup ngf
+ *
+ * Layout of the arguments read from the argument buffer by \ref ngf_cmd_draw_indexed_indirect.
+ */
+typedef struct ngf_draw_indexed_indirect_args {
+  uint32_t nindices;       /**< Number of indices to process. */
+  uint32_t ninstances;     /**< Number of instances. */
+  uint32_t first_index;    /**< Offset of the first index within the index buffer. */
+  int32_t  vertex_offset;  /**< Value added to each index before fetching the vertex. */
+  uint32_t first_instance; /**< Index of the first instance. */
+} ngf_draw_indexed_indirect_args;
+
+/**
+ * @struct ngf_dispatch_indirect_args
+ * \ingroup ngf
+ *
+ * Layout of the arguments read from the argument buffer by \ref ngf_cmd_dispatch_indirect.
+ */
+typedef struct ngf_dispatch_indirect_args {
+  uint32_t x_threadgroups; /**< Number of threadgroups along the X dimension of the grid. */
+  uint32_t y_threadgroups; /**< Number of threadgroups along the Y dimension of the grid. */
+  uint32_t z_threadgroups; /**< Number of threadgroups along the Z dimension of the grid. */
+} ngf_dispatch_indirect_args;
+
+/**
+ * \ingroup ngf
+ *
+ * Executes one or more non-indexed draws, the arguments of which are read from a buffer at the
+ * time the command executes on the GPU. This allows the GPU to generate its own work, e.g. from a
+ * compute pass that culls geometry, without any readback to the CPU. The necessary barriers for
+ * making preceding writes to the argument buffer visible are issued automatically.
+ *
+ * The argument buffer must have been created with \ref NGF_BUFFER_USAGE_INDIRECT_BUFFER. Within
+ * render passes with declared resources, it has to be declared with
+ * \ref NGF_RENDER_RESOURCE_USAGE_INDIRECT_BUFFER.
+ *
+ * @param enc The render encoder to record the command into.
+ * @param args_buf The buffer containing the arguments, as \ref ngf_draw_indirect_args.
+ * @param offset Offset of the first draw's arguments within the buffer, in bytes. Must be a
+ *               multiple of 4.
+ * @param ndraws Number of draws to issue. Must not exceed
+ *               \ref ngf_device_capabilities::max_draw_indirect_count.
+ * @param stride Distance in bytes between the arguments of consecutive draws. Zero means the
+ *               arguments are tightly packed.
+ */
+void ngf_cmd_draw_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Same as \ref ngf_cmd_draw_indirect, except that the draws use the bound index buffer, and their
+ * arguments are read as \ref ngf_draw_indexed_indirect_args.
+ */
+void ngf_cmd_draw_indexed_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Encodes a compute shader dispatch, the grid size of which is read from a buffer, as
+ * \ref ngf_dispatch_indirect_args, at the time the command executes on the GPU. The argument
+ * buffer must have been created with \ref NGF_BUFFER_USAGE_INDIRECT_BUFFER.
+ *
+ * @param enc The encoder to record the command into.
+ * @param args_buf The buffer containing the arguments.
+ * @param offset Offset of the arguments within the buffer, in bytes. Must be a multiple of 4.
+ */
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc, ngf_buffer args_buf, size_t offset)
+    NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  *
@@ -3518,6 +4403,265 @@ void ngf_cmd_begin_debug_group(ngf_cmd_buffer cmd_buffer, const char* name) NGF_
  */
 void ngf_cmd_end_current_debug_group(ngf_cmd_buffer cmd_buffer) NGF_NOEXCEPT;
 
+/**
+ * @typedef ngf_timestamp_query
+ * \ingroup ngf
+ *
+ * Identifies a timestamp written by \ref ngf_cmd_write_timestamp within a particular frame.
+ */
+typedef uint32_t ngf_timestamp_query;
+
+/**
+ * \ingroup ngf
+ *
+ * Records a command that writes a GPU timestamp once all previously recorded commands have
+ * finished executing. This may be done within render, compute and transfer passes as well as
+ * outside of them, but not within render passes that execute secondary command buffers, nor into
+ * secondary command buffers themselves.
+ *
+ * The queries backing the timestamps are managed by the backend, and there's a limited number of
+ * them per frame (see \ref ngf_context_info::max_timestamp_queries). The written value can be
+ * obtained with \ref ngf_get_timestamp once the frame has finished executing.
+ *
+ * Timestamps are not supported on Metal, where this and \ref ngf_get_timestamp return
+ * \ref NGF_ERROR_INVALID_OPERATION (see \ref ngf_device_capabilities::supports_timestamp_queries).
+ *
+ * @param buf The command buffer to record the command into.
+ * @param query Receives the identifier of the timestamp within the current frame.
+ */
+ngf_error ngf_cmd_write_timestamp(ngf_cmd_buffer buf, ngf_timestamp_query* query) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Obtains the value of a timestamp written during the given frame, in nanoseconds. Only the
+ * difference between two timestamps written on the same queue is meaningful.
+ *
+ * This never blocks. If the frame hasn't finished executing yet, \ref NGF_ERROR_TIMEOUT is
+ * returned. Results remain available until the resources of the frame get reused by a later
+ * frame, i.e. for as many frames as the context is allowed to have in flight.
+ *
+ * @param token The token of the frame during which the timestamp was written.
+ * @param query The timestamp to obtain, as returned by \ref ngf_cmd_write_timestamp.
+ * @param timestamp_ns Receives the timestamp value, in nanoseconds.
+ */
+ngf_error ngf_get_timestamp(
+    ngf_frame_token     token,
+    ngf_timestamp_query query,
+    uint64_t*           timestamp_ns) NGF_NOEXCEPT;
+
+/**
+ * @enum ngf_query_type
+ * \ingroup ngf
+ * Enumerates the types of queries that can be made with \ref ngf_cmd_begin_query.
+ */
+typedef enum ngf_query_type {
+  /**
+   * Counts the samples that pass the depth and stencil tests. Devices that can't count samples
+   * precisely may only report whether any samples passed (i.e. a zero or non-zero value).
+   */
+  NGF_QUERY_TYPE_OCCLUSION = 0,
+
+  /**
+   * Counts the work done by different stages of the pipeline. Only available on devices that report
+   * \ref ngf_device_capabilities::supports_pipeline_statistics_queries, and only on the graphics
+   * queue.
+   */
+  NGF_QUERY_TYPE_PIPELINE_STATISTICS,
+
+  NGF_QUERY_TYPE_COUNT
+} ngf_query_type;
+
+/**
+ * @struct ngf_query
+ * \ingroup ngf
+ *
+ * Identifies a query made within a particular frame.
+ */
+typedef struct ngf_query {
+  ngf_query_type type;  /**< The type of the query. */
+  uint32_t       index; /**< Index of the query among the frame's queries of the same type. */
+} ngf_query;
+
+/**
+ * @struct ngf_query_result
+ * \ingroup ngf
+ *
+ * The result of a query. Only the fields relevant to the query type are filled, the rest are set to
+ * zero.
+ */
+typedef struct ngf_query_result {
+  uint64_t samples_passed; /**< Samples that passed (\ref NGF_QUERY_TYPE_OCCLUSION). */
+
+  /* The remaining fields are filled for \ref NGF_QUERY_TYPE_PIPELINE_STATISTICS. */
+  uint64_t input_assembly_vertices;     /**< Vertices fetched by the input assembler. */
+  uint64_t input_assembly_primitives;   /**< Primitives assembled by the input assembler. */
+  uint64_t vertex_shader_invocations;   /**< Vertex shader invocations. */
+  uint64_t clipping_primitives;         /**< Primitives output by the clipping stage. */
+  uint64_t fragment_shader_invocations; /**< Fragment shader invocations. */
+  uint64_t compute_shader_invocations;  /**< Compute shader invocations. */
+} ngf_query_result;
+
+/**
+ * \ingroup ngf
+ *
+ * Begins a query of the given type within a render pass. Only one query of each type may be active
+ * on a command buffer at a time, and the query must be ended with \ref ngf_cmd_end_query within the
+ * same render pass. Queries can't be made within render passes that execute secondary command
+ * buffers, nor within secondary command buffers themselves.
+ *
+ * The queries are managed by the backend, and there's a limited number of them per frame (see
+ * \ref ngf_context_info::max_queries). The result can be obtained with
+ * \ref ngf_get_query_result once the frame has finished executing.
+ *
+ * Queries are not supported on Metal, where this and the other query entry points return
+ * \ref NGF_ERROR_INVALID_OPERATION.
+ *
+ * @param enc The render encoder to record the command into.
+ * @param type The type of query to begin.
+ * @param query Receives the identifier of the query within the current frame.
+ */
+ngf_error
+ngf_cmd_begin_query(ngf_render_encoder enc, ngf_query_type type, ngf_query* query) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Ends a query started with \ref ngf_cmd_begin_query.
+ *
+ * @param enc The render encoder to record the command into.
+ * @param query The query to end.
+ */
+ngf_error ngf_cmd_end_query(ngf_render_encoder enc, ngf_query query) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Begins a \ref NGF_QUERY_TYPE_PIPELINE_STATISTICS query within a compute pass. The query must be
+ * ended with \ref ngf_cmd_end_compute_query within the same compute pass.
+ *
+ * @param enc The compute encoder to record the command into.
+ * @param query Receives the identifier of the query within the current frame.
+ */
+ngf_error ngf_cmd_begin_compute_query(ngf_compute_encoder enc, ngf_query* query) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Ends a query started with \ref ngf_cmd_begin_compute_query.
+ *
+ * @param enc The compute encoder to record the command into.
+ * @param query The query to end.
+ */
+ngf_error ngf_cmd_end_compute_query(ngf_compute_encoder enc, ngf_query query) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Obtains the result of a query made during the given frame.
+ *
+ * This never blocks. If the frame hasn't finished executing yet, \ref NGF_ERROR_TIMEOUT is
+ * returned. Results remain available for as long as those of timestamps (see
+ * \ref ngf_get_timestamp).
+ *
+ * @param token The token of the frame during which the query was made.
+ * @param query The query, as returned by \ref ngf_cmd_begin_query or
+ *              \ref ngf_cmd_begin_compute_query.
+ * @param result Receives the result of the query.
+ */
+ngf_error ngf_get_query_result(ngf_frame_token token, ngf_query query, ngf_query_result* result)
+    NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Places an image into the bindless resource heap, so that shaders can sample it without it being
+ * bound. The image must have been created with \ref NGF_IMAGE_USAGE_SAMPLE_FROM.
+ *
+ * There is a single heap for the whole device, shared by all contexts. The returned index is
+ * therefore valid in command buffers recorded on any context, including secondary ones.
+ *
+ * The heap doesn't keep track of how registered resources are used, so barriers for them are
+ * only issued if they are declared with \ref ngf_cmd_use_resources or
+ * \ref ngf_cmd_use_compute_resources (or up front, for immediate mode render passes).
+ *
+ * Requires \ref ngf_device_capabilities::supports_bindless_resources.
+ *
+ * @param image The image to register.
+ * @param index Receives the index of the image within the heap's image array.
+ */
+ngf_error ngf_register_bindless_image(ngf_image image, uint32_t* index) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Places a sampler into the bindless resource heap. See
+ * \ref ngf_register_bindless_image.
+ *
+ * @param sampler The sampler to register.
+ * @param index Receives the index of the sampler within the heap's sampler array.
+ */
+ngf_error ngf_register_bindless_sampler(ngf_sampler sampler, uint32_t* index) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Places a region of a storage buffer into the bindless resource heap. See
+ * \ref ngf_register_bindless_image. The buffer must have been created with
+ * \ref NGF_BUFFER_USAGE_STORAGE_BUFFER.
+ *
+ * @param slice The region of the buffer to register.
+ * @param index Receives the index of the region within the heap's storage buffer array.
+ */
+ngf_error
+ngf_register_bindless_buffer(const ngf_buffer_slice* slice, uint32_t* index) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Removes a resource from the bindless resource heap. The index may be handed out again once the
+ * current context's frames that are currently in flight have finished executing, so the resource
+ * must not be accessed through it by any work submitted after this call.
+ *
+ * @param type The kind of resource that the index refers to.
+ * @param index The index returned when the resource was registered.
+ */
+void ngf_release_bindless_index(ngf_bindless_resource_type type, uint32_t index) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Declares that the draws recorded after this call within the current render pass access the
+ * given resources, so that the necessary barriers get issued. This is required for resources that
+ * shaders access through the bindless resource heap, since they aren't bound.
+ *
+ * Immediate mode render passes (see \ref ngf_render_pass_info::declared_resources) don't support
+ * this, and resources used within them must be declared when the pass begins instead.
+ *
+ * @param enc The handle to the render encoder.
+ * @param resources A pointer to a contiguous array of \ref ngf_render_pass_resource objects.
+ * @param nresources The number of elements in the array.
+ */
+ngf_error ngf_cmd_use_resources(
+    ngf_render_encoder              enc,
+    const ngf_render_pass_resource* resources,
+    uint32_t                        nresources) NGF_NOEXCEPT;
+
+/**
+ * \ingroup ngf
+ *
+ * Same as \ref ngf_cmd_use_resources, for the dispatches recorded after this call within the
+ * current compute pass. Vertex attribute and index buffer usages aren't allowed.
+ *
+ * @param enc The handle to the compute encoder.
+ * @param resources A pointer to a contiguous array of \ref ngf_render_pass_resource objects.
+ * @param nresources The number of elements in the array.
+ */
+ngf_error ngf_cmd_use_compute_resources(
+    ngf_compute_encoder             enc,
+    const ngf_render_pass_resource* resources,
+    uint32_t                        nresources) NGF_NOEXCEPT;
+
 /**
  * \ingroup ngf
  * Triggers RenderDoc Capture.
@@ -28,6 +28,22 @@ template<class T, class InfoT> ngf_error generic_create(const InfoT& info, T** r
   if (!maybe_t.has_error()) result[0] = maybe_t.value().release();
   return maybe_t.has_error() ? maybe_t.error() : NGF_ERROR_OK;
 }
+
+// Creates the objects one after another on the calling thread.
+template<class T, class InfoT>
+ngf_error generic_create_batch(uint32_t n, const InfoT* infos, T** results) {
+  for (uint32_t i = 0u; i < n; ++i) {
+    const ngf_error err = generic_create(infos[i], &results[i]);
+    if (err != NGF_ERROR_OK) {
+      for (uint32_t j = 0u; j < n; ++j) {
+        if (j < i) { NGFI_FREE(results[j]); }
+        results[j] = nullptr;
+      }
+      return err;
+    }
+  }
+  return NGF_ERROR_OK;
+}
 }  // namespace ngfi
 
 ngf_error ngf_create_context(const ngf_context_info* info, ngf_context* result) NGF_NOEXCEPT {
@@ -87,6 +103,25 @@ ngf_error ngf_create_graphics_pipeline(
   return ngfi::generic_create(*info, result);
 }
 
+// The job dispatcher is not used by this backend, pipelines are always created serially.
+ngf_error ngf_create_compute_pipelines(
+    uint32_t                         npipelines,
+    const ngf_compute_pipeline_info* infos,
+    ngf_compute_pipeline*            results,
+    const ngf_job_dispatcher*) NGF_NOEXCEPT {
+  assert(npipelines == 0u || (infos && results));
+  return ngfi::generic_create_batch(npipelines, infos, results);
+}
+
+ngf_error ngf_create_graphics_pipelines(
+    uint32_t                          npipelines,
+    const ngf_graphics_pipeline_info* infos,
+    ngf_graphics_pipeline*            results,
+    const ngf_job_dispatcher*) NGF_NOEXCEPT {
+  assert(npipelines == 0u || (infos && results));
+  return ngfi::generic_create_batch(npipelines, infos, results);
+}
+
 void ngf_destroy_graphics_pipeline(ngf_graphics_pipeline pipe) NGF_NOEXCEPT {
   if (pipe != nullptr) { NGFI_FREE(pipe); }
 }
@@ -47,6 +47,28 @@ static inline uint8_t ngfi_frame_id(uintptr_t frame_token) {
   return (uint8_t)(frame_token & 0xff);
 }
 
+// On 64-bit targets, the upper half of a frame token holds the frame's serial number, which
+// increases by one with every frame begun on a context. 32-bit tokens have no room for it, and
+// report a serial of zero.
+static inline uintptr_t ngfi_frame_token_with_serial(uintptr_t frame_token, uint32_t serial) {
+#if UINTPTR_MAX > 0xffffffffu
+  const uintptr_t serial_ext = serial;
+  return (frame_token & 0xffffffffu) | (serial_ext << 0x20);
+#else
+  (void)serial;
+  return frame_token;
+#endif
+}
+
+static inline uint32_t ngfi_frame_serial(uintptr_t frame_token) {
+#if UINTPTR_MAX > 0xffffffffu
+  return (uint32_t)(frame_token >> 0x20);
+#else
+  (void)frame_token;
+  return 0u;
+#endif
+}
+
 #ifdef __cplusplus
 }
 #endif
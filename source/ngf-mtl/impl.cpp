@@ -934,6 +934,12 @@ static void ngfmtl_populate_ngf_device(uint32_t handle, ngf_device& ngfdev, MTL:
   caps.max_image_layers                         = 2048;
   caps.max_uniform_buffer_range                 = NGF_DEVICE_LIMIT_UNKNOWN;
   caps.device_local_memory_is_host_visible      = mtldev->hasUnifiedMemory();
+  caps.supports_async_compute                   = false;
+  caps.supports_async_transfer                  = false;
+  caps.supports_timestamp_queries               = false;
+  caps.supports_pipeline_statistics_queries     = false;
+  caps.max_draw_indirect_count                  = NGF_DEVICE_LIMIT_UNKNOWN;
+  caps.supports_bindless_resources              = false;
 
   if (gpu_family_idx >= ngfmtl_gpufam_idx(MTL::GPUFamilyApple6)) {
     caps.max_sampled_images_per_stage = 128;
@@ -1685,6 +1691,21 @@ const ngf_device_capabilities* ngf_get_device_capabilities() NGF_NOEXCEPT {
   return &DEVICE_CAPS;
 }
 
+ngf_error ngf_get_descriptor_set_cache_stats(ngf_descriptor_set_cache_stats* stats) NGF_NOEXCEPT {
+  assert(stats);
+  if (CURRENT_CONTEXT == nullptr) { return NGF_ERROR_INVALID_OPERATION; }
+  stats->hits   = 0u;
+  stats->misses = 0u;
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_get_descriptor_pool_stats(ngf_descriptor_pool_stats* stats) NGF_NOEXCEPT {
+  assert(stats);
+  if (CURRENT_CONTEXT == nullptr) { return NGF_ERROR_INVALID_OPERATION; }
+  memset(stats, 0, sizeof(*stats));
+  return NGF_ERROR_OK;
+}
+
 extern "C" {
 void* objc_autoreleasePoolPush(void);
 void  objc_autoreleasePoolPop(void* pool);
@@ -1721,6 +1742,22 @@ ngf_error ngf_end_frame(ngf_frame_token token) NGF_NOEXCEPT {
   return NGF_ERROR_OK;
 }
 
+// Frame completion queries are not supported on Metal.
+bool ngf_is_frame_complete(ngf_frame_token) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Frame completion queries are not supported by Metal backend");
+  return false;
+}
+
+ngf_error ngf_wait_frame(ngf_frame_token, uint64_t) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Frame completion queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+// Transfers execute on the same queue as everything else.
+bool ngf_is_frame_transfer_complete(ngf_frame_token token) NGF_NOEXCEPT {
+  return ngf_is_frame_complete(token);
+}
+
 ngf_error ngf_get_current_swapchain_image(ngf_frame_token token, ngf_image* result) NGF_NOEXCEPT {
   assert(CURRENT_CONTEXT);
   *result = &CURRENT_CONTEXT->frame.img_wrapper;
@@ -1822,6 +1859,25 @@ ngf_error ngf_submit_cmd_buffers(uint32_t n, ngf_cmd_buffer* cmd_buffers) NGF_NO
   return NGF_ERROR_OK;
 }
 
+// All command buffers execute on the same queue in submission order, so dependencies between them
+// are always satisfied.
+ngf_error ngf_cmd_buffer_add_dependency(ngf_cmd_buffer, ngf_cmd_buffer) NGF_NOEXCEPT {
+  return NGF_ERROR_OK;
+}
+
+// Staging upload allocation is not supported on Metal.
+ngf_error ngf_upload_alloc(size_t, size_t, ngf_upload_region*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Staging upload allocation is not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+void ngf_upload_end(const ngf_upload_region*) NGF_NOEXCEPT {
+}
+
+ngf_error ngf_uniform_alloc(size_t size, ngf_upload_region* region) NGF_NOEXCEPT {
+  return ngf_upload_alloc(size, DEVICE_CAPS.uniform_buffer_offset_alignment, region);
+}
+
 void ngfmtl_finish_pending_encoders(ngf_cmd_buffer cmd_buffer) {
   /* End any current Metal encoders.*/
   if (cmd_buffer->active_rce) {
@@ -2009,6 +2065,20 @@ ngf_error ngf_cmd_begin_render_pass(
   return NGF_ERROR_OK;
 }
 
+// Secondary render passes are not supported on Metal.
+ngf_error
+ngf_cmd_begin_secondary_render_pass(ngf_cmd_buffer, ngf_render_encoder, ngf_render_encoder*)
+    NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Secondary render passes are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_cmd_execute_secondary_cmd_buffers(ngf_render_encoder, uint32_t, const ngf_cmd_buffer*)
+    NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Secondary render passes are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
 ngf_error ngf_cmd_end_render_pass(ngf_render_encoder enc) NGF_NOEXCEPT {
   auto cmd_buffer = NGFMTL_ENC2CMDBUF(enc);
   if (cmd_buffer->active_rce) {
@@ -2141,6 +2211,29 @@ void ngf_cmd_dispatch(
                                                 MTL::Size::Make(threadgroup_size[0], threadgroup_size[1], threadgroup_size[2]));
 }
 
+void ngf_cmd_dispatch_indirect(ngf_compute_encoder enc, ngf_buffer args_buf, size_t offset)
+    NGF_NOEXCEPT {
+  auto cmd_buf = NGFMTL_ENC2CMDBUF(enc);
+  assert(cmd_buf->active_cce);
+  if (!cmd_buf->active_cce) {
+    NGFI_DIAG_ERROR("Attempt to perform a compute dispatch without an active "
+                    "compute encoder.");
+    return;
+  }
+  assert(cmd_buf->active_compute_pipe);
+  if (!cmd_buf->active_compute_pipe) {
+    NGFI_DIAG_ERROR("Attempt to perform a compute dispatch without a bound "
+                    "compute pipeline.");
+    return;
+  }
+  const uint32_t* threadgroup_size =
+      cmd_buf->active_compute_pipe->niceshade_metadata.threadgroup_size;
+  cmd_buf->active_cce->dispatchThreadgroups(
+      args_buf->mtl_buffer.get(),
+      offset,
+      MTL::Size::Make(threadgroup_size[0], threadgroup_size[1], threadgroup_size[2]));
+}
+
 void ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc, const ngf_graphics_pipeline pipeline)
     NGF_NOEXCEPT {
   auto buf = NGFMTL_ENC2CMDBUF(enc);
@@ -2194,21 +2287,80 @@ void ngf_cmd_draw(
     uint32_t           first_element,
     uint32_t           nelements,
     uint32_t           ninstances) NGF_NOEXCEPT {
+  const ngf_draw_info draw = {
+      .first_element  = first_element,
+      .nelements      = nelements,
+      .base_vertex    = 0,
+      .ninstances     = ninstances,
+      .first_instance = 0u};
+  ngf_cmd_draw_ext(enc, indexed, &draw);
+}
+
+void ngf_cmd_draw_ext(ngf_render_encoder enc, bool indexed, const ngf_draw_info* draw)
+    NGF_NOEXCEPT {
   auto               buf       = NGFMTL_ENC2CMDBUF(enc);
   MTL::PrimitiveType prim_type = buf->active_gfx_pipe->primitive_type;
   if (!indexed) {
-    buf->active_rce->drawPrimitives(prim_type, first_element, nelements, ninstances, 0);
+    buf->active_rce->drawPrimitives(
+        prim_type,
+        draw->first_element,
+        draw->nelements,
+        draw->ninstances,
+        draw->first_instance);
   } else {
     buf->active_rce->drawIndexedPrimitives(
         prim_type,
-        nelements,
+        draw->nelements,
         buf->bound_index_buffer_type,
         buf->bound_index_buffer.get(),
         buf->bound_index_buffer_offset +
-            first_element * (buf->bound_index_buffer_type == MTL::IndexTypeUInt16 ? 2 : 4),
-        ninstances,
-        0,
-        0);
+            draw->first_element * (buf->bound_index_buffer_type == MTL::IndexTypeUInt16 ? 2 : 4),
+        draw->ninstances,
+        draw->base_vertex,
+        draw->first_instance);
+  }
+}
+
+void ngf_cmd_multi_draw(
+    ngf_render_encoder   enc,
+    bool                 indexed,
+    const ngf_draw_info* draws,
+    uint32_t             ndraws) NGF_NOEXCEPT {
+  for (uint32_t i = 0u; i < ndraws; ++i) { ngf_cmd_draw_ext(enc, indexed, &draws[i]); }
+}
+
+// Metal has no multi-draw indirect, so each draw is encoded separately.
+void ngf_cmd_draw_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT {
+  auto               buf       = NGFMTL_ENC2CMDBUF(enc);
+  MTL::PrimitiveType prim_type = buf->active_gfx_pipe->primitive_type;
+  if (stride == 0u) { stride = sizeof(ngf_draw_indirect_args); }
+  for (uint32_t i = 0u; i < ndraws; ++i) {
+    buf->active_rce->drawPrimitives(prim_type, args_buf->mtl_buffer.get(), offset + i * stride);
+  }
+}
+
+void ngf_cmd_draw_indexed_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT {
+  auto               buf       = NGFMTL_ENC2CMDBUF(enc);
+  MTL::PrimitiveType prim_type = buf->active_gfx_pipe->primitive_type;
+  if (stride == 0u) { stride = sizeof(ngf_draw_indexed_indirect_args); }
+  for (uint32_t i = 0u; i < ndraws; ++i) {
+    buf->active_rce->drawIndexedPrimitives(
+        prim_type,
+        buf->bound_index_buffer_type,
+        buf->bound_index_buffer.get(),
+        buf->bound_index_buffer_offset,
+        args_buf->mtl_buffer.get(),
+        offset + i * stride);
   }
 }
 
@@ -2592,6 +2744,73 @@ void ngf_cmd_end_current_debug_group(ngf_cmd_buffer cmd_buf) NGF_NOEXCEPT {
   cmd_buf->mtl_cmd_buffer->popDebugGroup();
 }
 
+// Timestamp queries are not supported on Metal.
+ngf_error ngf_cmd_write_timestamp(ngf_cmd_buffer, ngf_timestamp_query*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Timestamp queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_get_timestamp(ngf_frame_token, ngf_timestamp_query, uint64_t*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Timestamp queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+// Queries are not supported on Metal.
+ngf_error ngf_cmd_begin_query(ngf_render_encoder, ngf_query_type, ngf_query*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_cmd_end_query(ngf_render_encoder, ngf_query) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_cmd_begin_compute_query(ngf_compute_encoder, ngf_query*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_cmd_end_compute_query(ngf_compute_encoder, ngf_query) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_get_query_result(ngf_frame_token, ngf_query, ngf_query_result*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Queries are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_register_bindless_image(ngf_image, uint32_t*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Bindless resources are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_register_bindless_sampler(ngf_sampler, uint32_t*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Bindless resources are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_register_bindless_buffer(const ngf_buffer_slice*, uint32_t*) NGF_NOEXCEPT {
+  NGFI_DIAG_ERROR("Bindless resources are not supported by Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+void ngf_release_bindless_index(ngf_bindless_resource_type, uint32_t) NGF_NOEXCEPT {}
+
+// Metal tracks hazards for the resources it's told about, nothing to do here.
+ngf_error
+ngf_cmd_use_resources(ngf_render_encoder, const ngf_render_pass_resource*, uint32_t) NGF_NOEXCEPT {
+  return NGF_ERROR_OK;
+}
+
+ngf_error ngf_cmd_use_compute_resources(
+    ngf_compute_encoder,
+    const ngf_render_pass_resource*,
+    uint32_t) NGF_NOEXCEPT {
+  return NGF_ERROR_OK;
+}
+
 void ngf_finish() NGF_NOEXCEPT {
   if (CURRENT_CONTEXT->pending_cmd_buffer) {
     CURRENT_CONTEXT->last_cmd_buffer =
@@ -2645,6 +2864,17 @@ ngf_error ngf_set_compute_bytes(
   return NGF_ERROR_OK;
 }
 
+ngf_error ngf_pipeline_cache_serialize(void*, size_t* size) NGF_NOEXCEPT {
+  NGFI_DIAG_WARNING("Pipeline cache serialization is not implemented for Metal backend");
+  if (size) *size = 0u;
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
+ngf_error ngf_pipeline_cache_load(const void*, size_t) NGF_NOEXCEPT {
+  NGFI_DIAG_WARNING("Pipeline cache serialization is not implemented for Metal backend");
+  return NGF_ERROR_INVALID_OPERATION;
+}
+
 void ngf_renderdoc_capture_next_frame() NGF_NOEXCEPT {
   NGFI_DIAG_WARNING("RenderDoc functionality is not implemented for Metal backend");
 }
@@ -38,6 +38,7 @@
 #include "vk_10.h"
 
 #include <assert.h>
+#include <atomic>
 #include <renderdoc_app.h>
 #include <spirv_reflect.h>
 #include <string.h>
@@ -52,12 +53,66 @@ constexpr uint32_t invalid_idx                    = ~((uint32_t)0u);
 constexpr uint32_t max_phys_dev                   = 64u;  // 64 GPUs oughta be enough for everybody.
 constexpr uint32_t img_usage_transient_attachment = (1u << 31u);
 
+// Identifies blobs produced by ngf_pipeline_cache_serialize ("NGPC").
+constexpr uint32_t pipeline_cache_magic   = 0x4350474eu;
+constexpr uint32_t pipeline_cache_version = 1u;
+
 // Used by every pipeline layout and by ngf_context_t::vk_default_push_layout.
 constexpr VkPushConstantRange default_push_constant_range = {
     .stageFlags = VK_SHADER_STAGE_ALL,
     .offset     = 0u,
     .size       = NGF_MAX_ENCODER_INLINE_BYTES};
 
+// Number of descriptor set indices per bind point for which command buffers track what's bound.
+constexpr uint32_t max_tracked_desc_sets = 8u;
+
+// Upper bound on the number of uniform buffer bindings per pipeline layout that use dynamic
+// offsets. This is the minimum value of maxDescriptorSetUniformBuffersDynamic guaranteed by the
+// spec.
+constexpr uint32_t max_dynamic_uniform_buffers = 8u;
+
+// Number of descriptor set indices, starting from 0, whose layouts may use dynamic offsets. The
+// device's limit on dynamic uniform buffers per pipeline layout is split evenly between them, so
+// that whether a set uses dynamic offsets depends only on the set itself and not on the other sets
+// of the pipeline.
+constexpr uint32_t max_dynamic_uniform_buffer_sets = 4u;
+
+// Render pass ops key with DONTCARE load/store ops for every attachment. Used for looking up
+// compatible render passes, since load/store ops don't affect render pass compatibility.
+constexpr uint64_t compat_renderpass_ops_key = 0u;
+
+// Per-frame staging buffer size used when the context info doesn't specify one, and the minimum
+// alignment of upload regions, which satisfies the offset requirements of buffer-to-image copies
+// for all formats with power-of-two texel sizes.
+constexpr size_t default_upload_buffer_size = 8u * 1024u * 1024u;
+constexpr size_t min_upload_alignment       = 16u;
+
+// Number of queries of each type per frame used when the context info doesn't specify one.
+constexpr uint32_t default_queries_per_frame = 256u;
+
+// Statistics gathered by pipeline statistics queries. Results are written in the order of the
+// flag bits.
+constexpr VkQueryPipelineStatisticFlags pipeline_statistics_flags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+constexpr uint32_t npipeline_statistics = 6u;
+
+// Number of slots for each ngf_bindless_resource_type in the bindless resource heap, unless
+// the device's limits are lower.
+constexpr uint32_t default_bindless_heap_capacities[NGF_BINDLESS_RESOURCE_TYPE_COUNT] = {
+    65536u,
+    1024u,
+    65536u};
+
+// Number of descriptors of each type that the bindless resource heap leaves to the other sets of
+// the pipeline layouts that include it, when the device's limits are too low for the default
+// capacities.
+constexpr uint32_t bindless_layout_reserve = 256u;
+
 }  // namespace global
 }  // namespace ngfvk
 
@@ -84,6 +139,81 @@ struct ngfvk_dummy_resources {
   bool                       image_transitioned;
 };
 
+// Identifies the device and driver that a pipeline cache blob was produced by.
+struct ngfvk_pipeline_cache_id {
+  uint32_t vendor_id;
+  uint32_t device_id;
+  uint32_t driver_version;
+  uint8_t  cache_uuid[VK_UUID_SIZE];
+  uint8_t  driver_uuid[VK_UUID_SIZE];
+};
+
+// Prepended to the driver-provided data in serialized pipeline caches.
+struct ngfvk_pipeline_cache_blob_header {
+  uint32_t                magic;
+  uint32_t                version;
+  ngfvk_pipeline_cache_id id;
+  uint64_t                data_size;
+};
+
+// Vulkan objects released on threads that have no current context (e.g. when pipeline creation
+// fails on a worker thread). They are handed over to the retire lists of the next frame that
+// begins on any context.
+struct ngfvk_orphaned_objects {
+  pthread_mutex_t                         mu;
+  ngfi::array<VkPipeline>                 pipelines;
+  ngfi::array<VkPipelineLayout>           pipeline_layouts;
+  ngfi::array<VkDescriptorSetLayout>      set_layouts;
+  ngfi::array<VkDescriptorUpdateTemplate> update_templates;
+  ngfi::array<VkRenderPass>               render_passes;
+};
+
+struct ngfvk_shared_set_layout;
+struct ngfvk_shared_pipeline_layout;
+struct ngfvk_renderpass_cache_entry;
+
+// Device-wide cache of descriptor set layouts and pipeline layouts, so that pipelines with
+// identical bindings share them. This also makes descriptor sets bound for one pipeline
+// compatible with the others.
+struct ngfvk_layout_cache {
+  pthread_mutex_t                                mu;
+  ngfi::hashtable<ngfvk_shared_set_layout*>      set_layouts;
+  ngfi::hashtable<ngfvk_shared_pipeline_layout*> pipeline_layouts;
+};
+
+// Device-wide cache of render passes, shared by all render targets with compatible attachments.
+struct ngfvk_renderpass_cache {
+  pthread_mutex_t                                mu;
+  ngfi::hashtable<ngfvk_renderpass_cache_entry*> entries;
+};
+
+// Hands out indices into one of the arrays of a bindless resource heap. Released indices are handed
+// out again before new ones.
+struct ngfvk_bindless_slots {
+  uint32_t              capacity;
+  uint32_t              nallocated;  // < Indices below this have been handed out at least once.
+  ngfi::array<uint32_t> free_indices;
+};
+
+// Limits on the descriptors accessible to any one stage through a pipeline layout that includes the
+// bindless resource heap, counting the heap itself.
+struct ngfvk_bindless_layout_limits {
+  uint32_t sampled_images;
+  uint32_t samplers;
+  uint32_t storage_buffers;
+  uint32_t resources;
+};
+
+// The device's bindless resource heap: a single update-after-bind descriptor set, which resources
+// get written into once, when they're registered. Shared by all contexts, so that secondary command
+// buffers recorded on any of them see the same indices.
+struct ngfvk_bindless_heap {
+  pthread_mutex_t      mu;  // < Guards the slots and the descriptor writes.
+  VkDescriptorPool     vk_pool;
+  VkDescriptorSet      vk_set;
+  ngfvk_bindless_slots slots[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+};
+
 // Singleton for holding vulkan instance, device and queue handles.
 // This is shared by all contexts.
 struct {
@@ -93,14 +223,42 @@ struct {
   VmaAllocator             allocator;
   VkQueue                  gfx_queue;
   VkQueue                  present_queue;
+  VkQueue                  compute_queue;
+  VkQueue                  transfer_queue;
   uint32_t                 gfx_family_idx;
   uint32_t                 present_family_idx;
+  uint32_t                 compute_family_idx;
+  uint32_t                 transfer_family_idx;
   VkDebugUtilsMessengerEXT debug_messenger;
+  VkPipelineCache          pipeline_cache;
+  ngfvk_pipeline_cache_id  pipeline_cache_id;
+  bool                     partially_bound_descs;  // < Pipelines may opt into partially bound sets.
+  bool                     dynamic_rendering;      // < Render without render pass objects.
+  bool                     timeline_semaphores;    // < Track frame completion with timelines.
+  bool                     async_compute;          // < Has a dedicated compute queue.
+  bool                     async_transfer;         // < Has a dedicated transfer queue.
+  uint32_t max_dynamic_uniform_buffers;  // < Per set layout, see ngfvk::global.
+  uint32_t timestamp_queues_mask;        // < Bit N set if queue type N can write timestamps.
+  float    timestamp_period;             // < Nanoseconds per timestamp tick.
+  bool     precise_occlusion_queries;    // < Occlusion queries count the exact number of samples.
+  bool     multi_draw;                   // < VK_EXT_multi_draw is enabled.
+  uint32_t max_multi_draw_count;         // < Max number of draws per vkCmdDrawMulti*EXT call.
+  bool     push_descriptors;             // < VK_KHR_push_descriptor is enabled.
+  uint32_t max_push_descriptors;         // < Max number of descriptors in a push descriptor set.
+  // Layout of bindless resource heap sets, NULL if the device doesn't support them. Not part of the
+  // layout cache, and holds a reference of its own, so it's never released by pipelines.
+  ngfvk_shared_set_layout* bindless_set_layout;
+  uint32_t bindless_heap_capacities[NGF_BINDLESS_RESOURCE_TYPE_COUNT];  // < Slots per array.
+  ngfvk_bindless_layout_limits bindless_layout_limits;
 #if defined(__linux__)
   xcb_connection_t* xcb_connection;
   xcb_visualid_t    xcb_visualid;
 #endif
-  ngfvk_dummy_resources dummy_res;
+  ngfvk_dummy_resources  dummy_res;
+  ngfvk_orphaned_objects orphans;
+  ngfvk_layout_cache     layout_cache;
+  ngfvk_renderpass_cache renderpass_cache;
+  ngfvk_bindless_heap    bindless_heap;
 } _vk;
 
 // Singleton for holding on to RenderDoc API
@@ -183,12 +341,65 @@ struct ngfvk_desc_binding {
   bool                 is_multilayered_image;
   bool                 is_cubemap;
   uint32_t             ndescs_in_binding;
+  uint32_t             first_payload_slot;  // < Index of the binding's first descriptor in the
+                                            // < update template payload.
+  uint32_t dynamic_offset_idx;  // < For dynamic uniform buffers, index of the binding's offset
+                                // < among the set's dynamic offsets.
+};
+
+// Data for a single descriptor within a descriptor update template payload.
+union ngfvk_desc_payload_slot {
+  VkDescriptorImageInfo      image;
+  VkDescriptorBufferInfo     buffer;
+  VkBufferView               texel_buffer_view;
+  VkAccelerationStructureKHR accel_struct;
+};
+
+// Identifies a descriptor set layout in the layout cache. One per binding index, including the
+// unused ones.
+struct ngfvk_set_layout_key_binding {
+  uint32_t type;
+  uint32_t ndescs;
+  uint32_t image_flags;  // < Bit 0: multilayered image, bit 1: cubemap.
 };
 
+// Descriptor set layout shared by all pipelines with identical bindings in a given set.
+struct ngfvk_shared_set_layout {
+  ngfvk_shared_set_layout*                        next;  // < Next entry with the same hash.
+  uint64_t                                        hash;
+  uint32_t                                        refcount;
+  ngfi::fixed_array<ngfvk_set_layout_key_binding> key;
+  bool                                            is_push;  // < Push descriptor set layout.
+  bool                                            is_partially_bound;  // < May be left unwritten.
+  VkDescriptorSetLayout                           vk_handle;
+  VkDescriptorUpdateTemplate vk_update_template;  // < Writes every descriptor in the set at once.
+  // Template payload referencing dummy resources for every descriptor in the set. Copied over
+  // before the bound descriptors are filled in, so that none are left undefined.
+  ngfi::fixed_array<ngfvk_desc_payload_slot> dummy_payload;
+};
+
+// Pipeline layout shared by all pipelines with identical descriptor set layouts. Holds a reference
+// to each of its set layouts.
+struct ngfvk_shared_pipeline_layout {
+  ngfvk_shared_pipeline_layout*               next;  // < Next entry with the same hash.
+  uint64_t                                    hash;
+  uint32_t                                    refcount;
+  ngfi::fixed_array<ngfvk_shared_set_layout*> set_layouts;
+  VkPipelineLayout                            vk_handle;
+};
+
+// Per-pipeline view of a descriptor set layout. The Vulkan objects are owned by the shared layout,
+// while the binding properties (e.g. which stages access a binding) are specific to the pipeline.
 struct ngfvk_desc_set_layout {
-  VkDescriptorSetLayout vk_handle;
-  ngfvk_desc_count      counts;
-  uint32_t              nall_descs;  // < Total number of descriptors across all bindings.
+  VkDescriptorSetLayout          vk_handle;
+  VkDescriptorUpdateTemplate     vk_update_template;
+  const ngfvk_desc_payload_slot* dummy_payload;
+  ngfvk_desc_count               counts;
+  uint32_t                       nall_descs;  // < Total number of descriptors across all bindings.
+  uint32_t                       ndynamic_offsets;  // < Number of dynamic uniform buffer bindings.
+  bool is_bindless;         // < Set of the bindless resource heap. Has no binding properties.
+  bool is_push;             // < Updated with push descriptors, never allocated from a pool.
+  bool is_partially_bound;  // < Descriptors that aren't bound may be left unwritten.
   ngfi::fixed_array<ngfvk_desc_binding> binding_properties;
 };
 
@@ -199,9 +410,45 @@ struct ngfvk_desc_pool {
   ngfvk_desc_pool_capacity utilization;
 };
 
+// Contents of a single descriptor written by a bind op, in a form suitable for hashing and
+// comparison. Unused fields are zeroed.
+struct ngfvk_desc_write_key {
+  uint32_t binding;
+  uint32_t array_index;
+  uint32_t type;
+  uint32_t image_layout;
+  uint64_t handles[2];  // < Buffer, buffer view, image view + sampler or acceleration structure.
+  uint64_t offset;
+  uint64_t range;
+};
+
+// A descriptor set that has already been allocated and written.
+struct ngfvk_desc_set_cache_entry {
+  ngfvk_desc_set_cache_entry* next;  // < Next entry with the same hash.
+  VkDescriptorSetLayout       layout;
+  VkDescriptorSet             set;
+  uint32_t                    nwrites;
+  ngfvk_desc_write_key*       writes;
+};
+
+// Maps descriptor set contents to descriptor sets that have already been written within the
+// same frame, so that binding identical resources repeatedly doesn't allocate and write a new set
+// each time. Entries are dropped when the owning pools list is reset.
+struct ngfvk_desc_set_cache {
+  ngfi::hashtable<ngfvk_desc_set_cache_entry*> entries;
+  ngfi::arena                                  storage;
+  uint64_t                                     hits;
+  uint64_t                                     misses;
+};
+
 struct ngfvk_desc_pools_list {
-  ngfvk_desc_pool* active_pool;
-  ngfvk_desc_pool* list;
+  ngfvk_desc_pool*         active_pool;
+  ngfvk_desc_pool*         list;
+  ngfvk_desc_set_cache     set_cache;
+  ngf_descriptor_pool_info config;          // < Pool sizing settings of the owning context.
+  ngfvk_desc_pool_capacity frame_usage;     // < Sets and descriptors allocated since last reset.
+  ngfvk_desc_pool_capacity high_water;      // < Slowly decaying maximum of per-frame usage.
+  uint32_t                 npools_created;  // < Pools created since last reset.
 };
 
 struct ngfvk_desc_superpool {
@@ -215,6 +462,13 @@ struct ngfvk_cmd_buf_with_pool {
   VkCommandPool   cmd_pool;
 };
 
+// An index released from the bindless resource heap, which can be reused once the frame that
+// released it has finished.
+struct ngfvk_bindless_slot {
+  uint32_t type;
+  uint32_t index;
+};
+
 // Typed chunk lists for retiring Vulkan objects.
 template<class T> struct ngfvk_retire_list {
   ngfi::chunked_list<T> list;
@@ -241,6 +495,7 @@ using ngfvk_retire_lists = ngfvk_retire_lists_t<
     VkPipeline,
     VkPipelineLayout,
     VkDescriptorSetLayout,
+    VkDescriptorUpdateTemplate,
     ngfvk_cmd_buf_with_pool,
     VkFramebuffer,
     VkRenderPass,
@@ -250,7 +505,31 @@ using ngfvk_retire_lists = ngfvk_retire_lists_t<
     ngf_texel_buffer_view,
     ngf_image,
     ngf_buffer,
-    ngfvk_desc_pools_list*>;
+    ngfvk_desc_pools_list*,
+    ngfvk_bindless_slot>;
+
+// Kinds of queries that frames have pools for. The first ones correspond to ngf_query_type.
+enum ngfvk_query_pool_type {
+  NGFVK_QUERY_POOL_OCCLUSION           = NGF_QUERY_TYPE_OCCLUSION,
+  NGFVK_QUERY_POOL_PIPELINE_STATISTICS = NGF_QUERY_TYPE_PIPELINE_STATISTICS,
+  NGFVK_QUERY_POOL_TIMESTAMP,
+  NGFVK_QUERY_POOL_COUNT
+};
+
+// Pool of queries of one type used by a frame, created on first use. Tracks the number of queries
+// handed out, and how many of those have been reset by a submission so far.
+struct ngfvk_frame_query_pool {
+  VkQueryPool vk_pool;
+  uint32_t    nqueries;
+  uint32_t    nqueries_reset;
+};
+
+// Events used by a frame for split barriers, created on first use. The ones handed out during the
+// frame are reset once it's retired.
+struct ngfvk_frame_event_pool {
+  ngfi::array<VkEvent> events;
+  uint32_t             nevents;  // < Number of events handed out during the frame.
+};
 
 // Vulkan resources associated with a given frame.
 struct ngfvk_frame_resources {
@@ -265,13 +544,34 @@ struct ngfvk_frame_resources {
   // Fences that will be signaled at the end of the frame.
   VkFence fences[2];
 
+  // Descriptor pool usage recorded when the pools used by this frame were last reset.
+  ngf_descriptor_pool_stats desc_pool_stats;
+
   // Number of fences to wait on to complete all submissions related to this
-  // frame.
+  // frame. Only used when timeline semaphores are not supported.
   uint32_t nwait_fences;
+
+  // Serial number of the last frame that used these resources, zero if there was none.
+  uint64_t serial;
+
+  // Timeline values signaled by the frame's last submission to each queue.
+  uint64_t queue_timeline_values[NGF_QUEUE_TYPE_COUNT];
+
+  // Staging buffer that uploads are suballocated from, created on first use, and the offset of its
+  // unused part. The whole buffer becomes available again once the frame is retired.
+  ngf_buffer upload_buffer;
+  size_t     upload_buffer_offset;
+
+  // Query pools used by the frame, one per type.
+  ngfvk_frame_query_pool query_pools[NGFVK_QUERY_POOL_COUNT];
+
+  // Events used by the frame's split barriers.
+  ngfvk_frame_event_pool event_pool;
 };
 
 struct ngfvk_command_superpool {
   ngfi::fixed_array<VkCommandPool> cmd_pools;
+  uint32_t                         queue_family_idx;
   uint16_t                         ctx_id;
 
   ngfvk_command_superpool() = default;
@@ -288,10 +588,30 @@ struct ngfvk_attachment_pass_desc {
   bool                is_resolve;
 };
 
+// Describes an attachment for the purpose of looking up render passes in the render pass cache.
+struct ngfvk_renderpass_attachment_key {
+  uint32_t format;
+  uint32_t sample_count;
+  uint32_t type;
+  uint32_t layout;
+  uint32_t is_resolve;
+};
+
+// Render pass for a given combination of attachments and load/store ops.
 struct ngfvk_renderpass_cache_entry {
-  ngf_render_target rt;
-  uint64_t          ops_key;
-  VkRenderPass      renderpass;
+  ngfvk_renderpass_cache_entry*                      next;  // < Next entry with the same hash.
+  uint64_t                                           hash;
+  uint64_t                                           ops_key;
+  uint32_t                                           refcount;  // < Number of render targets.
+  ngfi::fixed_array<ngfvk_renderpass_attachment_key> attachments;
+  VkRenderPass                                       renderpass;
+};
+
+// A render pass that a render target has been used with. The render target holds a reference to
+// the render pass for as long as it lives.
+struct ngfvk_rt_renderpass {
+  ngfvk_renderpass_cache_entry* entry;
+  ngfvk_rt_renderpass*          next;
 };
 
 #define NGFVK_ENC2CMDBUF(enc) ((ngf_cmd_buffer)((void*)enc.pvt_data_donotuse.d0))
@@ -299,6 +619,7 @@ struct ngfvk_renderpass_cache_entry {
 struct ngfvk_device_info {
   uint32_t vendor_id;
   uint32_t device_id;
+  bool     push_descriptor_supported;  // < VK_KHR_push_descriptor is enabled.
 
   ngfi::array<const char*, ngfi::system_alloc_callbacks> enabled_ext_names;
   VkPhysicalDeviceFeatures                               required_features;
@@ -307,13 +628,18 @@ struct ngfvk_device_info {
   VkPhysicalDeviceBufferDeviceAddressFeatures            bda_features;
   VkPhysicalDeviceAccelerationStructureFeaturesKHR       accls_features;
   VkPhysicalDeviceRayQueryFeaturesKHR                    ray_query_features;
+  VkPhysicalDeviceDescriptorIndexingFeatures             desc_indexing_features;
+  VkPhysicalDeviceDynamicRenderingFeatures               dynamic_rendering_features;
+  VkPhysicalDeviceTimelineSemaphoreFeatures              timeline_semaphore_features;
+  VkPhysicalDeviceMultiDrawFeaturesEXT                   multi_draw_features;
   VkPhysicalDeviceFeatures2                              phys_dev_features2;
 };
 
 struct ngfvk_generic_pipeline {
   VkPipeline                         vk_pipeline;
   ngfi::array<ngfvk_desc_set_layout> descriptor_set_layouts;
-  VkPipelineLayout                   vk_pipeline_layout;
+  ngfvk_shared_pipeline_layout*      shared_layout;
+  VkPipelineLayout                   vk_pipeline_layout;  // < Owned by the shared layout.
   VkSpecializationInfo               vk_spec_info;
   VkRenderPass                       compat_render_pass;
 
@@ -330,7 +656,9 @@ struct ngfvk_generic_pipeline {
       const ngf_specialization_info*   spec_info,
       VkPipelineShaderStageCreateInfo* vk_shader_stages,
       const ngf_shader_stage*          shader_stages,
-      uint32_t                         nshader_stages) NGF_NOEXCEPT;
+      uint32_t                         nshader_stages,
+      uint32_t                         push_descriptor_sets,
+      uint32_t                         partially_bound_sets) NGF_NOEXCEPT;
 };
 
 // Describes how a resource is accessed within a synchronization scope.
@@ -351,12 +679,21 @@ struct ngfvk_sync_state {
   ngfvk_sync_barrier_masks active_readers_masks;
   uint32_t                 per_stage_readers_mask;
   VkImageLayout            layout;
+  uint8_t                  queue;  // < Queue that accessed the resource last (ngf_queue_type).
   bool                     skip_hazard_tracking;
 };
 
 // Type of synchronized resource.
 enum ngfvk_sync_res_type { NGFVK_SYNC_RES_BUFFER, NGFVK_SYNC_RES_IMAGE, NGFVK_SYNC_RES_COUNT };
 
+// A range of mip levels and array layers within an image.
+struct ngfvk_subres_range {
+  uint32_t base_level;
+  uint32_t nlevels;
+  uint32_t base_layer;
+  uint32_t nlayers;
+};
+
 // Tagged union for passing around handles to synchronized GPU resources in a generic way.
 struct ngfvk_sync_res {
   union {
@@ -365,26 +702,45 @@ struct ngfvk_sync_res {
   } data;
   ngfvk_sync_res_type type;
   uint64_t            hash;
+  ngfvk_subres_range  range;  // < For image resources only, the subresources being accessed.
+};
+
+// Synchronization data of a resource, or of a single image subresource, within the context of a
+// single cmd buffer.
+struct ngfvk_sync_track {
+  ngfvk_sync_req   expected_sync_req;  // < Expected sync state.
+  ngfvk_sync_state sync_state;         // < Latest synchronization state.
+  bool             had_barrier;
+  bool             accessed;  // < Whether the cmd buffer has accessed it yet.
 };
 
 // Data associated with a particular synchronized resource within the context of a single cmd
 // buffer.
 struct ngfvk_sync_res_data {
-  ngfvk_sync_req      expected_sync_req;  // < Expected sync state.
-  ngfvk_sync_state    sync_state;         // < Latest synchronization state.
+  ngfvk_sync_track    whole;  // < Shared by all subresources while `subres` is NULL.
+  // For images whose subresources have diverged, per-subresource data indexed by
+  // `level * nlayers + layer`. Allocated from the frame arena.
+  ngfvk_sync_track*   subres;
   uint32_t            pending_sync_req_idx;
+  uint32_t            deferred_epoch;  // < Epoch of the last deferred cmd run to access it.
+  uint32_t            deferred_cmd_idx;  // < Index of the last deferred cmd to access it, if known.
   ngfvk_sync_res_type res_type;
   uintptr_t           res_handle;
-  bool                had_barrier;
 };
 
 // Typedef for the sync resource data hash table
 using ngfvk_sync_res_hashtable = ngfi::hashtable<ngfvk_sync_res_data>;
 
+// Sync requests for the resources accessed by a single operation. All requests for the same
+// resource are chained together via `next_pending_idx`. Requests targeting overlapping parts of the
+// resource form a group: their ranges are kept as they are, and the merged request of the whole
+// group is stored at the index of its owner. Requests for disjoint subresources are kept apart.
 struct ngfvk_sync_req_batch {
   ngfvk_sync_res_hashtable::keyhash* sync_res_data_keys;
   ngfvk_sync_req*                    pending_sync_reqs;
-  bool*                              freshness;
+  ngfvk_subres_range*                pending_ranges;
+  uint32_t*                          next_pending_idx;
+  uint32_t*                          owner_idx;  // < Index of the request owning the group.
   uint32_t                           npending_sync_reqs;
   uint32_t                           nbuffer_sync_reqs;
   uint32_t                           nimage_sync_reqs;
@@ -402,6 +758,19 @@ enum ngfvk_render_cmd_type {
   NGFVK_RENDER_CMD_BIND_INDEX_BUFFER,
   NGFVK_RENDER_CMD_SET_DEPTH_BIAS,
   NGFVK_RENDER_CMD_DRAW,
+  NGFVK_RENDER_CMD_DRAW_INDIRECT,
+  NGFVK_RENDER_CMD_MULTI_DRAW,
+  NGFVK_RENDER_CMD_EXECUTE_SECONDARIES,
+  NGFVK_RENDER_CMD_WRITE_TIMESTAMP,
+  NGFVK_RENDER_CMD_BEGIN_QUERY,
+  NGFVK_RENDER_CMD_END_QUERY,
+  NGFVK_RENDER_CMD_BIND_COMPUTE_PIPELINE,
+  NGFVK_RENDER_CMD_SET_BYTES,
+  NGFVK_RENDER_CMD_DISPATCH,
+  NGFVK_RENDER_CMD_DISPATCH_INDIRECT,
+  NGFVK_RENDER_CMD_COPY_BUFFER,
+  NGFVK_RENDER_CMD_COPY_BUFFER_TO_IMAGE,
+  NGFVK_RENDER_CMD_COPY_IMAGE_TO_BUFFER,
 };
 
 struct ngfvk_barrier_data {
@@ -411,6 +780,8 @@ struct ngfvk_barrier_data {
   VkPipelineStageFlags dst_stage_mask;
   VkImageLayout        src_layout;
   VkImageLayout        dst_layout;
+  uint32_t             src_queue_family;  // < Only used for queue family ownership transfers.
+  uint32_t             dst_queue_family;  // < Only used for queue family ownership transfers.
   ngfvk_sync_res       res;
 };
 
@@ -434,16 +805,63 @@ struct ngfvk_render_cmd {
       ngf_type   type;
     } bind_index_buffer;
     struct {
-      uint32_t first_element;
-      uint32_t nelements;
-      uint32_t ninstances;
-      bool     indexed;
+      ngf_draw_info info;
+      bool          indexed;
     } draw;
+    struct {
+      const ngf_draw_info* draws;  // < Allocated from the frame arena.
+      uint32_t             ndraws;
+      bool                 indexed;
+    } multi_draw;
+    struct {
+      ngf_buffer args_buffer;
+      size_t     offset;
+      uint32_t   ndraws;
+      uint32_t   stride;
+      bool       indexed;
+    } draw_indirect;
     struct {
       float const_factor;
       float slope_factor;
       float clamp;
     } depth_bias;
+    struct {
+      const VkCommandBuffer* cmd_bufs;
+      uint32_t               ncmd_bufs;
+    } execute_secondaries;
+    struct {
+      VkQueryPool         pool;
+      uint32_t            query;
+      VkQueryControlFlags flags;  // < Only used for beginning queries.
+    } query;
+    struct {
+      ngf_compute_pipeline pipeline;
+      ngf_compute_pipeline prev_pipeline;  // < Pipeline bound before this one, if any.
+    } bind_compute_pipeline;
+    struct {
+      const void* data;  // < Allocated from the frame arena.
+      uint32_t    size;
+    } set_bytes;
+    struct {
+      uint32_t x;
+      uint32_t y;
+      uint32_t z;
+    } dispatch;
+    struct {
+      ngf_buffer args_buffer;
+      size_t     offset;
+    } dispatch_indirect;
+    struct {
+      ngf_buffer   src;
+      ngf_buffer   dst;
+      VkBufferCopy region;
+    } copy_buffer;
+    struct {
+      ngf_buffer               buffer;
+      ngf_image                image;
+      const VkBufferImageCopy* regions;  // < Allocated from the frame arena.
+      uint32_t                 nregions;
+    } buffer_image_copy;
   } data;
   ngfvk_render_cmd_type type : 8;
 };
@@ -454,6 +872,22 @@ struct ngfvk_pending_barrier_list {
   uint32_t                               npending_buf_bars;
 };
 
+// A barrier split in two halves: the event is set right after the commands producing the guarded
+// resources, and waited on right before the commands consuming them.
+struct ngfvk_split_barrier {
+  VkEvent          event;     // < VK_NULL_HANDLE if there's no split barrier.
+  VkDependencyInfo dep_info;  // < Barrier arrays are allocated from the frame arena.
+};
+
+// A run of command buffers that are submitted to the same queue at once.
+struct ngfvk_submit_batch {
+  uint64_t       wait_values[NGF_QUEUE_TYPE_COUNT];  // < Timeline values to wait for, 0 if none.
+  uint64_t       signal_value;   // < Value signaled on the queue's timeline upon completion.
+  uint32_t       first_cmd_buf;  // < Index of the batch's first command buffer handle.
+  uint32_t       ncmd_bufs;
+  ngf_queue_type queue;
+};
+
 // Range of render commands for virtual bind operations.
 // Stores a pointer to the first command and the count.
 struct ngfvk_virt_bind_range {
@@ -461,11 +895,29 @@ struct ngfvk_virt_bind_range {
   uint32_t                count;
 };
 
+// Resource bound to a descriptor of the compute bind point, identified by set, binding and array
+// index. Descriptor sets stay bound across dispatches, so every dispatch may access it.
+struct ngfvk_bound_compute_res {
+  uint32_t       set;
+  uint32_t       binding;
+  uint32_t       array_index;
+  ngfvk_sync_res res;
+};
+
 struct ngfvk_reflect_binding_and_stage_mask {
   SpvReflectDescriptorBinding binding_data;
   VkPipelineStageFlags        mask;
 };
 
+// Descriptor sets bound at one of a command buffer's bind points, along with the set layouts of the
+// pipeline layout used for the most recent bind. Used to avoid rebinding sets that remain bound
+// and compatible after a pipeline change.
+struct ngfvk_bound_desc_sets {
+  VkDescriptorSet       sets[ngfvk::global::max_tracked_desc_sets];
+  VkDescriptorSetLayout layouts[ngfvk::global::max_tracked_desc_sets];
+  uint32_t              nlayouts;
+};
+
 #pragma endregion
 
 #pragma region external_struct_definitions
@@ -486,16 +938,29 @@ struct ngf_cmd_buffer_t {
   ngfi::chunked_list<ngfvk_virt_bind_range> virt_bind_ops_ranges;
   ngfvk_pending_barrier_list                pending_barriers;
   ngfvk_sync_res_hashtable                  local_res_states;
+  ngfvk_bound_desc_sets                     bound_gfx_desc_sets;
+  ngfvk_bound_desc_sets                     bound_compute_desc_sets;
+  ngfi::array<ngfvk_bound_compute_res>      bound_compute_res;  // < Within the active compute pass.
   ngf_render_pass_info   pending_render_pass_info;  // < describes the active render pass
   uint32_t               npending_bind_ops;
   uint32_t               pending_clear_value_count;
+  uint32_t               wait_queues_mask;  // < Queues with explicit dependencies to wait on.
+  uint32_t               active_queries_mask;  // < Bit N set if a query of type N is active.
+  uint32_t               pass_queries_mask;  // < Active queries begun within the current pass.
+  uint32_t               deferred_epoch;  // < Incremented each time deferred cmds get recorded.
+  uint32_t               nin_pass_cmds;   // < Number of commands in `in_pass_cmd_chnks`.
+  ngfvk_split_barrier    pending_split_wait;  // < To be waited on before the next deferred cmds.
+  ngf_queue_type         queue;             // < Queue type requested for the cmd buffer.
   ngfi::cmd_buffer_state state;  // < State of the cmd buffer (i.e. new/recording/etc.)
-  bool                   renderpass_active : 1;    // < Has an active renderpass.
-  bool                   compute_pass_active : 1;  // < Has an active compute pass.
-  bool                   xfer_pass_active : 1;     // < Has an active transfer pass.
-  bool                   destroy_on_submit : 1;    // < Destroy after submitting.
-
-  static ngfi::maybe_ngfptr<ngf_cmd_buffer_t> make() noexcept;
+  bool                   renderpass_active : 1;      // < Has an active renderpass.
+  bool                   immediate_render_pass : 1;  // < Renderpass commands aren't deferred.
+  bool                   executes_secondaries : 1;   // < Renderpass executes secondary buffers.
+  bool                   compute_pass_active : 1;    // < Has an active compute pass.
+  bool                   xfer_pass_active : 1;       // < Has an active transfer pass.
+  bool                   destroy_on_submit : 1;      // < Destroy after submitting.
+  bool                   secondary : 1;              // < Records parts of other buffers' passes.
+
+  static ngfi::maybe_ngfptr<ngf_cmd_buffer_t> make(const ngf_cmd_buffer_info& info) noexcept;
   ~ngf_cmd_buffer_t() noexcept;
 };
 
@@ -528,17 +993,20 @@ struct ngf_texel_buffer_view_t {
 };
 
 struct ngf_image_t {
-  ngfvk_alloc      alloc;
-  VkImageView      vkview;
-  VkImageView      vkview_arrayed;
-  VkFormat         vk_fmt;
-  ngf_extent3d     extent;
-  ngf_image_type   type;
-  ngfvk_sync_state sync_state;
-  uint64_t         hash;
-  uint32_t         usage_flags;
-  uint32_t         nlevels;
-  uint32_t         nlayers;
+  ngfvk_alloc       alloc;
+  VkImageView       vkview;
+  VkImageView       vkview_arrayed;
+  VkFormat          vk_fmt;
+  ngf_extent3d      extent;
+  ngf_image_type    type;
+  ngfvk_sync_state  sync_state;
+  // Per-subresource states, indexed by `level * nlayers + layer`. NULL while all subresources are
+  // in the same state, described by `sync_state`.
+  ngfvk_sync_state* subres_sync_states;
+  uint64_t          hash;
+  uint32_t          usage_flags;
+  uint32_t          nlevels;
+  uint32_t          nlayers;
 
   static ngfi::maybe_ngfptr<ngf_image_t>
   make(const ngf_image_info& wrapper_info, ngfvk_alloc&& alloc) NGF_NOEXCEPT;
@@ -548,8 +1016,9 @@ struct ngf_image_t {
 };
 
 struct ngf_image_view_t {
-  VkImageView vk_view;
-  ngf_image   src;
+  VkImageView        vk_view;
+  ngf_image          src;
+  ngfvk_subres_range range;  // < Subresources of the source image that the view covers.
 
   static ngfi::maybe_ngfptr<ngf_image_view_t> make(const ngf_image_view_info& info) NGF_NOEXCEPT;
 
@@ -563,13 +1032,19 @@ struct ngf_context_t {
   uint32_t                              frame_id;
   uint32_t                              max_inflight_frames;
   ngf_frame_token                       current_frame_token;
+  uint64_t                              frame_serial;            // < Serial of the last frame.
+  uint64_t                              completed_frame_serial;  // < Last frame known finished.
+  VkSemaphore queue_timelines[NGF_QUEUE_TYPE_COUNT];  // < Signaled by submissions to each queue.
+  uint64_t    queue_timeline_values[NGF_QUEUE_TYPE_COUNT];  // < Last value signaled per queue.
+  ngf_descriptor_pool_info              desc_pool_info;
+  size_t                                upload_buffer_size;  // < Size of per-frame staging buffers.
+  uint32_t query_pool_capacities[NGFVK_QUERY_POOL_COUNT];  // < Sizes of per-frame query pools.
   ngf_attachment_descriptions           default_attachment_descriptions_list;
   ngfi::unique_ptr<ngf_render_target_t> default_render_target;
 
   ngfi::fixed_array<ngfvk_frame_resources>  frame_res;
   ngfi::array<ngfvk_command_superpool>      command_superpools;
   ngfi::array<ngfvk_desc_superpool>         desc_superpools;
-  ngfi::array<ngfvk_renderpass_cache_entry> renderpass_cache;
 
   // Push-constant-compatible with every pipeline layout (all share default_push_constant_range).
   VkPipelineLayout vk_default_push_layout = VK_NULL_HANDLE;
@@ -592,10 +1067,14 @@ struct ngf_shader_stage_t {
 struct ngf_render_target_t {
   VkFramebuffer                                 frame_buffer;
   VkRenderPass                                  compat_render_pass;
+  // Render passes this target has been used with, most recent first. New ones are only added with
+  // the render pass cache lock held, but the list may be read without it.
+  std::atomic<ngfvk_rt_renderpass*>             renderpasses {NULL};
   uint32_t                                      nattachments;
   ngfi::fixed_array<ngf_attachment_description> attachment_descs;
   ngfi::fixed_array<VkImageView>                attachment_image_views; /* unused in default RT. */
   ngfi::fixed_array<ngf_image>                  attachment_images;      /* unused in default RT. */
+  ngfi::fixed_array<ngfvk_subres_range>         attachment_ranges;      /* unused in default RT. */
   ngfi::fixed_array<ngfvk_attachment_pass_desc> attachment_compat_pass_descs;
   bool                                          is_default;
   bool                                          have_resolve_attachments;
@@ -976,6 +1455,7 @@ static VkBufferUsageFlags get_vk_buffer_usage(uint32_t usage) {
   if (usage & NGF_BUFFER_USAGE_VERTEX_BUFFER) flags |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
   if (usage & NGF_BUFFER_USAGE_TEXEL_BUFFER) flags |= VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT;
   if (usage & NGF_BUFFER_USAGE_STORAGE_BUFFER) flags |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+  if (usage & NGF_BUFFER_USAGE_INDIRECT_BUFFER) flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
   if (usage & NGF_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
     flags |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
   if (usage & NGF_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT)
@@ -1097,6 +1577,52 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL ngfvk_debug_message_callback(
   return VK_FALSE;
 }
 
+// Checks whether a queue family is meant specifically for transfers, i.e. supports neither graphics
+// nor compute. Families that can only copy whole mip levels are skipped, since image writes and
+// copies may address arbitrary regions.
+static bool ngfvk_is_dedicated_transfer_family(const VkQueueFamilyProperties* props) {
+  const VkQueueFlags      flags       = props->queueFlags;
+  const VkExtent3D* const granularity = &props->minImageTransferGranularity;
+  return (flags & VK_QUEUE_TRANSFER_BIT) != 0 &&
+         (flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0 &&
+         granularity->width == 1u && granularity->height == 1u && granularity->depth == 1u;
+}
+
+// Returns the queue that work requested for the given queue type actually runs on. Work for
+// queues that the device doesn't have goes to the graphics queue.
+static ngf_queue_type ngfvk_effective_queue(ngf_queue_type queue) {
+  switch (queue) {
+  case NGF_QUEUE_TYPE_COMPUTE:
+    return _vk.async_compute ? queue : NGF_QUEUE_TYPE_GRAPHICS;
+  case NGF_QUEUE_TYPE_TRANSFER:
+    return _vk.async_transfer ? queue : NGF_QUEUE_TYPE_GRAPHICS;
+  default:
+    return NGF_QUEUE_TYPE_GRAPHICS;
+  }
+}
+
+static uint32_t ngfvk_queue_family_idx(ngf_queue_type queue) {
+  switch (ngfvk_effective_queue(queue)) {
+  case NGF_QUEUE_TYPE_COMPUTE:
+    return _vk.compute_family_idx;
+  case NGF_QUEUE_TYPE_TRANSFER:
+    return _vk.transfer_family_idx;
+  default:
+    return _vk.gfx_family_idx;
+  }
+}
+
+static VkQueue ngfvk_vk_queue(ngf_queue_type queue) {
+  switch (ngfvk_effective_queue(queue)) {
+  case NGF_QUEUE_TYPE_COMPUTE:
+    return _vk.compute_queue;
+  case NGF_QUEUE_TYPE_TRANSFER:
+    return _vk.transfer_queue;
+  default:
+    return _vk.gfx_queue;
+  }
+}
+
 static bool
 ngfvk_query_presentation_support(VkPhysicalDevice phys_dev, uint32_t queue_family_index) {
 #if defined(_WIN32) || defined(_WIN64)
@@ -1128,27 +1654,110 @@ ngfvk_query_presentation_support(VkPhysicalDevice phys_dev, uint32_t queue_famil
 #endif
 }
 
-static void ngfvk_reset_renderpass_cache(ngf_context ctx) {
-  for (size_t p = 0; p < ctx->renderpass_cache.size(); ++p) {
-    ctx->frame_res[ctx->frame_id].retire.append(ctx->renderpass_cache[p].renderpass);
+// Forward declaration for use in ngfvk_retire_resources
+static void ngfvk_reset_desc_pools_list(
+    ngfvk_desc_pools_list*     pools_list,
+    ngf_descriptor_pool_stats* frame_stats);
+
+// Moves objects orphaned by threads without a current context into the given frame's retire
+// lists.
+static void ngfvk_adopt_orphaned_objects(ngfvk_frame_resources* frame_res) {
+  ngfvk_orphaned_objects* orphans = &_vk.orphans;
+  pthread_mutex_lock(&orphans->mu);
+  for (VkPipeline p : orphans->pipelines) { frame_res->retire.append(p); }
+  for (VkPipelineLayout l : orphans->pipeline_layouts) { frame_res->retire.append(l); }
+  for (VkDescriptorSetLayout l : orphans->set_layouts) { frame_res->retire.append(l); }
+  for (VkDescriptorUpdateTemplate t : orphans->update_templates) { frame_res->retire.append(t); }
+  for (VkRenderPass rp : orphans->render_passes) { frame_res->retire.append(rp); }
+  orphans->pipelines.clear();
+  orphans->pipeline_layouts.clear();
+  orphans->set_layouts.clear();
+  orphans->update_templates.clear();
+  orphans->render_passes.clear();
+  pthread_mutex_unlock(&orphans->mu);
+}
+
+// Immediately destroys orphaned objects. Only safe once the device is idle.
+static void ngfvk_destroy_orphaned_objects() {
+  ngfvk_orphaned_objects* orphans = &_vk.orphans;
+  pthread_mutex_lock(&orphans->mu);
+  for (VkPipeline p : orphans->pipelines) { vkDestroyPipeline(_vk.device, p, NULL); }
+  for (VkPipelineLayout l : orphans->pipeline_layouts) {
+    vkDestroyPipelineLayout(_vk.device, l, NULL);
+  }
+  for (VkDescriptorSetLayout l : orphans->set_layouts) {
+    vkDestroyDescriptorSetLayout(_vk.device, l, NULL);
+  }
+  for (VkDescriptorUpdateTemplate t : orphans->update_templates) {
+    vkDestroyDescriptorUpdateTemplate(_vk.device, t, NULL);
+  }
+  for (VkRenderPass rp : orphans->render_passes) { vkDestroyRenderPass(_vk.device, rp, NULL); }
+  orphans->pipelines.clear();
+  orphans->pipeline_layouts.clear();
+  orphans->set_layouts.clear();
+  orphans->update_templates.clear();
+  orphans->render_passes.clear();
+  pthread_mutex_unlock(&orphans->mu);
+}
+
+// Waits up to the given number of nanoseconds for the frame with the given serial number to finish
+// executing on the GPU. Frames that haven't been submitted yet never finish.
+static VkResult ngfvk_wait_frame_serial(ngf_context ctx, uint64_t serial, uint64_t timeout_ns) {
+  if (serial <= ctx->completed_frame_serial) { return VK_SUCCESS; }
+
+  // Frame resources are only reused once the frame that last used them has finished, so the
+  // serial recorded by the frame's resources tells whether it is still pending.
+  ngfvk_frame_resources* frame_res = &ctx->frame_res[serial % ctx->max_inflight_frames];
+  if (frame_res->serial < serial) { return VK_TIMEOUT; }
+
+  VkResult result = VK_SUCCESS;
+  if (frame_res->serial == serial) {
+    if (ctx->queue_timelines[NGF_QUEUE_TYPE_GRAPHICS] != VK_NULL_HANDLE) {
+      // The frame is done once its last submission to each of the queues is.
+      VkSemaphore timelines[NGF_QUEUE_TYPE_COUNT];
+      uint64_t    values[NGF_QUEUE_TYPE_COUNT];
+      uint32_t    ntimelines = 0u;
+      for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+        if (frame_res->queue_timeline_values[q] == 0u) { continue; }
+        timelines[ntimelines] = ctx->queue_timelines[q];
+        values[ntimelines++]  = frame_res->queue_timeline_values[q];
+      }
+      const VkSemaphoreWaitInfo wait_info = {
+          .sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+          .pNext          = NULL,
+          .flags          = 0u,
+          .semaphoreCount = ntimelines,
+          .pSemaphores    = timelines,
+          .pValues        = values};
+      result = vkWaitSemaphores(_vk.device, &wait_info, timeout_ns);
+    } else if (frame_res->nwait_fences > 0u) {
+      result = vkWaitForFences(
+          _vk.device,
+          frame_res->nwait_fences,
+          frame_res->fences,
+          VK_TRUE,
+          timeout_ns);
+    }
   }
-  ctx->renderpass_cache.clear();
+  if (result == VK_SUCCESS) { ctx->completed_frame_serial = serial; }
+  return result;
 }
 
-// Forward declaration for use in ngfvk_retire_resources
-static void ngfvk_reset_desc_pools_list(ngfvk_desc_pools_list* superpool);
+// Finds the serial number of the frame that the given token was generated for. Tokens without a
+// serial resolve to the latest frame that used the same frame resources.
+static uint64_t ngfvk_frame_token_serial(ngf_context ctx, ngf_frame_token token) {
+  const uint32_t token_serial = ngfi_frame_serial(token);
+  if (token_serial == 0u) {
+    return ngfi_frame_id(token) == ctx->frame_id
+               ? ctx->frame_serial
+               : ctx->frame_res[ngfi_frame_id(token)].serial;
+  }
+  return ctx->frame_serial - (uint32_t)((uint32_t)ctx->frame_serial - token_serial);
+}
 
+// Releases the resources retired by a frame. The frame must have finished executing on the GPU.
 static void ngfvk_retire_resources(ngfvk_frame_resources* frame_res) {
   if (frame_res->nwait_fences > 0u) {
-    VkResult wait_status = VK_SUCCESS;
-    do {
-      wait_status = vkWaitForFences(
-          _vk.device,
-          frame_res->nwait_fences,
-          frame_res->fences,
-          VK_TRUE,
-          0x3B9ACA00ul);
-    } while (wait_status == VK_TIMEOUT);
     vkResetFences(_vk.device, frame_res->nwait_fences, frame_res->fences);
     frame_res->nwait_fences = 0;
   }
@@ -1171,6 +1780,12 @@ static void ngfvk_retire_resources(ngfvk_frame_resources* frame_res) {
   }
   frame_res->retire.clear<VkDescriptorSetLayout>();
 
+  // Destroy retired descriptor update templates
+  for (VkDescriptorUpdateTemplate t : frame_res->retire.list<VkDescriptorUpdateTemplate>()) {
+    vkDestroyDescriptorUpdateTemplate(_vk.device, t, NULL);
+  }
+  frame_res->retire.clear<VkDescriptorUpdateTemplate>();
+
   // Free retired command buffers
   for (const ngfvk_cmd_buf_with_pool& cb : frame_res->retire.list<ngfvk_cmd_buf_with_pool>()) {
     vkFreeCommandBuffers(_vk.device, cb.cmd_pool, 1u, &cb.cmd_buf);
@@ -1218,18 +1833,42 @@ static void ngfvk_retire_resources(ngfvk_frame_resources* frame_res) {
   for (ngf_buffer buf : frame_res->retire.list<ngf_buffer>()) { NGFI_FREE(buf); }
   frame_res->retire.clear<ngf_buffer>();
 
+  // Hand released bindless heap indices back to the heap.
+  pthread_mutex_lock(&_vk.bindless_heap.mu);
+  for (const ngfvk_bindless_slot& s : frame_res->retire.list<ngfvk_bindless_slot>()) {
+    _vk.bindless_heap.slots[s.type].free_indices.push_back(s.index);
+  }
+  pthread_mutex_unlock(&_vk.bindless_heap.mu);
+  frame_res->retire.clear<ngfvk_bindless_slot>();
+  frame_res->upload_buffer_offset = 0u;
+  for (ngfvk_frame_query_pool& pool : frame_res->query_pools) {
+    pool.nqueries       = 0u;
+    pool.nqueries_reset = 0u;
+  }
+  for (uint32_t i = 0u; i < frame_res->event_pool.nevents; ++i) {
+    vkResetEvent(_vk.device, frame_res->event_pool.events[i]);
+  }
+  frame_res->event_pool.nevents = 0u;
+
   // Reset retired descriptor pool lists
+  memset(&frame_res->desc_pool_stats, 0, sizeof(frame_res->desc_pool_stats));
   for (ngfvk_desc_pools_list* dpl : frame_res->retire.list<ngfvk_desc_pools_list*>()) {
-    ngfvk_reset_desc_pools_list(dpl);
+    ngfvk_reset_desc_pools_list(dpl, &frame_res->desc_pool_stats);
   }
   frame_res->retire.clear<ngfvk_desc_pools_list*>();
 }
 
-static ngf_error
-ngfvk_create_desc_superpool(ngfvk_desc_superpool* superpool, uint8_t pools_lists, uint16_t ctx_id) {
+static ngf_error ngfvk_create_desc_superpool(
+    ngfvk_desc_superpool*           superpool,
+    uint8_t                         pools_lists,
+    uint16_t                        ctx_id,
+    const ngf_descriptor_pool_info* config) {
   superpool->ctx_id      = ctx_id;
   superpool->pools_lists = ngfi::fixed_array<ngfvk_desc_pools_list> {pools_lists};
-  memset(superpool->pools_lists.data(), 0, pools_lists * sizeof(ngfvk_desc_pools_list));
+  for (auto& pools_list : superpool->pools_lists) {
+    pools_list.set_cache.storage.set_block_size(4096u);
+    pools_list.config = *config;
+  }
   return NGF_ERROR_OK;
 }
 
@@ -1265,15 +1904,195 @@ static ngfvk_desc_pools_list* ngfvk_find_desc_pools_list(ngf_frame_token token)
         .pools_lists = ngfi::fixed_array<ngfvk_desc_pools_list> {}};
     CURRENT_CONTEXT->desc_superpools.emplace_back(ngfi::move(new_superpool));
     superpool = &CURRENT_CONTEXT->desc_superpools.back();
-    ngfvk_create_desc_superpool(superpool, nframes, ctx_id);
+    ngfvk_create_desc_superpool(superpool, nframes, ctx_id, &CURRENT_CONTEXT->desc_pool_info);
   }
 
   return &superpool->pools_lists[frame_id];
 }
 
+// Returns the data of a descriptor referencing the appropriate dummy resource for the given
+// binding.
+static ngfvk_desc_payload_slot ngfvk_dummy_desc_payload_slot(const ngfvk_desc_binding* binding) {
+  ngfvk_desc_payload_slot      slot;
+  const ngfvk_dummy_resources* dummy_res = &_vk.dummy_res;
+  memset(&slot, 0, sizeof(slot));
+  switch (binding->type) {
+  case VK_DESCRIPTOR_TYPE_SAMPLER:
+    slot.image = dummy_res->samp_info;
+    break;
+  case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    slot.image =
+        binding->is_multilayered_image ? dummy_res->imgsamp_arr_info : dummy_res->imgsamp_info;
+    break;
+  case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+  case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    if (!binding->is_cubemap) {
+      slot.image = binding->is_multilayered_image ? dummy_res->img_arr_info : dummy_res->img_info;
+    } else {
+      slot.image =
+          binding->is_multilayered_image ? dummy_res->cube_arr_info : dummy_res->cube_info;
+    }
+    break;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    slot.buffer = dummy_res->buf_info;
+    break;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    slot.texel_buffer_view = dummy_res->tbuf->vk_buf_view;
+    break;
+  case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+    slot.accel_struct = dummy_res->dummy_accel_struct;
+    break;
+  default:
+    assert(false);
+  }
+  return slot;
+}
+
+// Returns how much of an adaptive pool capacity target remains to be provided given the amount
+// that was already allocated in the current frame, or `fallback` if the target has been exceeded.
+// Nothing is provided for what previous frames haven't used at all.
+static uint32_t ngfvk_desc_pool_remaining_capacity(
+    uint32_t high_water,
+    uint32_t frame_usage,
+    uint32_t fallback) {
+  if (high_water == 0u) { return 0u; }
+  // Leave some headroom over the high-water mark to absorb small fluctuations in usage.
+  const uint32_t target = high_water + high_water / 4u;
+  return target > frame_usage ? target - frame_usage : fallback;
+}
+
+// Determines the capacity of a new descriptor pool for the given pools list. The pool is always
+// able to accommodate at least one set with the given layout.
+static ngfvk_desc_pool_capacity ngfvk_desc_pool_capacity_for(
+    const ngfvk_desc_pools_list* pools,
+    const ngfvk_desc_set_layout* set_layout) {
+  const ngf_descriptor_pool_info* config       = &pools->config;
+  const bool                      have_history = config->adaptive && pools->high_water.sets > 0u;
+  ngfvk_desc_pool_capacity        capacity;
+  if (have_history) {
+    capacity.sets = ngfvk_desc_pool_remaining_capacity(
+        pools->high_water.sets,
+        pools->frame_usage.sets,
+        config->sets_per_pool);
+    for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+      capacity.descriptors[i] = ngfvk_desc_pool_remaining_capacity(
+          pools->high_water.descriptors[i],
+          pools->frame_usage.descriptors[i],
+          config->descriptors_per_pool[i]);
+    }
+  } else {
+    capacity.sets = config->sets_per_pool;
+    for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+      capacity.descriptors[i] = config->descriptors_per_pool[i];
+    }
+  }
+  capacity.sets = NGFI_MAX(capacity.sets, 1u);
+  for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+    capacity.descriptors[i] = NGFI_MAX(capacity.descriptors[i], set_layout->counts[i]);
+  }
+  return capacity;
+}
+
+// Fills in writes that point the descriptors not listed in `bound` at dummy resources. Each run of
+// consecutive unbound array elements within a binding gets a single write. `writes` must have room
+// for as many writes as there are descriptors in the set. Returns the number of writes.
+static uint32_t ngfvk_dummy_desc_writes(
+    const ngfvk_desc_set_layout* set_layout,
+    const ngfvk_desc_write_key*  bound,
+    uint32_t                     nbound,
+    VkDescriptorSet              set,
+    VkWriteDescriptorSet*        writes) {
+  auto first_desc_in_binding = ngfi::tmp_alloc<uint32_t>(set_layout->binding_properties.size());
+  uint32_t ndescs            = 0u;
+  for (uint32_t b = 0u; b < set_layout->binding_properties.size(); ++b) {
+    first_desc_in_binding[b] = ndescs;
+    ndescs += set_layout->binding_properties[b].ndescs_in_binding;
+  }
+  auto desc_is_bound = ngfi::tmp_alloc<bool>(ndescs);
+  if (ndescs > 0u) { memset(desc_is_bound, 0, ndescs * sizeof(bool)); }
+  for (uint32_t w = 0u; w < nbound; ++w) {
+    const ngfvk_desc_write_key* bound_desc = &bound[w];
+    if (bound_desc->binding < set_layout->binding_properties.size() &&
+        bound_desc->array_index <
+            set_layout->binding_properties[bound_desc->binding].ndescs_in_binding) {
+      desc_is_bound[first_desc_in_binding[bound_desc->binding] + bound_desc->array_index] = true;
+    }
+  }
+
+  uint32_t num_writes = 0u;
+  for (uint32_t b = 0u; b < set_layout->binding_properties.size(); ++b) {
+    const ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    if (binding->type == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
+    const bool* binding_is_bound = &desc_is_bound[first_desc_in_binding[b]];
+    for (uint32_t array_idx = 0u; array_idx < binding->ndescs_in_binding;) {
+      if (binding_is_bound[array_idx]) {
+        ++array_idx;
+        continue;
+      }
+      uint32_t run_length = 1u;
+      while (array_idx + run_length < binding->ndescs_in_binding &&
+             !binding_is_bound[array_idx + run_length]) {
+        ++run_length;
+      }
+
+      VkWriteDescriptorSet* desc_w = &writes[num_writes++];
+      desc_w->sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+      desc_w->pNext                = NULL;
+      desc_w->descriptorCount      = run_length;
+      desc_w->descriptorType       = binding->type;
+      desc_w->dstArrayElement      = array_idx;
+      desc_w->dstBinding           = b;
+      desc_w->dstSet               = set;
+
+      const ngfvk_desc_payload_slot dummy = ngfvk_dummy_desc_payload_slot(binding);
+      switch (desc_w->descriptorType) {
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: {
+        auto buf_infos = ngfi::tmp_alloc<VkDescriptorBufferInfo>(run_length);
+        for (uint32_t i = 0u; i < run_length; ++i) { buf_infos[i] = dummy.buffer; }
+        desc_w->pBufferInfo = buf_infos;
+        break;
+      }
+      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER: {
+        auto buf_views = ngfi::tmp_alloc<VkBufferView>(run_length);
+        for (uint32_t i = 0u; i < run_length; ++i) { buf_views[i] = dummy.texel_buffer_view; }
+        desc_w->pTexelBufferView = buf_views;
+        break;
+      }
+      case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+        auto dummy_accel_structs = ngfi::tmp_alloc<VkAccelerationStructureKHR>(run_length);
+        for (uint32_t i = 0u; i < run_length; ++i) { dummy_accel_structs[i] = dummy.accel_struct; }
+        auto dummy_accel_info   = ngfi::tmp_alloc<VkWriteDescriptorSetAccelerationStructureKHR>();
+        dummy_accel_info->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+        dummy_accel_info->pNext = NULL;
+        dummy_accel_info->accelerationStructureCount = run_length;
+        dummy_accel_info->pAccelerationStructures    = dummy_accel_structs;
+        desc_w->pNext                                = dummy_accel_info;
+        break;
+      }
+      default: {
+        auto image_infos = ngfi::tmp_alloc<VkDescriptorImageInfo>(run_length);
+        for (uint32_t i = 0u; i < run_length; ++i) { image_infos[i] = dummy.image; }
+        desc_w->pImageInfo = image_infos;
+        break;
+      }
+      }
+      array_idx += run_length;
+    }
+  }
+  return num_writes;
+}
+
+// Allocates a descriptor set with the given layout. `bound` lists the descriptors that the caller
+// is going to write into the new set.
 static VkDescriptorSet ngfvk_desc_pools_list_allocate_set(
     ngfvk_desc_pools_list*       pools,
-    const ngfvk_desc_set_layout* set_layout) {
+    const ngfvk_desc_set_layout* set_layout,
+    const ngfvk_desc_write_key*  bound,
+    uint32_t                     nbound) {
   // Ensure we have an active desriptor pool that is able to service the
   // request.
   const bool have_active_pool    = (pools->active_pool != NULL);
@@ -1287,22 +2106,29 @@ static VkDescriptorSet ngfvk_desc_pools_list_allocate_set(
     ngfvk_desc_pool_capacity*       usage    = &pool->utilization;
     for (unsigned i = 0; !fresh_pool_required && i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
       fresh_pool_required |=
-          (usage->descriptors[i] + set_layout->counts[i] >= capacity->descriptors[i]);
+          (usage->descriptors[i] + set_layout->counts[i] > capacity->descriptors[i]);
     }
-    fresh_pool_required |= (usage->sets + 1u >= capacity->sets);
+    fresh_pool_required |= (usage->sets + 1u > capacity->sets);
   }
   if (fresh_pool_required) {
     if (!have_active_pool || pools->active_pool->next == NULL) {
-      // TODO: make this tweakable
-      ngfvk_desc_pool_capacity capacity;
-      capacity.sets = 100u;
-      for (int i = 0; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) capacity.descriptors[i] = 100u;
+      const ngfvk_desc_pool_capacity capacity = ngfvk_desc_pool_capacity_for(pools, set_layout);
 
-      // Prepare descriptor counts.
-      auto vk_pool_sizes = ngfi::tmp_alloc<VkDescriptorPoolSize>(NGF_DESCRIPTOR_TYPE_COUNT);
+      // Prepare descriptor counts, leaving out the types that the pool has no capacity for.
+      // Uniform buffers with and without dynamic offsets share a budget, which the pool provides
+      // for both descriptor types.
+      auto vk_pool_sizes = ngfi::tmp_alloc<VkDescriptorPoolSize>(NGF_DESCRIPTOR_TYPE_COUNT + 1u);
+      uint32_t npool_sizes = 0u;
       for (unsigned i = 0; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
-        vk_pool_sizes[i].descriptorCount = capacity.descriptors[i];
-        vk_pool_sizes[i].type            = get_vk_descriptor_type((ngf_descriptor_type)i);
+        if (capacity.descriptors[i] == 0u) continue;
+        vk_pool_sizes[npool_sizes].descriptorCount = capacity.descriptors[i];
+        vk_pool_sizes[npool_sizes].type = get_vk_descriptor_type((ngf_descriptor_type)i);
+        ++npool_sizes;
+        if (i == NGF_DESCRIPTOR_UNIFORM_BUFFER) {
+          vk_pool_sizes[npool_sizes].descriptorCount = capacity.descriptors[i];
+          vk_pool_sizes[npool_sizes].type            = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+          ++npool_sizes;
+        }
       }
 
       // Prepare a createinfo structure for the new pool.
@@ -1311,7 +2137,7 @@ static VkDescriptorSet ngfvk_desc_pools_list_allocate_set(
           .pNext         = NULL,
           .flags         = 0u,
           .maxSets       = capacity.sets,
-          .poolSizeCount = NGF_DESCRIPTOR_TYPE_COUNT,
+          .poolSizeCount = npool_sizes,
           .pPoolSizes    = vk_pool_sizes};
 
       // Create the new pool.
@@ -1330,6 +2156,7 @@ static VkDescriptorSet ngfvk_desc_pools_list_allocate_set(
           assert(false);
         }
         pools->active_pool = new_pool;
+        pools->npools_created++;
       } else {
         NGFI_FREE(new_pool);
         assert(false);
@@ -1356,116 +2183,748 @@ static VkDescriptorSet ngfvk_desc_pools_list_allocate_set(
   // Update usage counters for the active descriptor pool.
   for (unsigned i = 0; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
     pool->utilization.descriptors[i] += set_layout->counts[i];
+    pools->frame_usage.descriptors[i] += set_layout->counts[i];
   }
   pool->utilization.sets++;
+  pools->frame_usage.sets++;
 
-  // Bind dummy resources.
-  auto     dummy_writes = ngfi::tmp_alloc<VkWriteDescriptorSet>(set_layout->nall_descs);
-  uint32_t num_writes   = 0u;
-  for (uint32_t b = 0u; b < set_layout->binding_properties.size(); ++b) {
-    if (set_layout->binding_properties[b].type == VK_DESCRIPTOR_TYPE_MAX_ENUM) continue;
-    for (uint32_t array_idx = 0u; array_idx < set_layout->binding_properties[b].ndescs_in_binding;
-         ++array_idx) {
-      VkWriteDescriptorSet* desc_w = &dummy_writes[num_writes++];
-      desc_w->sType                = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-      desc_w->pNext                = NULL;
-      desc_w->descriptorCount      = 1u;
-      desc_w->descriptorType       = set_layout->binding_properties[b].type;
-      desc_w->dstArrayElement      = array_idx;
-      desc_w->dstBinding           = b;
-      desc_w->dstSet               = result;
+  // Descriptors that are never written don't need to be valid if the set layout permits partially
+  // bound bindings. Sets updated with a template get all of their descriptors written at once, so
+  // no separate dummy writes are required for those either.
+  if (set_layout->is_partially_bound || set_layout->vk_update_template != VK_NULL_HANDLE) {
+    return result;
+  }
 
-      const bool is_multilayered_image = set_layout->binding_properties[b].is_multilayered_image;
-      const bool is_cubemap            = set_layout->binding_properties[b].is_cubemap;
+  // Bind dummy resources to the descriptors that the caller is not going to write, so that none of
+  // them are left undefined.
+  auto           dummy_writes = ngfi::tmp_alloc<VkWriteDescriptorSet>(set_layout->nall_descs);
+  const uint32_t num_writes =
+      ngfvk_dummy_desc_writes(set_layout, bound, nbound, result, dummy_writes);
+  if (num_writes > 0u) { vkUpdateDescriptorSets(_vk.device, num_writes, dummy_writes, 0, NULL); }
 
-      switch (desc_w->descriptorType) {
-      case VK_DESCRIPTOR_TYPE_SAMPLER:
-        desc_w->pImageInfo = &_vk.dummy_res.samp_info;
-        break;
-      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-        desc_w->pImageInfo =
-            is_multilayered_image ? &_vk.dummy_res.imgsamp_arr_info : &_vk.dummy_res.imgsamp_info;
-        break;
-      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-        if (!is_cubemap) {
-          desc_w->pImageInfo =
-              is_multilayered_image ? &_vk.dummy_res.img_arr_info : &_vk.dummy_res.img_info;
-        } else {
-          desc_w->pImageInfo =
-              is_multilayered_image ? &_vk.dummy_res.cube_arr_info : &_vk.dummy_res.cube_info;
-        }
-        break;
-      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-        desc_w->pBufferInfo = &_vk.dummy_res.buf_info;
-        break;
-      case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-        desc_w->pTexelBufferView = &_vk.dummy_res.tbuf->vk_buf_view;
-        break;
-      case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
-        auto dummy_accel_info   = ngfi::tmp_alloc<VkWriteDescriptorSetAccelerationStructureKHR>();
-        dummy_accel_info->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-        dummy_accel_info->pNext = NULL;
-        dummy_accel_info->accelerationStructureCount = 1;
-        dummy_accel_info->pAccelerationStructures    = &_vk.dummy_res.dummy_accel_struct;
-        desc_w->pNext                                = dummy_accel_info;
-        break;
-      }
-      default:
-        assert(false);
-      }
+  return result;
+}
+
+// Assigns each descriptor in the set a slot in the update template payload, in binding order.
+// Returns the total number of slots.
+static uint32_t ngfvk_assign_desc_payload_slots(ngfvk_desc_set_layout* set_layout) {
+  uint32_t nslots = 0u;
+  for (uint32_t b = 0u; b < set_layout->binding_properties.size(); ++b) {
+    ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    binding->first_payload_slot = nslots;
+    nslots += binding->ndescs_in_binding;
+  }
+  return nslots;
+}
+
+// Switches the set's non-array uniform buffer bindings over to dynamic offsets, in binding order,
+// up to `max_dynamic_offsets` of them. Rebinding those with a different offset into the same buffer
+// then reuses the descriptor set and only changes the offsets passed when binding it.
+static void ngfvk_assign_dynamic_offset_slots(
+    ngfvk_desc_set_layout* set_layout,
+    uint32_t               max_dynamic_offsets) {
+  for (uint32_t b = 0u;
+       b < set_layout->binding_properties.size() &&
+       set_layout->ndynamic_offsets < max_dynamic_offsets;
+       ++b) {
+    ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    if (binding->type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || binding->ndescs_in_binding != 1u) {
+      continue;
     }
+    binding->type               = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    binding->dynamic_offset_idx = set_layout->ndynamic_offsets++;
   }
-  vkUpdateDescriptorSets(_vk.device, num_writes, dummy_writes, 0, NULL);
+}
 
-  return result;
+// Prepares the dummy payload and creates the update template for a newly created shared set
+// layout. Payload slots must have already been assigned. If the template can't be created, sets
+// with this layout fall back to individual descriptor writes.
+static void ngfvk_create_desc_update_template(
+    ngfvk_shared_set_layout*     shared,
+    const ngfvk_desc_set_layout* set_layout) {
+  const uint32_t nbindings = (uint32_t)set_layout->binding_properties.size();
+  auto           entries   = ngfi::tmp_alloc<VkDescriptorUpdateTemplateEntry>(nbindings);
+  uint32_t       nentries  = 0u;
+  uint32_t       nslots    = 0u;
+  for (uint32_t b = 0u; b < nbindings; ++b) {
+    const ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    if (binding->ndescs_in_binding == 0u) continue;
+    VkDescriptorUpdateTemplateEntry* entry = &entries[nentries++];
+    entry->dstBinding                      = b;
+    entry->dstArrayElement                 = 0u;
+    entry->descriptorCount                 = binding->ndescs_in_binding;
+    entry->descriptorType                  = binding->type;
+    entry->offset = binding->first_payload_slot * sizeof(ngfvk_desc_payload_slot);
+    entry->stride = sizeof(ngfvk_desc_payload_slot);
+    nslots        = binding->first_payload_slot + binding->ndescs_in_binding;
+  }
+  if (nentries == 0u || vkCreateDescriptorUpdateTemplate == NULL) { return; }
+
+  shared->dummy_payload = ngfi::fixed_array<ngfvk_desc_payload_slot> {nslots};
+  if (shared->dummy_payload.data() == NULL) { return; }
+  for (uint32_t b = 0u; b < nbindings; ++b) {
+    const ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    if (binding->ndescs_in_binding == 0u) continue;
+    const ngfvk_desc_payload_slot dummy = ngfvk_dummy_desc_payload_slot(binding);
+    for (uint32_t i = 0u; i < binding->ndescs_in_binding; ++i) {
+      shared->dummy_payload[binding->first_payload_slot + i] = dummy;
+    }
+  }
+
+  const VkDescriptorUpdateTemplateCreateInfo vk_template_info = {
+      .sType                      = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .pNext                      = NULL,
+      .flags                      = 0u,
+      .descriptorUpdateEntryCount = nentries,
+      .pDescriptorUpdateEntries   = entries,
+      .templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout        = shared->vk_handle,
+      .pipelineBindPoint          = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .pipelineLayout             = VK_NULL_HANDLE,
+      .set                        = 0u};
+  if (vkCreateDescriptorUpdateTemplate(
+          _vk.device,
+          &vk_template_info,
+          NULL,
+          &shared->vk_update_template) != VK_SUCCESS) {
+    shared->vk_update_template = VK_NULL_HANDLE;
+  }
 }
-static ngf_error ngfvk_create_vk_image_view(
-    VkImage         image,
-    VkImageViewType image_type,
-    VkFormat        image_format,
-    uint32_t        nmips,
-    uint32_t        nlayers,
-    VkImageView*    result) {
-  const bool is_depth    = ngfvk_format_is_depth(image_format);
-  const bool is_stencil  = ngfvk_format_is_stencil(image_format);
-  const auto stencil_bit = is_stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : ((VkImageAspectFlagBits)0);
-  const auto aspect_mask = (VkImageAspectFlags)(is_depth ? (VK_IMAGE_ASPECT_DEPTH_BIT | stencil_bit)
-                                                         : VK_IMAGE_ASPECT_COLOR_BIT);
 
-  const VkImageViewCreateInfo image_view_info = {
-      .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-      .pNext    = NULL,
-      .flags    = 0u,
-      .image    = image,
-      .viewType = image_type,
-      .format   = image_format,
-      .components =
-          {.r = VK_COMPONENT_SWIZZLE_IDENTITY,
-           .g = VK_COMPONENT_SWIZZLE_IDENTITY,
-           .b = VK_COMPONENT_SWIZZLE_IDENTITY,
-           .a = VK_COMPONENT_SWIZZLE_IDENTITY},
-      .subresourceRange = {
-          .aspectMask     = aspect_mask,
-          .baseMipLevel   = 0u,
-          .levelCount     = nmips,
-          .baseArrayLayer = 0u,
-          .layerCount     = nlayers}};
-  const VkResult create_view_vkerr = vkCreateImageView(_vk.device, &image_view_info, NULL, result);
-  if (create_view_vkerr != VK_SUCCESS) {
-    return NGF_ERROR_INVALID_OPERATION;
-  } else {
-    return NGF_ERROR_OK;
+// Disposes of a Vulkan object once the GPU is done with it: via the current context's retire
+// lists, or via the orphan list if the calling thread has no current context.
+template<class T> static void ngfvk_retire_or_orphan(T handle, ngfi::array<T>* orphan_list) {
+  if (handle == VK_NULL_HANDLE) return;
+  if (CURRENT_CONTEXT != NULL) {
+    CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].retire.append(handle);
+    return;
   }
+  pthread_mutex_lock(&_vk.orphans.mu);
+  orphan_list->push_back(handle);
+  pthread_mutex_unlock(&_vk.orphans.mu);
 }
 
-static VkResult ngfvk_renderpass_from_attachment_descs(
-    uint32_t                          nattachments,
-    const ngf_attachment_description* attachment_descs,
-    const ngfvk_attachment_pass_desc* attachment_compat_pass_descs,
-    VkRenderPass*                     result) {
-  auto     vk_attachment_descs        = ngfi::tmp_alloc<VkAttachmentDescription>(nattachments);
+// Hashes the given words, starting from a seed that captures whatever else identifies the key,
+// for use as a key in the caches.
+template<class W> static uint64_t ngfvk_hash_words(uint64_t seed, const W* words, size_t nwords) {
+  uint64_t hash = ngfi::detail::fmix64(seed ^ 0x9e3779b97f4a7c15ull);
+  for (size_t w = 0u; w < nwords; ++w) {
+    hash = ngfi::detail::fmix64(ngfi::detail::rotl64(hash, 27) ^ (uint64_t)words[w]);
+  }
+  // The all-ones value is reserved by the hashtable to mark empty slots.
+  return hash == ngfi::hashtable<void*>::EMPTY_KEY ? 0u : hash;
+}
+
+static uint64_t ngfvk_set_layout_key_hash(
+    const ngfvk_set_layout_key_binding* key,
+    uint32_t                            n,
+    bool                                is_push,
+    bool                                is_partially_bound) {
+  const uint64_t flags = ((uint64_t)is_push << 32u) | ((uint64_t)is_partially_bound << 33u);
+  return ngfvk_hash_words(
+      (uint64_t)n | flags,
+      (const uint32_t*)key,
+      n * sizeof(ngfvk_set_layout_key_binding) / sizeof(uint32_t));
+}
+
+static uint64_t
+ngfvk_pipeline_layout_key_hash(ngfvk_shared_set_layout* const* set_layouts, uint32_t n) {
+  return ngfvk_hash_words((uint64_t)n, (const uintptr_t*)set_layouts, n);
+}
+
+// Removes an entry from its hash chain.
+template<class E> static void ngfvk_unlink_cache_entry(ngfi::hashtable<E*>* table, E* e) {
+  E** head = table->get(e->hash);
+  for (E** link = head; link != NULL && *link != NULL; link = &(*link)->next) {
+    if (*link == e) {
+      *link = e->next;
+      break;
+    }
+  }
+}
+
+// Adds a new entry to the front of its hash chain.
+template<class E> static bool ngfvk_link_cache_entry(ngfi::hashtable<E*>* table, E* e) {
+  bool is_new = false;
+  E**  head   = table->get_or_insert(e->hash, NULL, is_new);
+  if (head == NULL) return false;
+  e->next = *head;
+  *head   = e;
+  return true;
+}
+
+// Drops a reference to a shared set layout, scheduling its destruction if it was the last one.
+// Must be called with the layout cache lock held.
+static void ngfvk_release_shared_set_layout_locked(ngfvk_shared_set_layout* shared) {
+  if (--shared->refcount > 0u) return;
+  ngfvk_unlink_cache_entry(&_vk.layout_cache.set_layouts, shared);
+  ngfvk_retire_or_orphan(shared->vk_update_template, &_vk.orphans.update_templates);
+  ngfvk_retire_or_orphan(shared->vk_handle, &_vk.orphans.set_layouts);
+  ngfi::free(shared);
+}
+
+static void ngfvk_release_shared_set_layouts(ngfvk_shared_set_layout* const* shared, uint32_t n) {
+  pthread_mutex_lock(&_vk.layout_cache.mu);
+  for (uint32_t s = 0u; s < n; ++s) { ngfvk_release_shared_set_layout_locked(shared[s]); }
+  pthread_mutex_unlock(&_vk.layout_cache.mu);
+}
+
+// Drops a reference to a shared pipeline layout, scheduling its destruction (and releasing its set
+// layouts) if it was the last one.
+static void ngfvk_release_shared_pipeline_layout(ngfvk_shared_pipeline_layout* shared) {
+  pthread_mutex_lock(&_vk.layout_cache.mu);
+  if (--shared->refcount == 0u) {
+    ngfvk_unlink_cache_entry(&_vk.layout_cache.pipeline_layouts, shared);
+    ngfvk_retire_or_orphan(shared->vk_handle, &_vk.orphans.pipeline_layouts);
+    for (ngfvk_shared_set_layout* set_layout : shared->set_layouts) {
+      ngfvk_release_shared_set_layout_locked(set_layout);
+    }
+    ngfi::free(shared);
+  }
+  pthread_mutex_unlock(&_vk.layout_cache.mu);
+}
+
+// Returns a reference to a shared set layout matching the given pipeline-specific one, creating it
+// if necessary, and points the pipeline-specific layout to its Vulkan objects. Payload slots must
+// have already been assigned. Returns NULL on failure.
+static ngfvk_shared_set_layout* ngfvk_acquire_shared_set_layout(
+    ngfvk_desc_set_layout*                 set_layout,
+    const VkDescriptorSetLayoutCreateInfo* vk_info) {
+  const uint32_t nbindings = (uint32_t)set_layout->binding_properties.size();
+  auto           key       = ngfi::tmp_alloc<ngfvk_set_layout_key_binding>(nbindings);
+  for (uint32_t b = 0u; b < nbindings; ++b) {
+    const ngfvk_desc_binding* binding = &set_layout->binding_properties[b];
+    key[b].type                       = (uint32_t)binding->type;
+    key[b].ndescs                     = binding->ndescs_in_binding;
+    key[b].image_flags =
+        (binding->is_multilayered_image ? 1u : 0u) | (binding->is_cubemap ? 2u : 0u);
+  }
+  const uint64_t hash = ngfvk_set_layout_key_hash(
+      key,
+      nbindings,
+      set_layout->is_push,
+      set_layout->is_partially_bound);
+
+  ngfvk_layout_cache* cache = &_vk.layout_cache;
+  pthread_mutex_lock(&cache->mu);
+  ngfvk_shared_set_layout** head   = cache->set_layouts.get(hash);
+  ngfvk_shared_set_layout*  shared = NULL;
+  for (ngfvk_shared_set_layout* e = head ? *head : NULL; e; e = e->next) {
+    if (e->key.size() == nbindings && e->is_push == set_layout->is_push &&
+        e->is_partially_bound == set_layout->is_partially_bound &&
+        (nbindings == 0u ||
+         memcmp(e->key.data(), key, nbindings * sizeof(ngfvk_set_layout_key_binding)) == 0)) {
+      shared = e;
+      break;
+    }
+  }
+  if (shared == NULL) {
+    shared = ngfi::alloc<ngfvk_shared_set_layout>();
+    if (shared != NULL) {
+      shared->hash               = hash;
+      shared->refcount           = 0u;
+      shared->is_push            = set_layout->is_push;
+      shared->is_partially_bound = set_layout->is_partially_bound;
+      shared->key = ngfi::fixed_array<ngfvk_set_layout_key_binding> {nbindings};
+      const bool ok =
+          (nbindings == 0u || shared->key.data() != NULL) &&
+          vkCreateDescriptorSetLayout(_vk.device, vk_info, NULL, &shared->vk_handle) == VK_SUCCESS;
+      if (ok) {
+        if (nbindings > 0u) {
+          memcpy(shared->key.data(), key, nbindings * sizeof(ngfvk_set_layout_key_binding));
+        }
+        // Update templates for push descriptors are tied to a pipeline layout, so push descriptor
+        // sets are always written with individual descriptor writes. Templates write every
+        // descriptor in the set, so partially bound sets are better off with individual writes of
+        // just the bound descriptors as well.
+        if (!set_layout->is_push && !set_layout->is_partially_bound) {
+          ngfvk_create_desc_update_template(shared, set_layout);
+        }
+      }
+      if (!ok || !ngfvk_link_cache_entry(&cache->set_layouts, shared)) {
+        if (shared->vk_update_template != VK_NULL_HANDLE) {
+          vkDestroyDescriptorUpdateTemplate(_vk.device, shared->vk_update_template, NULL);
+        }
+        if (shared->vk_handle != VK_NULL_HANDLE) {
+          vkDestroyDescriptorSetLayout(_vk.device, shared->vk_handle, NULL);
+        }
+        ngfi::free(shared);
+        shared = NULL;
+      }
+    }
+  }
+  if (shared != NULL) {
+    ++shared->refcount;
+    set_layout->vk_handle          = shared->vk_handle;
+    set_layout->vk_update_template = shared->vk_update_template;
+    set_layout->dummy_payload      = shared->dummy_payload.data();
+  }
+  pthread_mutex_unlock(&cache->mu);
+  return shared;
+}
+
+// Returns a reference to a shared pipeline layout with the given set layouts, creating it if
+// necessary. Takes over the caller's references to the set layouts, even on failure. Returns NULL
+// on failure.
+static ngfvk_shared_pipeline_layout*
+ngfvk_acquire_shared_pipeline_layout(ngfvk_shared_set_layout* const* set_layouts, uint32_t nsets) {
+  const uint64_t      hash  = ngfvk_pipeline_layout_key_hash(set_layouts, nsets);
+  ngfvk_layout_cache* cache = &_vk.layout_cache;
+  pthread_mutex_lock(&cache->mu);
+  ngfvk_shared_pipeline_layout** head   = cache->pipeline_layouts.get(hash);
+  ngfvk_shared_pipeline_layout*  shared = NULL;
+  for (ngfvk_shared_pipeline_layout* e = head ? *head : NULL; e; e = e->next) {
+    if (e->set_layouts.size() == nsets &&
+        (nsets == 0u ||
+         memcmp(e->set_layouts.data(), set_layouts, nsets * sizeof(set_layouts[0])) == 0)) {
+      shared = e;
+      break;
+    }
+  }
+  bool keep_set_layout_refs = false;
+  if (shared == NULL) {
+    shared = ngfi::alloc<ngfvk_shared_pipeline_layout>();
+    if (shared != NULL) {
+      shared->hash        = hash;
+      shared->refcount    = 0u;
+      shared->set_layouts = ngfi::fixed_array<ngfvk_shared_set_layout*> {nsets};
+      auto vk_set_layouts = ngfi::tmp_alloc<VkDescriptorSetLayout>(nsets);
+      for (uint32_t s = 0u; s < nsets; ++s) { vk_set_layouts[s] = set_layouts[s]->vk_handle; }
+      const VkPipelineLayoutCreateInfo vk_pipeline_layout_info = {
+          .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+          .pNext                  = NULL,
+          .flags                  = 0u,
+          .setLayoutCount         = nsets,
+          .pSetLayouts            = vk_set_layouts,
+          .pushConstantRangeCount = 1u,
+          .pPushConstantRanges    = &ngfvk::global::default_push_constant_range};
+      const bool ok = (nsets == 0u || shared->set_layouts.data() != NULL) &&
+                      vkCreatePipelineLayout(
+                          _vk.device,
+                          &vk_pipeline_layout_info,
+                          NULL,
+                          &shared->vk_handle) == VK_SUCCESS &&
+                      ngfvk_link_cache_entry(&cache->pipeline_layouts, shared);
+      if (ok) {
+        for (uint32_t s = 0u; s < nsets; ++s) { shared->set_layouts[s] = set_layouts[s]; }
+        keep_set_layout_refs = true;
+      } else {
+        if (shared->vk_handle != VK_NULL_HANDLE) {
+          vkDestroyPipelineLayout(_vk.device, shared->vk_handle, NULL);
+        }
+        ngfi::free(shared);
+        shared = NULL;
+      }
+    }
+  }
+  if (!keep_set_layout_refs) {
+    // The existing pipeline layout already holds references to the same set layouts.
+    for (uint32_t s = 0u; s < nsets; ++s) {
+      ngfvk_release_shared_set_layout_locked(set_layouts[s]);
+    }
+  }
+  if (shared != NULL) { ++shared->refcount; }
+  pthread_mutex_unlock(&cache->mu);
+  return shared;
+}
+
+// Immediately destroys everything left in the layout cache. Only safe once the device is idle.
+static void ngfvk_destroy_layout_cache() {
+  ngfvk_layout_cache* cache = &_vk.layout_cache;
+  for (auto& entry : cache->pipeline_layouts) {
+    for (ngfvk_shared_pipeline_layout* e = entry.value; e != NULL;) {
+      ngfvk_shared_pipeline_layout* next = e->next;
+      vkDestroyPipelineLayout(_vk.device, e->vk_handle, NULL);
+      ngfi::free(e);
+      e = next;
+    }
+  }
+  for (auto& entry : cache->set_layouts) {
+    for (ngfvk_shared_set_layout* e = entry.value; e != NULL;) {
+      ngfvk_shared_set_layout* next = e->next;
+      if (e->vk_update_template != VK_NULL_HANDLE) {
+        vkDestroyDescriptorUpdateTemplate(_vk.device, e->vk_update_template, NULL);
+      }
+      vkDestroyDescriptorSetLayout(_vk.device, e->vk_handle, NULL);
+      ngfi::free(e);
+      e = next;
+    }
+  }
+  cache->pipeline_layouts = ngfi::hashtable<ngfvk_shared_pipeline_layout*> {};
+  cache->set_layouts      = ngfi::hashtable<ngfvk_shared_set_layout*> {};
+}
+
+// Returns the descriptor type of the given binding in sets of the bindless resource heap.
+static VkDescriptorType ngfvk_bindless_desc_type(uint32_t binding) {
+  static const VkDescriptorType vktypes[NGF_BINDLESS_RESOURCE_TYPE_COUNT] = {
+      VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+      VK_DESCRIPTOR_TYPE_SAMPLER,
+      VK_DESCRIPTOR_TYPE_STORAGE_BUFFER};
+  return binding < NGF_BINDLESS_RESOURCE_TYPE_COUNT ? vktypes[binding]
+                                                    : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+// Returns a free index from the given slots, or ~0u if all of them are taken.
+static uint32_t ngfvk_bindless_slots_alloc(ngfvk_bindless_slots* slots) {
+  if (!slots->free_indices.empty()) {
+    const uint32_t idx = slots->free_indices.back();
+    slots->free_indices.pop_back();
+    return idx;
+  }
+  return slots->nallocated < slots->capacity ? slots->nallocated++ : ~0u;
+}
+
+// Creates the layout of bindless resource heap sets, with the given number of descriptors in each
+// binding. The layout starts out with a single reference. Returns NULL on failure.
+static ngfvk_shared_set_layout* ngfvk_create_bindless_set_layout(const uint32_t* capacities) {
+  VkDescriptorSetLayoutBinding vk_bindings[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+  VkDescriptorBindingFlags     vk_binding_flags[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+  for (uint32_t b = 0u; b < NGF_BINDLESS_RESOURCE_TYPE_COUNT; ++b) {
+    vk_bindings[b] = VkDescriptorSetLayoutBinding {
+        .binding            = b,
+        .descriptorType     = ngfvk_bindless_desc_type(b),
+        .descriptorCount    = capacities[b],
+        .stageFlags         = VK_SHADER_STAGE_ALL,
+        .pImmutableSamplers = NULL};
+    vk_binding_flags[b] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+                          VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                          VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+  }
+  const VkDescriptorSetLayoutBindingFlagsCreateInfo vk_binding_flags_info = {
+      .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+      .pNext         = NULL,
+      .bindingCount  = NGF_BINDLESS_RESOURCE_TYPE_COUNT,
+      .pBindingFlags = vk_binding_flags};
+  const VkDescriptorSetLayoutCreateInfo vk_ds_info = {
+      .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+      .pNext        = &vk_binding_flags_info,
+      .flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+      .bindingCount = NGF_BINDLESS_RESOURCE_TYPE_COUNT,
+      .pBindings    = vk_bindings};
+  ngfvk_shared_set_layout* shared = ngfi::alloc<ngfvk_shared_set_layout>();
+  if (shared == NULL) return NULL;
+  if (vkCreateDescriptorSetLayout(_vk.device, &vk_ds_info, NULL, &shared->vk_handle) !=
+      VK_SUCCESS) {
+    ngfi::free(shared);
+    return NULL;
+  }
+  shared->refcount = 1u;
+  return shared;
+}
+
+// Creates the descriptor set of the bindless resource heap, with the given number of slots in each
+// array.
+static ngf_error ngfvk_bindless_heap_init(ngfvk_bindless_heap* heap, const uint32_t* capacities) {
+  VkDescriptorPoolSize vk_pool_sizes[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+  for (uint32_t t = 0u; t < NGF_BINDLESS_RESOURCE_TYPE_COUNT; ++t) {
+    vk_pool_sizes[t].type            = ngfvk_bindless_desc_type(t);
+    vk_pool_sizes[t].descriptorCount = capacities[t];
+    heap->slots[t].capacity          = capacities[t];
+    heap->slots[t].nallocated        = 0u;
+  }
+  const VkDescriptorPoolCreateInfo vk_pool_info = {
+      .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+      .pNext         = NULL,
+      .flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT,
+      .maxSets       = 1u,
+      .poolSizeCount = NGF_BINDLESS_RESOURCE_TYPE_COUNT,
+      .pPoolSizes    = vk_pool_sizes};
+  if (vkCreateDescriptorPool(_vk.device, &vk_pool_info, NULL, &heap->vk_pool) != VK_SUCCESS) {
+    heap->vk_pool = VK_NULL_HANDLE;
+    return NGF_ERROR_OBJECT_CREATION_FAILED;
+  }
+  const VkDescriptorSetAllocateInfo vk_set_info = {
+      .sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+      .pNext              = NULL,
+      .descriptorPool     = heap->vk_pool,
+      .descriptorSetCount = 1u,
+      .pSetLayouts        = &_vk.bindless_set_layout->vk_handle};
+  if (vkAllocateDescriptorSets(_vk.device, &vk_set_info, &heap->vk_set) != VK_SUCCESS) {
+    vkDestroyDescriptorPool(_vk.device, heap->vk_pool, NULL);
+    heap->vk_pool = VK_NULL_HANDLE;
+    heap->vk_set  = VK_NULL_HANDLE;
+    return NGF_ERROR_OBJECT_CREATION_FAILED;
+  }
+  return NGF_ERROR_OK;
+}
+
+template<class H> static uint64_t ngfvk_handle_bits(H handle) {
+  uint64_t result = 0u;
+  memcpy(&result, &handle, sizeof(handle));
+  return result;
+}
+
+template<class H> static H ngfvk_handle_from_bits(uint64_t bits) {
+  H result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// Fills out a cache key describing the descriptor written by the given bind op. The bind op is
+// assumed to have been validated against the target binding. For dynamic uniform buffers, the
+// bind offset is returned in `dynamic_offset` and left out of the key, so that binding another
+// region of the same buffer maps to the same descriptor set.
+static void ngfvk_desc_write_key_from_bind_op(
+    const ngf_resource_bind_op* bind_op,
+    const ngfvk_desc_binding*   binding,
+    ngfvk_desc_write_key*       key,
+    uint32_t*                   dynamic_offset) {
+  memset(key, 0, sizeof(*key));
+  *dynamic_offset  = 0u;
+  key->binding     = bind_op->target_binding;
+  key->array_index = bind_op->array_index;
+  key->type        = (uint32_t)binding->type;
+  switch (bind_op->type) {
+  case NGF_DESCRIPTOR_STORAGE_BUFFER:
+  case NGF_DESCRIPTOR_UNIFORM_BUFFER: {
+    const ngf_buffer_bind_info* bind_info = &bind_op->info.buffer;
+    key->handles[0] = ngfvk_handle_bits((VkBuffer)bind_info->buffer->alloc.obj_handle);
+    key->offset     = bind_info->offset;
+    key->range      = bind_info->range;
+    // A whole-size range would be resolved against the descriptor offset alone, so those keep the
+    // offset in the descriptor.
+    if (binding->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC &&
+        bind_info->range != VK_WHOLE_SIZE && bind_info->offset <= UINT32_MAX) {
+      *dynamic_offset = (uint32_t)bind_info->offset;
+      key->offset     = 0u;
+    }
+    break;
+  }
+  case NGF_DESCRIPTOR_TEXEL_BUFFER:
+    key->handles[0] = ngfvk_handle_bits(bind_op->info.texel_buffer_view->vk_buf_view);
+    break;
+  case NGF_DESCRIPTOR_STORAGE_IMAGE:
+  case NGF_DESCRIPTOR_IMAGE:
+  case NGF_DESCRIPTOR_SAMPLER:
+  case NGF_DESCRIPTOR_IMAGE_AND_SAMPLER: {
+    const ngf_image_sampler_bind_info* bind_info = &bind_op->info.image_sampler;
+    if (bind_op->type != NGF_DESCRIPTOR_SAMPLER) {
+      const VkImageView image_view =
+          bind_info->is_image_view
+              ? bind_info->resource.view->vk_view
+              : (binding->is_multilayered_image ? bind_info->resource.image->vkview_arrayed
+                                                : bind_info->resource.image->vkview);
+      key->handles[0]   = ngfvk_handle_bits(image_view);
+      key->image_layout = bind_op->type == NGF_DESCRIPTOR_STORAGE_IMAGE
+                              ? (uint32_t)VK_IMAGE_LAYOUT_GENERAL
+                              : (uint32_t)VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    if (bind_op->type == NGF_DESCRIPTOR_SAMPLER ||
+        bind_op->type == NGF_DESCRIPTOR_IMAGE_AND_SAMPLER) {
+      key->handles[1] = ngfvk_handle_bits(bind_info->sampler->vksampler);
+    }
+    break;
+  }
+  case NGF_DESCRIPTOR_ACCELERATION_STRUCTURE:
+    key->handles[0] = ngfvk_handle_bits(
+        *(const VkAccelerationStructureKHR*)&bind_op->info.acceleration_structure);
+    break;
+  default:
+    assert(false);
+  }
+}
+
+// Converts the given cache key into the corresponding descriptor update template payload data.
+static void
+ngfvk_desc_payload_slot_from_key(const ngfvk_desc_write_key* key, ngfvk_desc_payload_slot* slot) {
+  switch ((VkDescriptorType)key->type) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    slot->buffer.buffer = ngfvk_handle_from_bits<VkBuffer>(key->handles[0]);
+    slot->buffer.offset = key->offset;
+    slot->buffer.range  = key->range;
+    break;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    slot->texel_buffer_view = ngfvk_handle_from_bits<VkBufferView>(key->handles[0]);
+    break;
+  case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR:
+    slot->accel_struct = ngfvk_handle_from_bits<VkAccelerationStructureKHR>(key->handles[0]);
+    break;
+  default:
+    slot->image.imageView   = ngfvk_handle_from_bits<VkImageView>(key->handles[0]);
+    slot->image.sampler     = ngfvk_handle_from_bits<VkSampler>(key->handles[1]);
+    slot->image.imageLayout = (VkImageLayout)key->image_layout;
+    break;
+  }
+}
+
+// Constructs a single-descriptor write into the given set from a cache key. Used to update sets
+// whose layout has no update template.
+static void ngfvk_desc_write_from_key(
+    const ngfvk_desc_write_key* key,
+    VkDescriptorSet             set,
+    VkWriteDescriptorSet*       write) {
+  write->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+  write->pNext           = NULL;
+  write->dstSet          = set;
+  write->dstBinding      = key->binding;
+  write->dstArrayElement = key->array_index;
+  write->descriptorCount = 1u;
+  write->descriptorType  = (VkDescriptorType)key->type;
+  auto slot              = ngfi::tmp_alloc<ngfvk_desc_payload_slot>();
+  ngfvk_desc_payload_slot_from_key(key, slot);
+  switch (write->descriptorType) {
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+  case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+  case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    write->pBufferInfo = &slot->buffer;
+    break;
+  case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    write->pTexelBufferView = &slot->texel_buffer_view;
+    break;
+  case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: {
+    auto accel_struct_info   = ngfi::tmp_alloc<VkWriteDescriptorSetAccelerationStructureKHR>();
+    accel_struct_info->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+    accel_struct_info->pNext = NULL;
+    accel_struct_info->accelerationStructureCount = 1u;
+    accel_struct_info->pAccelerationStructures    = &slot->accel_struct;
+    write->pNext                                  = accel_struct_info;
+    break;
+  }
+  default:
+    write->pImageInfo = &slot->image;
+    break;
+  }
+}
+
+// Writes all descriptors of a newly allocated set with a single templated update. Descriptors
+// that aren't listed in `writes` are pointed at dummy resources.
+static void ngfvk_write_desc_set_with_template(
+    VkDescriptorSet              set,
+    const ngfvk_desc_set_layout* set_layout,
+    const ngfvk_desc_write_key*  writes,
+    uint32_t                     nwrites) {
+  const uint32_t nslots  = set_layout->nall_descs;
+  auto           payload = ngfi::tmp_alloc<ngfvk_desc_payload_slot>(nslots);
+  if (payload == NULL) { return; }
+  memcpy(payload, set_layout->dummy_payload, nslots * sizeof(ngfvk_desc_payload_slot));
+  for (uint32_t w = 0u; w < nwrites; ++w) {
+    const ngfvk_desc_write_key* key     = &writes[w];
+    const ngfvk_desc_binding*   binding = &set_layout->binding_properties[key->binding];
+    if (key->array_index >= binding->ndescs_in_binding) { continue; }
+    ngfvk_desc_payload_slot_from_key(key, &payload[binding->first_payload_slot + key->array_index]);
+  }
+  vkUpdateDescriptorSetWithTemplate(_vk.device, set, set_layout->vk_update_template, payload);
+}
+
+// Pushes the given descriptors into set `s` of the given pipeline layout on the command buffer.
+// Unless the layout permits partially bound bindings, the descriptors that aren't listed in
+// `writes` are pointed at dummy resources, same as for newly allocated sets.
+static void ngfvk_push_desc_set(
+    VkCommandBuffer              cmd_buf,
+    VkPipelineBindPoint          bind_point,
+    VkPipelineLayout             pipeline_layout,
+    uint32_t                     s,
+    const ngfvk_desc_set_layout* set_layout,
+    const ngfvk_desc_write_key*  writes,
+    uint32_t                     nwrites) {
+  auto     vk_writes  = ngfi::tmp_alloc<VkWriteDescriptorSet>(set_layout->nall_descs + nwrites);
+  uint32_t nvk_writes = 0u;
+  if (vk_writes == NULL) { return; }
+  if (!set_layout->is_partially_bound) {
+    nvk_writes = ngfvk_dummy_desc_writes(set_layout, writes, nwrites, VK_NULL_HANDLE, vk_writes);
+  }
+  for (uint32_t w = 0u; w < nwrites; ++w) {
+    ngfvk_desc_write_from_key(&writes[w], VK_NULL_HANDLE, &vk_writes[nvk_writes++]);
+  }
+  vkCmdPushDescriptorSetKHR(cmd_buf, bind_point, pipeline_layout, s, nvk_writes, vk_writes);
+}
+
+static uint64_t ngfvk_desc_set_contents_hash(
+    VkDescriptorSetLayout       layout,
+    const ngfvk_desc_write_key* writes,
+    uint32_t                    nwrites) {
+  return ngfvk_hash_words(
+      ngfvk_handle_bits(layout),
+      (const uint64_t*)writes,
+      nwrites * sizeof(ngfvk_desc_write_key) / sizeof(uint64_t));
+}
+
+// Returns a previously written descriptor set with the given layout and contents, or
+// VK_NULL_HANDLE if there is none.
+static VkDescriptorSet ngfvk_desc_set_cache_find(
+    ngfvk_desc_set_cache*       cache,
+    uint64_t                    hash,
+    VkDescriptorSetLayout       layout,
+    const ngfvk_desc_write_key* writes,
+    uint32_t                    nwrites) {
+  ngfvk_desc_set_cache_entry** head = cache->entries.get(hash);
+  for (ngfvk_desc_set_cache_entry* e = head ? *head : NULL; e; e = e->next) {
+    if (e->layout == layout && e->nwrites == nwrites &&
+        memcmp(e->writes, writes, nwrites * sizeof(ngfvk_desc_write_key)) == 0) {
+      return e->set;
+    }
+  }
+  return VK_NULL_HANDLE;
+}
+
+static void ngfvk_desc_set_cache_insert(
+    ngfvk_desc_set_cache*       cache,
+    uint64_t                    hash,
+    VkDescriptorSetLayout       layout,
+    const ngfvk_desc_write_key* writes,
+    uint32_t                    nwrites,
+    VkDescriptorSet             set) {
+  auto entry = cache->storage.alloc<ngfvk_desc_set_cache_entry>();
+  auto keys  = cache->storage.alloc<ngfvk_desc_write_key>(nwrites);
+  if (entry == NULL || keys == NULL) { return; }
+  memcpy(keys, writes, nwrites * sizeof(ngfvk_desc_write_key));
+  bool                         is_new = false;
+  ngfvk_desc_set_cache_entry** head   = cache->entries.get_or_insert(hash, NULL, is_new);
+  if (head == NULL) { return; }
+  entry->next    = *head;
+  entry->layout  = layout;
+  entry->set     = set;
+  entry->nwrites = nwrites;
+  entry->writes  = keys;
+  *head          = entry;
+}
+static ngf_error ngfvk_create_vk_image_view(
+    VkImage         image,
+    VkImageViewType image_type,
+    VkFormat        image_format,
+    uint32_t        nmips,
+    uint32_t        nlayers,
+    VkImageView*    result) {
+  const bool is_depth    = ngfvk_format_is_depth(image_format);
+  const bool is_stencil  = ngfvk_format_is_stencil(image_format);
+  const auto stencil_bit = is_stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : ((VkImageAspectFlagBits)0);
+  const auto aspect_mask = (VkImageAspectFlags)(is_depth ? (VK_IMAGE_ASPECT_DEPTH_BIT | stencil_bit)
+                                                         : VK_IMAGE_ASPECT_COLOR_BIT);
+
+  const VkImageViewCreateInfo image_view_info = {
+      .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .pNext    = NULL,
+      .flags    = 0u,
+      .image    = image,
+      .viewType = image_type,
+      .format   = image_format,
+      .components =
+          {.r = VK_COMPONENT_SWIZZLE_IDENTITY,
+           .g = VK_COMPONENT_SWIZZLE_IDENTITY,
+           .b = VK_COMPONENT_SWIZZLE_IDENTITY,
+           .a = VK_COMPONENT_SWIZZLE_IDENTITY},
+      .subresourceRange = {
+          .aspectMask     = aspect_mask,
+          .baseMipLevel   = 0u,
+          .levelCount     = nmips,
+          .baseArrayLayer = 0u,
+          .layerCount     = nlayers}};
+  const VkResult create_view_vkerr = vkCreateImageView(_vk.device, &image_view_info, NULL, result);
+  if (create_view_vkerr != VK_SUCCESS) {
+    return NGF_ERROR_INVALID_OPERATION;
+  } else {
+    return NGF_ERROR_OK;
+  }
+}
+
+static VkResult ngfvk_renderpass_from_attachment_descs(
+    uint32_t                          nattachments,
+    const ngf_attachment_description* attachment_descs,
+    const ngfvk_attachment_pass_desc* attachment_compat_pass_descs,
+    VkRenderPass*                     result) {
+  auto     vk_attachment_descs        = ngfi::tmp_alloc<VkAttachmentDescription>(nattachments);
   auto     vk_color_attachment_refs   = ngfi::tmp_alloc<VkAttachmentReference>(nattachments);
   auto     vk_resolve_attachment_refs = ngfi::tmp_alloc<VkAttachmentReference>(nattachments);
   uint32_t ncolor_attachments         = 0u;
@@ -1545,6 +3004,168 @@ static VkResult ngfvk_renderpass_from_attachment_descs(
 
   return vkCreateRenderPass(_vk.device, &renderpass_ci, NULL, result);
 }
+
+// Macros for accessing load/store ops encoded in a renderpass ops key.
+#define NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) ((ops_key >> (4u * idx)) & 15u)
+#define NGFVK_ATTACHMENT_LOAD_OP_FROM_KEY(idx, ops_key) \
+  (get_vk_load_op((ngf_attachment_load_op)(NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) >> 2u)))
+#define NGFVK_ATTACHMENT_STORE_OP_FROM_KEY(idx, ops_key) \
+  (get_vk_store_op((ngf_attachment_store_op)(NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) & 3u)))
+
+static uint64_t ngfvk_renderpass_key_hash(
+    const ngfvk_renderpass_attachment_key* attachments,
+    uint32_t                               nattachments,
+    uint64_t                               ops_key) {
+  return ngfvk_hash_words(
+      ops_key,
+      (const uint32_t*)attachments,
+      nattachments * sizeof(ngfvk_renderpass_attachment_key) / sizeof(uint32_t));
+}
+
+static void ngfvk_renderpass_attachment_keys(
+    ngf_render_target                rt,
+    ngfvk_renderpass_attachment_key* keys) {
+  for (uint32_t i = 0u; i < rt->nattachments; ++i) {
+    keys[i].format       = rt->attachment_descs[i].format;
+    keys[i].sample_count = rt->attachment_descs[i].sample_count;
+    keys[i].type         = rt->attachment_descs[i].type;
+    keys[i].layout       = rt->attachment_compat_pass_descs[i].layout;
+    keys[i].is_resolve   = rt->attachment_compat_pass_descs[i].is_resolve;
+  }
+}
+
+// Returns a render pass with the given render target's attachments and load/store ops, creating it
+// if necessary. The returned entry holds a new reference. Must be called with the render pass cache
+// lock held.
+static ngfvk_renderpass_cache_entry*
+ngfvk_acquire_renderpass_locked(ngf_render_target rt, uint64_t ops_key) {
+  const uint32_t nattachments = rt->nattachments;
+  auto attachment_keys = ngfi::tmp_alloc<ngfvk_renderpass_attachment_key>(nattachments);
+  ngfvk_renderpass_attachment_keys(rt, attachment_keys);
+  const uint64_t hash = ngfvk_renderpass_key_hash(attachment_keys, nattachments, ops_key);
+
+  ngfvk_renderpass_cache*        cache = &_vk.renderpass_cache;
+  ngfvk_renderpass_cache_entry** head  = cache->entries.get(hash);
+  for (ngfvk_renderpass_cache_entry* e = head ? *head : NULL; e; e = e->next) {
+    if (e->ops_key == ops_key && e->attachments.size() == nattachments &&
+        (nattachments == 0u ||
+         memcmp(
+             e->attachments.data(),
+             attachment_keys,
+             nattachments * sizeof(ngfvk_renderpass_attachment_key)) == 0)) {
+      ++e->refcount;
+      return e;
+    }
+  }
+
+  auto attachment_pass_descs = ngfi::tmp_alloc<ngfvk_attachment_pass_desc>(nattachments);
+  for (uint32_t i = 0; i < nattachments; ++i) {
+    attachment_pass_descs[i]          = rt->attachment_compat_pass_descs[i];
+    attachment_pass_descs[i].load_op  = NGFVK_ATTACHMENT_LOAD_OP_FROM_KEY(i, ops_key);
+    attachment_pass_descs[i].store_op = NGFVK_ATTACHMENT_STORE_OP_FROM_KEY(i, ops_key);
+  }
+  auto entry = ngfi::alloc<ngfvk_renderpass_cache_entry>();
+  if (entry == NULL) return NULL;
+  entry->hash        = hash;
+  entry->ops_key     = ops_key;
+  entry->refcount    = 1u;
+  entry->attachments = ngfi::fixed_array<ngfvk_renderpass_attachment_key> {nattachments};
+
+  const bool ok = (nattachments == 0u || entry->attachments.data() != NULL) &&
+                  ngfvk_renderpass_from_attachment_descs(
+                      nattachments,
+                      rt->attachment_descs.data(),
+                      attachment_pass_descs,
+                      &entry->renderpass) == VK_SUCCESS &&
+                  ngfvk_link_cache_entry(&cache->entries, entry);
+  if (!ok) {
+    if (entry->renderpass != VK_NULL_HANDLE) {
+      vkDestroyRenderPass(_vk.device, entry->renderpass, NULL);
+    }
+    ngfi::free(entry);
+    return NULL;
+  }
+  if (nattachments > 0u) {
+    memcpy(
+        entry->attachments.data(),
+        attachment_keys,
+        nattachments * sizeof(ngfvk_renderpass_attachment_key));
+  }
+  return entry;
+}
+
+// Looks up a renderpass object with the given load/store ops for the given render target,
+// and creates one if it doesn't exist. Render targets with the same attachment formats, sample
+// counts and layouts share render passes. Returns VK_NULL_HANDLE on failure.
+static VkRenderPass ngfvk_lookup_renderpass(ngf_render_target rt, uint64_t ops_key) {
+  // Most targets are only ever used with a handful of load/store op combinations, so check the
+  // ones this target already references first, without taking the cache lock. Entries are only
+  // ever prepended to the list, and stay alive for as long as the target does.
+  ngfvk_rt_renderpass* const head = rt->renderpasses.load(std::memory_order_acquire);
+  for (const ngfvk_rt_renderpass* r = head; r != NULL; r = r->next) {
+    if (r->entry->ops_key == ops_key) { return r->entry->renderpass; }
+  }
+
+  VkRenderPass result = VK_NULL_HANDLE;
+  pthread_mutex_lock(&_vk.renderpass_cache.mu);
+  // Another thread may have added the render pass to the target in the meantime.
+  ngfvk_rt_renderpass* const locked_head = rt->renderpasses.load(std::memory_order_relaxed);
+  for (const ngfvk_rt_renderpass* r = locked_head; r != head; r = r->next) {
+    if (r->entry->ops_key == ops_key) {
+      result = r->entry->renderpass;
+      break;
+    }
+  }
+  if (result == VK_NULL_HANDLE) {
+    ngfvk_renderpass_cache_entry* entry = ngfvk_acquire_renderpass_locked(rt, ops_key);
+    ngfvk_rt_renderpass*          ref   = entry != NULL ? ngfi::alloc<ngfvk_rt_renderpass>() : NULL;
+    if (ref != NULL) {
+      ref->entry = entry;
+      ref->next  = locked_head;
+      rt->renderpasses.store(ref, std::memory_order_release);
+      result = entry->renderpass;
+    } else if (entry != NULL) {
+      --entry->refcount;
+    }
+  }
+  pthread_mutex_unlock(&_vk.renderpass_cache.mu);
+  return result;
+}
+
+// Drops the given render target's references to render passes, disposing of the ones that are no
+// longer used by any target.
+static void ngfvk_release_renderpasses(ngf_render_target rt) {
+  pthread_mutex_lock(&_vk.renderpass_cache.mu);
+  for (ngfvk_rt_renderpass* r = rt->renderpasses.load(std::memory_order_relaxed); r != NULL;) {
+    ngfvk_rt_renderpass*          next = r->next;
+    ngfvk_renderpass_cache_entry* e    = r->entry;
+    if (--e->refcount == 0u) {
+      ngfvk_unlink_cache_entry(&_vk.renderpass_cache.entries, e);
+      ngfvk_retire_or_orphan(e->renderpass, &_vk.orphans.render_passes);
+      ngfi::free(e);
+    }
+    ngfi::free(r);
+    r = next;
+  }
+  rt->renderpasses.store(NULL, std::memory_order_relaxed);
+  pthread_mutex_unlock(&_vk.renderpass_cache.mu);
+}
+
+// Immediately destroys everything left in the render pass cache. Only safe once the device is
+// idle.
+static void ngfvk_destroy_renderpass_cache() {
+  ngfvk_renderpass_cache* cache = &_vk.renderpass_cache;
+  for (auto& slot : cache->entries) {
+    for (ngfvk_renderpass_cache_entry* e = slot.value; e != NULL;) {
+      ngfvk_renderpass_cache_entry* next = e->next;
+      vkDestroyRenderPass(_vk.device, e->renderpass, NULL);
+      ngfi::free(e);
+      e = next;
+    }
+  }
+  cache->entries = ngfi::hashtable<ngfvk_renderpass_cache_entry*> {};
+}
+
 static inline uint64_t ngfvk_ptr_hash(void* data) {
   uint64_t mmh3_out[2] = {0, 0};
   ngfi::detail::mmh3_x64_128(reinterpret_cast<uintptr_t>(data), 0x9e3779b9, mmh3_out);
@@ -1666,11 +3287,14 @@ ngfi::maybe_ngfptr<ngf_context_t> ngf_context_t::make(const ngf_context_info& in
       ctx->default_render_target->have_resolve_attachments = true;
     }
 
-    ngfvk_renderpass_from_attachment_descs(
-        nattachment_descs,
-        ctx->default_render_target->attachment_descs.data(),
-        ctx->default_render_target->attachment_compat_pass_descs.data(),
-        &ctx->default_render_target->compat_render_pass);
+    if (!_vk.dynamic_rendering) {
+      ctx->default_render_target->compat_render_pass = ngfvk_lookup_renderpass(
+          ctx->default_render_target.get(),
+          ngfvk::global::compat_renderpass_ops_key);
+      if (ctx->default_render_target->compat_render_pass == VK_NULL_HANDLE) {
+        return NGF_ERROR_OBJECT_CREATION_FAILED;
+      }
+    }
 
     // Create the swapchain itself.
     auto maybe_swapchain =
@@ -1704,19 +3328,71 @@ ngfi::maybe_ngfptr<ngf_context_t> ngf_context_t::make(const ngf_context_info& in
         .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
         .pNext = NULL,
         .flags = 0u};
-    ctx->frame_res[f].nwait_fences = 0;
+    ctx->frame_res[f].nwait_fences         = 0;
+    ctx->frame_res[f].serial               = 0u;
+    ctx->frame_res[f].upload_buffer        = nullptr;
+    ctx->frame_res[f].upload_buffer_offset = 0u;
+    memset(ctx->frame_res[f].query_pools, 0, sizeof(ctx->frame_res[f].query_pools));
+    ctx->frame_res[f].event_pool.nevents = 0u;
+    memset(
+        ctx->frame_res[f].queue_timeline_values,
+        0,
+        sizeof(ctx->frame_res[f].queue_timeline_values));
     for (uint32_t i = 0u; i < sizeof(ctx->frame_res[f].fences) / sizeof(VkFence); ++i) {
       vk_err = vkCreateFence(_vk.device, &fence_info, NULL, &ctx->frame_res[f].fences[i]);
       if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
     }
   }
 
-  ctx->frame_id            = 0u;
-  ctx->current_frame_token = ~0u;
+  ctx->frame_id               = 0u;
+  ctx->current_frame_token    = ~0u;
+  ctx->frame_serial           = 0u;
+  ctx->completed_frame_serial = 0u;
+  memset(ctx->queue_timelines, 0, sizeof(ctx->queue_timelines));
+  memset(ctx->queue_timeline_values, 0, sizeof(ctx->queue_timeline_values));
+
+  // Each submission signals the timeline semaphore of its queue with a new value. Work for queues
+  // that the device doesn't have goes to the graphics queue.
+  if (_vk.timeline_semaphores) {
+    const VkSemaphoreTypeCreateInfo timeline_info = {
+        .sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO,
+        .pNext         = NULL,
+        .semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE,
+        .initialValue  = 0u};
+    const VkSemaphoreCreateInfo semaphore_info = {
+        .sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO,
+        .pNext = &timeline_info,
+        .flags = 0u};
+    for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+      if (ngfvk_effective_queue((ngf_queue_type)q) != q) { continue; }
+      vk_err = vkCreateSemaphore(_vk.device, &semaphore_info, NULL, &ctx->queue_timelines[q]);
+      if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+    }
+  }
+
+  ctx->upload_buffer_size = info.upload_buffer_size > 0u
+                                ? info.upload_buffer_size
+                                : ngfvk::global::default_upload_buffer_size;
+  const uint32_t max_queries =
+      info.max_queries > 0u ? info.max_queries : ngfvk::global::default_queries_per_frame;
+  ctx->query_pool_capacities[NGFVK_QUERY_POOL_OCCLUSION]           = max_queries;
+  ctx->query_pool_capacities[NGFVK_QUERY_POOL_PIPELINE_STATISTICS] = max_queries;
+  ctx->query_pool_capacities[NGFVK_QUERY_POOL_TIMESTAMP] =
+      info.max_timestamp_queries > 0u ? info.max_timestamp_queries
+                                      : ngfvk::global::default_queries_per_frame;
+
+  if (info.descriptor_pool_info) {
+    ctx->desc_pool_info = *info.descriptor_pool_info;
+  } else {
+    ctx->desc_pool_info.sets_per_pool = 100u;
+    for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+      ctx->desc_pool_info.descriptors_per_pool[i] = 100u;
+    }
+    ctx->desc_pool_info.adaptive = true;
+  }
 
   ctx->command_superpools.reserve(3);
   ctx->desc_superpools.reserve(3);
-  ctx->renderpass_cache.reserve(8);
 
   {
     const VkPipelineLayoutCreateInfo default_push_layout_info = {
@@ -1752,18 +3428,24 @@ ngf_context_t::~ngf_context_t() noexcept {
       ngfi::unique_ptr<ngf_render_target_t> {};  // explicitly destroy default RT here.
   for (ngfvk_frame_resources& fr : frame_res) {
     ngfvk_retire_resources(&fr);
+    if (fr.upload_buffer) { NGFI_FREE(fr.upload_buffer); }
+    for (const ngfvk_frame_query_pool& pool : fr.query_pools) {
+      if (pool.vk_pool != VK_NULL_HANDLE) { vkDestroyQueryPool(_vk.device, pool.vk_pool, NULL); }
+    }
+    for (VkEvent event : fr.event_pool.events) { vkDestroyEvent(_vk.device, event, NULL); }
     for (uint32_t i = 0u; i < sizeof(fr.fences) / sizeof(VkFence); ++i) {
       vkDestroyFence(_vk.device, fr.fences[i], NULL);
     }
     if (fr.semaphore != VK_NULL_HANDLE) { vkDestroySemaphore(_vk.device, fr.semaphore, nullptr); }
   }
+  for (VkSemaphore timeline : queue_timelines) {
+    if (timeline != VK_NULL_HANDLE) { vkDestroySemaphore(_vk.device, timeline, NULL); }
+  }
 
   for (size_t p = 0; p < desc_superpools.size(); ++p) {
     ngfvk_destroy_desc_superpool(&desc_superpools[p]);
   }
 
-  ngfvk_reset_renderpass_cache(this);
-
   if (CURRENT_CONTEXT == this) CURRENT_CONTEXT = nullptr;
 }
 
@@ -1790,8 +3472,9 @@ ngf_render_target_t::make(const ngf_render_target_info& info) NGF_NOEXCEPT {
 
   ngfi::fixed_array<ngfvk_attachment_pass_desc> vk_attachment_pass_descs {
       info.attachment_descriptions->ndescs};
-  ngfi::fixed_array<VkImageView> attachment_views {info.attachment_descriptions->ndescs};
-  ngfi::fixed_array<ngf_image>   attachment_images {info.attachment_descriptions->ndescs};
+  ngfi::fixed_array<VkImageView>        attachment_views {info.attachment_descriptions->ndescs};
+  ngfi::fixed_array<ngf_image>          attachment_images {info.attachment_descriptions->ndescs};
+  ngfi::fixed_array<ngfvk_subres_range> attachment_ranges {info.attachment_descriptions->ndescs};
 
   for (uint32_t a = 0u; a < info.attachment_descriptions->ndescs; ++a) {
     const ngf_attachment_description* ngf_attachment_desc = &info.attachment_descriptions->descs[a];
@@ -1830,6 +3513,9 @@ ngf_render_target_t::make(const ngf_render_target_info& info) NGF_NOEXCEPT {
         (attachment_type == NGF_ATTACHMENT_DEPTH_STENCIL
              ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT
              : 0u);
+    const uint32_t attachment_layer =
+        attachment_is_cubemap ? 6u * attachment_img_ref->layer + attachment_img_ref->cubemap_face
+                              : attachment_img_ref->layer;
     const VkImageViewCreateInfo image_view_create_info = {
         .sType    = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .pNext    = NULL,
@@ -1848,25 +3534,18 @@ ngf_render_target_t::make(const ngf_render_target_info& info) NGF_NOEXCEPT {
             .aspectMask     = subresource_aspect_flags,
             .baseMipLevel   = attachment_img_ref->mip_level,
             .levelCount     = 1u,
-            .baseArrayLayer = attachment_is_cubemap ? 6u * attachment_img_ref->layer +
-                                                          attachment_img_ref->cubemap_face
-                                                    : attachment_img_ref->layer,
+            .baseArrayLayer = attachment_layer,
             .layerCount     = 1u,
         }};
     VkResult vk_err =
         vkCreateImageView(_vk.device, &image_view_create_info, NULL, &attachment_views[a]);
     if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
     attachment_images[a] = attachment_img;
+    attachment_ranges[a] = {attachment_img_ref->mip_level, 1u, attachment_layer, 1u};
   }
   rt->attachment_image_views = ngfi::move(attachment_views);
   rt->attachment_images      = ngfi::move(attachment_images);
-
-  const VkResult renderpass_create_result = ngfvk_renderpass_from_attachment_descs(
-      info.attachment_descriptions->ndescs,
-      info.attachment_descriptions->descs,
-      vk_attachment_pass_descs.data(),
-      &rt->compat_render_pass);
-  if (renderpass_create_result != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  rt->attachment_ranges      = ngfi::move(attachment_ranges);
 
   rt->width            = info.attachment_image_refs[0].image->extent.width;
   rt->height           = info.attachment_image_refs[0].image->extent.height;
@@ -1878,6 +3557,13 @@ ngf_render_target_t::make(const ngf_render_target_info& info) NGF_NOEXCEPT {
       info.attachment_descriptions->descs,
       sizeof(rt->attachment_descs[0]) * info.attachment_descriptions->ndescs);
 
+  // With dynamic rendering, attachment image views are bound directly when a pass begins.
+  if (_vk.dynamic_rendering) { return rt; }
+
+  rt->compat_render_pass =
+      ngfvk_lookup_renderpass(rt.get(), ngfvk::global::compat_renderpass_ops_key);
+  if (rt->compat_render_pass == VK_NULL_HANDLE) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+
   // Create a framebuffer.
   const VkFramebufferCreateInfo fb_info = {
       .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
@@ -1919,13 +3605,10 @@ ngf_render_target_t::~ngf_render_target_t() NGF_NOEXCEPT {
     if (!is_default) {
       if (frame_buffer != VK_NULL_HANDLE) { res->retire.append(frame_buffer); }
     }
-    if (compat_render_pass != VK_NULL_HANDLE) { res->retire.append(compat_render_pass); }
     for (VkImageView v : attachment_image_views) { res->retire.append(v); }
-    // clear out the entire renderpass cache to make sure the entries associated
-    // with this target don't stick around.
-    // TODO: clear out all caches across all contexts.
-    ngfvk_reset_renderpass_cache(CURRENT_CONTEXT);
   }
+  // Render passes that aren't used by any other target are evicted from the cache.
+  ngfvk_release_renderpasses(this);
 }
 
 ngfi::maybe_ngfptr<ngf_texel_buffer_view_t>
@@ -1963,7 +3646,9 @@ ngfvk_generic_pipeline::make(const ngf_graphics_pipeline_info& info) NGF_NOEXCEP
       info.spec_info,
       vk_shader_stages,
       info.shader_stages,
-      info.nshader_stages);
+      info.nshader_stages,
+      info.push_descriptor_sets,
+      info.partially_bound_sets);
   if (err != NGF_ERROR_OK) return err;
 
   // Prepare vertex input.
@@ -2166,28 +3851,56 @@ ngfvk_generic_pipeline::make(const ngf_graphics_pipeline_info& info) NGF_NOEXCEP
         .dynamicStateCount = ndynamic_states,
         .pDynamicStates    = dynamic_states};
 
-  // Create a compatible render pass object.
-  auto attachment_compat_pass_descs =
-      ngfi::tmp_alloc<ngfvk_attachment_pass_desc>(info.compatible_rt_attachment_descs->ndescs);
-  for (uint32_t i = 0u; i < info.compatible_rt_attachment_descs->ndescs; ++i) {
-    attachment_compat_pass_descs[i].load_op  = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachment_compat_pass_descs[i].store_op = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachment_compat_pass_descs[i].is_resolve =
-        info.compatible_rt_attachment_descs->descs[i].is_resolve;
-    attachment_compat_pass_descs[i].layout = VK_IMAGE_LAYOUT_GENERAL;
-  }
-
-  VkResult vk_err = ngfvk_renderpass_from_attachment_descs(
-      info.compatible_rt_attachment_descs->ndescs,
-      info.compatible_rt_attachment_descs->descs,
-      attachment_compat_pass_descs,
-      &pipeline->compat_render_pass);
-  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  // With dynamic rendering, the pipeline only needs to know the attachment formats. Otherwise,
+  // create a compatible render pass object.
+  const ngf_attachment_descriptions* compat_descs = info.compatible_rt_attachment_descs;
+  auto rendering_color_formats = ngfi::tmp_alloc<VkFormat>(compat_descs->ndescs);
+  VkPipelineRenderingCreateInfo rendering_info = {
+      .sType                   = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO,
+      .pNext                   = NULL,
+      .viewMask                = 0u,
+      .colorAttachmentCount    = 0u,
+      .pColorAttachmentFormats = rendering_color_formats,
+      .depthAttachmentFormat   = VK_FORMAT_UNDEFINED,
+      .stencilAttachmentFormat = VK_FORMAT_UNDEFINED};
+  VkResult vk_err = VK_SUCCESS;
+  if (_vk.dynamic_rendering) {
+    for (uint32_t i = 0u; i < compat_descs->ndescs; ++i) {
+      const ngf_attachment_description& desc   = compat_descs->descs[i];
+      const VkFormat                    format = get_vk_image_format(desc.format);
+      if (desc.type == NGF_ATTACHMENT_COLOR) {
+        if (!desc.is_resolve) {
+          rendering_color_formats[rendering_info.colorAttachmentCount++] = format;
+        }
+      } else {
+        rendering_info.depthAttachmentFormat = format;
+        if (desc.type == NGF_ATTACHMENT_DEPTH_STENCIL) {
+          rendering_info.stencilAttachmentFormat = format;
+        }
+      }
+    }
+  } else {
+    auto attachment_compat_pass_descs =
+        ngfi::tmp_alloc<ngfvk_attachment_pass_desc>(compat_descs->ndescs);
+    for (uint32_t i = 0u; i < compat_descs->ndescs; ++i) {
+      attachment_compat_pass_descs[i].load_op    = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+      attachment_compat_pass_descs[i].store_op   = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+      attachment_compat_pass_descs[i].is_resolve = compat_descs->descs[i].is_resolve;
+      attachment_compat_pass_descs[i].layout     = VK_IMAGE_LAYOUT_GENERAL;
+    }
+
+    vk_err = ngfvk_renderpass_from_attachment_descs(
+        compat_descs->ndescs,
+        compat_descs->descs,
+        attachment_compat_pass_descs,
+        &pipeline->compat_render_pass);
+    if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  }
 
   // Create required pipeline.
   const VkGraphicsPipelineCreateInfo vk_pipeline_info = {
       .sType               = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-      .pNext               = NULL,
+      .pNext               = _vk.dynamic_rendering ? &rendering_info : NULL,
       .flags               = 0u,
       .stageCount          = info.nshader_stages,
       .pStages             = vk_shader_stages,
@@ -2207,7 +3920,7 @@ ngfvk_generic_pipeline::make(const ngf_graphics_pipeline_info& info) NGF_NOEXCEP
       .basePipelineIndex   = -1};
   vk_err = vkCreateGraphicsPipelines(
       _vk.device,
-      VK_NULL_HANDLE,
+      _vk.pipeline_cache,
       1u,
       &vk_pipeline_info,
       NULL,
@@ -2222,7 +3935,13 @@ ngfvk_generic_pipeline::make(const ngf_compute_pipeline_info& info) NGF_NOEXCEPT
   auto pipeline = ngfi::unique_ptr<ngfvk_generic_pipeline>::make();
   if (!pipeline) return NGF_ERROR_OUT_OF_MEM;
   VkPipelineShaderStageCreateInfo vk_shader_stage {};
-  ngf_error err = pipeline->common_init(info.spec_info, &vk_shader_stage, &info.shader_stage, 1u);
+  ngf_error err = pipeline->common_init(
+      info.spec_info,
+      &vk_shader_stage,
+      &info.shader_stage,
+      1u,
+      info.push_descriptor_sets,
+      info.partially_bound_sets);
   if (err != NGF_ERROR_OK) return err;
   const VkComputePipelineCreateInfo vk_pipeline_ci = {
       .sType              = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
@@ -2234,7 +3953,7 @@ ngfvk_generic_pipeline::make(const ngf_compute_pipeline_info& info) NGF_NOEXCEPT
       .basePipelineIndex  = -1};
   VkResult vk_err = vkCreateComputePipelines(
       _vk.device,
-      VK_NULL_HANDLE,
+      _vk.pipeline_cache,
       1,
       &vk_pipeline_ci,
       NULL,
@@ -2243,6 +3962,31 @@ ngfvk_generic_pipeline::make(const ngf_compute_pipeline_info& info) NGF_NOEXCEPT
   return pipeline;
 }
 
+// Checks that a serialized pipeline cache was produced by the device and driver identified by `id`.
+// Both the nicegraf header and the driver's own header that follows it are validated, since
+// feeding mismatched data to vkCreatePipelineCache is legal but wastes time on some drivers.
+static bool ngfvk_pipeline_cache_blob_is_compatible(
+    const void*                    blob,
+    size_t                         size,
+    const ngfvk_pipeline_cache_id* id) {
+  if (blob == nullptr || size < sizeof(ngfvk_pipeline_cache_blob_header)) { return false; }
+  ngfvk_pipeline_cache_blob_header header;
+  memcpy(&header, blob, sizeof(header));
+  if (header.magic != ngfvk::global::pipeline_cache_magic ||
+      header.version != ngfvk::global::pipeline_cache_version ||
+      memcmp(&header.id, id, sizeof(*id)) != 0 ||
+      header.data_size != size - sizeof(header) ||
+      header.data_size < sizeof(VkPipelineCacheHeaderVersionOne)) {
+    return false;
+  }
+  VkPipelineCacheHeaderVersionOne vk_header;
+  memcpy(&vk_header, (const uint8_t*)blob + sizeof(header), sizeof(vk_header));
+  return vk_header.headerSize >= sizeof(vk_header) &&
+         vk_header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+         vk_header.vendorID == id->vendor_id && vk_header.deviceID == id->device_id &&
+         memcmp(vk_header.pipelineCacheUUID, id->cache_uuid, VK_UUID_SIZE) == 0;
+}
+
 static int ngfvk_binding_comparator(const void* a, const void* b) {
   auto a_binding = (const ngfvk_reflect_binding_and_stage_mask*)a;
   auto b_binding = (const ngfvk_reflect_binding_and_stage_mask*)b;
@@ -2280,11 +4024,62 @@ ngfvk_get_ngf_descriptor_type(SpvReflectDescriptorType spv_reflect_type) {
     return NGF_DESCRIPTOR_TYPE_COUNT;
   }
 }
+// Checks whether a binding reflected from SPIR-V follows the binding convention of the bindless
+// resource heap.
+static bool ngfvk_is_bindless_heap_binding(const SpvReflectDescriptorBinding* d) {
+  const ngf_descriptor_type ngf_desc_type = ngfvk_get_ngf_descriptor_type(d->descriptor_type);
+  return d->count == 0u && ngf_desc_type != NGF_DESCRIPTOR_TYPE_COUNT &&
+         get_vk_descriptor_type(ngf_desc_type) == ngfvk_bindless_desc_type(d->binding);
+}
+
+// Checks whether the descriptors of the given set layouts stay within the device's limits, if one
+// of the sets is the bindless resource heap. Bindings are visible to all stages, so every
+// descriptor in the layout counts towards the per-stage limits.
+static bool
+ngfvk_fits_bindless_layout_limits(const ngfvk_desc_set_layout* set_layouts, uint32_t nsets) {
+  bool             has_heap = false;
+  ngfvk_desc_count counts   = {};
+  for (uint32_t s = 0u; s < nsets; ++s) {
+    has_heap |= set_layouts[s].is_bindless;
+    for (uint32_t t = 0u; t < NGF_DESCRIPTOR_TYPE_COUNT; ++t) {
+      counts[t] += set_layouts[s].counts[t];
+    }
+  }
+  if (!has_heap) { return true; }
+  const uint32_t* heap           = _vk.bindless_heap_capacities;
+  const uint32_t  sampled_images = heap[NGF_BINDLESS_RESOURCE_IMAGE] +
+                                  counts[NGF_DESCRIPTOR_IMAGE] +
+                                  counts[NGF_DESCRIPTOR_IMAGE_AND_SAMPLER] +
+                                  counts[NGF_DESCRIPTOR_TEXEL_BUFFER];
+  const uint32_t samplers = heap[NGF_BINDLESS_RESOURCE_SAMPLER] + counts[NGF_DESCRIPTOR_SAMPLER] +
+                            counts[NGF_DESCRIPTOR_IMAGE_AND_SAMPLER];
+  const uint32_t storage_buffers =
+      heap[NGF_BINDLESS_RESOURCE_STORAGE_BUFFER] + counts[NGF_DESCRIPTOR_STORAGE_BUFFER];
+  const uint32_t resources = sampled_images + storage_buffers +
+                             counts[NGF_DESCRIPTOR_UNIFORM_BUFFER] +
+                             counts[NGF_DESCRIPTOR_STORAGE_IMAGE];
+  const ngfvk_bindless_layout_limits* limits = &_vk.bindless_layout_limits;
+  return sampled_images <= limits->sampled_images && samplers <= limits->samplers &&
+         storage_buffers <= limits->storage_buffers && resources <= limits->resources;
+}
+
+// Returns the index of the descriptor set to update with push descriptors, out of the ones flagged
+// in the given mask. Only one set per pipeline layout may be a push descriptor set, so the lowest
+// flagged one is picked. Returns ~0u if no set is flagged or push descriptors are unsupported.
+static uint32_t ngfvk_push_desc_set_index(uint32_t push_descriptor_sets) {
+  if (!_vk.push_descriptors || push_descriptor_sets == 0u) { return ~0u; }
+  uint32_t s = 0u;
+  while ((push_descriptor_sets & (1u << s)) == 0u) { ++s; }
+  return s;
+}
+
 ngf_error ngfvk_generic_pipeline::common_init(
     const ngf_specialization_info*   spec_info,
     VkPipelineShaderStageCreateInfo* vk_shader_stages,
     const ngf_shader_stage*          shader_stages,
-    uint32_t                         nshader_stages) NGF_NOEXCEPT {
+    uint32_t                         nshader_stages,
+    uint32_t                         push_descriptor_sets,
+    uint32_t                         partially_bound_sets) NGF_NOEXCEPT {
   if (spec_info) {
     auto spec_map_entries = ngfi::tmp_alloc<VkSpecializationMapEntry>(spec_info->nspecializations);
 
@@ -2399,9 +4194,12 @@ ngf_error ngfvk_generic_pipeline::common_init(
     }
   }
 
-  // Create descriptor set layouts.
-  auto     vk_set_layouts = ngfi::tmp_alloc<VkDescriptorSetLayout>(max_set_id + 1);
-  uint32_t last_set_id    = ~0u;
+  // Find or create the descriptor set layouts. Each acquired shared layout is referenced from
+  // `shared_set_layouts`, and those references are handed over to the pipeline layout at the end.
+  auto     shared_set_layouts  = ngfi::tmp_alloc<ngfvk_shared_set_layout*>(nall_sets);
+  uint32_t nshared_set_layouts = 0u;
+  uint32_t last_set_id         = ~0u;
+  const uint32_t push_set_id = ngfvk_push_desc_set_index(push_descriptor_sets);
   for (uint32_t cur = 0u; cur < nunique_bindings;) {
     ngfvk_desc_set_layout set_layout;
     memset((void*)&set_layout, 0, sizeof(set_layout));
@@ -2415,15 +4213,52 @@ ngf_error ngfvk_generic_pipeline::common_init(
             .flags        = 0u,
             .bindingCount = 0u,
             .pBindings    = NULL};
-        vkCreateDescriptorSetLayout(_vk.device, &vk_ds_info, NULL, &set_layout.vk_handle);
-        vk_set_layouts[i] = set_layout.vk_handle;
+        ngfvk_shared_set_layout* shared = ngfvk_acquire_shared_set_layout(&set_layout, &vk_ds_info);
+        if (shared == NULL) {
+          ngfvk_release_shared_set_layouts(shared_set_layouts, nshared_set_layouts);
+          return NGF_ERROR_OBJECT_CREATION_FAILED;
+        }
+        shared_set_layouts[nshared_set_layouts++] = shared;
         descriptor_set_layouts.emplace_back(ngfi::move(set_layout));
       }
     }
-    const uint32_t nall_bindings = nall_bindings_per_set[bindings[cur].binding_data.set];
-    if (nall_bindings > 0u) {
-      set_layout.binding_properties = ngfi::fixed_array<ngfvk_desc_binding> {nall_bindings};
-      for (size_t i = 0u; i < nall_bindings; ++i) {
+
+    // Sets with runtime-sized arrays refer to the bindless resource heap, and use its layout.
+    uint32_t set_end         = cur;
+    bool     is_bindless_set = false;
+    while (set_end < nunique_bindings && current_set_id == bindings[set_end].binding_data.set) {
+      is_bindless_set |= bindings[set_end].binding_data.count == 0u;
+      ++set_end;
+    }
+    if (is_bindless_set) {
+      bool valid = _vk.bindless_set_layout != NULL;
+      for (uint32_t i = cur; valid && i < set_end; ++i) {
+        valid = ngfvk_is_bindless_heap_binding(&bindings[i].binding_data);
+      }
+      if (!valid) {
+        NGFI_DIAG_ERROR(
+            "descriptor set %d has runtime-sized arrays, but bindless resources are unsupported or "
+            "the set's bindings don't match the bindless resource heap",
+            current_set_id);
+        ngfvk_release_shared_set_layouts(shared_set_layouts, nshared_set_layouts);
+        return NGF_ERROR_OBJECT_CREATION_FAILED;
+      }
+      pthread_mutex_lock(&_vk.layout_cache.mu);
+      ++_vk.bindless_set_layout->refcount;
+      pthread_mutex_unlock(&_vk.layout_cache.mu);
+      set_layout.vk_handle                      = _vk.bindless_set_layout->vk_handle;
+      set_layout.is_bindless                    = true;
+      shared_set_layouts[nshared_set_layouts++] = _vk.bindless_set_layout;
+      descriptor_set_layouts.emplace_back(ngfi::move(set_layout));
+      last_set_id = current_set_id;
+      cur         = set_end;
+      continue;
+    }
+
+    const uint32_t nall_bindings = nall_bindings_per_set[bindings[cur].binding_data.set];
+    if (nall_bindings > 0u) {
+      set_layout.binding_properties = ngfi::fixed_array<ngfvk_desc_binding> {nall_bindings};
+      for (size_t i = 0u; i < nall_bindings; ++i) {
         set_layout.binding_properties[i].type = VK_DESCRIPTOR_TYPE_MAX_ENUM;
       }
       memset(
@@ -2439,7 +4274,10 @@ ngf_error ngfvk_generic_pipeline::common_init(
       VkDescriptorSetLayoutBinding*      vk_d = &vk_descriptor_bindings[i - first_binding_in_set];
       const SpvReflectDescriptorBinding* d    = &bindings[i].binding_data;
       const ngf_descriptor_type ngf_desc_type = ngfvk_get_ngf_descriptor_type(d->descriptor_type);
-      if (ngf_desc_type == NGF_DESCRIPTOR_TYPE_COUNT) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+      if (ngf_desc_type == NGF_DESCRIPTOR_TYPE_COUNT) {
+        ngfvk_release_shared_set_layouts(shared_set_layouts, nshared_set_layouts);
+        return NGF_ERROR_OBJECT_CREATION_FAILED;
+      }
       vk_d->binding                               = d->binding;
       vk_d->descriptorCount                       = d->count;
       vk_d->descriptorType                        = get_vk_descriptor_type(ngf_desc_type);
@@ -2453,50 +4291,71 @@ ngf_error ngfvk_generic_pipeline::common_init(
           .is_cubemap            = (d->image.dim == SpvDimCube),
           .ndescs_in_binding     = vk_d->descriptorCount};
       set_layout.binding_properties[d->binding] = binding_properties;
-      set_layout.counts[ngf_desc_type]++;
+      set_layout.counts[ngf_desc_type] += vk_d->descriptorCount;
       set_layout.nall_descs += vk_d->descriptorCount;
     }
+    // Push descriptor set layouts can't have dynamic uniform buffers, so none are assigned there.
+    set_layout.is_push = current_set_id == push_set_id && set_layout.nall_descs > 0u &&
+                         set_layout.nall_descs <= _vk.max_push_descriptors;
+    if (!set_layout.is_push && current_set_id < ngfvk::global::max_dynamic_uniform_buffer_sets) {
+      ngfvk_assign_dynamic_offset_slots(&set_layout, _vk.max_dynamic_uniform_buffers);
+    }
+    set_layout.is_partially_bound = _vk.partially_bound_descs && current_set_id < 32u &&
+                                    (partially_bound_sets & (1u << current_set_id)) != 0u;
+    for (uint32_t i = 0u; i < nbindings_in_set; ++i) {
+      vk_descriptor_bindings[i].descriptorType =
+          set_layout.binding_properties[vk_descriptor_bindings[i].binding].type;
+    }
+    auto vk_binding_flags = ngfi::tmp_alloc<VkDescriptorBindingFlags>(nbindings_in_set);
+    for (uint32_t i = 0u; i < nbindings_in_set; ++i) {
+      vk_binding_flags[i] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+    }
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo vk_binding_flags_info = {
+        .sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .pNext         = NULL,
+        .bindingCount  = nbindings_in_set,
+        .pBindingFlags = vk_binding_flags};
     const VkDescriptorSetLayoutCreateInfo vk_ds_info = {
         .sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-        .pNext        = NULL,
-        .flags        = 0u,
+        .pNext        = set_layout.is_partially_bound ? &vk_binding_flags_info : NULL,
+        .flags        = set_layout.is_push ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+                                           : 0u,
         .bindingCount = nbindings_in_set,
         .pBindings    = vk_descriptor_bindings};
-    const VkResult vk_err =
-        vkCreateDescriptorSetLayout(_vk.device, &vk_ds_info, NULL, &set_layout.vk_handle);
-    vk_set_layouts[current_set_id] = set_layout.vk_handle;
+    ngfvk_assign_desc_payload_slots(&set_layout);
+    ngfvk_shared_set_layout* shared = ngfvk_acquire_shared_set_layout(&set_layout, &vk_ds_info);
+    if (shared == NULL) {
+      ngfvk_release_shared_set_layouts(shared_set_layouts, nshared_set_layouts);
+      return NGF_ERROR_OBJECT_CREATION_FAILED;
+    }
+    shared_set_layouts[nshared_set_layouts++] = shared;
     descriptor_set_layouts.emplace_back(ngfi::move(set_layout));
-    if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
     last_set_id = current_set_id;
   }
 
-  // Pipeline layout.
-  const uint32_t ndescriptor_sets = static_cast<uint32_t>(descriptor_set_layouts.size());
+  if (!ngfvk_fits_bindless_layout_limits(
+          descriptor_set_layouts.data(),
+          (uint32_t)descriptor_set_layouts.size())) {
+    NGFI_DIAG_ERROR(
+        "the pipeline's descriptor sets exceed the device's limits when combined with the bindless "
+        "resource heap");
+    ngfvk_release_shared_set_layouts(shared_set_layouts, nshared_set_layouts);
+    return NGF_ERROR_OBJECT_CREATION_FAILED;
+  }
 
-  const VkPipelineLayoutCreateInfo vk_pipeline_layout_info = {
-      .sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
-      .pNext                  = NULL,
-      .flags                  = 0u,
-      .setLayoutCount         = ndescriptor_sets,
-      .pSetLayouts            = vk_set_layouts,
-      .pushConstantRangeCount = 1u,
-      .pPushConstantRanges    = &ngfvk::global::default_push_constant_range};
-  const VkResult vk_err =
-      vkCreatePipelineLayout(_vk.device, &vk_pipeline_layout_info, NULL, &vk_pipeline_layout);
-  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  // Pipeline layout.
+  shared_layout = ngfvk_acquire_shared_pipeline_layout(shared_set_layouts, nshared_set_layouts);
+  if (shared_layout == NULL) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  vk_pipeline_layout = shared_layout->vk_handle;
 
   return NGF_ERROR_OK;
 }
 ngfvk_generic_pipeline::~ngfvk_generic_pipeline() NGF_NOEXCEPT {
-  auto res = &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id];
-  if (vk_pipeline != VK_NULL_HANDLE) { res->retire.append(vk_pipeline); }
-  if (vk_pipeline_layout != VK_NULL_HANDLE) { res->retire.append(vk_pipeline_layout); }
-  for (size_t l = 0; l < descriptor_set_layouts.size(); ++l) {
-    ngfvk_desc_set_layout* layout    = &descriptor_set_layouts[l];
-    VkDescriptorSetLayout  vk_layout = layout->vk_handle;
-    res->retire.append(vk_layout);
-  }
-  if (compat_render_pass != VK_NULL_HANDLE) res->retire.append(compat_render_pass);
+  // Without a current context on this thread, the objects are deferred to whichever context begins
+  // a frame next.
+  ngfvk_retire_or_orphan(vk_pipeline, &_vk.orphans.pipelines);
+  if (shared_layout != NULL) { ngfvk_release_shared_pipeline_layout(shared_layout); }
+  ngfvk_retire_or_orphan(compat_render_pass, &_vk.orphans.render_passes);
 }
 ngfi::maybe_ngfptr<ngf_shader_stage_t>
 ngf_shader_stage_t::make(const ngf_shader_stage_info& info) NGF_NOEXCEPT {
@@ -2567,7 +4426,8 @@ ngf_image_view_t::make(const ngf_image_view_info& info) NGF_NOEXCEPT {
           .layerCount     = info.nlayers}};
   const VkResult vk_err = vkCreateImageView(_vk.device, &vk_view_info, NULL, &view->vk_view);
   if (vk_err != VK_SUCCESS) return NGF_ERROR_OBJECT_CREATION_FAILED;
-  view->src = info.src_image;
+  view->src   = info.src_image;
+  view->range = {info.base_mip_level, info.nmips, info.base_layer, info.nlayers};
   return view;
 }
 
@@ -2589,8 +4449,9 @@ ngf_image_t::make(const ngf_image_info& info, ngfvk_alloc&& alloc) NGF_NOEXCEPT
   result->usage_flags   = info.usage_hint;
   result->vk_fmt        = get_vk_image_format(info.format);
   memset(&result->sync_state, 0, sizeof(result->sync_state));
-  result->sync_state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-  result->hash              = ngfvk_ptr_hash(result.get());
+  result->sync_state.layout  = VK_IMAGE_LAYOUT_UNDEFINED;
+  result->subres_sync_states = NULL;
+  result->hash               = ngfvk_ptr_hash(result.get());
 
   ngf_error err = NGF_ERROR_OK;
   if (result->alloc.vma_alloc) {
@@ -2625,6 +4486,7 @@ ngfi::maybe_ngfptr<ngf_image_t> ngf_image_t::make(const ngf_image_info& info) NG
 ngf_image_t::~ngf_image_t() noexcept {
   if (vkview) { vkDestroyImageView(_vk.device, vkview, NULL); }
   if (vkview_arrayed) { vkDestroyImageView(_vk.device, vkview_arrayed, NULL); }
+  if (subres_sync_states) { ngfi::freen(subres_sync_states, nlevels * nlayers); }
 }
 
 ngfi::value_or_ngferr<ngfvk_alloc> ngfvk_alloc::make(const ngf_image_info& info) NGF_NOEXCEPT {
@@ -2823,6 +4685,20 @@ ngfvk_swapchain::~ngfvk_swapchain() noexcept {
   if (depth_img) { ngf_destroy_image(depth_img); }
 }
 
+// Writes out the image views backing the default render target's attachments for the given
+// swapchain image, in the same order as the default render target's attachment descriptions.
+static void ngfvk_swapchain_attachment_views(
+    ngfvk_swapchain* swapchain,
+    uint32_t         img_idx,
+    VkImageView*     views) {
+  const bool is_multisampled = swapchain->multisample_img_views.size() > 0u;
+  uint32_t   nviews          = 0u;
+  views[nviews++] = is_multisampled ? swapchain->multisample_img_views[img_idx]
+                                    : swapchain->wrapper_imgs[img_idx]->vkview;
+  if (swapchain->depth_img) { views[nviews++] = swapchain->depth_img->vkview; }
+  if (is_multisampled) { views[nviews++] = swapchain->wrapper_imgs[img_idx]->vkview; }
+}
+
 ngfi::maybe_ngfptr<ngfvk_swapchain> ngfvk_swapchain::make(
     const ngf_swapchain_info& swapchain_info,
     ngf_render_target         rt,
@@ -3014,37 +4890,29 @@ ngfi::maybe_ngfptr<ngfvk_swapchain> ngfvk_swapchain::make(
     swapchain->depth_img = nullptr;
   }
 
-  // Create framebuffers for swapchain images.
+  // Create framebuffers for swapchain images. Dynamic rendering binds the image views directly,
+  // so the framebuffers are left null in that case.
   swapchain->framebufs = ngfi::fixed_array<VkFramebuffer> {swapchain->nimgs};
   if (swapchain->framebufs.data() == nullptr) { return NGF_ERROR_OUT_OF_MEM; }
 
-  const bool     have_resolve_attachment      = (unsigned int)swapchain_info.sample_count > 1u;
-  const uint32_t depth_stencil_attachment_idx = swapchain->depth_img ? 1u : VK_ATTACHMENT_UNUSED;
-  const uint32_t resolve_attachment_idx =
-      have_resolve_attachment ? (swapchain->depth_img ? 2u : 1u) : VK_ATTACHMENT_UNUSED;
   const uint32_t nattachments = rt->nattachments;
-  for (uint32_t f = 0u; f < swapchain->nimgs; ++f) {
-    VkImageView attachment_views[3] {};
-    attachment_views[0] =
-        is_multisampled ? swapchain->multisample_img_views[f] : swapchain->wrapper_imgs[f]->vkview;
-    if (depth_stencil_attachment_idx != VK_ATTACHMENT_UNUSED) {
-      attachment_views[depth_stencil_attachment_idx] = swapchain->depth_img->vkview;
-    }
-    if (resolve_attachment_idx != VK_ATTACHMENT_UNUSED) {
-      attachment_views[resolve_attachment_idx] = swapchain->wrapper_imgs[f]->vkview;
-    }
-    const VkFramebufferCreateInfo fb_info = {
-        .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
-        .pNext           = NULL,
-        .flags           = 0u,
-        .renderPass      = rt->compat_render_pass,
-        .attachmentCount = nattachments,
-        .pAttachments    = attachment_views,
-        .width           = swapchain_info.width,
-        .height          = swapchain_info.height,
-        .layers          = 1u};
-    vk_err = vkCreateFramebuffer(_vk.device, &fb_info, NULL, &swapchain->framebufs[f]);
-    if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  if (!_vk.dynamic_rendering) {
+    for (uint32_t f = 0u; f < swapchain->nimgs; ++f) {
+      VkImageView attachment_views[3] {};
+      ngfvk_swapchain_attachment_views(swapchain.get(), f, attachment_views);
+      const VkFramebufferCreateInfo fb_info = {
+          .sType           = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+          .pNext           = NULL,
+          .flags           = 0u,
+          .renderPass      = rt->compat_render_pass,
+          .attachmentCount = nattachments,
+          .pAttachments    = attachment_views,
+          .width           = swapchain_info.width,
+          .height          = swapchain_info.height,
+          .layers          = 1u};
+      vk_err = vkCreateFramebuffer(_vk.device, &fb_info, NULL, &swapchain->framebufs[f]);
+      if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+    }
   }
 
   // Create semaphores to be signaled when a swapchain image becomes available.
@@ -3071,6 +4939,10 @@ static void ngfvk_cleanup_pending_binds(ngf_cmd_buffer cmd_buf) {
 }
 
 static ngf_error ngfvk_encoder_start(ngf_cmd_buffer cmd_buf) {
+  if (cmd_buf->secondary) {
+    NGFI_DIAG_ERROR("secondary command buffers may only record secondary render passes");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
   NGFI_TRANSITION_CMD_BUF(cmd_buf, ngfi::CMD_BUFFER_STATE_RECORDING);
   return NGF_ERROR_OK;
 }
@@ -3093,6 +4965,7 @@ ngfvk_command_superpool::ngfvk_command_superpool(
     uint32_t capacity,
     uint16_t ctx_id)
     : cmd_pools {capacity},
+      queue_family_idx {queue_family_idx},
       ctx_id {ctx_id} {
   memset(cmd_pools.data(), 0, sizeof(cmd_pools[0]) * capacity);
   for (VkCommandPool& pool : cmd_pools) {
@@ -3111,10 +4984,12 @@ ngfvk_command_superpool::~ngfvk_command_superpool() {
   }
 }
 
-static ngfvk_command_superpool* ngfvk_find_command_superpool(uint16_t ctx_id, uint8_t nframes) {
+static ngfvk_command_superpool*
+ngfvk_find_command_superpool(uint16_t ctx_id, uint8_t nframes, uint32_t queue_family_idx) {
   ngfvk_command_superpool* result = NULL;
   for (size_t i = 0; i < CURRENT_CONTEXT->command_superpools.size(); ++i) {
-    if (CURRENT_CONTEXT->command_superpools[i].ctx_id == ctx_id) {
+    if (CURRENT_CONTEXT->command_superpools[i].ctx_id == ctx_id &&
+        CURRENT_CONTEXT->command_superpools[i].queue_family_idx == queue_family_idx) {
       result = &CURRENT_CONTEXT->command_superpools[i];
       break;
     }
@@ -3122,19 +4997,24 @@ static ngfvk_command_superpool* ngfvk_find_command_superpool(uint16_t ctx_id, ui
 
   if (result == nullptr) {
     result = CURRENT_CONTEXT->command_superpools.emplace_back(
-        ngfvk_command_superpool {_vk.gfx_family_idx, nframes, ctx_id});
+        ngfvk_command_superpool {queue_family_idx, nframes, ctx_id});
   }
 
   return result;
 }
 
+// Allocates a command buffer for the given frame and queue, and begins it. Secondary command
+// buffers are allocated if inheritance info is provided, and continue the render pass it describes.
 static ngf_error ngfvk_cmd_buffer_allocate_for_frame(
-    ngf_frame_token  frame_token,
-    VkCommandPool*   pool,
-    VkCommandBuffer* cmd_buf) {
+    ngf_frame_token                       frame_token,
+    ngf_queue_type                        queue,
+    const VkCommandBufferInheritanceInfo* inheritance_info,
+    VkCommandPool*                        pool,
+    VkCommandBuffer*                      cmd_buf) {
   const ngfvk_command_superpool* superpool = ngfvk_find_command_superpool(
       ngfi_frame_ctx_id(frame_token),
-      ngfi_frame_max_inflight_frames(frame_token));
+      ngfi_frame_max_inflight_frames(frame_token),
+      ngfvk_queue_family_idx(queue));
   if (superpool == nullptr || superpool->cmd_pools.empty()) {
     NGFI_DIAG_ERROR("failed to allocate command buffer");
     return NGF_ERROR_OBJECT_CREATION_FAILED;
@@ -3144,7 +5024,8 @@ static ngf_error ngfvk_cmd_buffer_allocate_for_frame(
       .sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
       .pNext              = NULL,
       .commandPool        = *pool,
-      .level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .level              = inheritance_info ? VK_COMMAND_BUFFER_LEVEL_SECONDARY
+                                             : VK_COMMAND_BUFFER_LEVEL_PRIMARY,
       .commandBufferCount = 1u};
   const VkResult vk_err = vkAllocateCommandBuffers(_vk.device, &vk_cmdbuf_info, cmd_buf);
   if (vk_err != VK_SUCCESS) {
@@ -3154,13 +5035,22 @@ static ngf_error ngfvk_cmd_buffer_allocate_for_frame(
   const VkCommandBufferBeginInfo cmd_buf_begin = {
       .sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
       .pNext            = NULL,
-      .flags            = 0,
-      .pInheritanceInfo = NULL};
+      .flags            = inheritance_info ? VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT : 0u,
+      .pInheritanceInfo = inheritance_info};
   vkBeginCommandBuffer(*cmd_buf, &cmd_buf_begin);
   return NGF_ERROR_OK;
 }
 
-ngfi::maybe_ngfptr<ngf_cmd_buffer_t> ngf_cmd_buffer_t::make() NGF_NOEXCEPT {
+ngfi::maybe_ngfptr<ngf_cmd_buffer_t>
+ngf_cmd_buffer_t::make(const ngf_cmd_buffer_info& info) NGF_NOEXCEPT {
+  if (info.queue >= NGF_QUEUE_TYPE_COUNT) {
+    NGFI_DIAG_ERROR("Invalid queue type %d for command buffer.", info.queue);
+    return NGF_ERROR_INVALID_ENUM;
+  }
+  if (info.level == NGF_CMD_BUFFER_LEVEL_SECONDARY && info.queue != NGF_QUEUE_TYPE_GRAPHICS) {
+    NGFI_DIAG_ERROR("Secondary command buffers must execute on the graphics queue.");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
   auto cmd_buf = ngfi::unique_ptr<ngf_cmd_buffer_t>::make();
   if (!cmd_buf) { return NGF_ERROR_OUT_OF_MEM; }
   cmd_buf->parent_frame                       = ~0u;
@@ -3170,8 +5060,18 @@ ngfi::maybe_ngfptr<ngf_cmd_buffer_t> ngf_cmd_buffer_t::make() NGF_NOEXCEPT {
   cmd_buf->active_attr_buf                    = NULL;
   cmd_buf->active_idx_buf                     = NULL;
   cmd_buf->renderpass_active                  = false;
+  cmd_buf->immediate_render_pass              = false;
+  cmd_buf->executes_secondaries               = false;
   cmd_buf->compute_pass_active                = false;
   cmd_buf->destroy_on_submit                  = false;
+  cmd_buf->secondary                          = info.level == NGF_CMD_BUFFER_LEVEL_SECONDARY;
+  cmd_buf->queue                              = info.queue;
+  cmd_buf->wait_queues_mask                   = 0u;
+  cmd_buf->active_queries_mask                = 0u;
+  cmd_buf->pass_queries_mask                  = 0u;
+  cmd_buf->deferred_epoch                     = 1u;
+  cmd_buf->nin_pass_cmds                      = 0u;
+  cmd_buf->pending_split_wait.event           = VK_NULL_HANDLE;
   cmd_buf->active_rt                          = NULL;
   cmd_buf->desc_pools_list                    = NULL;
   cmd_buf->vk_cmd_buffer                      = VK_NULL_HANDLE;
@@ -3179,6 +5079,8 @@ ngfi::maybe_ngfptr<ngf_cmd_buffer_t> ngf_cmd_buffer_t::make() NGF_NOEXCEPT {
   cmd_buf->pending_barriers.npending_img_bars = 0;
   cmd_buf->pending_barriers.npending_buf_bars = 0;
   cmd_buf->local_res_states                   = ngfvk_sync_res_hashtable {100u};
+  memset(&cmd_buf->bound_gfx_desc_sets, 0, sizeof(cmd_buf->bound_gfx_desc_sets));
+  memset(&cmd_buf->bound_compute_desc_sets, 0, sizeof(cmd_buf->bound_compute_desc_sets));
   return ngfi::move(cmd_buf);
 }
 
@@ -3191,6 +5093,45 @@ ngf_cmd_buffer_t::~ngf_cmd_buffer_t() noexcept {
   virt_bind_ops_ranges.clear();
 }
 
+// Returns true if the given descriptor set is still bound at index `s`, by a pipeline layout that
+// is compatible for set `s` with the one having the given set layouts. Since set layouts are shared
+// between all pipelines with identical bindings, compatibility comes down to comparing handles.
+static bool ngfvk_is_desc_set_bound(
+    const ngfvk_bound_desc_sets* bound,
+    VkDescriptorSet              set,
+    uint32_t                     s,
+    const ngfvk_desc_set_layout* set_layouts) {
+  if (s >= bound->nlayouts || bound->sets[s] != set) return false;
+  for (uint32_t i = 0u; i <= s; ++i) {
+    if (bound->layouts[i] != set_layouts[i].vk_handle) return false;
+  }
+  return true;
+}
+
+// Records that a descriptor set has been bound at index `s` with a pipeline layout having the given
+// set layouts. Previously bound sets at indices past the point where the layouts diverge are
+// considered disturbed.
+static void ngfvk_track_bound_desc_set(
+    ngfvk_bound_desc_sets*       bound,
+    VkDescriptorSet              set,
+    uint32_t                     s,
+    const ngfvk_desc_set_layout* set_layouts,
+    uint32_t                     nset_layouts) {
+  const uint32_t ntracked    = NGFI_MIN(nset_layouts, ngfvk::global::max_tracked_desc_sets);
+  const uint32_t ncomparable = NGFI_MIN(ntracked, bound->nlayouts);
+  uint32_t       ncompatible = 0u;
+  while (ncompatible < ncomparable &&
+         bound->layouts[ncompatible] == set_layouts[ncompatible].vk_handle) {
+    ++ncompatible;
+  }
+  for (uint32_t i = ncompatible; i < ngfvk::global::max_tracked_desc_sets; ++i) {
+    bound->sets[i] = VK_NULL_HANDLE;
+  }
+  for (uint32_t i = 0u; i < ntracked; ++i) { bound->layouts[i] = set_layouts[i].vk_handle; }
+  bound->nlayouts = ntracked;
+  if (s < ntracked) { bound->sets[s] = set; }
+}
+
 static void ngfvk_execute_pending_binds(ngf_cmd_buffer cmd_buf) {
   // Binding resources requires an active pipeline.
   ngfvk_generic_pipeline* pipeline_data = NULL;
@@ -3217,16 +5158,22 @@ static void ngfvk_execute_pending_binds(ngf_cmd_buffer cmd_buf) {
   auto vk_desc_sets = ngfi::tmp_alloc<VkDescriptorSet>(ndesc_set_layouts);
   memset(vk_desc_sets, (uintptr_t)VK_NULL_HANDLE, ndesc_set_layouts * sizeof(vk_desc_sets[0]));
 
-  // Allocate an array of vulkan descriptor set writes from temp storage, one write per
-  // pending bind op.
-  auto vk_writes = ngfi::tmp_alloc<VkWriteDescriptorSet>(cmd_buf->npending_bind_ops);
+  // Allocate an array of descriptor cache keys from temp storage, one per pending bind op, along
+  // with the index of the set targeted by each of them.
+  auto write_sets            = ngfi::tmp_alloc<uint32_t>(cmd_buf->npending_bind_ops);
+  auto write_keys            = ngfi::tmp_alloc<ngfvk_desc_write_key>(cmd_buf->npending_bind_ops);
+  auto write_dynamic_offsets = ngfi::tmp_alloc<uint32_t>(cmd_buf->npending_bind_ops);
+  auto set_keys              = ngfi::tmp_alloc<ngfvk_desc_write_key>(cmd_buf->npending_bind_ops);
+
+  // Dynamic offsets for each set, in the order expected by vkCmdBindDescriptorSets.
+  auto dynamic_offsets = ngfi::tmp_alloc<uint32_t>(
+      (size_t)ndesc_set_layouts * ngfvk::global::max_dynamic_uniform_buffers);
 
   // Find a descriptor pools list to allocate from.
   ngfvk_desc_pools_list* pools = ngfvk_find_desc_pools_list(cmd_buf->parent_frame);
   cmd_buf->desc_pools_list     = pools;
 
-  // Process each bind operation, constructing a corresponding
-  // vulkan descriptor set write operation.
+  // Process each bind operation, constructing a key that describes the descriptor it writes.
   uint32_t descriptor_write_idx = 0u;
   for (const ngf_resource_bind_op& bind_op_ref : cmd_buf->pending_bind_ops) {
     const ngf_resource_bind_op* bind_op = &bind_op_ref;
@@ -3243,6 +5190,13 @@ static void ngfvk_execute_pending_binds(ngf_cmd_buffer cmd_buf) {
     // Find the corresponding descriptor set layout.
     const ngfvk_desc_set_layout* set_layout =
         &pipeline_data->descriptor_set_layouts[bind_op->target_set];
+    if (set_layout->is_bindless) {
+      NGFI_DIAG_WARNING(
+          "descriptor set %d refers to the bindless resource heap, which resources can't be "
+          "bound to - ignoring",
+          bind_op->target_set);
+      continue;
+    }
     // Ensure that a valid binding is referenced by this bind operation.
     if (bind_op->target_binding >= set_layout->binding_properties.size()) {
       NGFI_DIAG_WARNING(
@@ -3253,8 +5207,11 @@ static void ngfvk_execute_pending_binds(ngf_cmd_buffer cmd_buf) {
       continue;
     }
 
-    if (set_layout->binding_properties[bind_op->target_binding].type !=
-        get_vk_descriptor_type(bind_op->type)) {
+    const VkDescriptorType binding_type =
+        set_layout->binding_properties[bind_op->target_binding].type;
+    if (binding_type != get_vk_descriptor_type(bind_op->type) &&
+        !(binding_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC &&
+          bind_op->type == NGF_DESCRIPTOR_UNIFORM_BUFFER)) {
       NGFI_DIAG_WARNING(
           "attempting to bind descriptor with unmatching type (set %d binding %d) - ignoring",
           bind_op->target_set,
@@ -3262,125 +5219,125 @@ static void ngfvk_execute_pending_binds(ngf_cmd_buffer cmd_buf) {
       continue;
     }
 
-    // Allocate a new descriptor set if necessary.
-    const bool need_new_desc_set = vk_desc_sets[bind_op->target_set] == VK_NULL_HANDLE;
-    if (need_new_desc_set) {
-      VkDescriptorSet set = ngfvk_desc_pools_list_allocate_set(pools, set_layout);
-      if (set == VK_NULL_HANDLE) {
-        NGFI_DIAG_ERROR("Failed to bind graphics resources - could not allocate descriptor set");
-        return;
-      }
-      vk_desc_sets[bind_op->target_set] = set;
+    if (bind_op->type == NGF_DESCRIPTOR_STORAGE_IMAGE && cmd_buf->renderpass_active) {
+      NGFI_DIAG_WARNING("Binding storage images to non-compute shader is currently unsupported.");
+      continue;
     }
 
-    // At this point, we have a valid descriptor set in the `vk_sets` array.
-    // We'll use it in the write operation corresponding to the current bind_op.
-    VkDescriptorSet set = vk_desc_sets[bind_op->target_set];
-
-    // Construct a vulkan descriptor set write corresponding to this bind
-    // operation.
-    VkWriteDescriptorSet* vk_write = &vk_writes[descriptor_write_idx];
-
-    vk_write->sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    vk_write->pNext           = NULL;
-    vk_write->dstSet          = set;
-    vk_write->dstBinding      = bind_op->target_binding;
-    vk_write->descriptorCount = 1u;
-    vk_write->dstArrayElement = bind_op->array_index;
-    vk_write->descriptorType  = get_vk_descriptor_type(bind_op->type);
-
-    switch (bind_op->type) {
-    case NGF_DESCRIPTOR_STORAGE_BUFFER:
-    case NGF_DESCRIPTOR_UNIFORM_BUFFER: {
-      const ngf_buffer_bind_info* bind_info    = &bind_op->info.buffer;
-      auto                        vk_bind_info = ngfi::tmp_alloc<VkDescriptorBufferInfo>();
-
-      vk_bind_info->buffer = (VkBuffer)bind_info->buffer->alloc.obj_handle;
-      vk_bind_info->offset = bind_info->offset;
-      vk_bind_info->range  = bind_info->range;
+    write_sets[descriptor_write_idx] = bind_op->target_set;
+    ngfvk_desc_write_key_from_bind_op(
+        bind_op,
+        &set_layout->binding_properties[bind_op->target_binding],
+        &write_keys[descriptor_write_idx],
+        &write_dynamic_offsets[descriptor_write_idx]);
+    ++descriptor_write_idx;
+  }
 
-      vk_write->pBufferInfo = vk_bind_info;
-      break;
-    }
-    case NGF_DESCRIPTOR_TEXEL_BUFFER: {
-      vk_write->pTexelBufferView = &(bind_op->info.texel_buffer_view->vk_buf_view);
-      break;
+  ngfvk_bound_desc_sets* bound_sets = cmd_buf->renderpass_active
+                                          ? &cmd_buf->bound_gfx_desc_sets
+                                          : &cmd_buf->bound_compute_desc_sets;
+  const ngfvk_desc_set_layout* set_layouts = pipeline_data->descriptor_set_layouts.data();
+  const VkPipelineBindPoint    bind_point  = cmd_buf->renderpass_active
+                                                 ? VK_PIPELINE_BIND_POINT_GRAPHICS
+                                                 : VK_PIPELINE_BIND_POINT_COMPUTE;
+
+  // For each set targeted by the bind ops, reuse a set with identical contents written earlier in
+  // the frame if there is one, otherwise allocate and populate a new one. Push descriptor sets are
+  // written directly into the command buffer instead.
+  ngfvk_desc_set_cache* set_cache = &pools->set_cache;
+  for (uint32_t s = 0u; s < ndesc_set_layouts; ++s) {
+    const ngfvk_desc_set_layout* set_layout = &pipeline_data->descriptor_set_layouts[s];
+    if (set_layout->is_bindless) {
+      // The bindless resource heap is always bound as is.
+      vk_desc_sets[s] = _vk.bindless_heap.vk_set;
+      continue;
     }
-    case NGF_DESCRIPTOR_STORAGE_IMAGE:
-      if (cmd_buf->renderpass_active) {
-        NGFI_DIAG_WARNING("Binding storage images to non-compute shader is currently unsupported.");
-        continue;
-      }
-    /* break omitted intentionally */
-    case NGF_DESCRIPTOR_IMAGE:
-    case NGF_DESCRIPTOR_SAMPLER:
-    case NGF_DESCRIPTOR_IMAGE_AND_SAMPLER: {
-      const ngf_image_sampler_bind_info* bind_info = &bind_op->info.image_sampler;
-      const bool                         is_multilayered_image =
-          set_layout->binding_properties[bind_op->target_binding].is_multilayered_image;
-      VkImageView image_view = VK_NULL_HANDLE;
-      if (bind_op->type == NGF_DESCRIPTOR_IMAGE || bind_op->type == NGF_DESCRIPTOR_STORAGE_IMAGE ||
-          bind_op->type == NGF_DESCRIPTOR_IMAGE_AND_SAMPLER) {
-        image_view = bind_info->is_image_view
-                         ? bind_info->resource.view->vk_view
-                         : (is_multilayered_image ? bind_info->resource.image->vkview_arrayed
-                                                  : bind_info->resource.image->vkview);
-      }
-      auto vk_bind_info         = ngfi::tmp_alloc<VkDescriptorImageInfo>();
-      vk_bind_info->imageView   = VK_NULL_HANDLE;
-      vk_bind_info->imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-      vk_bind_info->sampler     = VK_NULL_HANDLE;
-      if (bind_op->type == NGF_DESCRIPTOR_IMAGE ||
-          bind_op->type == NGF_DESCRIPTOR_IMAGE_AND_SAMPLER) {
-        vk_bind_info->imageView   = image_view;
-        vk_bind_info->imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-      } else if (bind_op->type == NGF_DESCRIPTOR_STORAGE_IMAGE) {
-        vk_bind_info->imageView   = image_view;
-        vk_bind_info->imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-      } else if (
-          bind_op->type == NGF_DESCRIPTOR_SAMPLER ||
-          bind_op->type == NGF_DESCRIPTOR_IMAGE_AND_SAMPLER) {
-        vk_bind_info->sampler = bind_info->sampler->vksampler;
+    uint32_t*                    set_dynamic_offsets =
+        &dynamic_offsets[s * ngfvk::global::max_dynamic_uniform_buffers];
+    memset(set_dynamic_offsets, 0, set_layout->ndynamic_offsets * sizeof(uint32_t));
+    uint32_t nset_writes = 0u;
+    for (uint32_t w = 0u; w < descriptor_write_idx; ++w) {
+      if (write_sets[w] != s) { continue; }
+      const ngfvk_desc_binding* binding = &set_layout->binding_properties[write_keys[w].binding];
+      if (binding->type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC &&
+          write_keys[w].array_index == 0u) {
+        set_dynamic_offsets[binding->dynamic_offset_idx] = write_dynamic_offsets[w];
       }
-      vk_write->pImageInfo = vk_bind_info;
-      break;
+      set_keys[nset_writes++] = write_keys[w];
     }
-    case NGF_DESCRIPTOR_ACCELERATION_STRUCTURE: {
-      auto accel_struct_info   = ngfi::tmp_alloc<VkWriteDescriptorSetAccelerationStructureKHR>();
-      accel_struct_info->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
-      accel_struct_info->pNext = NULL;
-      accel_struct_info->accelerationStructureCount = 1u;
-      accel_struct_info->pAccelerationStructures =
-          (const VkAccelerationStructureKHR*)&bind_op->info.acceleration_structure;
-      vk_write->pNext = accel_struct_info;
-      break;
+    if (nset_writes == 0u) { continue; }
+
+    if (set_layout->is_push) {
+      ngfvk_push_desc_set(
+          cmd_buf->vk_cmd_buffer,
+          bind_point,
+          pipeline_data->vk_pipeline_layout,
+          s,
+          set_layout,
+          set_keys,
+          nset_writes);
+      // Whatever set was bound at this index before has been replaced.
+      ngfvk_track_bound_desc_set(bound_sets, VK_NULL_HANDLE, s, set_layouts, ndesc_set_layouts);
+      continue;
     }
 
-    default:
-      assert(false);
+    const uint64_t               hash =
+        ngfvk_desc_set_contents_hash(set_layout->vk_handle, set_keys, nset_writes);
+    VkDescriptorSet set = ngfvk_desc_set_cache_find(
+        set_cache,
+        hash,
+        set_layout->vk_handle,
+        set_keys,
+        nset_writes);
+    if (set != VK_NULL_HANDLE) {
+      ++set_cache->hits;
+    } else {
+      ++set_cache->misses;
+      set = ngfvk_desc_pools_list_allocate_set(pools, set_layout, set_keys, nset_writes);
+      if (set == VK_NULL_HANDLE) {
+        NGFI_DIAG_ERROR("Failed to bind graphics resources - could not allocate descriptor set");
+        return;
+      }
+      if (set_layout->vk_update_template != VK_NULL_HANDLE) {
+        ngfvk_write_desc_set_with_template(set, set_layout, set_keys, nset_writes);
+      } else {
+        auto vk_writes = ngfi::tmp_alloc<VkWriteDescriptorSet>(nset_writes);
+        for (uint32_t w = 0u; w < nset_writes; ++w) {
+          ngfvk_desc_write_from_key(&set_keys[w], set, &vk_writes[w]);
+        }
+        vkUpdateDescriptorSets(_vk.device, nset_writes, vk_writes, 0, NULL);
+      }
+      ngfvk_desc_set_cache_insert(
+          set_cache,
+          hash,
+          set_layout->vk_handle,
+          set_keys,
+          nset_writes,
+          set);
     }
-    ++descriptor_write_idx;
+    vk_desc_sets[s] = set;
   }
-  // perform all the vulkan descriptor set write operations to populate the
-  // newly allocated descriptor sets.
-  vkUpdateDescriptorSets(_vk.device, descriptor_write_idx, vk_writes, 0, NULL);
 
   // bind each of the descriptor sets individually (this ensures that desc.
   // sets bound for a compatible pipeline earlier in this command buffer
-  // don't get clobbered).
+  // don't get clobbered). Sets that are still bound from before, with a compatible layout, are
+  // skipped, unless they have dynamic offsets which may have changed.
   for (uint32_t s = 0; s < ndesc_set_layouts; ++s) {
-    if (vk_desc_sets[s] != VK_NULL_HANDLE) {
-      vkCmdBindDescriptorSets(
-          cmd_buf->vk_cmd_buffer,
-          cmd_buf->renderpass_active ? VK_PIPELINE_BIND_POINT_GRAPHICS
-                                     : VK_PIPELINE_BIND_POINT_COMPUTE,
-          pipeline_data->vk_pipeline_layout,
-          s,
-          1,
-          &vk_desc_sets[s],
-          0,
-          NULL);
+    if (vk_desc_sets[s] == VK_NULL_HANDLE ||
+        (set_layouts[s].ndynamic_offsets == 0u &&
+         ngfvk_is_desc_set_bound(bound_sets, vk_desc_sets[s], s, set_layouts))) {
+      continue;
     }
+    vkCmdBindDescriptorSets(
+        cmd_buf->vk_cmd_buffer,
+        bind_point,
+        pipeline_data->vk_pipeline_layout,
+        s,
+        1,
+        &vk_desc_sets[s],
+        set_layouts[s].ndynamic_offsets,
+        &dynamic_offsets[s * ngfvk::global::max_dynamic_uniform_buffers]);
+    ngfvk_track_bound_desc_set(bound_sets, vk_desc_sets[s], s, set_layouts, ndesc_set_layouts);
   }
   ngfvk_cleanup_pending_binds(cmd_buf);
 }
@@ -3414,53 +5371,198 @@ static uint64_t ngfvk_renderpass_ops_key(
   return result;
 }
 
-// Macros for accessing load/store ops encoded in a renderpass ops key.
-#define NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) ((ops_key >> (4u * idx)) & 15u)
-#define NGFVK_ATTACHMENT_LOAD_OP_FROM_KEY(idx, ops_key) \
-  (get_vk_load_op((ngf_attachment_load_op)(NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) >> 2u)))
-#define NGFVK_ATTACHMENT_STORE_OP_FROM_KEY(idx, ops_key) \
-  (get_vk_store_op((ngf_attachment_store_op)(NGFVK_ATTACHMENT_OPS_COMBO(idx, ops_key) & 3u)))
+static bool ngfvk_format_is_integer(ngf_image_format f) {
+  return f >= NGF_IMAGE_FORMAT_R8U && f <= NGF_IMAGE_FORMAT_RGBA32U;
+}
 
-// Looks up a renderpass object from the current context's renderpass cache, and creates
-// one if it doesn't exist.
-static VkRenderPass ngfvk_lookup_renderpass(ngf_render_target rt, uint64_t ops_key) {
-  VkRenderPass result = VK_NULL_HANDLE;
-  for (size_t r = 0; r < CURRENT_CONTEXT->renderpass_cache.size(); ++r) {
-    const ngfvk_renderpass_cache_entry* cache_entry = &CURRENT_CONTEXT->renderpass_cache[r];
-    if (cache_entry->rt == rt && cache_entry->ops_key == ops_key) {
-      result = cache_entry->renderpass;
-      break;
+// Begins rendering to the pass's render target with VK_KHR_dynamic_rendering. Attachment image
+// views are bound directly, so no render pass or framebuffer objects are involved.
+static void ngfvk_cmd_begin_rendering(
+    ngf_cmd_buffer              buf,
+    const ngf_render_pass_info* pass_info,
+    const VkClearValue*         clears,
+    uint32_t                    nclears,
+    VkExtent2D                  render_extent) {
+  const ngf_render_target target       = pass_info->render_target;
+  const uint32_t          nattachments = target->nattachments;
+  const VkImageView*      views        = target->attachment_image_views.data();
+  if (target->is_default) {
+    ngfvk_swapchain* swapchain     = CURRENT_CONTEXT->swapchain.get();
+    auto             default_views = ngfi::tmp_alloc<VkImageView>(nattachments);
+    ngfvk_swapchain_attachment_views(swapchain, swapchain->image_idx, default_views);
+    views = default_views;
+  }
+
+  auto     color_infos = ngfi::tmp_alloc<VkRenderingAttachmentInfo>(nattachments);
+  uint32_t ncolor      = 0u;
+  VkRenderingAttachmentInfo depth_stencil_info {};
+  bool                      have_depth   = false;
+  bool                      have_stencil = false;
+  for (uint32_t a = 0u; a < nattachments; ++a) {
+    const ngf_attachment_description& desc      = target->attachment_descs[a];
+    const ngfvk_attachment_pass_desc& pass_desc = target->attachment_compat_pass_descs[a];
+    if (pass_desc.is_resolve) { continue; }
+    const VkRenderingAttachmentInfo info = {
+        .sType              = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO,
+        .pNext              = NULL,
+        .imageView          = views[a],
+        .imageLayout        = pass_desc.layout,
+        .resolveMode        = VK_RESOLVE_MODE_NONE,
+        .resolveImageView   = VK_NULL_HANDLE,
+        .resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .loadOp             = get_vk_load_op(pass_info->load_ops[a]),
+        .storeOp            = get_vk_store_op(pass_info->store_ops[a]),
+        .clearValue         = a < nclears ? clears[a] : VkClearValue {}};
+    if (desc.type == NGF_ATTACHMENT_COLOR) {
+      color_infos[ncolor++] = info;
+    } else {
+      depth_stencil_info = info;
+      have_depth         = true;
+      have_stencil       = desc.type == NGF_ATTACHMENT_DEPTH_STENCIL;
     }
   }
 
-  if (result == VK_NULL_HANDLE) {
-    const uint32_t nattachments       = rt->nattachments;
-    auto attachment_compat_pass_descs = ngfi::tmp_alloc<ngfvk_attachment_pass_desc>(nattachments);
-    const size_t rt_attachment_pass_descs_size =
-        rt->nattachments * sizeof(ngfvk_attachment_pass_desc);
-    memcpy(
-        attachment_compat_pass_descs,
-        rt->attachment_compat_pass_descs.data(),
-        rt_attachment_pass_descs_size);
+  // Same as with render passes, the n-th resolve attachment receives the n-th color attachment.
+  uint32_t nresolve = 0u;
+  for (uint32_t a = 0u; a < nattachments && nresolve < ncolor; ++a) {
+    if (!target->attachment_compat_pass_descs[a].is_resolve) { continue; }
+    VkRenderingAttachmentInfo* color_info = &color_infos[nresolve++];
+    color_info->resolveMode = ngfvk_format_is_integer(target->attachment_descs[a].format)
+                                  ? VK_RESOLVE_MODE_SAMPLE_ZERO_BIT
+                                  : VK_RESOLVE_MODE_AVERAGE_BIT;
+    color_info->resolveImageView   = views[a];
+    color_info->resolveImageLayout = target->attachment_compat_pass_descs[a].layout;
+  }
+
+  const VkRenderingFlags rendering_flags =
+      buf->executes_secondaries ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT : 0u;
+  const VkRenderingInfo rendering_info = {
+      .sType                = VK_STRUCTURE_TYPE_RENDERING_INFO,
+      .pNext                = NULL,
+      .flags                = rendering_flags,
+      .renderArea           = {.offset = {0u, 0u}, .extent = render_extent},
+      .layerCount           = 1u,
+      .viewMask             = 0u,
+      .colorAttachmentCount = ncolor,
+      .pColorAttachments    = color_infos,
+      .pDepthAttachment     = have_depth ? &depth_stencil_info : NULL,
+      .pStencilAttachment   = have_stencil ? &depth_stencil_info : NULL};
+  vkCmdBeginRendering(buf->vk_cmd_buffer, &rendering_info);
+}
+
+// Begins the Vulkan render pass (or dynamic rendering) for the command buffer's pending render
+// pass. Barriers for the pass must have been committed beforehand.
+static void ngfvk_cmd_begin_vk_render_pass(ngf_cmd_buffer buf) {
+  const ngf_render_pass_info* pass_info     = &buf->pending_render_pass_info;
+  const ngf_render_target     target        = pass_info->render_target;
+  const VkExtent2D            render_extent = {
+      target->is_default ? CURRENT_CONTEXT->swapchain_info.width : target->width,
+      target->is_default ? CURRENT_CONTEXT->swapchain_info.height : target->height};
 
-    for (uint32_t i = 0; i < rt->nattachments; ++i) {
-      attachment_compat_pass_descs[i].load_op  = NGFVK_ATTACHMENT_LOAD_OP_FROM_KEY(i, ops_key);
-      attachment_compat_pass_descs[i].store_op = NGFVK_ATTACHMENT_STORE_OP_FROM_KEY(i, ops_key);
+  const uint32_t clear_value_count = buf->pending_clear_value_count;
+  auto           vk_clears =
+      clear_value_count > 0 ? ngfi::tmp_alloc<VkClearValue>(clear_value_count) : nullptr;
+  if (clear_value_count > 0) {
+    for (size_t i = 0; i < clear_value_count; ++i) {
+      VkClearValue*    vk_clear_val = &vk_clears[i];
+      const ngf_clear* clear        = &pass_info->clears[i];
+      if (target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH16 &&
+          target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH32 &&
+          target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH24_STENCIL8) {
+        VkClearColorValue* clear_color_var = &vk_clear_val->color;
+        clear_color_var->float32[0]        = clear->clear_color[0];
+        clear_color_var->float32[1]        = clear->clear_color[1];
+        clear_color_var->float32[2]        = clear->clear_color[2];
+        clear_color_var->float32[3]        = clear->clear_color[3];
+      } else {
+        VkClearDepthStencilValue* clear_depth_stencil_val = &vk_clear_val->depthStencil;
+        clear_depth_stencil_val->depth                    = clear->clear_depth_stencil.clear_depth;
+        clear_depth_stencil_val->stencil = clear->clear_depth_stencil.clear_stencil;
+      }
     }
+  }
 
-    ngfvk_renderpass_from_attachment_descs(
-        nattachments,
-        rt->attachment_descs.data(),
-        attachment_compat_pass_descs,
-        &result);
-    const ngfvk_renderpass_cache_entry cache_entry = {
-        .rt         = rt,
-        .ops_key    = ops_key,
-        .renderpass = result};
-    CURRENT_CONTEXT->renderpass_cache.push_back(cache_entry);
+  if (_vk.dynamic_rendering) {
+    ngfvk_cmd_begin_rendering(buf, pass_info, vk_clears, clear_value_count, render_extent);
+  } else {
+    const ngfvk_swapchain* swapchain   = CURRENT_CONTEXT->swapchain.get();
+    const VkRenderPass     render_pass = ngfvk_lookup_renderpass(
+        target,
+        ngfvk_renderpass_ops_key(target, pass_info->load_ops, pass_info->store_ops));
+    const VkFramebuffer fb =
+        target->is_default ? swapchain->framebufs[swapchain->image_idx] : target->frame_buffer;
+    const VkRenderPassBeginInfo begin_info = {
+        .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .pNext           = NULL,
+        .renderPass      = render_pass,
+        .framebuffer     = fb,
+        .renderArea      = {.offset = {0u, 0u}, .extent = render_extent},
+        .clearValueCount = clear_value_count,
+        .pClearValues    = vk_clears};
+    vkCmdBeginRenderPass(
+        buf->vk_cmd_buffer,
+        &begin_info,
+        buf->executes_secondaries ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                  : VK_SUBPASS_CONTENTS_INLINE);
   }
 
-  return result;
+  // Clean up after the begin operation.
+  ngfi::tmp_arena().reset();
+}
+
+// Allocates and begins a secondary command buffer that continues the given render pass.
+static ngf_error
+ngfvk_cmd_buf_allocate_secondary(ngf_cmd_buffer buf, const ngf_render_pass_info* pass_info) {
+  const ngf_render_target target        = pass_info->render_target;
+  auto                    color_formats = ngfi::tmp_alloc<VkFormat>(target->nattachments);
+  VkCommandBufferInheritanceRenderingInfo rendering_info = {
+      .sType                   = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO,
+      .pNext                   = NULL,
+      .flags                   = 0u,
+      .viewMask                = 0u,
+      .colorAttachmentCount    = 0u,
+      .pColorAttachmentFormats = color_formats,
+      .depthAttachmentFormat   = VK_FORMAT_UNDEFINED,
+      .stencilAttachmentFormat = VK_FORMAT_UNDEFINED,
+      .rasterizationSamples    = VK_SAMPLE_COUNT_1_BIT};
+  VkCommandBufferInheritanceInfo inheritance_info = {
+      .sType                = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+      .pNext                = NULL,
+      .renderPass           = VK_NULL_HANDLE,
+      .subpass              = 0u,
+      .framebuffer          = VK_NULL_HANDLE,
+      .occlusionQueryEnable = VK_FALSE,
+      .queryFlags           = 0u,
+      .pipelineStatistics   = 0u};
+  if (_vk.dynamic_rendering) {
+    for (uint32_t a = 0u; a < target->nattachments; ++a) {
+      const ngf_attachment_description& desc = target->attachment_descs[a];
+      if (target->attachment_compat_pass_descs[a].is_resolve) { continue; }
+      const VkFormat format               = get_vk_image_format(desc.format);
+      rendering_info.rasterizationSamples = get_vk_sample_count(desc.sample_count);
+      if (desc.type == NGF_ATTACHMENT_COLOR) {
+        color_formats[rendering_info.colorAttachmentCount++] = format;
+      } else {
+        rendering_info.depthAttachmentFormat = format;
+        if (desc.type == NGF_ATTACHMENT_DEPTH_STENCIL) {
+          rendering_info.stencilAttachmentFormat = format;
+        }
+      }
+    }
+    inheritance_info.pNext = &rendering_info;
+  } else {
+    // Any render pass compatible with the one actually used by the primary will do, the framebuffer
+    // is left for the implementation to figure out.
+    inheritance_info.renderPass = ngfvk_lookup_renderpass(
+        target,
+        ngfvk_renderpass_ops_key(target, pass_info->load_ops, pass_info->store_ops));
+  }
+  return ngfvk_cmd_buffer_allocate_for_frame(
+      buf->parent_frame,
+      NGF_QUEUE_TYPE_GRAPHICS,
+      &inheritance_info,
+      &buf->vk_cmd_pool,
+      &buf->vk_cmd_buffer);
 }
 
 static bool ngfvk_init_loader_if_necessary() {
@@ -3571,40 +5673,142 @@ static void ngfvk_cmd_bind_resources(
   }
 }
 
-static void ngfvk_cmd_buf_reset_render_cmds(ngf_cmd_buffer cmd_buf) {
-  cmd_buf->in_pass_cmd_chnks.clear();
-}
-
-static void ngfvk_cmd_buf_add_render_cmd(
-    ngf_cmd_buffer          cmd_buf,
-    const ngfvk_render_cmd* cmd,
-    bool                    in_renderpass) {
-  if (in_renderpass) {
-    cmd_buf->in_pass_cmd_chnks.append(
-        *cmd,
-        CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
-  } else {
-    assert(false);
-  }
-}
-
 static void ngfvk_cmd_buf_reset_res_states(ngf_cmd_buffer cmd_buf) {
   cmd_buf->local_res_states.clear();
 }
 
 static inline ngfvk_sync_res ngfvk_sync_res_from_buf(ngf_buffer buf) {
   ngfvk_sync_res sync_res = {
-      .data = {.buf = buf},
-      .type = NGFVK_SYNC_RES_BUFFER,
-      .hash = buf->hash};
+      .data  = {.buf = buf},
+      .type  = NGFVK_SYNC_RES_BUFFER,
+      .hash  = buf->hash,
+      .range = {0u, 1u, 0u, 1u}};
   return sync_res;
 }
 
 static inline ngfvk_sync_res ngfvk_sync_res_from_img(ngf_image img) {
-  ngfvk_sync_res sync_res = {.data = {.img = img}, .type = NGFVK_SYNC_RES_IMAGE, .hash = img->hash};
+  ngfvk_sync_res sync_res = {
+      .data  = {.img = img},
+      .type  = NGFVK_SYNC_RES_IMAGE,
+      .hash  = img->hash,
+      .range = {0u, img->nlevels, 0u, img->nlayers}};
+  return sync_res;
+}
+
+// Same as above, but only for the given subresources of the image, clamped to its bounds.
+static inline ngfvk_sync_res
+ngfvk_sync_res_from_img_range(ngf_image img, const ngfvk_subres_range& range) {
+  ngfvk_sync_res sync_res   = ngfvk_sync_res_from_img(img);
+  sync_res.range.base_level = NGFI_MIN(range.base_level, img->nlevels - 1u);
+  sync_res.range.nlevels =
+      NGFI_MAX(1u, NGFI_MIN(range.nlevels, img->nlevels - sync_res.range.base_level));
+  sync_res.range.base_layer = NGFI_MIN(range.base_layer, img->nlayers - 1u);
+  sync_res.range.nlayers =
+      NGFI_MAX(1u, NGFI_MIN(range.nlayers, img->nlayers - sync_res.range.base_layer));
   return sync_res;
 }
 
+static inline bool ngfvk_subres_ranges_overlap(
+    const ngfvk_subres_range& a,
+    const ngfvk_subres_range& b) {
+  return a.base_level < b.base_level + b.nlevels && b.base_level < a.base_level + a.nlevels &&
+         a.base_layer < b.base_layer + b.nlayers && b.base_layer < a.base_layer + a.nlayers;
+}
+
+// Returns the smallest range containing both of the given ranges.
+static ngfvk_subres_range
+ngfvk_subres_range_union(const ngfvk_subres_range& a, const ngfvk_subres_range& b) {
+  const uint32_t base_level = NGFI_MIN(a.base_level, b.base_level);
+  const uint32_t base_layer = NGFI_MIN(a.base_layer, b.base_layer);
+  const uint32_t end_level  = NGFI_MAX(a.base_level + a.nlevels, b.base_level + b.nlevels);
+  const uint32_t end_layer  = NGFI_MAX(a.base_layer + a.nlayers, b.base_layer + b.nlayers);
+  return {base_level, end_level - base_level, base_layer, end_layer - base_layer};
+}
+
+static inline bool ngfvk_sync_state_eq(const ngfvk_sync_state* a, const ngfvk_sync_state* b) {
+  return a->last_writer_masks.access_mask == b->last_writer_masks.access_mask &&
+         a->last_writer_masks.stage_mask == b->last_writer_masks.stage_mask &&
+         a->active_readers_masks.access_mask == b->active_readers_masks.access_mask &&
+         a->active_readers_masks.stage_mask == b->active_readers_masks.stage_mask &&
+         a->per_stage_readers_mask == b->per_stage_readers_mask && a->layout == b->layout &&
+         a->queue == b->queue && a->skip_hazard_tracking == b->skip_hazard_tracking;
+}
+
+static inline bool ngfvk_sync_track_eq(const ngfvk_sync_track* a, const ngfvk_sync_track* b) {
+  return a->expected_sync_req.barrier_masks.access_mask ==
+             b->expected_sync_req.barrier_masks.access_mask &&
+         a->expected_sync_req.barrier_masks.stage_mask ==
+             b->expected_sync_req.barrier_masks.stage_mask &&
+         a->expected_sync_req.layout == b->expected_sync_req.layout &&
+         ngfvk_sync_state_eq(&a->sync_state, &b->sync_state) &&
+         a->had_barrier == b->had_barrier && a->accessed == b->accessed;
+}
+
+// Gives each subresource of the image its own global synchronization state, if it doesn't have
+// one already. Returns `false`, leaving the image as it was, if the memory for it can't be
+// allocated.
+static bool ngfvk_image_expand_sync_states(ngf_image img) {
+  if (img->subres_sync_states) return true;
+  const uint32_t          nsubres = img->nlevels * img->nlayers;
+  ngfvk_sync_state* const states  = ngfi::allocn<ngfvk_sync_state>(nsubres);
+  if (states == NULL) return false;
+  for (uint32_t s = 0u; s < nsubres; ++s) { states[s] = img->sync_state; }
+  img->subres_sync_states = states;
+  return true;
+}
+
+// Goes back to tracking a single global synchronization state for the whole image if all of its
+// subresources have ended up in the same state.
+static void ngfvk_image_collapse_sync_states(ngf_image img) {
+  if (!img->subres_sync_states) return;
+  const uint32_t nsubres = img->nlevels * img->nlayers;
+  for (uint32_t s = 1u; s < nsubres; ++s) {
+    if (!ngfvk_sync_state_eq(&img->subres_sync_states[0], &img->subres_sync_states[s])) return;
+  }
+  const bool skip_hazard_tracking      = img->sync_state.skip_hazard_tracking;
+  img->sync_state                      = img->subres_sync_states[0];
+  img->sync_state.skip_hazard_tracking = skip_hazard_tracking;
+  ngfi::freen(img->subres_sync_states, nsubres);
+  img->subres_sync_states = NULL;
+}
+
+// Same as `ngfvk_image_expand_sync_states`, for the data tracked by a cmd buffer.
+static bool ngfvk_sync_res_data_expand(ngfvk_sync_res_data* res_data, ngfi::arena& arena) {
+  if (res_data->subres) return true;
+  const ngf_image         img     = (ngf_image)res_data->res_handle;
+  const uint32_t          nsubres = img->nlevels * img->nlayers;
+  ngfvk_sync_track* const tracks  = arena.alloc<ngfvk_sync_track>(nsubres);
+  if (tracks == NULL) return false;
+  for (uint32_t s = 0u; s < nsubres; ++s) { tracks[s] = res_data->whole; }
+  res_data->subres = tracks;
+  return true;
+}
+
+// Same as `ngfvk_image_collapse_sync_states`, for the data tracked by a cmd buffer. The
+// per-subresource data remains allocated from the frame arena until it is reset.
+static void ngfvk_sync_res_data_collapse(ngfvk_sync_res_data* res_data) {
+  if (!res_data->subres) return;
+  const ngf_image img     = (ngf_image)res_data->res_handle;
+  const uint32_t  nsubres = img->nlevels * img->nlayers;
+  for (uint32_t s = 1u; s < nsubres; ++s) {
+    if (!ngfvk_sync_track_eq(&res_data->subres[0], &res_data->subres[s])) return;
+  }
+  res_data->whole  = res_data->subres[0];
+  res_data->subres = NULL;
+}
+
+static ngfvk_sync_res ngfvk_sync_res_from_data(const ngfvk_sync_res_data* res_data) {
+  return res_data->res_type == NGFVK_SYNC_RES_IMAGE
+             ? ngfvk_sync_res_from_img((ngf_image)res_data->res_handle)
+             : ngfvk_sync_res_from_buf((ngf_buffer)res_data->res_handle);
+}
+
+// Returns the data tracked for the given subresource index.
+static inline const ngfvk_sync_track*
+ngfvk_sync_res_data_track(const ngfvk_sync_res_data* res_data, uint32_t s) {
+  return res_data->subres ? &res_data->subres[s] : &res_data->whole;
+}
+
 static uintptr_t ngfvk_handle_from_sync_res(const ngfvk_sync_res* res) {
   return res->type == NGFVK_SYNC_RES_BUFFER ? (uintptr_t)res->data.img : (uintptr_t)res->data.buf;
 }
@@ -3627,10 +5831,11 @@ static bool ngfvk_cmd_buf_lookup_sync_res(
   if (new_res) {
     ngfvk_sync_res_data* sync_res_data = *sync_res_data_out;
     memset(sync_res_data, 0, sizeof(new_res_state));
-    sync_res_data->expected_sync_req.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-    sync_res_data->res_handle               = ngfvk_handle_from_sync_res(sync_res);
-    sync_res_data->res_type                 = sync_res->type;
-    sync_res_data->pending_sync_req_idx     = ~0u;
+    sync_res_data->whole.expected_sync_req.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    sync_res_data->subres                         = NULL;
+    sync_res_data->res_handle                     = ngfvk_handle_from_sync_res(sync_res);
+    sync_res_data->res_type                       = sync_res->type;
+    sync_res_data->pending_sync_req_idx           = ~0u;
   }
 
   return new_res;
@@ -3659,6 +5864,8 @@ static inline uint32_t ngfvk_stage_idx(VkPipelineStageFlagBits bit) {
     return 6;
   case VK_PIPELINE_STAGE_TRANSFER_BIT:
     return 7;
+  case VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT:
+    return 8;
   default:
     assert(false);
   }
@@ -3689,6 +5896,8 @@ static inline uint32_t ngfvk_access_idx(VkAccessFlagBits bit) {
     return 0u;
   case VK_ACCESS_TRANSFER_WRITE_BIT:
     return 1u;
+  case VK_ACCESS_INDIRECT_COMMAND_READ_BIT:
+    return 0u;
   default:
     assert(false);
   }
@@ -3708,7 +5917,8 @@ static uint32_t ngfvk_per_stage_access_mask(const ngfvk_sync_barrier_masks* barr
           VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,  // LATE_FRAGMENT_TESTS
       VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
           VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,                   // COLOR_ATTACHMENT_OUTPUT
-      VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT  // TRANSFER
+      VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT,  // TRANSFER
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT                          // DRAW_INDIRECT
   };
   static const uint32_t bits_per_stage = 3u;
 
@@ -3840,8 +6050,9 @@ static void ngfvk_sync_req_batch_init(uint32_t nmax_sync_reqs, ngfvk_sync_req_ba
   memset(result, 0, sizeof(*result));
   result->pending_sync_reqs  = ngfi::tmp_alloc<ngfvk_sync_req>(nmax_sync_reqs);
   result->sync_res_data_keys = ngfi::tmp_alloc<ngfvk_sync_res_hashtable::keyhash>(nmax_sync_reqs);
-  result->freshness          = ngfi::tmp_alloc<bool>(nmax_sync_reqs);
-  memset(result->freshness, 0, sizeof(bool) * nmax_sync_reqs);
+  result->pending_ranges     = ngfi::tmp_alloc<ngfvk_subres_range>(nmax_sync_reqs);
+  result->next_pending_idx   = ngfi::tmp_alloc<uint32_t>(nmax_sync_reqs);
+  result->owner_idx          = ngfi::tmp_alloc<uint32_t>(nmax_sync_reqs);
 }
 
 // Merges a given sync request with the resource's already pending sync request. Returns `false` and
@@ -3894,30 +6105,58 @@ static bool ngfvk_sync_req_batch_add(
     ngfvk_sync_res_hashtable::key_type key,
     uint64_t                           hash,
     ngfvk_sync_res_data*               sync_res_data,
-    bool                               fresh,
+    const ngfvk_subres_range&          range,
     const ngfvk_sync_req*              sync_req) {
-  if (sync_res_data->pending_sync_req_idx == ~0u) {
-    sync_res_data->pending_sync_req_idx = batch->npending_sync_reqs++;
-    if (sync_res_data->res_type == NGFVK_SYNC_RES_BUFFER) {
-      batch->nbuffer_sync_reqs++;
-    } else if (sync_res_data->res_type == NGFVK_SYNC_RES_IMAGE) {
-      batch->nimage_sync_reqs++;
+  // Find the group of pending requests overlapping the given range. If the range bridges several
+  // groups, they are folded into one. A range entirely within one of the pending ranges adds
+  // nothing new to cover, so only the group's request needs to be updated.
+  bool     result    = true;
+  uint32_t owner     = ~0u;
+  bool     contained = false;
+  for (uint32_t i = sync_res_data->pending_sync_req_idx; i != ~0u; i = batch->next_pending_idx[i]) {
+    const ngfvk_subres_range& pending_range = batch->pending_ranges[i];
+    if (!ngfvk_subres_ranges_overlap(pending_range, range)) continue;
+    contained |= pending_range.base_level <= range.base_level &&
+                 pending_range.base_layer <= range.base_layer &&
+                 pending_range.base_level + pending_range.nlevels >=
+                     range.base_level + range.nlevels &&
+                 pending_range.base_layer + pending_range.nlayers >=
+                     range.base_layer + range.nlayers;
+    const uint32_t other_owner = batch->owner_idx[i];
+    if (owner == ~0u) {
+      owner = other_owner;
+    } else if (other_owner != owner) {
+      result &= ngfvk_sync_req_merge(
+          &batch->pending_sync_reqs[owner],
+          &batch->pending_sync_reqs[other_owner]);
+      for (uint32_t j = sync_res_data->pending_sync_req_idx; j != ~0u;
+           j          = batch->next_pending_idx[j]) {
+        if (batch->owner_idx[j] == other_owner) { batch->owner_idx[j] = owner; }
+      }
     }
-    memset(
-        &batch->pending_sync_reqs[sync_res_data->pending_sync_req_idx],
-        0,
-        sizeof(batch->pending_sync_reqs[0]));
-    batch->pending_sync_reqs[sync_res_data->pending_sync_req_idx].layout =
-        VK_IMAGE_LAYOUT_UNDEFINED;
-    batch->sync_res_data_keys[sync_res_data->pending_sync_req_idx].key  = key;
-    batch->sync_res_data_keys[sync_res_data->pending_sync_req_idx].hash = hash;
   }
-  if (fresh && sync_res_data->pending_sync_req_idx < batch->npending_sync_reqs) {
-    batch->freshness[sync_res_data->pending_sync_req_idx] = true;
+  if (contained) {
+    return ngfvk_sync_req_merge(&batch->pending_sync_reqs[owner], sync_req) && result;
   }
-  return ngfvk_sync_req_merge(
-      &batch->pending_sync_reqs[sync_res_data->pending_sync_req_idx],
-      sync_req);
+
+  const uint32_t idx = batch->npending_sync_reqs++;
+  if (sync_res_data->res_type == NGFVK_SYNC_RES_BUFFER) {
+    batch->nbuffer_sync_reqs++;
+  } else if (sync_res_data->res_type == NGFVK_SYNC_RES_IMAGE) {
+    batch->nimage_sync_reqs++;
+  }
+  if (owner == ~0u) {
+    owner = idx;
+    memset(&batch->pending_sync_reqs[idx], 0, sizeof(batch->pending_sync_reqs[0]));
+    batch->pending_sync_reqs[idx].layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  }
+  batch->sync_res_data_keys[idx].key  = key;
+  batch->sync_res_data_keys[idx].hash = hash;
+  batch->pending_ranges[idx]          = range;
+  batch->owner_idx[idx]               = owner;
+  batch->next_pending_idx[idx]        = sync_res_data->pending_sync_req_idx;
+  sync_res_data->pending_sync_req_idx = idx;
+  return ngfvk_sync_req_merge(&batch->pending_sync_reqs[owner], sync_req) && result;
 }
 
 static bool ngfvk_sync_req_batch_add_with_lookup(
@@ -3935,18 +6174,29 @@ static bool ngfvk_sync_req_batch_add_with_lookup(
   default:;
   }
   ngfvk_sync_res_data* sync_res_data;
-
-  const bool fresh = ngfvk_cmd_buf_lookup_sync_res(cmd_buf, res, &sync_res_data);
+  ngfvk_cmd_buf_lookup_sync_res(cmd_buf, res, &sync_res_data);
 
   return ngfvk_sync_req_batch_add(
       batch,
       ngfvk_handle_from_sync_res(res),
       res->hash,
       sync_res_data,
-      fresh,
+      res->range,
       sync_req);
 }
 
+// Queue family indices for a barrier. Unless the barrier transfers the ownership of a resource
+// between queue families, they are ignored.
+static uint32_t ngfvk_barrier_src_queue_family(const ngfvk_barrier_data* barrier) {
+  return barrier->src_queue_family != barrier->dst_queue_family ? barrier->src_queue_family
+                                                                  : VK_QUEUE_FAMILY_IGNORED;
+}
+
+static uint32_t ngfvk_barrier_dst_queue_family(const ngfvk_barrier_data* barrier) {
+  return barrier->src_queue_family != barrier->dst_queue_family ? barrier->dst_queue_family
+                                                                  : VK_QUEUE_FAMILY_IGNORED;
+}
+
 static void ngfvk_sync_commit_pending_barriers_legacy(
     ngfvk_pending_barrier_list* pending_bars,
     VkCommandBuffer             cmd_buf) {
@@ -3967,17 +6217,17 @@ static void ngfvk_sync_commit_pending_barriers_legacy(
       VkImageMemoryBarrier* image_barrier            = &img_bars[nimg_bars++];
       image_barrier->sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
       image_barrier->pNext                           = NULL;
-      image_barrier->srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-      image_barrier->dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier->srcQueueFamilyIndex             = ngfvk_barrier_src_queue_family(barrier);
+      image_barrier->dstQueueFamilyIndex             = ngfvk_barrier_dst_queue_family(barrier);
       image_barrier->srcAccessMask                   = barrier->src_access_mask;
       image_barrier->dstAccessMask                   = barrier->dst_access_mask;
       image_barrier->oldLayout                       = barrier->src_layout;
       image_barrier->newLayout                       = barrier->dst_layout;
       image_barrier->image                           = (VkImage)img->alloc.obj_handle;
-      image_barrier->subresourceRange.baseArrayLayer = 0u;
-      image_barrier->subresourceRange.baseMipLevel   = 0u;
-      image_barrier->subresourceRange.layerCount     = img->nlayers;
-      image_barrier->subresourceRange.levelCount     = img->nlevels;
+      image_barrier->subresourceRange.baseArrayLayer = barrier->res.range.base_layer;
+      image_barrier->subresourceRange.baseMipLevel   = barrier->res.range.base_level;
+      image_barrier->subresourceRange.layerCount     = barrier->res.range.nlayers;
+      image_barrier->subresourceRange.levelCount     = barrier->res.range.nlevels;
       const bool is_depth                            = ngfvk_format_is_depth(img->vk_fmt);
       const bool is_stencil                          = ngfvk_format_is_stencil(img->vk_fmt);
       image_barrier->subresourceRange.aspectMask =
@@ -3991,8 +6241,8 @@ static void ngfvk_sync_commit_pending_barriers_legacy(
       VkBufferMemoryBarrier* buffer_barrier = &buf_bars[nbuf_bars++];
       buffer_barrier->sType                 = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
       buffer_barrier->pNext                 = NULL;
-      buffer_barrier->srcQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
-      buffer_barrier->dstQueueFamilyIndex   = VK_QUEUE_FAMILY_IGNORED;
+      buffer_barrier->srcQueueFamilyIndex   = ngfvk_barrier_src_queue_family(barrier);
+      buffer_barrier->dstQueueFamilyIndex   = ngfvk_barrier_dst_queue_family(barrier);
       buffer_barrier->srcAccessMask         = barrier->src_access_mask;
       buffer_barrier->dstAccessMask         = barrier->dst_access_mask;
       buffer_barrier->offset                = 0u;
@@ -4009,10 +6259,12 @@ static void ngfvk_sync_commit_pending_barriers_legacy(
   pending_bars->npending_buf_bars = 0u;
   pending_bars->npending_img_bars = 0u;
   if (nbuf_bars > 0 || nimg_bars > 0) {
+    // The release and acquire halves of queue family ownership transfers have empty destination
+    // and source stage masks respectively, which the legacy barrier API doesn't accept.
     vkCmdPipelineBarrier(
         cmd_buf,
-        src_stage_mask,
-        dst_stage_mask,
+        src_stage_mask ? src_stage_mask : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        dst_stage_mask ? dst_stage_mask : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
         0u,
         0u,
         NULL,
@@ -4023,11 +6275,12 @@ static void ngfvk_sync_commit_pending_barriers_legacy(
   }
 }
 
-static void ngfvk_sync_commit_pending_barriers_sync2(
-    ngfvk_pending_barrier_list* pending_bars,
-    VkCommandBuffer             cmd_buf) {
-  auto     img_bars  = ngfi::tmp_alloc<VkImageMemoryBarrier2>(pending_bars->npending_img_bars);
-  auto     buf_bars  = ngfi::tmp_alloc<VkBufferMemoryBarrier2>(pending_bars->npending_buf_bars);
+// Translates a list of barriers for the synchronization2 API. The barrier arrays referenced by the
+// resulting dependency info are allocated from the given arena.
+static VkDependencyInfo
+ngfvk_sync_dependency_info(const ngfvk_pending_barrier_list* pending_bars, ngfi::arena& arena) {
+  auto     img_bars  = arena.alloc<VkImageMemoryBarrier2>(pending_bars->npending_img_bars);
+  auto     buf_bars  = arena.alloc<VkBufferMemoryBarrier2>(pending_bars->npending_buf_bars);
   uint32_t nimg_bars = 0u;
   uint32_t nbuf_bars = 0u;
   for (const ngfvk_barrier_data& barrier_ref : pending_bars->barriers) {
@@ -4038,8 +6291,8 @@ static void ngfvk_sync_commit_pending_barriers_sync2(
       VkImageMemoryBarrier2* image_barrier           = &img_bars[nimg_bars++];
       image_barrier->sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
       image_barrier->pNext                           = NULL;
-      image_barrier->srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
-      image_barrier->dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+      image_barrier->srcQueueFamilyIndex             = ngfvk_barrier_src_queue_family(barrier);
+      image_barrier->dstQueueFamilyIndex             = ngfvk_barrier_dst_queue_family(barrier);
       image_barrier->srcStageMask                    = barrier->src_stage_mask;
       image_barrier->dstStageMask                    = barrier->dst_stage_mask;
       image_barrier->srcAccessMask                   = barrier->src_access_mask;
@@ -4047,10 +6300,10 @@ static void ngfvk_sync_commit_pending_barriers_sync2(
       image_barrier->oldLayout                       = barrier->src_layout;
       image_barrier->newLayout                       = barrier->dst_layout;
       image_barrier->image                           = (VkImage)img->alloc.obj_handle;
-      image_barrier->subresourceRange.baseArrayLayer = 0u;
-      image_barrier->subresourceRange.baseMipLevel   = 0u;
-      image_barrier->subresourceRange.layerCount     = img->nlayers;
-      image_barrier->subresourceRange.levelCount     = img->nlevels;
+      image_barrier->subresourceRange.baseArrayLayer = barrier->res.range.base_layer;
+      image_barrier->subresourceRange.baseMipLevel   = barrier->res.range.base_level;
+      image_barrier->subresourceRange.layerCount     = barrier->res.range.nlayers;
+      image_barrier->subresourceRange.levelCount     = barrier->res.range.nlevels;
       const bool is_depth                            = ngfvk_format_is_depth(img->vk_fmt);
       const bool is_stencil                          = ngfvk_format_is_stencil(img->vk_fmt);
       image_barrier->subresourceRange.aspectMask =
@@ -4066,8 +6319,8 @@ static void ngfvk_sync_commit_pending_barriers_sync2(
       buffer_barrier->pNext                  = NULL;
       buffer_barrier->srcStageMask           = barrier->src_stage_mask;
       buffer_barrier->dstStageMask           = barrier->dst_stage_mask;
-      buffer_barrier->srcQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED;
-      buffer_barrier->dstQueueFamilyIndex    = VK_QUEUE_FAMILY_IGNORED;
+      buffer_barrier->srcQueueFamilyIndex    = ngfvk_barrier_src_queue_family(barrier);
+      buffer_barrier->dstQueueFamilyIndex    = ngfvk_barrier_dst_queue_family(barrier);
       buffer_barrier->srcAccessMask          = barrier->src_access_mask;
       buffer_barrier->dstAccessMask          = barrier->dst_access_mask;
       buffer_barrier->offset                 = 0u;
@@ -4080,20 +6333,27 @@ static void ngfvk_sync_commit_pending_barriers_sync2(
       break;
     }
   }
+  const VkDependencyInfo dep_info = {
+      .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+      .pNext                    = NULL,
+      .dependencyFlags          = 0u,
+      .memoryBarrierCount       = 0u,
+      .pMemoryBarriers          = NULL,
+      .bufferMemoryBarrierCount = nbuf_bars,
+      .pBufferMemoryBarriers    = buf_bars,
+      .imageMemoryBarrierCount  = nimg_bars,
+      .pImageMemoryBarriers     = img_bars};
+  return dep_info;
+}
+
+static void ngfvk_sync_commit_pending_barriers_sync2(
+    ngfvk_pending_barrier_list* pending_bars,
+    VkCommandBuffer             cmd_buf) {
+  const VkDependencyInfo dep_info = ngfvk_sync_dependency_info(pending_bars, ngfi::tmp_arena());
   pending_bars->barriers.clear();
   pending_bars->npending_buf_bars = 0u;
   pending_bars->npending_img_bars = 0u;
-  if (nbuf_bars > 0 || nimg_bars > 0) {
-    const VkDependencyInfo dep_info = {
-        .sType                    = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
-        .pNext                    = NULL,
-        .dependencyFlags          = 0u,
-        .memoryBarrierCount       = 0u,
-        .pMemoryBarriers          = NULL,
-        .bufferMemoryBarrierCount = nbuf_bars,
-        .pBufferMemoryBarriers    = buf_bars,
-        .imageMemoryBarrierCount  = nimg_bars,
-        .pImageMemoryBarriers     = img_bars};
+  if (dep_info.bufferMemoryBarrierCount > 0 || dep_info.imageMemoryBarrierCount > 0) {
     vkCmdPipelineBarrier2(cmd_buf, &dep_info);
   }
 }
@@ -4108,8 +6368,116 @@ static void ngfvk_sync_commit_pending_barriers(
   }
 }
 
+// Accumulates barriers for individual subresources of an image, visited in level-major order, into
+// as few barriers over rectangular subresource ranges as it can.
+struct ngfvk_subres_barrier_builder {
+  ngfvk_pending_barrier_list* list;
+  ngfi::arena*                arena;
+  ngf_image                   img;
+  ngfvk_barrier_data          run;   // < Barrier for a run of adjacent layers within a level.
+  ngfvk_barrier_data*         last;  // < Barrier most recently appended to the list.
+  bool                        has_run;
+};
+
+static void ngfvk_subres_barrier_builder_init(
+    ngfvk_subres_barrier_builder* builder,
+    ngfvk_pending_barrier_list*   list,
+    ngfi::arena&                  arena,
+    ngf_image                     img) {
+  memset(builder, 0, sizeof(*builder));
+  builder->list  = list;
+  builder->arena = &arena;
+  builder->img   = img;
+}
+
+// Checks whether two barriers differ only in the resources they apply to.
+static bool
+ngfvk_barrier_data_compatible(const ngfvk_barrier_data* a, const ngfvk_barrier_data* b) {
+  return a->src_access_mask == b->src_access_mask && a->dst_access_mask == b->dst_access_mask &&
+         a->src_stage_mask == b->src_stage_mask && a->dst_stage_mask == b->dst_stage_mask &&
+         a->src_layout == b->src_layout && a->dst_layout == b->dst_layout &&
+         a->src_queue_family == b->src_queue_family && a->dst_queue_family == b->dst_queue_family;
+}
+
+static void ngfvk_subres_barrier_builder_flush(ngfvk_subres_barrier_builder* builder) {
+  if (!builder->has_run) return;
+  builder->has_run = false;
+
+  const ngfvk_subres_range& run  = builder->run.res.range;
+  ngfvk_barrier_data*       last = builder->last;
+  // Extend the last barrier to the next level if it covers the same layers.
+  if (last && ngfvk_barrier_data_compatible(last, &builder->run) &&
+      last->res.range.base_layer == run.base_layer && last->res.range.nlayers == run.nlayers &&
+      last->res.range.base_level + last->res.range.nlevels == run.base_level) {
+    last->res.range.nlevels += run.nlevels;
+  } else {
+    builder->last = builder->list->barriers.append(builder->run, *builder->arena);
+    builder->list->npending_img_bars++;
+  }
+}
+
+static void ngfvk_subres_barrier_builder_add(
+    ngfvk_subres_barrier_builder* builder,
+    const ngfvk_barrier_data*     barrier,
+    uint32_t                      level,
+    uint32_t                      layer) {
+  ngfvk_subres_range* run = &builder->run.res.range;
+  if (builder->has_run && ngfvk_barrier_data_compatible(&builder->run, barrier) &&
+      run->base_level == level && run->base_layer + run->nlayers == layer) {
+    run->nlayers++;
+    return;
+  }
+  ngfvk_subres_barrier_builder_flush(builder);
+  builder->run     = *barrier;
+  builder->run.res = ngfvk_sync_res_from_img_range(builder->img, {level, 1u, layer, 1u});
+  builder->has_run = true;
+}
+
+// Updates the data tracked by a cmd buffer for a resource or subresource to account for an access
+// described by `sync_req`. Returns `true` if a barrier has to be recorded before the access. The
+// first access within a cmd buffer never gets a barrier here. Instead, it is recorded as expected
+// by the cmd buffer, and reconciled with the global synchronization state at submission time.
+static bool ngfvk_sync_track_process(
+    ngfvk_sync_track*     track,
+    const ngfvk_sync_req* sync_req,
+    ngfvk_barrier_data*   barrier) {
+  const bool barrier_needed =
+      ngfvk_sync_barrier(&track->sync_state, sync_req, barrier) && track->accessed;
+  if (barrier_needed) { track->had_barrier = true; }
+  if (!track->had_barrier) {
+    track->expected_sync_req.barrier_masks.stage_mask |= sync_req->barrier_masks.stage_mask;
+    track->expected_sync_req.barrier_masks.access_mask |= sync_req->barrier_masks.access_mask;
+    // Make note of the initial layout with which the resource is expected to be used.
+    if (track->expected_sync_req.layout == VK_IMAGE_LAYOUT_UNDEFINED) {
+      track->expected_sync_req.layout = sync_req->layout;
+    }
+  }
+  track->accessed = true;
+  return barrier_needed;
+}
+
+// Checks whether any of the ranges in the group owned by the given pending request covers the
+// given subresource.
+static bool ngfvk_sync_req_group_covers(
+    const ngfvk_sync_req_batch* batch,
+    const ngfvk_sync_res_data*  sync_res_data,
+    uint32_t                    owner,
+    uint32_t                    level,
+    uint32_t                    layer) {
+  for (uint32_t i = sync_res_data->pending_sync_req_idx; i != ~0u; i = batch->next_pending_idx[i]) {
+    const ngfvk_subres_range& r = batch->pending_ranges[i];
+    if (batch->owner_idx[i] == owner && level >= r.base_level &&
+        level < r.base_level + r.nlevels && layer >= r.base_layer &&
+        layer < r.base_layer + r.nlayers) {
+      return true;
+    }
+  }
+  return false;
+}
+
 static void ngfvk_sync_req_batch_process(ngfvk_sync_req_batch* batch, ngf_cmd_buffer cmd_buf) {
-  for (size_t i = 0u; i < batch->npending_sync_reqs; ++i) {
+  for (uint32_t i = 0u; i < batch->npending_sync_reqs; ++i) {
+    if (batch->owner_idx[i] != i) continue;  // Part of a group owned by another request.
     auto sync_res_data = cmd_buf->local_res_states.get_prehashed(batch->sync_res_data_keys[i]);
     if (!sync_res_data) {
       NGFI_DIAG_WARNING(
@@ -4117,37 +6485,68 @@ static void ngfvk_sync_req_batch_process(ngfvk_sync_req_batch* batch, ngf_cmd_bu
       assert(false);
     }
 
+    // Find the range spanned by the group, and whether it is made up of more than one range.
+    ngfvk_subres_range range   = batch->pending_ranges[i];
+    uint32_t           nranges = 0u;
+    for (uint32_t j = sync_res_data->pending_sync_req_idx; j != ~0u;
+         j          = batch->next_pending_idx[j]) {
+      if (batch->owner_idx[j] != i) continue;
+      range = ngfvk_subres_range_union(range, batch->pending_ranges[j]);
+      ++nranges;
+    }
+
     const ngfvk_sync_req* sync_req = &batch->pending_sync_reqs[i];
-    const bool            fresh    = batch->freshness[i];
+    const ngfvk_sync_res  res      = ngfvk_sync_res_from_data(sync_res_data);
     ngfvk_barrier_data    barrier_data;
-    const bool            barrier_needed =
-        ngfvk_sync_barrier(&sync_res_data->sync_state, sync_req, &barrier_data);
-    if (barrier_needed && !fresh) {
-      barrier_data.res.type = sync_res_data->res_type;
-      if (barrier_data.res.type == NGFVK_SYNC_RES_IMAGE) {
-        barrier_data.res.data.img = (ngf_image)sync_res_data->res_handle;
-        ++cmd_buf->pending_barriers.npending_img_bars;
-      } else {
-        barrier_data.res.data.buf = (ngf_buffer)sync_res_data->res_handle;
-        ++cmd_buf->pending_barriers.npending_buf_bars;
+    bool                  whole_res =
+        res.type != NGFVK_SYNC_RES_IMAGE ||
+        (!sync_res_data->subres && nranges == 1u && range.nlevels == res.range.nlevels &&
+         range.nlayers == res.range.nlayers);
+    // Only some subresources of the image are accessed, so track them separately. If that isn't
+    // possible, synchronize the whole image instead, which is overly conservative, but correct.
+    if (!whole_res && !ngfvk_sync_res_data_expand(sync_res_data, current_frame_res_arena())) {
+      NGFI_DIAG_WARNING("Failed to allocate per-subresource synchronization data for image. "
+                        "Synchronizing the whole image instead.");
+      whole_res = true;
+    }
+    if (whole_res) {
+      if (ngfvk_sync_track_process(&sync_res_data->whole, sync_req, &barrier_data)) {
+        barrier_data.res = res;
+        if (res.type == NGFVK_SYNC_RES_IMAGE) {
+          ++cmd_buf->pending_barriers.npending_img_bars;
+        } else {
+          ++cmd_buf->pending_barriers.npending_buf_bars;
+        }
+        cmd_buf->pending_barriers.barriers.append(barrier_data, current_frame_res_arena());
       }
-      cmd_buf->pending_barriers.barriers.append(
-          barrier_data,
-          CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
-      sync_res_data->had_barrier = true;
-    }
-    sync_res_data->pending_sync_req_idx = ~0u;
-
-    if (!sync_res_data->had_barrier) {
-      sync_res_data->expected_sync_req.barrier_masks.stage_mask |=
-          sync_req->barrier_masks.stage_mask;
-      sync_res_data->expected_sync_req.barrier_masks.access_mask |=
-          sync_req->barrier_masks.access_mask;
-      // Make note of the initial layout with which the resource is expected to be used.
-      if (sync_res_data->expected_sync_req.layout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        sync_res_data->expected_sync_req.layout = sync_req->layout;
+      continue;
+    }
+
+    const ngf_image              img   = res.data.img;
+    ngfi::arena&                 arena = current_frame_res_arena();
+    ngfvk_subres_barrier_builder builder;
+    ngfvk_subres_barrier_builder_init(&builder, &cmd_buf->pending_barriers, arena, img);
+    for (uint32_t level = range.base_level; level < range.base_level + range.nlevels; ++level) {
+      for (uint32_t layer = range.base_layer; layer < range.base_layer + range.nlayers; ++layer) {
+        if (nranges > 1u &&
+            !ngfvk_sync_req_group_covers(batch, sync_res_data, i, level, layer)) {
+          continue;
+        }
+        ngfvk_sync_track* track = &sync_res_data->subres[level * img->nlayers + layer];
+        if (ngfvk_sync_track_process(track, sync_req, &barrier_data)) {
+          ngfvk_subres_barrier_builder_add(&builder, &barrier_data, level, layer);
+        }
       }
     }
+    ngfvk_subres_barrier_builder_flush(&builder);
+    ngfvk_sync_res_data_collapse(sync_res_data);
+  }
+
+  // The chains of pending requests are only needed until all of the groups have been processed.
+  for (uint32_t i = 0u; i < batch->npending_sync_reqs; ++i) {
+    if (batch->owner_idx[i] != i) continue;
+    auto sync_res_data = cmd_buf->local_res_states.get_prehashed(batch->sync_res_data_keys[i]);
+    if (sync_res_data) { sync_res_data->pending_sync_req_idx = ~0u; }
   }
 }
 
@@ -4156,18 +6555,151 @@ static void ngfvk_sync_req_batch_commit(ngfvk_sync_req_batch* batch, ngf_cmd_buf
   ngfvk_sync_commit_pending_barriers(&cmd_buf->pending_barriers, cmd_buf->vk_cmd_buffer);
 }
 
-static void ngfvk_handle_single_sync_req(
-    ngf_cmd_buffer        cmd_buf,
-    const ngfvk_sync_res* res,
-    const ngfvk_sync_req* sync_req) {
-  bool                              fresh = false;
-  ngfvk_sync_res_hashtable::keyhash sync_res_data_key;
-  ngfvk_sync_req empty_sync_req = {.barrier_masks = {0u, 0u}, .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+// Checks whether a resource with the given synchronization state has to be transferred to another
+// queue before it is accessed on that queue. Resources that haven't been accessed yet have no
+// contents worth preserving, and read-only resources are never transferred.
+static bool ngfvk_sync_needs_queue_transfer(const ngfvk_sync_state* sync_state, uint8_t queue) {
+  return sync_state->queue != queue && !sync_state->skip_hazard_tracking &&
+         (sync_state->last_writer_masks.stage_mask != 0u ||
+          sync_state->active_readers_masks.stage_mask != 0u ||
+          sync_state->layout != VK_IMAGE_LAYOUT_UNDEFINED);
+}
 
-  ngfvk_sync_req_batch batch = {
-      .sync_res_data_keys = &sync_res_data_key,
-      .pending_sync_reqs  = &empty_sync_req,
-      .freshness          = &fresh,
+// Populates the pair of barriers that transfer the ownership of a resource between two queue
+// families before it is accessed according to `sync_req`. The release barrier has to execute on the
+// source queue, and the acquire barrier on the destination queue once the release has completed.
+// Any layout transition needed by the access is performed as part of the transfer. The
+// synchronization state is updated as if the access had happened.
+static void ngfvk_sync_queue_transfer(
+    ngfvk_sync_state*     sync_state,
+    const ngfvk_sync_req* sync_req,
+    uint32_t              src_queue_family,
+    uint32_t              dst_queue_family,
+    ngfvk_barrier_data*   release,
+    ngfvk_barrier_data*   acquire) {
+  memset(release, 0, sizeof(*release));
+  release->src_stage_mask =
+      sync_state->last_writer_masks.stage_mask | sync_state->active_readers_masks.stage_mask;
+  release->src_access_mask  = sync_state->last_writer_masks.access_mask;
+  release->src_layout       = sync_state->layout;
+  release->dst_layout       = sync_req->layout;
+  release->src_queue_family = src_queue_family;
+  release->dst_queue_family = dst_queue_family;
+
+  // Accesses on the source queue are complete by the time the acquire barrier executes.
+  memset(&sync_state->last_writer_masks, 0, sizeof(sync_state->last_writer_masks));
+  memset(&sync_state->active_readers_masks, 0, sizeof(sync_state->active_readers_masks));
+  sync_state->per_stage_readers_mask = 0u;
+  ngfvk_sync_barrier(sync_state, sync_req, acquire);
+
+  *acquire                 = *release;
+  acquire->src_stage_mask  = 0u;
+  acquire->src_access_mask = 0u;
+  acquire->dst_stage_mask  = sync_req->barrier_masks.stage_mask;
+  acquire->dst_access_mask = sync_req->barrier_masks.access_mask;
+}
+
+// Updates the synchronization state of a resource to account for accesses, described by `src`,
+// that happen after the ones reflected in `dst`.
+static void ngfvk_sync_state_merge(ngfvk_sync_state* dst, const ngfvk_sync_state* src) {
+  if (src->last_writer_masks.access_mask != 0) {
+    const bool    skip_hazard_tracking = dst->skip_hazard_tracking;
+    const uint8_t queue                = dst->queue;
+    *dst                               = *src;
+    dst->skip_hazard_tracking          = skip_hazard_tracking;
+    dst->queue                         = queue;
+  } else {
+    dst->active_readers_masks.access_mask |= src->active_readers_masks.access_mask;
+    dst->per_stage_readers_mask |= src->per_stage_readers_mask;
+  }
+}
+
+// Folds the hazard tracking state of a secondary command buffer into the primary command buffer
+// executing it, as if the secondary's commands had been recorded into the primary directly.
+// Barriers needed before the secondary's first use of each resource are added to the primary's
+// pending barriers, followed by the barriers that the secondary itself has accumulated.
+static ngf_error ngfvk_cmd_buf_merge_secondary(ngf_cmd_buffer primary, ngf_cmd_buffer secondary) {
+  uint32_t nmax_sync_reqs = 0u;
+  for (const auto& entry : secondary->local_res_states) {
+    const ngfvk_sync_res_data* res_data = &entry.value;
+    const ngf_image            img      = (ngf_image)res_data->res_handle;
+    nmax_sync_reqs += res_data->subres ? img->nlevels * img->nlayers : 1u;
+  }
+  ngfvk_sync_req_batch sync_req_batch;
+  ngfvk_sync_req_batch_init(nmax_sync_reqs, &sync_req_batch);
+  for (const auto& entry : secondary->local_res_states) {
+    const ngfvk_sync_res_data* res_data = &entry.value;
+    const ngfvk_sync_res       res      = ngfvk_sync_res_from_data(res_data);
+    if (!res_data->subres) {
+      ngfvk_sync_req_batch_add_with_lookup(
+          &sync_req_batch,
+          primary,
+          &res,
+          &res_data->whole.expected_sync_req);
+      continue;
+    }
+    const ngf_image img = res.data.img;
+    for (uint32_t s = 0u; s < img->nlevels * img->nlayers; ++s) {
+      const ngfvk_sync_track* track = &res_data->subres[s];
+      if (!track->accessed) continue;
+      const ngfvk_sync_res subres =
+          ngfvk_sync_res_from_img_range(img, {s / img->nlayers, 1u, s % img->nlayers, 1u});
+      ngfvk_sync_req_batch_add_with_lookup(
+          &sync_req_batch,
+          primary,
+          &subres,
+          &track->expected_sync_req);
+    }
+  }
+  ngfvk_sync_req_batch_process(&sync_req_batch, primary);
+
+  for (const auto& entry : secondary->local_res_states) {
+    const ngfvk_sync_res_data* res_data = &entry.value;
+    const ngfvk_sync_res       res      = ngfvk_sync_res_from_data(res_data);
+    ngfvk_sync_res_data* primary_res_data;
+    ngfvk_cmd_buf_lookup_sync_res(primary, &res, &primary_res_data);
+    if (!res_data->subres && !primary_res_data->subres) {
+      ngfvk_sync_state_merge(&primary_res_data->whole.sync_state, &res_data->whole.sync_state);
+      continue;
+    }
+    const ngf_image img = res.data.img;
+    if (!ngfvk_sync_res_data_expand(primary_res_data, current_frame_res_arena())) {
+      return NGF_ERROR_OUT_OF_MEM;
+    }
+    for (uint32_t s = 0u; s < img->nlevels * img->nlayers; ++s) {
+      const ngfvk_sync_track* track = ngfvk_sync_res_data_track(res_data, s);
+      if (!track->accessed) continue;
+      ngfvk_sync_state_merge(&primary_res_data->subres[s].sync_state, &track->sync_state);
+    }
+    ngfvk_sync_res_data_collapse(primary_res_data);
+  }
+
+  for (const ngfvk_barrier_data& barrier_data : secondary->pending_barriers.barriers) {
+    primary->pending_barriers.barriers.append(
+        barrier_data,
+        CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
+  }
+  primary->pending_barriers.npending_img_bars += secondary->pending_barriers.npending_img_bars;
+  primary->pending_barriers.npending_buf_bars += secondary->pending_barriers.npending_buf_bars;
+  return NGF_ERROR_OK;
+}
+
+static void ngfvk_handle_single_sync_req(
+    ngf_cmd_buffer        cmd_buf,
+    const ngfvk_sync_res* res,
+    const ngfvk_sync_req* sync_req) {
+  ngfvk_sync_res_hashtable::keyhash sync_res_data_key;
+  ngfvk_subres_range                pending_range;
+  uint32_t                          next_pending_idx;
+  uint32_t                          owner_idx;
+  ngfvk_sync_req empty_sync_req = {.barrier_masks = {0u, 0u}, .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+  ngfvk_sync_req_batch batch = {
+      .sync_res_data_keys = &sync_res_data_key,
+      .pending_sync_reqs  = &empty_sync_req,
+      .pending_ranges     = &pending_range,
+      .next_pending_idx   = &next_pending_idx,
+      .owner_idx          = &owner_idx,
       .npending_sync_reqs = 0,
       .nbuffer_sync_reqs  = 0,
       .nimage_sync_reqs   = 0};
@@ -4180,11 +6712,14 @@ static ngfvk_sync_res ngfvk_sync_res_from_bind_op(const ngf_resource_bind_op* bi
   switch (bind_op->type) {
   case NGF_DESCRIPTOR_IMAGE:
   case NGF_DESCRIPTOR_IMAGE_AND_SAMPLER:
-  case NGF_DESCRIPTOR_STORAGE_IMAGE:
-    return ngfvk_sync_res_from_img(
-        bind_op->info.image_sampler.is_image_view ? bind_op->info.image_sampler.resource.view->src
-                                                  : bind_op->info.image_sampler.resource.image);
+  case NGF_DESCRIPTOR_STORAGE_IMAGE: {
+    // Only the subresources covered by an image view are accessed through it.
+    const ngf_image_view view = bind_op->info.image_sampler.resource.view;
+    return bind_op->info.image_sampler.is_image_view
+               ? ngfvk_sync_res_from_img_range(view->src, view->range)
+               : ngfvk_sync_res_from_img(bind_op->info.image_sampler.resource.image);
     break;
+  }
   case NGF_DESCRIPTOR_STORAGE_BUFFER:
   case NGF_DESCRIPTOR_UNIFORM_BUFFER:
     return ngfvk_sync_res_from_buf(bind_op->info.buffer.buffer);
@@ -4256,137 +6791,617 @@ static ngfvk_sync_req ngfvk_sync_req_for_bind_op(
   return sync_req;
 }
 
-// Actually records renderpass commands into a command buffer.
-static void ngfvk_cmd_buf_record_render_cmds(
-    ngf_cmd_buffer                              buf,
-    const ngfi::chunked_list<ngfvk_render_cmd>& cmd_list) {
-  ngfi::tmp_arena().reset();
+static ngfvk_sync_res ngfvk_sync_res_from_declared_resource(const ngf_render_pass_resource* r) {
+  return r->usage == NGF_RENDER_RESOURCE_USAGE_IMAGE ? ngfvk_sync_res_from_img(r->image)
+                                                     : ngfvk_sync_res_from_buf(r->buffer);
+}
 
-  for (const ngfvk_render_cmd& cmd_ref : cmd_list) {
-    const ngfvk_render_cmd* cmd = &cmd_ref;
-    switch (cmd->type) {
-    case NGFVK_RENDER_CMD_BIND_PIPELINE: {
-      buf->active_gfx_pipe = cmd->data.pipeline;
-      // If we had a pipeline bound for which there have been resources bound, but no draw call
-      // executed, commit those resources to actual descriptor sets and bind them so that the next
-      // pipeline is able to "see" those resources, provided that it's compatible.
-      if (buf->active_gfx_pipe && buf->npending_bind_ops > 0u) { ngfvk_execute_pending_binds(buf); }
-      vkCmdBindPipeline(
-          buf->vk_cmd_buffer,
-          VK_PIPELINE_BIND_POINT_GRAPHICS,
-          ((ngfvk_generic_pipeline*)(cmd->data.pipeline))->vk_pipeline);
-      break;
-    }
-    case NGFVK_RENDER_CMD_SET_VIEWPORT: {
-      const VkViewport viewport = {
-          .x        = (float)cmd->data.rect.x,
-          .y        = (float)cmd->data.rect.y,
-          .width    = NGFI_MAX(1, (float)cmd->data.rect.width),
-          .height   = NGFI_MAX(1, (float)cmd->data.rect.height),
-          .minDepth = 0.0f,
-          .maxDepth = 1.0f};
-      vkCmdSetViewport(buf->vk_cmd_buffer, 0u, 1u, &viewport);
-      break;
-    }
-    case NGFVK_RENDER_CMD_SET_SCISSOR: {
-      const ngf_irect2d* r            = &cmd->data.rect;
-      const VkRect2D     scissor_rect = {.offset = {r->x, r->y}, .extent = {r->width, r->height}};
-      vkCmdSetScissor(buf->vk_cmd_buffer, 0u, 1u, &scissor_rect);
-      break;
+// Returns a sync request for reading draw or dispatch arguments from a buffer.
+static ngfvk_sync_req ngfvk_sync_req_for_indirect_args() {
+  ngfvk_sync_req sync_req;
+  sync_req.barrier_masks.access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+  sync_req.barrier_masks.stage_mask  = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+  sync_req.layout                    = VK_IMAGE_LAYOUT_UNDEFINED;
+  return sync_req;
+}
+
+// Returns a sync request corresponding to a resource declared up front for an immediate mode
+// render pass. The pipelines used within the pass aren't known at that point, so shader accesses
+// are assumed to happen in both the vertex and fragment stages.
+static ngfvk_sync_req ngfvk_sync_req_for_declared_resource(const ngf_render_pass_resource* r) {
+  ngfvk_sync_req sync_req;
+  memset(&sync_req, 0, sizeof(sync_req));
+  sync_req.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+  sync_req.barrier_masks.stage_mask =
+      VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+  switch (r->usage) {
+  case NGF_RENDER_RESOURCE_USAGE_ATTRIB_BUFFER: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+    sync_req.barrier_masks.stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_INDEX_BUFFER: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_INDEX_READ_BIT;
+    sync_req.barrier_masks.stage_mask  = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_UNIFORM_BUFFER: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_UNIFORM_READ_BIT;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_STORAGE_BUFFER: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_TEXEL_BUFFER: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_SHADER_READ_BIT;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_IMAGE: {
+    sync_req.barrier_masks.access_mask = VK_ACCESS_SHADER_READ_BIT;
+    sync_req.layout                    = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    break;
+  }
+  case NGF_RENDER_RESOURCE_USAGE_INDIRECT_BUFFER: {
+    sync_req = ngfvk_sync_req_for_indirect_args();
+    break;
+  }
+  default:
+    assert(0);
+  }
+  return sync_req;
+}
+
+static_assert(
+    offsetof(ngf_draw_info, first_element) == offsetof(VkMultiDrawIndexedInfoEXT, firstIndex) &&
+        offsetof(ngf_draw_info, nelements) == offsetof(VkMultiDrawIndexedInfoEXT, indexCount) &&
+        offsetof(ngf_draw_info, base_vertex) == offsetof(VkMultiDrawIndexedInfoEXT, vertexOffset) &&
+        offsetof(ngf_draw_info, first_element) == offsetof(VkMultiDrawInfoEXT, firstVertex) &&
+        offsetof(ngf_draw_info, nelements) == offsetof(VkMultiDrawInfoEXT, vertexCount),
+    "ngf_draw_info must be usable as VkMultiDraw*InfoEXT");
+
+static void ngfvk_record_draw(VkCommandBuffer cmd_buf, const ngf_draw_info* draw, bool indexed) {
+  if (indexed) {
+    vkCmdDrawIndexed(
+        cmd_buf,
+        draw->nelements,
+        draw->ninstances,
+        draw->first_element,
+        draw->base_vertex,
+        draw->first_instance);
+  } else {
+    vkCmdDraw(
+        cmd_buf,
+        draw->nelements,
+        draw->ninstances,
+        draw->first_element,
+        draw->first_instance);
+  }
+}
+
+// Returns the number of leading draws in the given array that can be issued with a single
+// vkCmdDrawMulti*EXT call, i.e. that share instance parameters, up to `max_batch`.
+static uint32_t
+ngfvk_multi_draw_batch_size(const ngf_draw_info* draws, uint32_t ndraws, uint32_t max_batch) {
+  uint32_t n = 1u;
+  while (n < ndraws && n < max_batch && draws[n].ninstances == draws[0].ninstances &&
+         draws[n].first_instance == draws[0].first_instance) {
+    ++n;
+  }
+  return n;
+}
+
+// Records a single renderpass command into a command buffer.
+static void ngfvk_cmd_buf_record_render_cmd(ngf_cmd_buffer buf, const ngfvk_render_cmd* cmd) {
+  switch (cmd->type) {
+  case NGFVK_RENDER_CMD_BIND_PIPELINE: {
+    buf->active_gfx_pipe = cmd->data.pipeline;
+    // If we had a pipeline bound for which there have been resources bound, but no draw call
+    // executed, commit those resources to actual descriptor sets and bind them so that the next
+    // pipeline is able to "see" those resources, provided that it's compatible.
+    if (buf->active_gfx_pipe && buf->npending_bind_ops > 0u) { ngfvk_execute_pending_binds(buf); }
+    vkCmdBindPipeline(
+        buf->vk_cmd_buffer,
+        VK_PIPELINE_BIND_POINT_GRAPHICS,
+        ((ngfvk_generic_pipeline*)(cmd->data.pipeline))->vk_pipeline);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_VIEWPORT: {
+    const VkViewport viewport = {
+        .x        = (float)cmd->data.rect.x,
+        .y        = (float)cmd->data.rect.y,
+        .width    = NGFI_MAX(1, (float)cmd->data.rect.width),
+        .height   = NGFI_MAX(1, (float)cmd->data.rect.height),
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f};
+    vkCmdSetViewport(buf->vk_cmd_buffer, 0u, 1u, &viewport);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_SCISSOR: {
+    const ngf_irect2d* r            = &cmd->data.rect;
+    const VkRect2D     scissor_rect = {.offset = {r->x, r->y}, .extent = {r->width, r->height}};
+    vkCmdSetScissor(buf->vk_cmd_buffer, 0u, 1u, &scissor_rect);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_STENCIL_REFERENCE: {
+    vkCmdSetStencilReference(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_FRONT_BIT,
+        cmd->data.stencil_values.front);
+    vkCmdSetStencilReference(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_BACK_BIT,
+        cmd->data.stencil_values.back);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_STENCIL_COMPARE_MASK: {
+    vkCmdSetStencilCompareMask(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_FRONT_BIT,
+        cmd->data.stencil_values.front);
+    vkCmdSetStencilCompareMask(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_BACK_BIT,
+        cmd->data.stencil_values.back);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_STENCIL_WRITE_MASK: {
+    vkCmdSetStencilWriteMask(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_FRONT_BIT,
+        cmd->data.stencil_values.front);
+    vkCmdSetStencilWriteMask(
+        buf->vk_cmd_buffer,
+        VK_STENCIL_FACE_BACK_BIT,
+        cmd->data.stencil_values.back);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_DEPTH_BIAS: {
+    vkCmdSetDepthBias(
+        buf->vk_cmd_buffer,
+        cmd->data.depth_bias.const_factor,
+        cmd->data.depth_bias.clamp,
+        cmd->data.depth_bias.slope_factor);
+    break;
+  }
+  case NGFVK_RENDER_CMD_BIND_RESOURCE: {
+    ngfvk_cmd_bind_resources(buf, &cmd->data.bind_resource, 1u);
+    break;
+  }
+  case NGFVK_RENDER_CMD_BIND_ATTRIB_BUFFER: {
+    VkDeviceSize vkoffset = cmd->data.bind_attrib_buffer.offset;
+    vkCmdBindVertexBuffers(
+        buf->vk_cmd_buffer,
+        cmd->data.bind_attrib_buffer.binding,
+        1,
+        (VkBuffer*)&cmd->data.bind_attrib_buffer.buffer->alloc.obj_handle,
+        &vkoffset);
+    break;
+  }
+  case NGFVK_RENDER_CMD_BIND_INDEX_BUFFER: {
+    const VkIndexType idx_type = get_vk_index_type(cmd->data.bind_index_buffer.type);
+    assert(idx_type == VK_INDEX_TYPE_UINT16 || idx_type == VK_INDEX_TYPE_UINT32);
+    vkCmdBindIndexBuffer(
+        buf->vk_cmd_buffer,
+        (VkBuffer)cmd->data.bind_index_buffer.buffer->alloc.obj_handle,
+        cmd->data.bind_index_buffer.offset,
+        idx_type);
+    break;
+  }
+  case NGFVK_RENDER_CMD_DRAW: {
+    // Allocate and write descriptor sets.
+    ngfvk_execute_pending_binds(buf);
+
+    // With all resources bound, we may perform the draw operation.
+    ngfvk_record_draw(buf->vk_cmd_buffer, &cmd->data.draw.info, cmd->data.draw.indexed);
+    break;
+  }
+  case NGFVK_RENDER_CMD_MULTI_DRAW: {
+    ngfvk_execute_pending_binds(buf);
+    const ngf_draw_info* draws  = cmd->data.multi_draw.draws;
+    const uint32_t       ndraws = cmd->data.multi_draw.ndraws;
+    const bool           idx    = cmd->data.multi_draw.indexed;
+    for (uint32_t i = 0u; i < ndraws;) {
+      const uint32_t max_batch = _vk.multi_draw ? _vk.max_multi_draw_count : 1u;
+      const uint32_t nbatch    = ngfvk_multi_draw_batch_size(&draws[i], ndraws - i, max_batch);
+      if (nbatch == 1u) {
+        ngfvk_record_draw(buf->vk_cmd_buffer, &draws[i], idx);
+      } else if (idx) {
+        // ngf_draw_info starts with the same fields as VkMultiDrawIndexedInfoEXT.
+        vkCmdDrawMultiIndexedEXT(
+            buf->vk_cmd_buffer,
+            nbatch,
+            (const VkMultiDrawIndexedInfoEXT*)&draws[i],
+            draws[i].ninstances,
+            draws[i].first_instance,
+            sizeof(ngf_draw_info),
+            NULL);
+      } else {
+        // ngf_draw_info starts with the same fields as VkMultiDrawInfoEXT.
+        vkCmdDrawMultiEXT(
+            buf->vk_cmd_buffer,
+            nbatch,
+            (const VkMultiDrawInfoEXT*)&draws[i],
+            draws[i].ninstances,
+            draws[i].first_instance,
+            sizeof(ngf_draw_info));
+      }
+      i += nbatch;
     }
-    case NGFVK_RENDER_CMD_SET_STENCIL_REFERENCE: {
-      vkCmdSetStencilReference(
+    break;
+  }
+  case NGFVK_RENDER_CMD_DRAW_INDIRECT: {
+    ngfvk_execute_pending_binds(buf);
+    const VkBuffer args_buffer = (VkBuffer)cmd->data.draw_indirect.args_buffer->alloc.obj_handle;
+    if (cmd->data.draw_indirect.indexed) {
+      vkCmdDrawIndexedIndirect(
           buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_FRONT_BIT,
-          cmd->data.stencil_values.front);
-      vkCmdSetStencilReference(
+          args_buffer,
+          cmd->data.draw_indirect.offset,
+          cmd->data.draw_indirect.ndraws,
+          cmd->data.draw_indirect.stride);
+    } else {
+      vkCmdDrawIndirect(
           buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_BACK_BIT,
-          cmd->data.stencil_values.back);
-      break;
+          args_buffer,
+          cmd->data.draw_indirect.offset,
+          cmd->data.draw_indirect.ndraws,
+          cmd->data.draw_indirect.stride);
     }
-    case NGFVK_RENDER_CMD_SET_STENCIL_COMPARE_MASK: {
-      vkCmdSetStencilCompareMask(
-          buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_FRONT_BIT,
-          cmd->data.stencil_values.front);
-      vkCmdSetStencilCompareMask(
-          buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_BACK_BIT,
-          cmd->data.stencil_values.back);
-      break;
+    break;
+  }
+  case NGFVK_RENDER_CMD_EXECUTE_SECONDARIES: {
+    vkCmdExecuteCommands(
+        buf->vk_cmd_buffer,
+        cmd->data.execute_secondaries.ncmd_bufs,
+        cmd->data.execute_secondaries.cmd_bufs);
+    // The state bound by the primary command buffer is undefined after executing secondaries.
+    memset(&buf->bound_gfx_desc_sets, 0, sizeof(buf->bound_gfx_desc_sets));
+    memset(&buf->bound_compute_desc_sets, 0, sizeof(buf->bound_compute_desc_sets));
+    break;
+  }
+  case NGFVK_RENDER_CMD_WRITE_TIMESTAMP: {
+    vkCmdWriteTimestamp(
+        buf->vk_cmd_buffer,
+        VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        cmd->data.query.pool,
+        cmd->data.query.query);
+    break;
+  }
+  case NGFVK_RENDER_CMD_BEGIN_QUERY: {
+    vkCmdBeginQuery(
+        buf->vk_cmd_buffer,
+        cmd->data.query.pool,
+        cmd->data.query.query,
+        cmd->data.query.flags);
+    break;
+  }
+  case NGFVK_RENDER_CMD_END_QUERY: {
+    vkCmdEndQuery(buf->vk_cmd_buffer, cmd->data.query.pool, cmd->data.query.query);
+    break;
+  }
+  case NGFVK_RENDER_CMD_BIND_COMPUTE_PIPELINE: {
+    // Resources bound while the previous pipeline was active are written using its layout.
+    buf->active_compute_pipe = cmd->data.bind_compute_pipeline.prev_pipeline;
+    if (buf->active_compute_pipe && buf->npending_bind_ops > 0u) {
+      ngfvk_execute_pending_binds(buf);
     }
-    case NGFVK_RENDER_CMD_SET_STENCIL_WRITE_MASK: {
-      vkCmdSetStencilWriteMask(
-          buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_FRONT_BIT,
-          cmd->data.stencil_values.front);
-      vkCmdSetStencilWriteMask(
-          buf->vk_cmd_buffer,
-          VK_STENCIL_FACE_BACK_BIT,
-          cmd->data.stencil_values.back);
-      break;
+    buf->active_compute_pipe = cmd->data.bind_compute_pipeline.pipeline;
+    vkCmdBindPipeline(
+        buf->vk_cmd_buffer,
+        VK_PIPELINE_BIND_POINT_COMPUTE,
+        ((ngfvk_generic_pipeline*)(buf->active_compute_pipe))->vk_pipeline);
+    break;
+  }
+  case NGFVK_RENDER_CMD_SET_BYTES: {
+    vkCmdPushConstants(
+        buf->vk_cmd_buffer,
+        CURRENT_CONTEXT->vk_default_push_layout,
+        VK_SHADER_STAGE_ALL,
+        0u,
+        cmd->data.set_bytes.size,
+        cmd->data.set_bytes.data);
+    break;
+  }
+  case NGFVK_RENDER_CMD_DISPATCH: {
+    ngfvk_execute_pending_binds(buf);
+    vkCmdDispatch(
+        buf->vk_cmd_buffer,
+        cmd->data.dispatch.x,
+        cmd->data.dispatch.y,
+        cmd->data.dispatch.z);
+    break;
+  }
+  case NGFVK_RENDER_CMD_DISPATCH_INDIRECT: {
+    ngfvk_execute_pending_binds(buf);
+    vkCmdDispatchIndirect(
+        buf->vk_cmd_buffer,
+        (VkBuffer)cmd->data.dispatch_indirect.args_buffer->alloc.obj_handle,
+        cmd->data.dispatch_indirect.offset);
+    break;
+  }
+  case NGFVK_RENDER_CMD_COPY_BUFFER: {
+    vkCmdCopyBuffer(
+        buf->vk_cmd_buffer,
+        (VkBuffer)cmd->data.copy_buffer.src->alloc.obj_handle,
+        (VkBuffer)cmd->data.copy_buffer.dst->alloc.obj_handle,
+        1u,
+        &cmd->data.copy_buffer.region);
+    break;
+  }
+  case NGFVK_RENDER_CMD_COPY_BUFFER_TO_IMAGE: {
+    vkCmdCopyBufferToImage(
+        buf->vk_cmd_buffer,
+        (VkBuffer)cmd->data.buffer_image_copy.buffer->alloc.obj_handle,
+        (VkImage)cmd->data.buffer_image_copy.image->alloc.obj_handle,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        cmd->data.buffer_image_copy.nregions,
+        cmd->data.buffer_image_copy.regions);
+    break;
+  }
+  case NGFVK_RENDER_CMD_COPY_IMAGE_TO_BUFFER: {
+    vkCmdCopyImageToBuffer(
+        buf->vk_cmd_buffer,
+        (VkImage)cmd->data.buffer_image_copy.image->alloc.obj_handle,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        (VkBuffer)cmd->data.buffer_image_copy.buffer->alloc.obj_handle,
+        cmd->data.buffer_image_copy.nregions,
+        cmd->data.buffer_image_copy.regions);
+    break;
+  }
+  default:
+    assert(false);
+  }
+}
+
+// Actually records renderpass commands into a command buffer.
+static void ngfvk_cmd_buf_record_render_cmds(
+    ngf_cmd_buffer                              buf,
+    const ngfi::chunked_list<ngfvk_render_cmd>& cmd_list) {
+  ngfi::tmp_arena().reset();
+  for (const ngfvk_render_cmd& cmd : cmd_list) { ngfvk_cmd_buf_record_render_cmd(buf, &cmd); }
+  ngfi::tmp_arena().reset();
+}
+
+static void ngfvk_cmd_buf_reset_render_cmds(ngf_cmd_buffer cmd_buf) {
+  cmd_buf->in_pass_cmd_chnks.clear();
+  cmd_buf->nin_pass_cmds = 0u;
+}
+
+// Adds a command to the active renderpass. Commands are deferred until the end of the pass, unless
+// the pass is recorded in immediate mode.
+static void ngfvk_cmd_buf_add_render_cmd(
+    ngf_cmd_buffer          cmd_buf,
+    const ngfvk_render_cmd* cmd,
+    bool                    in_renderpass) {
+  if (cmd_buf->immediate_render_pass) {
+    ngfi::tmp_arena().reset();
+    ngfvk_cmd_buf_record_render_cmd(cmd_buf, cmd);
+  } else if (cmd_buf->executes_secondaries && cmd->type != NGFVK_RENDER_CMD_EXECUTE_SECONDARIES) {
+    NGFI_DIAG_ERROR("Attempt to record a command into a render pass that executes secondary "
+                    "command buffers. Ignoring.");
+  } else if (in_renderpass) {
+    cmd_buf->in_pass_cmd_chnks.append(
+        *cmd,
+        CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
+    ++cmd_buf->nin_pass_cmds;
+  } else {
+    assert(false);
+  }
+}
+
+// Transfer and compute commands are deferred too, so that the barriers needed by a run of commands
+// that don't depend on each other can all be issued in front of the run, instead of one by one
+// between the commands. The run gets recorded once a command depends on a resource accessed within
+// it, or when something that can't be deferred needs to be recorded.
+static bool ngfvk_cmd_buf_defers_cmds(ngf_cmd_buffer cmd_buf) {
+  return cmd_buf->xfer_pass_active || cmd_buf->compute_pass_active;
+}
+
+// Records the run of deferred transfer or compute commands, preceded by the barriers they need. If
+// `split` is not NULL, its event is set right after the command at index `split_after_idx`.
+static void ngfvk_cmd_buf_record_deferred_cmds(
+    ngf_cmd_buffer             cmd_buf,
+    const ngfvk_split_barrier* split,
+    uint32_t                   split_after_idx) {
+  ngfvk_sync_commit_pending_barriers(&cmd_buf->pending_barriers, cmd_buf->vk_cmd_buffer);
+  ngfvk_split_barrier* wait = &cmd_buf->pending_split_wait;
+  if (wait->event != VK_NULL_HANDLE) {
+    vkCmdWaitEvents2(cmd_buf->vk_cmd_buffer, 1u, &wait->event, &wait->dep_info);
+    wait->event = VK_NULL_HANDLE;
+  }
+
+  ngfi::tmp_arena().reset();
+  uint32_t idx = 0u;
+  for (const ngfvk_render_cmd& cmd : cmd_buf->in_pass_cmd_chnks) {
+    ngfvk_cmd_buf_record_render_cmd(cmd_buf, &cmd);
+    if (split && idx++ == split_after_idx) {
+      vkCmdSetEvent2(cmd_buf->vk_cmd_buffer, split->event, &split->dep_info);
     }
-    case NGFVK_RENDER_CMD_SET_DEPTH_BIAS: {
-      vkCmdSetDepthBias(
-          buf->vk_cmd_buffer,
-          cmd->data.depth_bias.const_factor,
-          cmd->data.depth_bias.clamp,
-          cmd->data.depth_bias.slope_factor);
-      break;
+  }
+  ngfi::tmp_arena().reset();
+
+  ngfvk_cmd_buf_reset_render_cmds(cmd_buf);
+  ++cmd_buf->deferred_epoch;
+}
+
+static void ngfvk_cmd_buf_flush_deferred_cmds(ngf_cmd_buffer cmd_buf) {
+  ngfvk_cmd_buf_record_deferred_cmds(cmd_buf, NULL, 0u);
+}
+
+// Returns the data of the resource guarded by a barrier, if the resource is accessed by the current
+// run of deferred commands, and NULL otherwise.
+static const ngfvk_sync_res_data*
+ngfvk_cmd_buf_deferred_res_data(ngf_cmd_buffer cmd_buf, const ngfvk_barrier_data* barrier) {
+  const ngfvk_sync_res_hashtable::keyhash keyhash = {
+      ngfvk_handle_from_sync_res(&barrier->res),
+      barrier->res.hash};
+  const ngfvk_sync_res_data* res_data = cmd_buf->local_res_states.get_prehashed(keyhash);
+  return res_data && res_data->deferred_epoch == cmd_buf->deferred_epoch ? res_data : NULL;
+}
+
+// Returns true if any of the given barriers guards a resource accessed by the current run of
+// deferred commands.
+static bool ngfvk_cmd_buf_barriers_depend_on_deferred(
+    ngf_cmd_buffer                    cmd_buf,
+    const ngfvk_pending_barrier_list* barriers) {
+  for (const ngfvk_barrier_data& barrier : barriers->barriers) {
+    if (ngfvk_cmd_buf_deferred_res_data(cmd_buf, &barrier)) { return true; }
+  }
+  return false;
+}
+
+// Moves the barriers that guard resources accessed within the current run of deferred commands
+// from `barriers` to `split`, and returns the index of the last command in the run accessing any of
+// those resources. The barriers are left alone, and ~0u is returned, if splitting them wouldn't let
+// any of the run's commands overlap with the ones that follow, if they transfer queue family
+// ownership, or if it isn't known which commands access the guarded resources.
+static uint32_t ngfvk_cmd_buf_split_barriers(
+    ngf_cmd_buffer              cmd_buf,
+    ngfvk_pending_barrier_list* barriers,
+    ngfvk_pending_barrier_list* split,
+    ngfi::arena&                arena) {
+  uint32_t last_access_idx = 0u;
+  for (const ngfvk_barrier_data& barrier : barriers->barriers) {
+    const ngfvk_sync_res_data* res_data = ngfvk_cmd_buf_deferred_res_data(cmd_buf, &barrier);
+    if (res_data == NULL) { continue; }
+    if (res_data->deferred_cmd_idx == ~0u || barrier.src_queue_family != barrier.dst_queue_family) {
+      return ~0u;
     }
-    case NGFVK_RENDER_CMD_BIND_RESOURCE: {
-      ngfvk_cmd_bind_resources(buf, &cmd->data.bind_resource, 1u);
-      break;
+    last_access_idx = NGFI_MAX(last_access_idx, res_data->deferred_cmd_idx);
+  }
+  if (last_access_idx + 1u >= cmd_buf->nin_pass_cmds) { return ~0u; }
+
+  ngfvk_pending_barrier_list remaining {};
+  for (const ngfvk_barrier_data& barrier : barriers->barriers) {
+    const bool                  in_run = ngfvk_cmd_buf_deferred_res_data(cmd_buf, &barrier) != NULL;
+    ngfvk_pending_barrier_list* dst    = in_run ? split : &remaining;
+    dst->barriers.append(barrier, arena);
+    if (barrier.res.type == NGFVK_SYNC_RES_IMAGE) {
+      ++dst->npending_img_bars;
+    } else {
+      ++dst->npending_buf_bars;
     }
-    case NGFVK_RENDER_CMD_BIND_ATTRIB_BUFFER: {
-      VkDeviceSize vkoffset = cmd->data.bind_attrib_buffer.offset;
-      vkCmdBindVertexBuffers(
-          buf->vk_cmd_buffer,
-          cmd->data.bind_attrib_buffer.binding,
-          1,
-          (VkBuffer*)&cmd->data.bind_attrib_buffer.buffer->alloc.obj_handle,
-          &vkoffset);
-      break;
+  }
+  *barriers = remaining;
+  return last_access_idx;
+}
+
+// Hands out an event for a split barrier, creating one if none of the current frame's are free.
+static VkEvent ngfvk_alloc_event() {
+  ngfvk_frame_event_pool* pool = &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].event_pool;
+  if (pool->nevents == pool->events.size()) {
+    const VkEventCreateInfo event_info = {
+        .sType = VK_STRUCTURE_TYPE_EVENT_CREATE_INFO,
+        .pNext = NULL,
+        .flags = 0u};
+    VkEvent event = VK_NULL_HANDLE;
+    if (vkCreateEvent(_vk.device, &event_info, NULL, &event) != VK_SUCCESS) {
+      return VK_NULL_HANDLE;
     }
-    case NGFVK_RENDER_CMD_BIND_INDEX_BUFFER: {
-      const VkIndexType idx_type = get_vk_index_type(cmd->data.bind_index_buffer.type);
-      assert(idx_type == VK_INDEX_TYPE_UINT16 || idx_type == VK_INDEX_TYPE_UINT32);
-      vkCmdBindIndexBuffer(
-          buf->vk_cmd_buffer,
-          (VkBuffer)cmd->data.bind_index_buffer.buffer->alloc.obj_handle,
-          cmd->data.bind_index_buffer.offset,
-          idx_type);
-      break;
+    if (pool->events.push_back(event) == NULL) {
+      vkDestroyEvent(_vk.device, event, NULL);
+      return VK_NULL_HANDLE;
     }
-    case NGFVK_RENDER_CMD_DRAW: {
-      // Allocate and write descriptor sets.
-      ngfvk_execute_pending_binds(buf);
+  }
+  return pool->events[pool->nevents++];
+}
 
-      // With all resources bound, we may perform the draw operation.
-      if (cmd->data.draw.indexed) {
-        vkCmdDrawIndexed(
-            buf->vk_cmd_buffer,
-            cmd->data.draw.nelements,
-            cmd->data.draw.ninstances,
-            cmd->data.draw.first_element,
-            0u,
-            0u);
-      } else {
-        vkCmdDraw(
-            buf->vk_cmd_buffer,
-            cmd->data.draw.nelements,
-            cmd->data.draw.ninstances,
-            cmd->data.draw.first_element,
-            0u);
+// Processes the sync requests of a transfer or compute command that is about to be deferred. The
+// resulting barriers join the ones pending in front of the current run of deferred commands, unless
+// they guard resources accessed within the run, in which case the run gets recorded first. Those
+// barriers are split when possible, letting the run's commands that follow the last access to the
+// guarded resources overlap with the next run. `appends_cmd` has to be set if the command gets
+// appended to the deferred commands right after.
+static void ngfvk_sync_req_batch_process_deferred(
+    ngfvk_sync_req_batch* batch,
+    ngf_cmd_buffer        cmd_buf,
+    bool                  appends_cmd) {
+  ngfvk_pending_barrier_list hoisted_barriers = cmd_buf->pending_barriers;
+  cmd_buf->pending_barriers.barriers.clear();
+  cmd_buf->pending_barriers.npending_img_bars = 0u;
+  cmd_buf->pending_barriers.npending_buf_bars = 0u;
+  ngfvk_sync_req_batch_process(batch, cmd_buf);
+
+  // The command starts a new run if it depends on the current one.
+  const bool depends_on_run =
+      ngfvk_cmd_buf_barriers_depend_on_deferred(cmd_buf, &cmd_buf->pending_barriers);
+  ngfvk_pending_barrier_list split_barriers {};
+  uint32_t                   split_after_idx = ~0u;
+  if (depends_on_run && vkCmdSetEvent2 && vkCmdWaitEvents2) {
+    split_after_idx = ngfvk_cmd_buf_split_barriers(
+        cmd_buf,
+        &cmd_buf->pending_barriers,
+        &split_barriers,
+        current_frame_res_arena());
+  }
+
+  // The batch lives in temporary storage, which gets reset when the run is recorded, so the
+  // accessed resources are marked first. Resources declared with ngf_cmd_use_compute_resources may
+  // be accessed by any of the commands that follow within the run.
+  const uint32_t epoch   = cmd_buf->deferred_epoch + (depends_on_run ? 1u : 0u);
+  const uint32_t cmd_idx = !appends_cmd ? ~0u : depends_on_run ? 0u : cmd_buf->nin_pass_cmds;
+  for (uint32_t i = 0u; i < batch->npending_sync_reqs; ++i) {
+    ngfvk_sync_res_data* res_data =
+        cmd_buf->local_res_states.get_prehashed(batch->sync_res_data_keys[i]);
+    if (res_data == NULL) { continue; }
+    const bool declared = res_data->deferred_epoch == epoch && res_data->deferred_cmd_idx == ~0u;
+    res_data->deferred_epoch   = epoch;
+    res_data->deferred_cmd_idx = declared ? ~0u : cmd_idx;
+  }
+
+  if (depends_on_run) {
+    ngfvk_pending_barrier_list new_barriers = cmd_buf->pending_barriers;
+    ngfvk_split_barrier        split        = {.event = VK_NULL_HANDLE, .dep_info = {}};
+    cmd_buf->pending_barriers               = hoisted_barriers;
+    if (split_after_idx != ~0u) { split.event = ngfvk_alloc_event(); }
+    if (split.event != VK_NULL_HANDLE) {
+      split.dep_info = ngfvk_sync_dependency_info(&split_barriers, current_frame_res_arena());
+      ngfvk_cmd_buf_record_deferred_cmds(cmd_buf, &split, split_after_idx);
+      cmd_buf->pending_split_wait = split;
+    } else {
+      // Without an event, the barriers set aside for the split are issued after the run instead.
+      for (const ngfvk_barrier_data& barrier : split_barriers.barriers) {
+        new_barriers.barriers.append(barrier, current_frame_res_arena());
       }
-      break;
+      new_barriers.npending_img_bars += split_barriers.npending_img_bars;
+      new_barriers.npending_buf_bars += split_barriers.npending_buf_bars;
+      ngfvk_cmd_buf_flush_deferred_cmds(cmd_buf);
     }
-    default:
-      assert(false);
+    cmd_buf->pending_barriers = new_barriers;
+  } else {
+    for (const ngfvk_barrier_data& barrier : cmd_buf->pending_barriers.barriers) {
+      hoisted_barriers.barriers.append(barrier, current_frame_res_arena());
     }
+    hoisted_barriers.npending_img_bars += cmd_buf->pending_barriers.npending_img_bars;
+    hoisted_barriers.npending_buf_bars += cmd_buf->pending_barriers.npending_buf_bars;
+    cmd_buf->pending_barriers = hoisted_barriers;
   }
-  ngfi::tmp_arena().reset();
+}
+
+// Adds a command that doesn't access any synchronized resources, in order with the other commands
+// of the active pass.
+static void ngfvk_cmd_buf_add_ordered_cmd(ngf_cmd_buffer cmd_buf, const ngfvk_render_cmd* cmd) {
+  if (cmd_buf->renderpass_active) {
+    ngfvk_cmd_buf_add_render_cmd(cmd_buf, cmd, true);
+  } else if (ngfvk_cmd_buf_defers_cmds(cmd_buf)) {
+    cmd_buf->in_pass_cmd_chnks.append(*cmd, current_frame_res_arena());
+    ++cmd_buf->nin_pass_cmds;
+  } else {
+    ngfvk_cmd_buf_record_render_cmd(cmd_buf, cmd);
+  }
+}
+
+// Processes the sync requests of a transfer or compute command, then adds it to the current run of
+// deferred commands.
+static void ngfvk_cmd_buf_add_deferred_cmd(
+    ngf_cmd_buffer          cmd_buf,
+    ngfvk_sync_req_batch*   batch,
+    const ngfvk_render_cmd* cmd) {
+  assert(ngfvk_cmd_buf_defers_cmds(cmd_buf));
+  ngfvk_sync_req_batch_process_deferred(batch, cmd_buf, true);
+  ngfvk_cmd_buf_add_ordered_cmd(cmd_buf, cmd);
 }
 
 static void ngfvk_debug_label_begin(VkCommandBuffer b, const char* name) {
@@ -4405,26 +7420,207 @@ static void ngfvk_debug_label_end(VkCommandBuffer b) {
   if (vkCmdEndDebugUtilsLabelEXT) { vkCmdEndDebugUtilsLabelEXT(b); }
 }
 
+// Upper bounds on the number of command buffer handles and batches that a submission of the given
+// number of cmd buffers produces. Each cmd buffer may need a release batch with an aux command
+// buffer on every other queue, plus a batch with a patch aux command buffer for its own queue. The
+// prologue and presentation aux command buffers account for the rest.
+static uint32_t ngfvk_submit_max_cmd_buf_handles(uint32_t ncmd_bufs) {
+  return ncmd_bufs * (NGF_QUEUE_TYPE_COUNT + 1u) + 2u;
+}
+
+static uint32_t ngfvk_submit_max_batches(uint32_t ncmd_bufs) {
+  return ncmd_bufs * NGF_QUEUE_TYPE_COUNT + 2u;
+}
+
+// Returns the batch that command buffers for the given queue shall be appended to. A new batch is
+// started if the last one is for a different queue, or if the command buffers have to wait for
+// work on other queues first. New batches signal the next value of the queue's timeline.
+static ngfvk_submit_batch* ngfvk_submit_batch_for_queue(
+    ngfvk_submit_batch* batches,
+    uint32_t*           nbatches,
+    uint64_t*           timeline_values,
+    uint32_t            first_cmd_buf,
+    ngf_queue_type      queue,
+    const uint64_t*     wait_values) {
+  bool has_waits = false;
+  for (uint32_t q = 0u; wait_values && q < NGF_QUEUE_TYPE_COUNT; ++q) {
+    has_waits |= wait_values[q] != 0u;
+  }
+  ngfvk_submit_batch* last = *nbatches > 0u ? &batches[*nbatches - 1u] : NULL;
+  if (last != NULL && last->queue == queue && !has_waits) { return last; }
+
+  ngfvk_submit_batch* batch = &batches[(*nbatches)++];
+  memset(batch, 0, sizeof(*batch));
+  if (wait_values) { memcpy(batch->wait_values, wait_values, sizeof(batch->wait_values)); }
+  batch->signal_value  = ++timeline_values[queue];
+  batch->first_cmd_buf = first_cmd_buf;
+  batch->queue         = queue;
+  return batch;
+}
+
+static void ngfvk_pending_barrier_list_add(
+    ngfvk_pending_barrier_list* list,
+    ngfvk_barrier_data*         barrier,
+    const ngfvk_sync_res_data*  res_data) {
+  barrier->res = ngfvk_sync_res_from_data(res_data);
+  if (barrier->res.type == NGFVK_SYNC_RES_IMAGE) {
+    list->npending_img_bars++;
+  } else {
+    list->npending_buf_bars++;
+  }
+  list->barriers.append(
+      *barrier,
+      CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
+}
+
+// Brings the global synchronization state of a resource or subresource to what a cmd buffer
+// submitted to the given queue expects it to be, then updates it to reflect the cmd buffer's
+// accesses. If the resource has to be released by another queue first, `release_queue` is set to
+// that queue and `release` is populated; otherwise, `release_queue` is set to
+// NGF_QUEUE_TYPE_COUNT. Returns `true` if the `patch` barrier has to execute before the cmd buffer.
+static bool ngfvk_sync_reconcile(
+    ngfvk_sync_state*       global_sync_state,
+    const ngfvk_sync_track* track,
+    ngf_queue_type          queue,
+    ngf_queue_type*         release_queue,
+    ngfvk_barrier_data*     release,
+    ngfvk_barrier_data*     patch) {
+  bool need_patch = true;
+  *release_queue  = NGF_QUEUE_TYPE_COUNT;
+  if (ngfvk_sync_needs_queue_transfer(global_sync_state, (uint8_t)queue)) {
+    *release_queue = (ngf_queue_type)global_sync_state->queue;
+    ngfvk_sync_queue_transfer(
+        global_sync_state,
+        &track->expected_sync_req,
+        ngfvk_queue_family_idx(*release_queue),
+        ngfvk_queue_family_idx(queue),
+        release,
+        patch);
+  } else {
+    need_patch = ngfvk_sync_barrier(global_sync_state, &track->expected_sync_req, patch);
+  }
+  ngfvk_sync_state_merge(global_sync_state, &track->sync_state);
+  global_sync_state->queue = (uint8_t)queue;
+  return need_patch;
+}
+
+// Same as `ngfvk_sync_reconcile`, for images that are tracked per subresource either by the cmd
+// buffer or globally. Barriers for adjacent subresources are coalesced where possible.
+static ngf_error ngfvk_sync_reconcile_subres(
+    ngfvk_sync_res_data*        res_data,
+    ngf_queue_type              queue,
+    ngfvk_pending_barrier_list* release_barriers,
+    ngfvk_pending_barrier_list* patch_barriers) {
+  const ngf_image img = (ngf_image)res_data->res_handle;
+  if (!ngfvk_image_expand_sync_states(img)) { return NGF_ERROR_OUT_OF_MEM; }
+  ngfi::arena& arena = current_frame_res_arena();
+  ngfvk_subres_barrier_builder release_builders[NGF_QUEUE_TYPE_COUNT];
+  ngfvk_subres_barrier_builder patch_builder;
+  for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+    ngfvk_subres_barrier_builder_init(&release_builders[q], &release_barriers[q], arena, img);
+  }
+  ngfvk_subres_barrier_builder_init(&patch_builder, patch_barriers, arena, img);
+
+  for (uint32_t level = 0u; level < img->nlevels; ++level) {
+    for (uint32_t layer = 0u; layer < img->nlayers; ++layer) {
+      const uint32_t          s     = level * img->nlayers + layer;
+      const ngfvk_sync_track* track = ngfvk_sync_res_data_track(res_data, s);
+      if (!track->accessed) continue;
+      ngf_queue_type     release_queue;
+      ngfvk_barrier_data release_barrier_data;
+      ngfvk_barrier_data patch_barrier_data;
+      const bool         need_patch = ngfvk_sync_reconcile(
+          &img->subres_sync_states[s],
+          track,
+          queue,
+          &release_queue,
+          &release_barrier_data,
+          &patch_barrier_data);
+      if (release_queue != NGF_QUEUE_TYPE_COUNT) {
+        ngfvk_subres_barrier_builder_add(
+            &release_builders[release_queue],
+            &release_barrier_data,
+            level,
+            layer);
+      }
+      if (need_patch) {
+        ngfvk_subres_barrier_builder_add(&patch_builder, &patch_barrier_data, level, layer);
+      }
+    }
+  }
+  for (ngfvk_subres_barrier_builder& builder : release_builders) {
+    ngfvk_subres_barrier_builder_flush(&builder);
+  }
+  ngfvk_subres_barrier_builder_flush(&patch_builder);
+  ngfvk_image_collapse_sync_states(img);
+  return NGF_ERROR_OK;
+}
+
+// Records the given barriers into an aux command buffer for the given queue, and appends it to the
+// list of command buffers to be submitted.
+static void ngfvk_submit_aux_barriers(
+    ngfvk_frame_resources*      frame_res,
+    ngfvk_pending_barrier_list* barriers,
+    ngf_queue_type              queue,
+    VkCommandBuffer*            submitted_cmd_buf_handles,
+    uint32_t*                   submitted_cmd_buf_handles_idx,
+    ngfvk_submit_batch*         batch) {
+  VkCommandBuffer aux_cmd_buf;
+  VkCommandPool   aux_cmd_pool;
+  ngfvk_cmd_buffer_allocate_for_frame(
+      CURRENT_CONTEXT->current_frame_token,
+      queue,
+      NULL,
+      &aux_cmd_pool,
+      &aux_cmd_buf);
+  ngfvk_debug_label_begin(aux_cmd_buf, "ngf - patch barrier cmd buffer");
+  ngfvk_sync_commit_pending_barriers(barriers, aux_cmd_buf);
+  ngfvk_debug_label_end(aux_cmd_buf);
+  vkEndCommandBuffer(aux_cmd_buf);
+  submitted_cmd_buf_handles[(*submitted_cmd_buf_handles_idx)++] = aux_cmd_buf;
+  batch->ncmd_bufs++;
+  frame_res->retire.append(ngfvk_cmd_buf_with_pool {aux_cmd_buf, aux_cmd_pool});
+}
+
 // Submits all pending command buffers for the current frame.
+// Consecutive command buffers for the same queue are submitted together. Each submission signals
+// the timeline of its queue, which submissions to other queues wait on when they need to access
+// resources last used by that queue.
 static ngf_error ngfvk_submit_pending_cmd_buffers(
     ngfvk_frame_resources* frame_res,
     VkSemaphore            wait_semaphore,
     VkFence                signal_fence) {
-  ngf_error      err                 = NGF_ERROR_OK;
-  const uint32_t ncmd_bufs           = static_cast<uint32_t>(frame_res->submitted_cmd_bufs.size());
-  auto     submitted_cmd_buf_handles = ngfi::frame_alloc<VkCommandBuffer>(ncmd_bufs * 2u + 2u);
+  ngf_error      err       = NGF_ERROR_OK;
+  const uint32_t ncmd_bufs = static_cast<uint32_t>(frame_res->submitted_cmd_bufs.size());
+  auto     submitted_cmd_buf_handles =
+      ngfi::frame_alloc<VkCommandBuffer>(ngfvk_submit_max_cmd_buf_handles(ncmd_bufs));
   uint32_t submitted_cmd_buf_handles_idx = 0u;
+  auto     batches  = ngfi::frame_alloc<ngfvk_submit_batch>(ngfvk_submit_max_batches(ncmd_bufs));
+  uint32_t nbatches = 0u;
 
+  // Timeline value that work on other queues has to wait on before using the dummy image or the
+  // frame's queries, and the queues that have already been made to wait for it.
+  uint64_t prologue_wait_value  = 0u;
+  uint32_t prologue_waited_mask = 0u;
   {
-    // Check if dummy image needs to be transitioned from UNDEFINED to GENERAL layout,
-    // submit and aux command buffer with the appropriate barrier if so.
+    // Check if dummy image needs to be transitioned from UNDEFINED to GENERAL layout, and whether
+    // any queries handed out since the last submission need to be reset. Submit an aux command
+    // buffer that does so ahead of everything else if needed.
     pthread_mutex_lock(&_vk.dummy_res.img_mu);
-    if (!_vk.dummy_res.image_transitioned) {
-      _vk.dummy_res.image_transitioned = true;
+    const bool transition_dummy_image = !_vk.dummy_res.image_transitioned;
+    _vk.dummy_res.image_transitioned  = true;
+    pthread_mutex_unlock(&_vk.dummy_res.img_mu);
+    bool have_queries_to_reset = false;
+    for (const ngfvk_frame_query_pool& pool : frame_res->query_pools) {
+      have_queries_to_reset |= pool.nqueries > pool.nqueries_reset;
+    }
+    if (transition_dummy_image || have_queries_to_reset) {
       VkCommandBuffer aux_cmd_buf;
       VkCommandPool   aux_cmd_pool;
       ngfvk_cmd_buffer_allocate_for_frame(
           CURRENT_CONTEXT->current_frame_token,
+          NGF_QUEUE_TYPE_GRAPHICS,
+          NULL,
           &aux_cmd_pool,
           &aux_cmd_buf);
       const VkImageMemoryBarrier bar[] = {
@@ -4460,73 +7656,144 @@ static ngf_error ngfvk_submit_pending_cmd_buffers(
                   .levelCount     = 1u,
                   .baseArrayLayer = 0u,
                   .layerCount     = 6u}}};
-      vkCmdPipelineBarrier(aux_cmd_buf, 0, 0, 0, 0, NULL, 0, NULL, 2, bar);
+      if (transition_dummy_image) {
+        vkCmdPipelineBarrier(aux_cmd_buf, 0, 0, 0, 0, NULL, 0, NULL, 2, bar);
+      }
+      for (ngfvk_frame_query_pool& pool : frame_res->query_pools) {
+        if (pool.nqueries == pool.nqueries_reset) { continue; }
+        vkCmdResetQueryPool(
+            aux_cmd_buf,
+            pool.vk_pool,
+            pool.nqueries_reset,
+            pool.nqueries - pool.nqueries_reset);
+        pool.nqueries_reset = pool.nqueries;
+      }
       vkEndCommandBuffer(aux_cmd_buf);
+      ngfvk_submit_batch* batch = ngfvk_submit_batch_for_queue(
+          batches,
+          &nbatches,
+          CURRENT_CONTEXT->queue_timeline_values,
+          submitted_cmd_buf_handles_idx,
+          NGF_QUEUE_TYPE_GRAPHICS,
+          NULL);
       submitted_cmd_buf_handles[submitted_cmd_buf_handles_idx++] = aux_cmd_buf;
+      batch->ncmd_bufs++;
+      prologue_wait_value = batch->signal_value;
       frame_res->retire.append(ngfvk_cmd_buf_with_pool {aux_cmd_buf, aux_cmd_pool});
     }
-    pthread_mutex_unlock(&_vk.dummy_res.img_mu);
   }
 
   ngfvk_pending_barrier_list pending_patch_barriers;
   pending_patch_barriers.npending_img_bars = 0;
   pending_patch_barriers.npending_buf_bars = 0;
+  ngfvk_pending_barrier_list pending_release_barriers[NGF_QUEUE_TYPE_COUNT];
+  for (ngfvk_pending_barrier_list& release_barriers : pending_release_barriers) {
+    release_barriers.npending_img_bars = 0;
+    release_barriers.npending_buf_bars = 0;
+  }
 
   for (size_t c = 0; c < frame_res->submitted_cmd_bufs.size(); ++c) {
-    ngf_cmd_buffer cmd_buf = frame_res->submitted_cmd_bufs[c];
+    ngf_cmd_buffer       cmd_buf = frame_res->submitted_cmd_bufs[c];
+    const ngf_queue_type queue   = ngfvk_effective_queue(cmd_buf->queue);
     ngfi::tmp_arena().reset();
 
     for (auto& entry : cmd_buf->local_res_states) {
       ngfvk_sync_res_data* cmd_buf_res_state = &entry.value;
-      ngfvk_sync_state*    global_sync_state =
-          cmd_buf_res_state->res_type == NGFVK_SYNC_RES_IMAGE
-                 ? &(((ngf_image)cmd_buf_res_state->res_handle)->sync_state)
-                 : &(((ngf_buffer)cmd_buf_res_state->res_handle)->sync_state);
+      const ngf_image      img               = cmd_buf_res_state->res_type == NGFVK_SYNC_RES_IMAGE
+                                                   ? (ngf_image)cmd_buf_res_state->res_handle
+                                                   : NULL;
+      if (img && (cmd_buf_res_state->subres || img->subres_sync_states)) {
+        // Nothing is submitted if the synchronization state of any resource can't be reconciled.
+        const ngf_error reconcile_err = ngfvk_sync_reconcile_subres(
+            cmd_buf_res_state,
+            queue,
+            pending_release_barriers,
+            &pending_patch_barriers);
+        if (reconcile_err != NGF_ERROR_OK) { err = reconcile_err; }
+        continue;
+      }
+      ngfvk_sync_state* global_sync_state =
+          img ? &img->sync_state : &(((ngf_buffer)cmd_buf_res_state->res_handle)->sync_state);
+      ngf_queue_type     release_queue;
+      ngfvk_barrier_data release_barrier_data;
       ngfvk_barrier_data patch_barrier_data;
-      if (ngfvk_sync_barrier(
-              global_sync_state,
-              &cmd_buf_res_state->expected_sync_req,
-              &patch_barrier_data)) {
-        patch_barrier_data.res.type = cmd_buf_res_state->res_type;
-        if (patch_barrier_data.res.type == NGFVK_SYNC_RES_IMAGE) {
-          patch_barrier_data.res.data.img = (ngf_image)cmd_buf_res_state->res_handle;
-          pending_patch_barriers.npending_img_bars++;
-        } else {
-          patch_barrier_data.res.data.buf = (ngf_buffer)cmd_buf_res_state->res_handle;
-          pending_patch_barriers.npending_buf_bars++;
-        }
-        pending_patch_barriers.barriers.append(
-            patch_barrier_data,
-            CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
+      const bool         need_patch = ngfvk_sync_reconcile(
+          global_sync_state,
+          &cmd_buf_res_state->whole,
+          queue,
+          &release_queue,
+          &release_barrier_data,
+          &patch_barrier_data);
+      if (release_queue != NGF_QUEUE_TYPE_COUNT) {
+        ngfvk_pending_barrier_list_add(
+            &pending_release_barriers[release_queue],
+            &release_barrier_data,
+            cmd_buf_res_state);
       }
-      if (cmd_buf_res_state->sync_state.last_writer_masks.access_mask != 0) {
-        const bool skip_hazard_tracking = global_sync_state->skip_hazard_tracking;
-        *global_sync_state = cmd_buf_res_state->sync_state;
-        global_sync_state->skip_hazard_tracking = skip_hazard_tracking;
-      } else {
-        global_sync_state->active_readers_masks.access_mask |=
-            cmd_buf_res_state->sync_state.active_readers_masks.access_mask;
-        global_sync_state->per_stage_readers_mask |=
-            cmd_buf_res_state->sync_state.per_stage_readers_mask;
+      if (need_patch) {
+        ngfvk_pending_barrier_list_add(
+            &pending_patch_barriers,
+            &patch_barrier_data,
+            cmd_buf_res_state);
       }
     }
-    if (pending_patch_barriers.npending_buf_bars + pending_patch_barriers.npending_img_bars > 0u) {
-      VkCommandBuffer aux_cmd_buf;
-      VkCommandPool   aux_cmd_pool;
-      ngfvk_cmd_buffer_allocate_for_frame(
-          CURRENT_CONTEXT->current_frame_token,
-          &aux_cmd_pool,
-          &aux_cmd_buf);
-      ngfvk_debug_label_begin(aux_cmd_buf, "ngf - patch barrier cmd buffer");
-      ngfvk_sync_commit_pending_barriers(&pending_patch_barriers, aux_cmd_buf);
-      ngfvk_debug_label_end(aux_cmd_buf);
-      vkEndCommandBuffer(aux_cmd_buf);
-      submitted_cmd_buf_handles[submitted_cmd_buf_handles_idx++] = aux_cmd_buf;
 
-      frame_res->retire.append(ngfvk_cmd_buf_with_pool {aux_cmd_buf, aux_cmd_pool});
+    // Work on other queues that this command buffer has to wait for.
+    uint64_t wait_values[NGF_QUEUE_TYPE_COUNT] = {0u};
+    for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+      if (q != (uint32_t)queue && (cmd_buf->wait_queues_mask & (1u << q))) {
+        wait_values[q] = CURRENT_CONTEXT->queue_timeline_values[q];
+      }
+    }
+    if (queue != NGF_QUEUE_TYPE_GRAPHICS && prologue_wait_value != 0u &&
+        (prologue_waited_mask & (1u << queue)) == 0u) {
+      wait_values[NGF_QUEUE_TYPE_GRAPHICS] =
+          NGFI_MAX(wait_values[NGF_QUEUE_TYPE_GRAPHICS], prologue_wait_value);
+      prologue_waited_mask |= 1u << queue;
+    }
+
+    // Release the resources that are transferred from other queues in a separate submission to
+    // each source queue, and make this command buffer wait for them.
+    for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+      ngfvk_pending_barrier_list* release_barriers = &pending_release_barriers[q];
+      if (release_barriers->npending_buf_bars + release_barriers->npending_img_bars == 0u) {
+        continue;
+      }
+      ngfvk_submit_batch* release_batch = ngfvk_submit_batch_for_queue(
+          batches,
+          &nbatches,
+          CURRENT_CONTEXT->queue_timeline_values,
+          submitted_cmd_buf_handles_idx,
+          (ngf_queue_type)q,
+          NULL);
+      ngfvk_submit_aux_barriers(
+          frame_res,
+          release_barriers,
+          (ngf_queue_type)q,
+          submitted_cmd_buf_handles,
+          &submitted_cmd_buf_handles_idx,
+          release_batch);
+      wait_values[q] = release_batch->signal_value;
+    }
+
+    ngfvk_submit_batch* batch = ngfvk_submit_batch_for_queue(
+        batches,
+        &nbatches,
+        CURRENT_CONTEXT->queue_timeline_values,
+        submitted_cmd_buf_handles_idx,
+        queue,
+        wait_values);
+    if (pending_patch_barriers.npending_buf_bars + pending_patch_barriers.npending_img_bars > 0u) {
+      ngfvk_submit_aux_barriers(
+          frame_res,
+          &pending_patch_barriers,
+          queue,
+          submitted_cmd_buf_handles,
+          &submitted_cmd_buf_handles_idx,
+          batch);
     }
-    pending_patch_barriers.barriers.clear();
     submitted_cmd_buf_handles[submitted_cmd_buf_handles_idx++] = cmd_buf->vk_cmd_buffer;
+    batch->ncmd_bufs++;
     NGFI_TRANSITION_CMD_BUF(cmd_buf, ngfi::CMD_BUFFER_STATE_SUBMITTED);
     cmd_buf->active_gfx_pipe     = NULL;
     cmd_buf->active_compute_pipe = NULL;
@@ -4541,6 +7808,15 @@ static ngf_error ngfvk_submit_pending_cmd_buffers(
   }
   frame_res->submitted_cmd_bufs.clear();
 
+  // The frame always ends with a submission to the graphics queue, which presentation waits on.
+  ngfvk_submit_batch* present_batch = ngfvk_submit_batch_for_queue(
+      batches,
+      &nbatches,
+      CURRENT_CONTEXT->queue_timeline_values,
+      submitted_cmd_buf_handles_idx,
+      NGF_QUEUE_TYPE_GRAPHICS,
+      NULL);
+
   // Transition the swapchain image to VK_IMAGE_LAYOUT_PRESENT_SRC if necessary.
   const bool needs_present = CURRENT_CONTEXT->swapchain && wait_semaphore != VK_NULL_HANDLE;
   if (needs_present) {
@@ -4552,6 +7828,8 @@ static ngf_error ngfvk_submit_pending_cmd_buffers(
       VkCommandPool   aux_cmd_pool;
       ngfvk_cmd_buffer_allocate_for_frame(
           CURRENT_CONTEXT->current_frame_token,
+          NGF_QUEUE_TYPE_GRAPHICS,
+          NULL,
           &aux_cmd_pool,
           &aux_cmd_buf);
       const VkImageMemoryBarrier swapchain_mem_bar = {
@@ -4585,34 +7863,145 @@ static ngf_error ngfvk_submit_pending_cmd_buffers(
       memset(&swapchain_image->sync_state, 0, sizeof(swapchain_image->sync_state));
       swapchain_image->sync_state.layout                         = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
       submitted_cmd_buf_handles[submitted_cmd_buf_handles_idx++] = aux_cmd_buf;
+      present_batch->ncmd_bufs++;
       frame_res->retire.append(ngfvk_cmd_buf_with_pool {aux_cmd_buf, aux_cmd_pool});
     }
   }
 
-  const VkPipelineStageFlags wait_masks[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  const VkSubmitInfo         submit_info  = {
-               .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
-               .pNext                = NULL,
-               .waitSemaphoreCount   = needs_present ? 1u : 0u,
-               .pWaitSemaphores      = needs_present ? &wait_semaphore : NULL,
-               .pWaitDstStageMask    = wait_masks,
-               .commandBufferCount   = submitted_cmd_buf_handles_idx,
-               .pCommandBuffers      = submitted_cmd_buf_handles,
-               .signalSemaphoreCount = needs_present ? 1u : 0u,
-               .pSignalSemaphores    = needs_present ? &(frame_res->semaphore) : NULL};
+  // Each batch signals its queue's timeline, if there is one. The first graphics batch waits for
+  // the swapchain image to be acquired, and the last one signals the binary semaphore that
+  // presentation waits on.
+  const bool use_timelines =
+      CURRENT_CONTEXT->queue_timelines[NGF_QUEUE_TYPE_GRAPHICS] != VK_NULL_HANDLE;
+  const uint64_t frame_serial   = CURRENT_CONTEXT->frame_serial;
+  bool           acquire_waited = false;
+  memset(frame_res->queue_timeline_values, 0, sizeof(frame_res->queue_timeline_values));
+  for (uint32_t b = 0u; b < nbatches && err == NGF_ERROR_OK; ++b) {
+    const ngfvk_submit_batch* batch      = &batches[b];
+    const bool                last_batch = b == nbatches - 1u;
+
+    VkSemaphore          wait_semaphores[NGF_QUEUE_TYPE_COUNT + 1u];
+    uint64_t             wait_values[NGF_QUEUE_TYPE_COUNT + 1u];
+    VkPipelineStageFlags wait_stage_masks[NGF_QUEUE_TYPE_COUNT + 1u];
+    uint32_t             nwait_semaphores = 0u;
+    if (needs_present && !acquire_waited && batch->queue == NGF_QUEUE_TYPE_GRAPHICS) {
+      acquire_waited                      = true;
+      wait_values[nwait_semaphores]       = 0u;
+      wait_stage_masks[nwait_semaphores]  = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+      wait_semaphores[nwait_semaphores++] = wait_semaphore;
+    }
+    for (uint32_t q = 0u; use_timelines && q < NGF_QUEUE_TYPE_COUNT; ++q) {
+      if (batch->wait_values[q] == 0u) { continue; }
+      wait_values[nwait_semaphores]       = batch->wait_values[q];
+      wait_stage_masks[nwait_semaphores]  = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      wait_semaphores[nwait_semaphores++] = CURRENT_CONTEXT->queue_timelines[q];
+    }
+
+    VkSemaphore signal_semaphores[2];
+    uint64_t    signal_values[2];
+    uint32_t    nsignal_semaphores = 0u;
+    if (needs_present && last_batch) {
+      signal_values[nsignal_semaphores]       = 0u;
+      signal_semaphores[nsignal_semaphores++] = frame_res->semaphore;
+    }
+    if (use_timelines) {
+      signal_values[nsignal_semaphores]       = batch->signal_value;
+      signal_semaphores[nsignal_semaphores++] = CURRENT_CONTEXT->queue_timelines[batch->queue];
+    }
 
-  VkResult submit_result = vkQueueSubmit(_vk.gfx_queue, 1, &submit_info, signal_fence);
+    const VkTimelineSemaphoreSubmitInfo timeline_submit_info = {
+        .sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO,
+        .pNext                     = NULL,
+        .waitSemaphoreValueCount   = nwait_semaphores,
+        .pWaitSemaphoreValues      = wait_values,
+        .signalSemaphoreValueCount = nsignal_semaphores,
+        .pSignalSemaphoreValues    = signal_values};
+    const VkSubmitInfo submit_info = {
+        .sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+        .pNext                = use_timelines ? &timeline_submit_info : NULL,
+        .waitSemaphoreCount   = nwait_semaphores,
+        .pWaitSemaphores      = wait_semaphores,
+        .pWaitDstStageMask    = wait_stage_masks,
+        .commandBufferCount   = batch->ncmd_bufs,
+        .pCommandBuffers      = &submitted_cmd_buf_handles[batch->first_cmd_buf],
+        .signalSemaphoreCount = nsignal_semaphores,
+        .pSignalSemaphores    = signal_semaphores};
+
+    const VkResult submit_result = vkQueueSubmit(
+        ngfvk_vk_queue(batch->queue),
+        1,
+        &submit_info,
+        last_batch ? signal_fence : VK_NULL_HANDLE);
+    if (submit_result != VK_SUCCESS) {
+      err = NGF_ERROR_INVALID_OPERATION;
+    } else if (use_timelines) {
+      frame_res->queue_timeline_values[batch->queue] = batch->signal_value;
+    }
+  }
 
-  if (submit_result != VK_SUCCESS) err = NGF_ERROR_INVALID_OPERATION;
+  if (err == NGF_ERROR_OK) { frame_res->serial = frame_serial; }
   return err;
 }
 
-static void ngfvk_reset_desc_pools_list(ngfvk_desc_pools_list* superpool) {
-  for (ngfvk_desc_pool* pool = superpool->list; pool; pool = pool->next) {
+// Accounts for the usage of the given descriptor pools list over the frame that it was used for,
+// and makes all of its pools available for reuse. The same list may be retired multiple times
+// within a frame; only the first reset after it has been used contributes to the stats.
+static void ngfvk_reset_desc_pools_list(
+    ngfvk_desc_pools_list*     pools_list,
+    ngf_descriptor_pool_stats* frame_stats) {
+  const bool was_used = pools_list->frame_usage.sets > 0u || pools_list->npools_created > 0u;
+  if (was_used) {
+    uint32_t npools = 0u;
+    for (const ngfvk_desc_pool* pool = pools_list->list; pool; pool = pool->next) {
+      ++npools;
+      if (frame_stats == NULL) continue;
+      frame_stats->set_capacity += pool->capacity.sets;
+      for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+        frame_stats->descriptor_capacity[i] += pool->capacity.descriptors[i];
+      }
+    }
+    if (frame_stats) {
+      frame_stats->npools += npools;
+      frame_stats->npools_created += pools_list->npools_created;
+      frame_stats->nsets_allocated += pools_list->frame_usage.sets;
+      for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+        frame_stats->ndescriptors_allocated[i] += pools_list->frame_usage.descriptors[i];
+      }
+    }
+
+    if (pools_list->config.adaptive) {
+      ngfvk_desc_pool_capacity* high_water = &pools_list->high_water;
+      high_water->sets =
+          NGFI_MAX(pools_list->frame_usage.sets, high_water->sets - high_water->sets / 8u);
+      for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) {
+        high_water->descriptors[i] = NGFI_MAX(
+            pools_list->frame_usage.descriptors[i],
+            high_water->descriptors[i] - high_water->descriptors[i] / 8u);
+      }
+      // If a single pool wasn't enough for the frame, replace all of them with one pool sized
+      // according to the updated high-water marks, which gets created on next use.
+      if (npools > 1u) {
+        ngfvk_desc_pool* pool = pools_list->list;
+        while (pool) {
+          ngfvk_desc_pool* next = pool->next;
+          vkDestroyDescriptorPool(_vk.device, pool->vk_pool, NULL);
+          NGFI_FREE(pool);
+          pool = next;
+        }
+        pools_list->list = NULL;
+      }
+    }
+  }
+
+  for (ngfvk_desc_pool* pool = pools_list->list; pool; pool = pool->next) {
     vkResetDescriptorPool(_vk.device, pool->vk_pool, 0u);
     memset(&pool->utilization, 0, sizeof(pool->utilization));
   }
-  superpool->active_pool = superpool->list;
+  pools_list->active_pool = pools_list->list;
+  memset(&pools_list->frame_usage, 0, sizeof(pools_list->frame_usage));
+  pools_list->npools_created = 0u;
+  pools_list->set_cache.entries.clear();
+  pools_list->set_cache.storage.reset();
 }
 
 #if defined(__APPLE__)
@@ -4717,6 +8106,9 @@ ngf_get_device_list(const ngf_device** devices, uint32_t* ndevices) NGF_NOEXCEPT
         devcaps->max_sampler_anisotropy          = vkdevlimits->maxSamplerAnisotropy;
         devcaps->max_uniform_buffer_range        = vkdevlimits->maxUniformBufferRange;
         devcaps->cubemap_arrays_supported        = dev_features.imageCubeArray;
+        devcaps->supports_pipeline_statistics_queries = dev_features.pipelineStatisticsQuery;
+        devcaps->max_draw_indirect_count =
+            dev_features.multiDrawIndirect ? vkdevlimits->maxDrawIndirectCount : 1u;
         devcaps->framebuffer_color_sample_counts = vkdevlimits->framebufferColorSampleCounts;
         devcaps->framebuffer_depth_sample_counts = vkdevlimits->framebufferDepthSampleCounts;
         devcaps->texture_color_sample_counts     = vkdevlimits->sampledImageColorSampleCounts;
@@ -4775,13 +8167,21 @@ ngf_get_device_list(const ngf_device** devices, uint32_t* ndevices) NGF_NOEXCEPT
         enabled_exts.push_back("VK_KHR_swapchain");
         const bool shader_float16_int8_supported = add_optional_ext("VK_KHR_shader_float16_int8");
         const bool sync2_supported               = add_optional_ext("VK_KHR_synchronization2");
+        const bool descriptor_indexing_supported = add_optional_ext("VK_EXT_descriptor_indexing");
         const bool inline_ray_tracing_supported =
             add_optional_ext("VK_KHR_acceleration_structure") &&
             add_optional_ext("VK_KHR_buffer_device_address") &&
             add_optional_ext("VK_KHR_deferred_host_operations") &&
             add_optional_ext("VK_KHR_spirv_1_4") &&
             add_optional_ext("VK_KHR_shader_float_controls") &&
-            add_optional_ext("VK_KHR_ray_query") && add_optional_ext("VK_EXT_descriptor_indexing");
+            add_optional_ext("VK_KHR_ray_query") && descriptor_indexing_supported;
+        const bool dynamic_rendering_supported =
+            add_optional_ext("VK_KHR_create_renderpass2") &&
+            add_optional_ext("VK_KHR_depth_stencil_resolve") &&
+            add_optional_ext("VK_KHR_dynamic_rendering");
+        const bool timeline_semaphores_supported = add_optional_ext("VK_KHR_timeline_semaphore");
+        const bool multi_draw_supported          = add_optional_ext("VK_EXT_multi_draw");
+        ngfdevinfo->push_descriptor_supported    = add_optional_ext("VK_KHR_push_descriptor");
 
         // Device capabilities: features structs.
         const VkBool32 enable_cubemap_arrays =
@@ -4789,8 +8189,11 @@ ngf_get_device_list(const ngf_device** devices, uint32_t* ndevices) NGF_NOEXCEPT
         ngfdevinfo->required_features = VkPhysicalDeviceFeatures {
             .imageCubeArray                       = enable_cubemap_arrays,
             .independentBlend                     = VK_TRUE,
+            .multiDrawIndirect                    = dev_features.multiDrawIndirect,
             .depthBiasClamp                       = VK_TRUE,
             .samplerAnisotropy                    = VK_TRUE,
+            .occlusionQueryPrecise                = dev_features.occlusionQueryPrecise,
+            .pipelineStatisticsQuery              = dev_features.pipelineStatisticsQuery,
             .shaderStorageImageReadWithoutFormat  = VK_TRUE,
             .shaderStorageImageWriteWithoutFormat = VK_TRUE};
         ngfdevinfo->sf16i8_features = VkPhysicalDeviceShaderFloat16Int8Features {
@@ -4803,6 +8206,14 @@ ngf_get_device_list(const ngf_device** devices, uint32_t* ndevices) NGF_NOEXCEPT
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR};
         ngfdevinfo->ray_query_features = VkPhysicalDeviceRayQueryFeaturesKHR {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR};
+        ngfdevinfo->desc_indexing_features = VkPhysicalDeviceDescriptorIndexingFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+        ngfdevinfo->dynamic_rendering_features = VkPhysicalDeviceDynamicRenderingFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES};
+        ngfdevinfo->timeline_semaphore_features = VkPhysicalDeviceTimelineSemaphoreFeatures {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES};
+        ngfdevinfo->multi_draw_features = VkPhysicalDeviceMultiDrawFeaturesEXT {
+            .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_FEATURES_EXT};
         void* features_structs      = nullptr;
         auto  append_feature_struct = [&features_structs](auto& s) {
           s.pNext          = features_structs;
@@ -4810,12 +8221,42 @@ ngf_get_device_list(const ngf_device** devices, uint32_t* ndevices) NGF_NOEXCEPT
         };
         if (shader_float16_int8_supported) append_feature_struct(ngfdevinfo->sf16i8_features);
         if (sync2_supported) append_feature_struct(ngfdevinfo->sync2_features);
+        if (descriptor_indexing_supported) {
+          append_feature_struct(ngfdevinfo->desc_indexing_features);
+        }
         if (inline_ray_tracing_supported) {
           append_feature_struct(ngfdevinfo->bda_features);
           append_feature_struct(ngfdevinfo->accls_features);
           append_feature_struct(ngfdevinfo->ray_query_features);
         }
+        if (dynamic_rendering_supported) {
+          append_feature_struct(ngfdevinfo->dynamic_rendering_features);
+        }
+        if (timeline_semaphores_supported) {
+          append_feature_struct(ngfdevinfo->timeline_semaphore_features);
+        }
+        if (multi_draw_supported) { append_feature_struct(ngfdevinfo->multi_draw_features); }
         devcaps->supports_inline_raytracing = inline_ray_tracing_supported;
+
+        // Device capabilities: look for dedicated compute and transfer queue families.
+        uint32_t nqueue_families = 0u;
+        vkGetPhysicalDeviceQueueFamilyProperties(phys_devs[i], &nqueue_families, NULL);
+        ngfi::array<VkQueueFamilyProperties, ngfi::system_alloc_callbacks> queue_family_props;
+        queue_family_props.resize(nqueue_families);
+        vkGetPhysicalDeviceQueueFamilyProperties(
+            phys_devs[i],
+            &nqueue_families,
+            queue_family_props.data());
+        devcaps->supports_async_compute  = false;
+        devcaps->supports_async_transfer = false;
+        for (const VkQueueFamilyProperties& family_props : queue_family_props) {
+          const VkQueueFlags flags = family_props.queueFlags;
+          devcaps->supports_async_compute |= timeline_semaphores_supported &&
+                                             (flags & VK_QUEUE_COMPUTE_BIT) != 0 &&
+                                             (flags & VK_QUEUE_GRAPHICS_BIT) == 0;
+          devcaps->supports_async_transfer |=
+              timeline_semaphores_supported && ngfvk_is_dedicated_transfer_family(&family_props);
+        }
         ngfdevinfo->phys_dev_features2 = VkPhysicalDeviceFeatures2 {
             .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2,
             .pNext = features_structs};
@@ -4853,6 +8294,10 @@ extern "C" ngf_error ngf_initialize(const ngf_init_info* init_info) NGF_NOEXCEPT
 
   // Install user-provided allocation callbacks.
   ngfi_set_allocation_callbacks(init_info->allocation_callbacks);
+  pthread_mutex_init(&_vk.orphans.mu, NULL);
+  pthread_mutex_init(&_vk.layout_cache.mu, NULL);
+  pthread_mutex_init(&_vk.renderpass_cache.mu, NULL);
+  pthread_mutex_init(&_vk.bindless_heap.mu, NULL);
 
   // Engage RenderDoc if requested.
   if (init_info->renderdoc_info) {
@@ -4955,8 +8400,12 @@ extern "C" ngf_error ngf_initialize(const ngf_init_info* init_info) NGF_NOEXCEPT
   vkGetPhysicalDeviceQueueFamilyProperties(_vk.phys_dev, &num_queue_families, queue_families);
 
   // Pick suitable queue families for graphics and present, ensuring graphics also supports compute.
-  uint32_t gfx_family_idx     = ngfvk::global::invalid_idx;
-  uint32_t present_family_idx = ngfvk::global::invalid_idx;
+  // A compute family without graphics support, if there is one, backs the async compute queue, and
+  // a transfer-only family backs the transfer queue.
+  uint32_t gfx_family_idx      = ngfvk::global::invalid_idx;
+  uint32_t present_family_idx  = ngfvk::global::invalid_idx;
+  uint32_t compute_family_idx  = ngfvk::global::invalid_idx;
+  uint32_t transfer_family_idx = ngfvk::global::invalid_idx;
   for (uint32_t q = 0; queue_families && q < num_queue_families; ++q) {
     const VkQueueFlags flags      = queue_families[q].queueFlags;
     const bool         is_gfx     = (flags & VK_QUEUE_GRAPHICS_BIT) != 0;
@@ -4966,43 +8415,78 @@ extern "C" ngf_error ngf_initialize(const ngf_init_info* init_info) NGF_NOEXCEPT
       gfx_family_idx = q;
     }
     if (present_family_idx == ngfvk::global::invalid_idx && is_present) { present_family_idx = q; }
+    if (compute_family_idx == ngfvk::global::invalid_idx && !is_gfx && is_compute) {
+      compute_family_idx = q;
+    }
+    if (transfer_family_idx == ngfvk::global::invalid_idx &&
+        ngfvk_is_dedicated_transfer_family(&queue_families[q])) {
+      transfer_family_idx = q;
+    }
   }
-  queue_families = NULL;
   if (gfx_family_idx == ngfvk::global::invalid_idx ||
       present_family_idx == ngfvk::global::invalid_idx) {
     NGFI_DIAG_ERROR("Could not find a suitable queue family for graphics and/or presentation.");
     return NGF_ERROR_INVALID_OPERATION;
   }
-  _vk.gfx_family_idx     = gfx_family_idx;
-  _vk.present_family_idx = present_family_idx;
-
-  // Create logical device.
-  const float             queue_prio           = 1.0f;
-  const bool              same_gfx_and_present = _vk.gfx_family_idx == _vk.present_family_idx;
-  const uint32_t          num_queue_infos      = (same_gfx_and_present ? 1u : 2u);
-  VkDeviceQueueCreateInfo queue_infos[]        = {
-      {.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-              .pNext            = NULL,
-              .flags            = 0,
-              .queueFamilyIndex = _vk.present_family_idx,
-              .queueCount       = 1,
-              .pQueuePriorities = &queue_prio},
-      {.sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
-              .pNext            = NULL,
-              .flags            = 0,
-              .queueFamilyIndex = _vk.gfx_family_idx,
-              .queueCount       = 1,
-              .pQueuePriorities = &queue_prio}};
   if (vkGetPhysicalDeviceFeatures2KHR) {
     vkGetPhysicalDeviceFeatures2KHR(_vk.phys_dev, &ngfdevinfo->phys_dev_features2);
   }
 
+  // Async compute and transfers rely on timeline semaphores for synchronizing with the graphics
+  // queue.
+  const bool timeline_semaphores =
+      ngfdevinfo->timeline_semaphore_features.timelineSemaphore == VK_TRUE;
+  _vk.async_compute  = compute_family_idx != ngfvk::global::invalid_idx && timeline_semaphores;
+  _vk.async_transfer = transfer_family_idx != ngfvk::global::invalid_idx && timeline_semaphores;
+  _vk.gfx_family_idx      = gfx_family_idx;
+  _vk.present_family_idx  = present_family_idx;
+  _vk.compute_family_idx  = _vk.async_compute ? compute_family_idx : gfx_family_idx;
+  _vk.transfer_family_idx = _vk.async_transfer ? transfer_family_idx : gfx_family_idx;
+
+  // Timestamps can only be written on queues whose family reports valid timestamp bits.
+  _vk.timestamp_queues_mask = 0u;
+  for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+    if (queue_families[ngfvk_queue_family_idx((ngf_queue_type)q)].timestampValidBits > 0u) {
+      _vk.timestamp_queues_mask |= 1u << q;
+    }
+  }
+  queue_families = NULL;
+  ngf_device_capabilities* caps = &ngfvk::global::phys_devices[device_idx].capabilities;
+  caps->supports_async_compute  = _vk.async_compute;
+  caps->supports_async_transfer = _vk.async_transfer;
+  caps->supports_timestamp_queries =
+      (_vk.timestamp_queues_mask & (1u << NGF_QUEUE_TYPE_GRAPHICS)) != 0u;
+  _vk.precise_occlusion_queries = ngfdevinfo->required_features.occlusionQueryPrecise == VK_TRUE;
+
+  // Create logical device.
+  const float             queue_prio      = 1.0f;
+  uint32_t                num_queue_infos = 0u;
+  VkDeviceQueueCreateInfo queue_infos[4];
+  const uint32_t queue_families_to_create[] = {
+      _vk.gfx_family_idx,
+      _vk.present_family_idx,
+      _vk.compute_family_idx,
+      _vk.transfer_family_idx};
+  for (uint32_t family_idx : queue_families_to_create) {
+    bool already_created = false;
+    for (uint32_t i = 0u; i < num_queue_infos; ++i) {
+      already_created |= queue_infos[i].queueFamilyIndex == family_idx;
+    }
+    if (already_created) { continue; }
+    queue_infos[num_queue_infos++] = VkDeviceQueueCreateInfo {
+        .sType            = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+        .pNext            = NULL,
+        .flags            = 0,
+        .queueFamilyIndex = family_idx,
+        .queueCount       = 1,
+        .pQueuePriorities = &queue_prio};
+  }
   const VkDeviceCreateInfo dev_info = {
       .sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
       .pNext                   = ngfdevinfo->phys_dev_features2.pNext,
       .flags                   = 0,
       .queueCreateInfoCount    = num_queue_infos,
-      .pQueueCreateInfos       = &queue_infos[same_gfx_and_present ? 1u : 0u],
+      .pQueueCreateInfos       = queue_infos,
       .enabledLayerCount       = 0,
       .ppEnabledLayerNames     = NULL,
       .enabledExtensionCount   = static_cast<uint32_t>(ngfdevinfo->enabled_ext_names.size()),
@@ -5016,7 +8500,31 @@ extern "C" ngf_error ngf_initialize(const ngf_init_info* init_info) NGF_NOEXCEPT
   }
 
   // Load device-level entry points.
-  vkl_init_device(_vk.device, ngfdevinfo->sync2_features.synchronization2);
+  _vk.dynamic_rendering = ngfdevinfo->dynamic_rendering_features.dynamicRendering == VK_TRUE;
+  _vk.timeline_semaphores =
+      ngfdevinfo->timeline_semaphore_features.timelineSemaphore == VK_TRUE;
+  _vk.multi_draw = ngfdevinfo->multi_draw_features.multiDraw == VK_TRUE;
+  vkl_init_device(
+      _vk.device,
+      ngfdevinfo->sync2_features.synchronization2,
+      _vk.dynamic_rendering,
+      _vk.timeline_semaphores,
+      _vk.multi_draw,
+      ngfdevinfo->push_descriptor_supported);
+
+  // With partially bound descriptor bindings, freshly allocated descriptor sets of the pipelines
+  // that opt into them don't need to be pre-populated with dummy resources.
+  _vk.partially_bound_descs =
+      ngfdevinfo->desc_indexing_features.descriptorBindingPartiallyBound == VK_TRUE;
+
+  VkPhysicalDeviceProperties vk_dev_props;
+  vkGetPhysicalDeviceProperties(_vk.phys_dev, &vk_dev_props);
+  _vk.max_dynamic_uniform_buffers =
+      NGFI_MIN(
+          vk_dev_props.limits.maxDescriptorSetUniformBuffersDynamic,
+          ngfvk::global::max_dynamic_uniform_buffers) /
+      ngfvk::global::max_dynamic_uniform_buffer_sets;
+  _vk.timestamp_period = vk_dev_props.limits.timestampPeriod;
 
   // Set up VMA.
   VmaVulkanFunctions vma_vk_fns = {
@@ -5041,6 +8549,108 @@ extern "C" ngf_error ngf_initialize(const ngf_init_info* init_info) NGF_NOEXCEPT
   // Obtain queue handles.
   vkGetDeviceQueue(_vk.device, _vk.gfx_family_idx, 0, &_vk.gfx_queue);
   vkGetDeviceQueue(_vk.device, _vk.present_family_idx, 0, &_vk.present_queue);
+  vkGetDeviceQueue(_vk.device, _vk.compute_family_idx, 0, &_vk.compute_queue);
+  vkGetDeviceQueue(_vk.device, _vk.transfer_family_idx, 0, &_vk.transfer_queue);
+
+  // The bindless resource heap relies on update-after-bind descriptors that may be left unwritten.
+  const VkPhysicalDeviceDescriptorIndexingFeatures* desc_indexing =
+      &ngfdevinfo->desc_indexing_features;
+  const bool bindless_supported =
+      desc_indexing->runtimeDescriptorArray && desc_indexing->descriptorBindingPartiallyBound &&
+      desc_indexing->descriptorBindingSampledImageUpdateAfterBind &&
+      desc_indexing->descriptorBindingStorageBufferUpdateAfterBind &&
+      desc_indexing->descriptorBindingUpdateUnusedWhilePending;
+
+  // Create the device-wide pipeline cache, and record the identity of the device and driver
+  // for validating serialized caches later on.
+  // The multi-draw, push descriptor and descriptor indexing limits are queried along the way.
+  VkPhysicalDevicePushDescriptorPropertiesKHR push_desc_props = {
+      .sType              = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PUSH_DESCRIPTOR_PROPERTIES_KHR,
+      .pNext              = NULL,
+      .maxPushDescriptors = 0u};
+  VkPhysicalDeviceMultiDrawPropertiesEXT multi_draw_props = {
+      .sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTI_DRAW_PROPERTIES_EXT,
+      .pNext             = ngfdevinfo->push_descriptor_supported ? &push_desc_props : NULL,
+      .maxMultiDrawCount = 0u};
+  VkPhysicalDeviceDescriptorIndexingProperties desc_indexing_props = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES,
+      .pNext = _vk.multi_draw ? &multi_draw_props : multi_draw_props.pNext};
+  VkPhysicalDeviceIDProperties phys_dev_id_props = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES,
+      .pNext = bindless_supported ? (void*)&desc_indexing_props : desc_indexing_props.pNext};
+  VkPhysicalDeviceProperties2 phys_dev_properties2 = {
+      .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2,
+      .pNext = &phys_dev_id_props};
+  memset(&_vk.pipeline_cache_id, 0, sizeof(_vk.pipeline_cache_id));
+  if (vkGetPhysicalDeviceProperties2KHR) {
+    vkGetPhysicalDeviceProperties2KHR(_vk.phys_dev, &phys_dev_properties2);
+    memcpy(_vk.pipeline_cache_id.driver_uuid, phys_dev_id_props.driverUUID, VK_UUID_SIZE);
+  }
+  _vk.max_multi_draw_count = multi_draw_props.maxMultiDrawCount;
+  _vk.multi_draw &= _vk.max_multi_draw_count > 0u;
+  _vk.max_push_descriptors = push_desc_props.maxPushDescriptors;
+  _vk.push_descriptors     = _vk.max_push_descriptors > 0u && vkCmdPushDescriptorSetKHR != NULL;
+  if (bindless_supported && vkGetPhysicalDeviceProperties2KHR) {
+    _vk.bindless_layout_limits = ngfvk_bindless_layout_limits {
+        .sampled_images = NGFI_MIN(
+            desc_indexing_props.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            desc_indexing_props.maxDescriptorSetUpdateAfterBindSampledImages),
+        .samplers = NGFI_MIN(
+            desc_indexing_props.maxPerStageDescriptorUpdateAfterBindSamplers,
+            desc_indexing_props.maxDescriptorSetUpdateAfterBindSamplers),
+        .storage_buffers = NGFI_MIN(
+            desc_indexing_props.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            desc_indexing_props.maxDescriptorSetUpdateAfterBindStorageBuffers),
+        .resources = desc_indexing_props.maxPerStageUpdateAfterBindResources};
+    // Images and buffers also count towards the limit on all resources accessible to a stage. Some
+    // room is left for the other sets of the pipeline layouts that include the heap.
+    const ngfvk_bindless_layout_limits* layout_limits = &_vk.bindless_layout_limits;
+    const uint32_t max_resources                      = layout_limits->resources / 2u;
+    const uint32_t limits[NGF_BINDLESS_RESOURCE_TYPE_COUNT] = {
+        NGFI_MIN(layout_limits->sampled_images, max_resources),
+        layout_limits->samplers,
+        NGFI_MIN(layout_limits->storage_buffers, max_resources)};
+    bool have_capacity = true;
+    for (uint32_t t = 0u; t < NGF_BINDLESS_RESOURCE_TYPE_COUNT; ++t) {
+      const uint32_t reserve   = ngfvk::global::bindless_layout_reserve;
+      const uint32_t available = limits[t] > reserve ? limits[t] - reserve : 0u;
+      _vk.bindless_heap_capacities[t] =
+          NGFI_MIN(ngfvk::global::default_bindless_heap_capacities[t], available);
+      have_capacity &= _vk.bindless_heap_capacities[t] > 0u;
+    }
+    _vk.bindless_set_layout =
+        have_capacity ? ngfvk_create_bindless_set_layout(_vk.bindless_heap_capacities) : NULL;
+    if (_vk.bindless_set_layout != NULL &&
+        ngfvk_bindless_heap_init(&_vk.bindless_heap, _vk.bindless_heap_capacities) !=
+            NGF_ERROR_OK) {
+      vkDestroyDescriptorSetLayout(_vk.device, _vk.bindless_set_layout->vk_handle, NULL);
+      ngfi::free(_vk.bindless_set_layout);
+      _vk.bindless_set_layout = NULL;
+    }
+  }
+  if (_vk.bindless_set_layout == NULL) {
+    memset(_vk.bindless_heap_capacities, 0, sizeof(_vk.bindless_heap_capacities));
+  }
+  caps->supports_bindless_resources = _vk.bindless_set_layout != NULL;
+  memcpy(
+      caps->max_bindless_resources,
+      _vk.bindless_heap_capacities,
+      sizeof(caps->max_bindless_resources));
+  _vk.pipeline_cache_id.vendor_id      = phys_dev_properties.vendorID;
+  _vk.pipeline_cache_id.device_id      = phys_dev_properties.deviceID;
+  _vk.pipeline_cache_id.driver_version = phys_dev_properties.driverVersion;
+  memcpy(_vk.pipeline_cache_id.cache_uuid, phys_dev_properties.pipelineCacheUUID, VK_UUID_SIZE);
+  const VkPipelineCacheCreateInfo pipeline_cache_info = {
+      .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .pNext           = NULL,
+      .flags           = 0u,
+      .initialDataSize = 0u,
+      .pInitialData    = NULL};
+  vk_err = vkCreatePipelineCache(_vk.device, &pipeline_cache_info, NULL, &_vk.pipeline_cache);
+  if (vk_err != VK_SUCCESS) {
+    NGFI_DIAG_WARNING("Failed to create a pipeline cache, VK error %d.", vk_err);
+    _vk.pipeline_cache = VK_NULL_HANDLE;
+  }
 
   // Populate device capabilities.
   ngfvk::global::phys_device_caps = ngfvk::global::phys_devices[init_info->device].capabilities;
@@ -5117,6 +8727,30 @@ extern "C" void ngf_shutdown(void) NGF_NOEXCEPT {
   NGFI_FREE(_vk.dummy_res.samp);
 
   if (_vk.allocator != VK_NULL_HANDLE) { vmaDestroyAllocator(_vk.allocator); }
+  if (_vk.device != VK_NULL_HANDLE) {
+    ngfvk_destroy_orphaned_objects();
+    ngfvk_destroy_layout_cache();
+    if (_vk.bindless_set_layout != NULL) {
+      vkDestroyDescriptorSetLayout(_vk.device, _vk.bindless_set_layout->vk_handle, NULL);
+      ngfi::free(_vk.bindless_set_layout);
+      _vk.bindless_set_layout = NULL;
+    }
+    if (_vk.bindless_heap.vk_pool != VK_NULL_HANDLE) {
+      vkDestroyDescriptorPool(_vk.device, _vk.bindless_heap.vk_pool, NULL);
+      _vk.bindless_heap.vk_pool = VK_NULL_HANDLE;
+      _vk.bindless_heap.vk_set  = VK_NULL_HANDLE;
+    }
+    for (ngfvk_bindless_slots& slots : _vk.bindless_heap.slots) { slots.free_indices.clear(); }
+    ngfvk_destroy_renderpass_cache();
+  }
+  pthread_mutex_destroy(&_vk.orphans.mu);
+  pthread_mutex_destroy(&_vk.layout_cache.mu);
+  pthread_mutex_destroy(&_vk.renderpass_cache.mu);
+  pthread_mutex_destroy(&_vk.bindless_heap.mu);
+  if (_vk.pipeline_cache != VK_NULL_HANDLE) {
+    vkDestroyPipelineCache(_vk.device, _vk.pipeline_cache, NULL);
+    _vk.pipeline_cache = VK_NULL_HANDLE;
+  }
 
   if (_vk.device != VK_NULL_HANDLE) { vkDestroyDevice(_vk.device, NULL); }
   if (_vk.debug_messenger) {
@@ -5147,6 +8781,28 @@ extern "C" const ngf_device_capabilities* ngf_get_device_capabilities(void) NGF_
   return &ngfvk::global::phys_device_caps;
 }
 
+extern "C" ngf_error
+ngf_get_descriptor_set_cache_stats(ngf_descriptor_set_cache_stats* stats) NGF_NOEXCEPT {
+  assert(stats);
+  if (CURRENT_CONTEXT == NULL) { return NGF_ERROR_INVALID_OPERATION; }
+  stats->hits   = 0u;
+  stats->misses = 0u;
+  for (const ngfvk_desc_superpool& superpool : CURRENT_CONTEXT->desc_superpools) {
+    for (const ngfvk_desc_pools_list& pools_list : superpool.pools_lists) {
+      stats->hits += pools_list.set_cache.hits;
+      stats->misses += pools_list.set_cache.misses;
+    }
+  }
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_get_descriptor_pool_stats(ngf_descriptor_pool_stats* stats) NGF_NOEXCEPT {
+  assert(stats);
+  if (CURRENT_CONTEXT == NULL) { return NGF_ERROR_INVALID_OPERATION; }
+  *stats = CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].desc_pool_stats;
+  return NGF_ERROR_OK;
+}
+
 extern "C" ngf_error
 ngf_resize_context(ngf_context ctx, uint32_t new_width, uint32_t new_height) NGF_NOEXCEPT {
   assert(ctx);
@@ -5184,9 +8840,10 @@ extern "C" ngf_context ngf_get_context() NGF_NOEXCEPT {
 }
 
 extern "C" ngf_error
-ngf_create_cmd_buffer(const ngf_cmd_buffer_info*, ngf_cmd_buffer* result) NGF_NOEXCEPT {
+ngf_create_cmd_buffer(const ngf_cmd_buffer_info* info, ngf_cmd_buffer* result) NGF_NOEXCEPT {
+  assert(info);
   assert(result);
-  auto cmd_buf = ngf_cmd_buffer_t::make();
+  auto cmd_buf = ngf_cmd_buffer_t::make(*info);
   if (!cmd_buf.has_error()) { result[0] = cmd_buf.value().release(); }
   return cmd_buf.has_error() ? cmd_buf.error() : NGF_ERROR_OK;
 }
@@ -5240,14 +8897,16 @@ extern "C" ngf_error ngf_cmd_begin_render_pass(
     ngf_cmd_buffer              cmd_buf,
     const ngf_render_pass_info* pass_info,
     ngf_render_encoder*         enc) NGF_NOEXCEPT {
+  if (cmd_buf->queue != NGF_QUEUE_TYPE_GRAPHICS) {
+    NGFI_DIAG_ERROR("render passes may only be recorded into graphics queue command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
   if (pass_info->render_target->is_default &&
       ngfvk_maybe_acquire_swapchain_image() != NGF_ERROR_OK) {
     return NGF_ERROR_INVALID_OPERATION;
   }
 
-  ngf_error err = NGF_ERROR_OK;
-
-  ngfvk_encoder_start(cmd_buf);
+  ngf_error err = ngfvk_encoder_start(cmd_buf);
   if (err != NGF_ERROR_OK) return err;
 
   err = ngfvk_initialize_generic_encoder(cmd_buf, &enc->pvt_data_donotuse);
@@ -5295,9 +8954,15 @@ extern "C" ngf_error ngf_cmd_begin_render_pass(
   }
   cmd_buf->pending_clear_value_count = (uint16_t)nclears;
 
+  const ngf_render_pass_resources* declared_resources  = pass_info->declared_resources;
+  const uint32_t                   ndeclared_resources =
+      declared_resources ? declared_resources->nresources : 0u;
+
   ngfvk_sync_req_batch sync_req_batch;
 
-  ngfvk_sync_req_batch_init(pass_info->render_target->nattachments, &sync_req_batch);
+  ngfvk_sync_req_batch_init(
+      pass_info->render_target->nattachments + ndeclared_resources,
+      &sync_req_batch);
 
   for (size_t i = 0u; i < pass_info->render_target->nattachments; ++i) {
     const ngf_attachment_type attachment_type = pass_info->render_target->attachment_descs[i].type;
@@ -5310,17 +8975,19 @@ extern "C" ngf_error ngf_cmd_begin_render_pass(
           VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
       sync_req.barrier_masks.stage_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
       sync_req.layout                   = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-      ngf_image color_image =
+      ngfvk_sync_res res =
           cmd_buf->active_rt->is_default
-              ? (attachment_sample_count == NGF_SAMPLE_COUNT_1
-                     ? CURRENT_CONTEXT->swapchain
-                           ->wrapper_imgs[CURRENT_CONTEXT->swapchain->image_idx]
-                           .get()
-                     : CURRENT_CONTEXT->swapchain
-                           ->multisample_imgs[CURRENT_CONTEXT->swapchain->image_idx]
-                           .get())
-              : pass_info->render_target->attachment_images[i];
-      ngfvk_sync_res res = ngfvk_sync_res_from_img(color_image);
+              ? ngfvk_sync_res_from_img(
+                    attachment_sample_count == NGF_SAMPLE_COUNT_1
+                        ? CURRENT_CONTEXT->swapchain
+                              ->wrapper_imgs[CURRENT_CONTEXT->swapchain->image_idx]
+                              .get()
+                        : CURRENT_CONTEXT->swapchain
+                              ->multisample_imgs[CURRENT_CONTEXT->swapchain->image_idx]
+                              .get())
+              : ngfvk_sync_res_from_img_range(
+                    pass_info->render_target->attachment_images[i],
+                    pass_info->render_target->attachment_ranges[i]);
       ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
       break;
     }
@@ -5332,10 +8999,12 @@ extern "C" ngf_error ngf_cmd_begin_render_pass(
       sync_req.barrier_masks.stage_mask =
           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
       sync_req.layout                    = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-      ngf_image      depth_stencil_image = cmd_buf->active_rt->is_default
-                                               ? CURRENT_CONTEXT->swapchain->depth_img
-                                               : pass_info->render_target->attachment_images[i];
-      ngfvk_sync_res res                 = ngfvk_sync_res_from_img(depth_stencil_image);
+      const ngfvk_sync_res res =
+          cmd_buf->active_rt->is_default
+              ? ngfvk_sync_res_from_img(CURRENT_CONTEXT->swapchain->depth_img)
+              : ngfvk_sync_res_from_img_range(
+                    pass_info->render_target->attachment_images[i],
+                    pass_info->render_target->attachment_ranges[i]);
       ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
       break;
     }
@@ -5344,7 +9013,123 @@ extern "C" ngf_error ngf_cmd_begin_render_pass(
       assert(0);
     }
   }
-  ngfvk_sync_req_batch_process(&sync_req_batch, cmd_buf);
+  for (uint32_t i = 0u; i < ndeclared_resources; ++i) {
+    const ngf_render_pass_resource* res_decl = &declared_resources->resources[i];
+    const ngfvk_sync_req            sync_req = ngfvk_sync_req_for_declared_resource(res_decl);
+    const ngfvk_sync_res            res      = ngfvk_sync_res_from_declared_resource(res_decl);
+    ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
+  }
+
+  if (declared_resources == NULL) {
+    // Barriers for the resources used within the pass are determined as commands get recorded, so
+    // the pass can't begin until it's ended.
+    ngfvk_sync_req_batch_process(&sync_req_batch, cmd_buf);
+  } else {
+    // All the resources used within the pass are known, so the pass can begin right away, and
+    // subsequent commands can be recorded directly.
+    ngfvk_sync_req_batch_commit(&sync_req_batch, cmd_buf);
+    ngfvk_cmd_begin_vk_render_pass(cmd_buf);
+    cmd_buf->immediate_render_pass = true;
+  }
+
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_cmd_begin_secondary_render_pass(
+    ngf_cmd_buffer      cmd_buf,
+    ngf_render_encoder  primary_enc,
+    ngf_render_encoder* enc) NGF_NOEXCEPT {
+  const ngf_cmd_buffer primary = NGFVK_ENC2CMDBUF(primary_enc);
+  if (!cmd_buf->secondary || primary->secondary || !primary->renderpass_active ||
+      primary->immediate_render_pass) {
+    NGFI_DIAG_ERROR("secondary render passes require a secondary command buffer, and a deferred "
+                    "render pass in a primary command buffer");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (cmd_buf->parent_frame != primary->parent_frame) {
+    NGFI_DIAG_ERROR("secondary command buffer was started for a different frame");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (cmd_buf->vk_cmd_buffer != VK_NULL_HANDLE) {
+    NGFI_DIAG_ERROR("secondary command buffer has already recorded a render pass for this frame");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+
+  NGFI_TRANSITION_CMD_BUF(cmd_buf, ngfi::CMD_BUFFER_STATE_RECORDING);
+
+  ngf_error err = ngfvk_initialize_generic_encoder(cmd_buf, &enc->pvt_data_donotuse);
+  if (err != NGF_ERROR_OK) { return err; }
+
+  ngfi::tmp_arena().reset();
+  err = ngfvk_cmd_buf_allocate_secondary(cmd_buf, &primary->pending_render_pass_info);
+  ngfi::tmp_arena().reset();
+  if (err != NGF_ERROR_OK) { return err; }
+
+  // The render target's attachments are synchronized by the primary command buffer, the secondary
+  // only needs to track the resources used by its own commands.
+  cmd_buf->pending_render_pass_info  = primary->pending_render_pass_info;
+  cmd_buf->pending_clear_value_count = 0u;
+  cmd_buf->active_rt                 = primary->active_rt;
+  cmd_buf->renderpass_active         = true;
+
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_cmd_execute_secondary_cmd_buffers(
+    ngf_render_encoder    enc,
+    uint32_t              nbuffers,
+    const ngf_cmd_buffer* bufs) NGF_NOEXCEPT {
+  ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
+  const bool has_inline_cmds =
+      !buf->executes_secondaries && buf->in_pass_cmd_chnks.begin() != buf->in_pass_cmd_chnks.end();
+  if (buf->secondary || buf->immediate_render_pass || has_inline_cmds) {
+    NGFI_DIAG_ERROR("secondary command buffers may only be executed within deferred render passes "
+                    "that don't have any other commands");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  for (uint32_t i = 0u; i < nbuffers; ++i) {
+    const ngf_cmd_buffer secondary = bufs[i];
+    if (!secondary->secondary || secondary->parent_frame != buf->parent_frame ||
+        secondary->state != ngfi::CMD_BUFFER_STATE_READY_TO_SUBMIT ||
+        secondary->vk_cmd_buffer == VK_NULL_HANDLE) {
+      NGFI_DIAG_ERROR("command buffer hasn't finished recording a secondary render pass");
+      return NGF_ERROR_INVALID_OPERATION;
+    }
+  }
+
+  auto vk_cmd_bufs = ngfi::frame_alloc<VkCommandBuffer>(nbuffers);
+  if (vk_cmd_bufs == NULL) { return NGF_ERROR_OUT_OF_MEM; }
+
+  // Secondary command buffers are merged in the order in which they execute, which makes the
+  // resulting hazard tracking state independent of the order in which they were recorded.
+  ngfvk_frame_resources* frame_res = &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id];
+  for (uint32_t i = 0u; i < nbuffers; ++i) {
+    const ngf_cmd_buffer secondary = bufs[i];
+    NGFI_TRANSITION_CMD_BUF(secondary, ngfi::CMD_BUFFER_STATE_PENDING);
+    ngfi::tmp_arena().reset();
+    const ngf_error err = ngfvk_cmd_buf_merge_secondary(buf, secondary);
+    if (err != NGF_ERROR_OK) { return err; }
+    vk_cmd_bufs[i] = secondary->vk_cmd_buffer;
+
+    frame_res->retire.append(
+        ngfvk_cmd_buf_with_pool {secondary->vk_cmd_buffer, secondary->vk_cmd_pool});
+    if (secondary->desc_pools_list) { frame_res->retire.append(secondary->desc_pools_list); }
+    secondary->vk_cmd_buffer                      = VK_NULL_HANDLE;
+    secondary->vk_cmd_pool                        = VK_NULL_HANDLE;
+    secondary->desc_pools_list                    = NULL;
+    secondary->pending_barriers.npending_img_bars = 0u;
+    secondary->pending_barriers.npending_buf_bars = 0u;
+    secondary->pending_barriers.barriers.clear();
+    ngfvk_cmd_buf_reset_res_states(secondary);
+    NGFI_TRANSITION_CMD_BUF(secondary, ngfi::CMD_BUFFER_STATE_SUBMITTED);
+  }
+  ngfi::tmp_arena().reset();
+
+  buf->executes_secondaries  = true;
+  const ngfvk_render_cmd cmd = {
+      .data = {.execute_secondaries = {.cmd_bufs = vk_cmd_bufs, .ncmd_bufs = nbuffers}},
+      .type = NGFVK_RENDER_CMD_EXECUTE_SECONDARIES};
+  ngfvk_cmd_buf_add_render_cmd(buf, &cmd, true);
 
   return NGF_ERROR_OK;
 }
@@ -5369,6 +9154,10 @@ extern "C" ngf_error ngf_cmd_begin_compute_pass(
     const ngf_compute_pass_info* pass_info,
     ngf_compute_encoder*         enc) NGF_NOEXCEPT {
   (void)pass_info;
+  if (cmd_buf->queue == NGF_QUEUE_TYPE_TRANSFER) {
+    NGFI_DIAG_ERROR("compute passes can't be recorded into transfer queue command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
   ngf_error err = ngfvk_encoder_start(cmd_buf);
   if (err != NGF_ERROR_OK) return err;
 
@@ -5376,91 +9165,71 @@ extern "C" ngf_error ngf_cmd_begin_compute_pass(
   if (err != NGF_ERROR_OK) { return err; }
 
   cmd_buf->compute_pass_active = true;
+  cmd_buf->bound_compute_res.clear();
   return NGF_ERROR_OK;
 }
 
 extern "C" ngf_error ngf_cmd_end_render_pass(ngf_render_encoder enc) NGF_NOEXCEPT {
   ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
+  if (buf->pass_queries_mask != 0u) {
+    NGFI_DIAG_ERROR("queries begun within a render pass must be ended before the pass ends");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
 
-  // Commit all the pending barriers.
-  ngfvk_sync_commit_pending_barriers(&buf->pending_barriers, buf->vk_cmd_buffer);
-
-  // Begin the real render pass.
-  const ngf_render_pass_info* pass_info   = &buf->pending_render_pass_info;
-  const VkRenderPass          render_pass = ngfvk_lookup_renderpass(
-      pass_info->render_target,
-      ngfvk_renderpass_ops_key(
-          pass_info->render_target,
-          pass_info->load_ops,
-          pass_info->store_ops));
-
-  const ngfvk_swapchain*  swapchain = CURRENT_CONTEXT->swapchain.get();
-  const ngf_render_target target    = pass_info->render_target;
-
-  const VkFramebuffer fb =
-      target->is_default ? swapchain->framebufs[swapchain->image_idx] : target->frame_buffer;
-  const VkExtent2D render_extent = {
-      target->is_default ? CURRENT_CONTEXT->swapchain_info.width : target->width,
-      target->is_default ? CURRENT_CONTEXT->swapchain_info.height : target->height};
-
-  const uint32_t clear_value_count = buf->pending_clear_value_count;
-  auto           vk_clears =
-      clear_value_count > 0 ? ngfi::tmp_alloc<VkClearValue>(clear_value_count) : nullptr;
-  if (clear_value_count > 0) {
-    for (size_t i = 0; i < clear_value_count; ++i) {
-      VkClearValue*    vk_clear_val = &vk_clears[i];
-      const ngf_clear* clear        = &pass_info->clears[i];
-      if (target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH16 &&
-          target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH32 &&
-          target->attachment_descs[i].format != NGF_IMAGE_FORMAT_DEPTH24_STENCIL8) {
-        VkClearColorValue* clear_color_var = &vk_clear_val->color;
-        clear_color_var->float32[0]        = clear->clear_color[0];
-        clear_color_var->float32[1]        = clear->clear_color[1];
-        clear_color_var->float32[2]        = clear->clear_color[2];
-        clear_color_var->float32[3]        = clear->clear_color[3];
-      } else {
-        VkClearDepthStencilValue* clear_depth_stencil_val = &vk_clear_val->depthStencil;
-        clear_depth_stencil_val->depth                    = clear->clear_depth_stencil.clear_depth;
-        clear_depth_stencil_val->stencil = clear->clear_depth_stencil.clear_stencil;
-      }
-    }
+  // Secondary command buffers only get the pass's commands. The primary command buffer executing
+  // them begins and ends the pass, and takes care of the barriers.
+  if (buf->secondary) {
+    ngfvk_cmd_buf_record_render_cmds(buf, buf->in_pass_cmd_chnks);
+    ngfvk_cmd_buf_reset_render_cmds(buf);
+    vkEndCommandBuffer(buf->vk_cmd_buffer);
+    buf->renderpass_active = false;
+    buf->active_rt         = NULL;
+    return ngfvk_encoder_end(buf, &enc.pvt_data_donotuse);
   }
 
-  const VkRenderPassBeginInfo begin_info = {
-      .sType           = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
-      .pNext           = NULL,
-      .renderPass      = render_pass,
-      .framebuffer     = fb,
-      .renderArea      = {.offset = {0u, 0u}, .extent = render_extent},
-      .clearValueCount = clear_value_count,
-      .pClearValues    = vk_clears};
-  vkCmdBeginRenderPass(buf->vk_cmd_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+  // Immediate mode passes have already begun, with their commands recorded directly.
+  if (!buf->immediate_render_pass) {
+    // Commit all the pending barriers.
+    ngfvk_sync_commit_pending_barriers(&buf->pending_barriers, buf->vk_cmd_buffer);
 
-  // Clean up after the begin operation.
-  ngfi::tmp_arena().reset();
+    // Begin the real render pass.
+    ngfvk_cmd_begin_vk_render_pass(buf);
 
-  // Encode each pending render command.
-  ngfvk_cmd_buf_record_render_cmds(buf, buf->in_pass_cmd_chnks);
+    // Encode each pending render command.
+    ngfvk_cmd_buf_record_render_cmds(buf, buf->in_pass_cmd_chnks);
 
-  // Reset pending render command storage.
-  ngfvk_cmd_buf_reset_render_cmds(buf);
+    // Reset pending render command storage.
+    ngfvk_cmd_buf_reset_render_cmds(buf);
+  }
 
   // Finish renderpass.
-  vkCmdEndRenderPass(buf->vk_cmd_buffer);
-  buf->renderpass_active = false;
-  buf->active_rt         = NULL;
+  if (_vk.dynamic_rendering) {
+    vkCmdEndRendering(buf->vk_cmd_buffer);
+  } else {
+    vkCmdEndRenderPass(buf->vk_cmd_buffer);
+  }
+  buf->renderpass_active     = false;
+  buf->immediate_render_pass = false;
+  buf->executes_secondaries  = false;
+  buf->active_rt             = NULL;
 
   return ngfvk_encoder_end(buf, &enc.pvt_data_donotuse);
 }
 
 extern "C" ngf_error ngf_cmd_end_xfer_pass(ngf_xfer_encoder enc) NGF_NOEXCEPT {
-  ngf_cmd_buffer buf    = NGFVK_ENC2CMDBUF(enc);
+  ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
+  ngfvk_cmd_buf_flush_deferred_cmds(buf);
   buf->xfer_pass_active = false;
   return ngfvk_encoder_end(buf, &enc.pvt_data_donotuse);
 }
 
 extern "C" ngf_error ngf_cmd_end_compute_pass(ngf_compute_encoder enc) NGF_NOEXCEPT {
-  ngf_cmd_buffer cmd_buf       = NGFVK_ENC2CMDBUF(enc);
+  ngf_cmd_buffer cmd_buf = NGFVK_ENC2CMDBUF(enc);
+  if (cmd_buf->pass_queries_mask != 0u) {
+    NGFI_DIAG_ERROR("queries begun within a compute pass must be ended before the pass ends");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  ngfvk_cmd_buf_flush_deferred_cmds(cmd_buf);
   cmd_buf->compute_pass_active = false;
   return ngfvk_encoder_end(cmd_buf, &enc.pvt_data_donotuse);
 }
@@ -5476,18 +9245,47 @@ ngf_start_cmd_buffer(ngf_cmd_buffer cmd_buf, ngf_frame_token token) NGF_NOEXCEPT
   cmd_buf->active_rt           = nullptr;
   cmd_buf->active_gfx_pipe     = nullptr;
   cmd_buf->active_compute_pipe = nullptr;
-  cmd_buf->compute_pass_active = false;
-  cmd_buf->renderpass_active   = false;
-  cmd_buf->npending_bind_ops   = 0u;
+  cmd_buf->compute_pass_active   = false;
+  cmd_buf->renderpass_active     = false;
+  cmd_buf->immediate_render_pass = false;
+  cmd_buf->executes_secondaries  = false;
+  cmd_buf->npending_bind_ops     = 0u;
+  cmd_buf->wait_queues_mask      = 0u;
+  cmd_buf->active_queries_mask   = 0u;
+  cmd_buf->pass_queries_mask     = 0u;
+  cmd_buf->deferred_epoch        = 1u;
+  cmd_buf->nin_pass_cmds         = 0u;
+
+  cmd_buf->pending_split_wait.event = VK_NULL_HANDLE;
 
   cmd_buf->virt_bind_ops_ranges.clear();
   cmd_buf->in_pass_cmd_chnks.clear();
   cmd_buf->pending_barriers.barriers.clear();
+  cmd_buf->pending_barriers.npending_img_bars = 0u;
+  cmd_buf->pending_barriers.npending_buf_bars = 0u;
   cmd_buf->local_res_states.clear();
+  memset(&cmd_buf->bound_gfx_desc_sets, 0, sizeof(cmd_buf->bound_gfx_desc_sets));
+  memset(&cmd_buf->bound_compute_desc_sets, 0, sizeof(cmd_buf->bound_compute_desc_sets));
 
   ngfvk_cleanup_pending_binds(cmd_buf);
 
-  return ngfvk_cmd_buffer_allocate_for_frame(token, &cmd_buf->vk_cmd_pool, &cmd_buf->vk_cmd_buffer);
+  // Secondary command buffers are allocated once it's known which render pass they continue. One
+  // that has been recorded but never executed can be freed right away.
+  if (cmd_buf->secondary) {
+    if (cmd_buf->vk_cmd_buffer != VK_NULL_HANDLE) {
+      vkFreeCommandBuffers(_vk.device, cmd_buf->vk_cmd_pool, 1u, &cmd_buf->vk_cmd_buffer);
+      cmd_buf->vk_cmd_buffer = VK_NULL_HANDLE;
+      cmd_buf->vk_cmd_pool   = VK_NULL_HANDLE;
+    }
+    return NGF_ERROR_OK;
+  }
+
+  return ngfvk_cmd_buffer_allocate_for_frame(
+      token,
+      cmd_buf->queue,
+      NULL,
+      &cmd_buf->vk_cmd_pool,
+      &cmd_buf->vk_cmd_buffer);
 }
 
 extern "C" void ngf_destroy_cmd_buffer(ngf_cmd_buffer buffer) NGF_NOEXCEPT {
@@ -5509,6 +9307,14 @@ ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer* cmd_bufs) NGF_NOEXCEPT
       NGFI_DIAG_ERROR("submitting a command buffer for the wrong frame");
       return NGF_ERROR_INVALID_OPERATION;
     }
+    if (cmd_buf->secondary) {
+      NGFI_DIAG_ERROR("secondary command buffers can't be submitted directly");
+      return NGF_ERROR_INVALID_OPERATION;
+    }
+    if (cmd_buf->active_queries_mask != 0u) {
+      NGFI_DIAG_ERROR("command buffers can't be submitted while queries are active on them");
+      return NGF_ERROR_INVALID_OPERATION;
+    }
     NGFI_TRANSITION_CMD_BUF(cmd_bufs[i], ngfi::CMD_BUFFER_STATE_PENDING);
     if (cmd_buf->desc_pools_list) { frame_res_data->retire.append(cmd_buf->desc_pools_list); }
     vkEndCommandBuffer(cmd_buf->vk_cmd_buffer);
@@ -5518,6 +9324,30 @@ ngf_submit_cmd_buffers(uint32_t nbuffers, ngf_cmd_buffer* cmd_bufs) NGF_NOEXCEPT
   return NGF_ERROR_OK;
 }
 
+extern "C" ngf_error
+ngf_cmd_buffer_add_dependency(ngf_cmd_buffer buf, ngf_cmd_buffer dependency) NGF_NOEXCEPT {
+  assert(buf);
+  assert(dependency);
+  if (buf->secondary || dependency->secondary) {
+    NGFI_DIAG_ERROR("secondary command buffers can't have dependencies");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (buf->state != ngfi::CMD_BUFFER_STATE_RECORDING &&
+      buf->state != ngfi::CMD_BUFFER_STATE_READY_TO_SUBMIT) {
+    NGFI_DIAG_ERROR("dependencies may only be added to command buffers before submission");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (buf->parent_frame != dependency->parent_frame) {
+    NGFI_DIAG_ERROR("command buffer dependencies must belong to the same frame");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const ngf_queue_type dependency_queue = ngfvk_effective_queue(dependency->queue);
+  if (dependency_queue != ngfvk_effective_queue(buf->queue)) {
+    buf->wait_queues_mask |= 1u << dependency_queue;
+  }
+  return NGF_ERROR_OK;
+}
+
 extern "C" ngf_error ngf_begin_frame(ngf_frame_token* token) NGF_NOEXCEPT {
   ngf_error err = NGF_ERROR_OK;
 
@@ -5538,18 +9368,25 @@ extern "C" ngf_error ngf_begin_frame(ngf_frame_token* token) NGF_NOEXCEPT {
   ngfi::tmp_arena().reset();
   ngfi::frame_arena().reset();
 
-  // Retire resources.
+  // Wait for the last frame that used the same resources to finish, and retire them.
   ngfvk_frame_resources* next_frame_res = &CURRENT_CONTEXT->frame_res[fi];
+  if (next_frame_res->serial > 0u) {
+    ngfvk_wait_frame_serial(CURRENT_CONTEXT, next_frame_res->serial, UINT64_MAX);
+  }
   ngfvk_retire_resources(next_frame_res);
   next_frame_res->res_frame_arena.reset();
+  ngfvk_adopt_orphaned_objects(next_frame_res);
 
   if (CURRENT_CONTEXT->swapchain) {
     CURRENT_CONTEXT->swapchain->image_idx = ngfvk::global::invalid_idx;
   }
-  CURRENT_CONTEXT->current_frame_token  = ngfi_encode_frame_token(
-      (uint16_t)((uintptr_t)CURRENT_CONTEXT & 0xffff),
-      (uint8_t)CURRENT_CONTEXT->max_inflight_frames,
-      (uint8_t)CURRENT_CONTEXT->frame_id);
+  CURRENT_CONTEXT->frame_serial++;
+  CURRENT_CONTEXT->current_frame_token = ngfi_frame_token_with_serial(
+      ngfi_encode_frame_token(
+          (uint16_t)((uintptr_t)CURRENT_CONTEXT & 0xffff),
+          (uint8_t)CURRENT_CONTEXT->max_inflight_frames,
+          (uint8_t)CURRENT_CONTEXT->frame_id),
+      (uint32_t)CURRENT_CONTEXT->frame_serial);
 
   *token = CURRENT_CONTEXT->current_frame_token;
   return err;
@@ -5593,10 +9430,13 @@ extern "C" ngf_error ngf_end_frame(ngf_frame_token token) NGF_NOEXCEPT {
   const bool  needs_present   = CURRENT_CONTEXT->swapchain && CURRENT_CONTEXT->swapchain->vk_swapchain != VK_NULL_HANDLE;
   if (needs_present) { image_semaphore = CURRENT_CONTEXT->swapchain->img_sems[fi]; }
 
-  ngf_error submit_result = ngfvk_submit_pending_cmd_buffers(
-      frame_res,
-      image_semaphore,
-      frame_res->fences[frame_res->nwait_fences++]);
+  // Without a timeline semaphore, completion of the frame is tracked with a fence.
+  const bool    use_fence =
+      CURRENT_CONTEXT->queue_timelines[NGF_QUEUE_TYPE_GRAPHICS] == VK_NULL_HANDLE;
+  const VkFence signal_fence =
+      use_fence ? frame_res->fences[frame_res->nwait_fences++] : VK_NULL_HANDLE;
+  ngf_error submit_result =
+      ngfvk_submit_pending_cmd_buffers(frame_res, image_semaphore, signal_fence);
 
   // Present if necessary.
   if (submit_result == NGF_ERROR_OK && needs_present) {
@@ -5624,6 +9464,51 @@ extern "C" ngf_error ngf_end_frame(ngf_frame_token token) NGF_NOEXCEPT {
   return err;
 }
 
+extern "C" bool ngf_is_frame_complete(ngf_frame_token token) NGF_NOEXCEPT {
+  return ngf_wait_frame(token, 0u) == NGF_ERROR_OK;
+}
+
+extern "C" bool ngf_is_frame_transfer_complete(ngf_frame_token token) NGF_NOEXCEPT {
+  assert(CURRENT_CONTEXT);
+  ngf_context ctx = CURRENT_CONTEXT;
+  if (ngfi_frame_ctx_id(token) != (uint16_t)((uintptr_t)ctx & 0xffff)) {
+    NGFI_DIAG_ERROR("frame token was generated by a different context");
+    return false;
+  }
+  const ngf_queue_type queue = ngfvk_effective_queue(NGF_QUEUE_TYPE_TRANSFER);
+  const uint64_t       serial = ngfvk_frame_token_serial(ctx, token);
+  if (serial <= ctx->completed_frame_serial) { return true; }
+  const ngfvk_frame_resources* frame_res = &ctx->frame_res[serial % ctx->max_inflight_frames];
+  if (frame_res->serial < serial) { return false; }
+  if (frame_res->serial > serial) { return true; }
+  if (ctx->queue_timelines[queue] == VK_NULL_HANDLE) { return ngf_is_frame_complete(token); }
+
+  // The frame's transfers are done once its last submission to the transfer queue is.
+  uint64_t completed_value = 0u;
+  return frame_res->queue_timeline_values[queue] == 0u ||
+         (vkGetSemaphoreCounterValue(_vk.device, ctx->queue_timelines[queue], &completed_value) ==
+              VK_SUCCESS &&
+          completed_value >= frame_res->queue_timeline_values[queue]);
+}
+
+extern "C" ngf_error ngf_wait_frame(ngf_frame_token token, uint64_t timeout_ns) NGF_NOEXCEPT {
+  assert(CURRENT_CONTEXT);
+  if (ngfi_frame_ctx_id(token) != (uint16_t)((uintptr_t)CURRENT_CONTEXT & 0xffff)) {
+    NGFI_DIAG_ERROR("frame token was generated by a different context");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const uint64_t serial = ngfvk_frame_token_serial(CURRENT_CONTEXT, token);
+  if (serial > CURRENT_CONTEXT->completed_frame_serial &&
+      CURRENT_CONTEXT->frame_res[serial % CURRENT_CONTEXT->max_inflight_frames].serial < serial) {
+    if (timeout_ns == 0u) { return NGF_ERROR_TIMEOUT; }
+    NGFI_DIAG_ERROR("waiting for a frame that hasn't been ended");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const VkResult result = ngfvk_wait_frame_serial(CURRENT_CONTEXT, serial, timeout_ns);
+  if (result == VK_SUCCESS) { return NGF_ERROR_OK; }
+  return result == VK_TIMEOUT ? NGF_ERROR_TIMEOUT : NGF_ERROR_OPERATION_FAILED;
+}
+
 extern "C" ngf_error
 ngf_create_shader_stage(const ngf_shader_stage_info* info, ngf_shader_stage* result) NGF_NOEXCEPT {
   assert(info);
@@ -5673,6 +9558,137 @@ extern "C" void ngf_destroy_compute_pipeline(ngf_compute_pipeline p) NGF_NOEXCEP
   }
 }
 
+template<class InfoT, class ResultT> struct ngfvk_pipeline_batch {
+  const InfoT* infos;
+  ResultT*     results;
+  ngf_error*   errors;
+
+  static void create_one(void* job_data, uint32_t job_idx) NGF_NOEXCEPT {
+    auto batch          = (ngfvk_pipeline_batch*)job_data;
+    auto maybe_pipeline = ngfvk_generic_pipeline::make(batch->infos[job_idx]);
+    if (maybe_pipeline.has_error()) {
+      batch->results[job_idx] = NULL;
+      batch->errors[job_idx]  = maybe_pipeline.error();
+    } else {
+      batch->results[job_idx] = (ResultT)maybe_pipeline.value().release();
+      batch->errors[job_idx]  = NGF_ERROR_OK;
+    }
+  }
+};
+
+template<class InfoT, class ResultT>
+static ngf_error ngfvk_create_pipelines(
+    uint32_t                  npipelines,
+    const InfoT*              infos,
+    ResultT*                  results,
+    const ngf_job_dispatcher* dispatcher) NGF_NOEXCEPT {
+  using batch_t = ngfvk_pipeline_batch<InfoT, ResultT>;
+  if (npipelines == 0u) { return NGF_ERROR_OK; }
+
+  // The jobs may run on threads other than the calling one, so the temporary arena can't be used
+  // here.
+  ngf_error* errors = NGFI_ALLOCN(ngf_error, npipelines);
+  if (errors == NULL) { return NGF_ERROR_OUT_OF_MEM; }
+  batch_t batch = {infos, results, errors};
+
+  if (dispatcher && dispatcher->dispatch) {
+    dispatcher->dispatch(batch_t::create_one, &batch, npipelines, dispatcher->userdata);
+  } else {
+    for (uint32_t i = 0u; i < npipelines; ++i) { batch_t::create_one(&batch, i); }
+  }
+
+  ngf_error err = NGF_ERROR_OK;
+  for (uint32_t i = 0u; i < npipelines && err == NGF_ERROR_OK; ++i) { err = errors[i]; }
+  if (err != NGF_ERROR_OK) {
+    for (uint32_t i = 0u; i < npipelines; ++i) {
+      if (results[i]) {
+        auto gp = (ngfvk_generic_pipeline*)results[i];
+        NGFI_FREE(gp);
+        results[i] = NULL;
+      }
+    }
+  }
+  NGFI_FREEN(errors, npipelines);
+  return err;
+}
+
+extern "C" ngf_error ngf_create_graphics_pipelines(
+    uint32_t                          npipelines,
+    const ngf_graphics_pipeline_info* infos,
+    ngf_graphics_pipeline*            results,
+    const ngf_job_dispatcher*         dispatcher) NGF_NOEXCEPT {
+  assert(npipelines == 0u || (infos && results));
+  return ngfvk_create_pipelines(npipelines, infos, results, dispatcher);
+}
+
+extern "C" ngf_error ngf_create_compute_pipelines(
+    uint32_t                         npipelines,
+    const ngf_compute_pipeline_info* infos,
+    ngf_compute_pipeline*            results,
+    const ngf_job_dispatcher*        dispatcher) NGF_NOEXCEPT {
+  assert(npipelines == 0u || (infos && results));
+  return ngfvk_create_pipelines(npipelines, infos, results, dispatcher);
+}
+
+extern "C" ngf_error ngf_pipeline_cache_serialize(void* data, size_t* size) NGF_NOEXCEPT {
+  assert(size);
+  if (_vk.pipeline_cache == VK_NULL_HANDLE) { return NGF_ERROR_INVALID_OPERATION; }
+
+  const size_t header_size  = sizeof(ngfvk_pipeline_cache_blob_header);
+  size_t       vk_data_size = 0u;
+  if (data == nullptr) {
+    const VkResult vk_err =
+        vkGetPipelineCacheData(_vk.device, _vk.pipeline_cache, &vk_data_size, NULL);
+    if (vk_err != VK_SUCCESS) { return NGF_ERROR_OPERATION_FAILED; }
+    *size = header_size + vk_data_size;
+    return NGF_ERROR_OK;
+  }
+
+  if (*size < header_size) { return NGF_ERROR_INVALID_SIZE; }
+  vk_data_size = *size - header_size;
+  const VkResult vk_err = vkGetPipelineCacheData(
+      _vk.device,
+      _vk.pipeline_cache,
+      &vk_data_size,
+      (uint8_t*)data + header_size);
+  if (vk_err == VK_INCOMPLETE) { return NGF_ERROR_INVALID_SIZE; }
+  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OPERATION_FAILED; }
+
+  ngfvk_pipeline_cache_blob_header header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = ngfvk::global::pipeline_cache_magic;
+  header.version   = ngfvk::global::pipeline_cache_version;
+  header.id        = _vk.pipeline_cache_id;
+  header.data_size = vk_data_size;
+  memcpy(data, &header, sizeof(header));
+  *size = header_size + vk_data_size;
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_pipeline_cache_load(const void* data, size_t size) NGF_NOEXCEPT {
+  if (_vk.pipeline_cache == VK_NULL_HANDLE) { return NGF_ERROR_INVALID_OPERATION; }
+  if (!ngfvk_pipeline_cache_blob_is_compatible(data, size, &_vk.pipeline_cache_id)) {
+    NGFI_DIAG_WARNING("pipeline cache data was produced by a different device or driver, ignoring");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+
+  // Load the data into a temporary cache and merge it into the device-wide one, so that
+  // pipelines created prior to this call stay cached as well.
+  const size_t                    header_size    = sizeof(ngfvk_pipeline_cache_blob_header);
+  const VkPipelineCacheCreateInfo src_cache_info = {
+      .sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .pNext           = NULL,
+      .flags           = 0u,
+      .initialDataSize = size - header_size,
+      .pInitialData    = (const uint8_t*)data + header_size};
+  VkPipelineCache src_cache = VK_NULL_HANDLE;
+  VkResult        vk_err    = vkCreatePipelineCache(_vk.device, &src_cache_info, NULL, &src_cache);
+  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OBJECT_CREATION_FAILED; }
+  vk_err = vkMergePipelineCaches(_vk.device, _vk.pipeline_cache, 1u, &src_cache);
+  vkDestroyPipelineCache(_vk.device, src_cache, NULL);
+  return vk_err == VK_SUCCESS ? NGF_ERROR_OK : NGF_ERROR_OPERATION_FAILED;
+}
+
 extern "C" ngf_render_target ngf_default_render_target() NGF_NOEXCEPT {
   if (CURRENT_CONTEXT) {
     return CURRENT_CONTEXT->default_render_target.get();
@@ -5712,48 +9728,143 @@ extern "C" void ngf_destroy_render_target(ngf_render_target target) NGF_NOEXCEPT
     NGFI_FREE(target);
   }
 }
-extern "C" void ngf_cmd_dispatch(
-    ngf_compute_encoder enc,
-    uint32_t            x_threadgroups,
-    uint32_t            y_threadgroups,
-    uint32_t            z_threadgroups) NGF_NOEXCEPT {
-  ngf_cmd_buffer cmd_buf = NGFVK_ENC2CMDBUF(enc);
+// Records the resources bound by the given bind operations within a compute pass, replacing the
+// ones previously bound to the same descriptors.
+static void ngfvk_cmd_buf_track_bound_compute_res(
+    ngf_cmd_buffer              cmd_buf,
+    const ngf_resource_bind_op* bind_operations,
+    uint32_t                    nbind_operations) {
+  for (uint32_t i = 0u; i < nbind_operations; ++i) {
+    const ngf_resource_bind_op* bind_op = &bind_operations[i];
+    const ngfvk_bound_compute_res bound = {
+        .set         = bind_op->target_set,
+        .binding     = bind_op->target_binding,
+        .array_index = bind_op->array_index,
+        .res         = ngfvk_sync_res_from_bind_op(bind_op)};
+    const bool tracked =
+        bound.res.type != NGFVK_SYNC_RES_COUNT && !ngfi_skip_hazard_tracking_for_bind_op(*bind_op);
+    size_t idx = 0u;
+    while (idx < cmd_buf->bound_compute_res.size() &&
+           (cmd_buf->bound_compute_res[idx].set != bound.set ||
+            cmd_buf->bound_compute_res[idx].binding != bound.binding ||
+            cmd_buf->bound_compute_res[idx].array_index != bound.array_index)) {
+      ++idx;
+    }
+    if (idx < cmd_buf->bound_compute_res.size()) {
+      if (tracked) {
+        cmd_buf->bound_compute_res[idx] = bound;
+      } else {
+        cmd_buf->bound_compute_res[idx] = cmd_buf->bound_compute_res.back();
+        cmd_buf->bound_compute_res.pop_back();
+      }
+    } else if (tracked) {
+      cmd_buf->bound_compute_res.push_back(bound);
+    }
+  }
+}
 
+// Marks the resources bound to the compute bind point as accessed by the last command of the
+// current run of deferred commands. Resources declared with ngf_cmd_use_compute_resources remain
+// accessible to any of the run's commands.
+static void ngfvk_cmd_buf_mark_bound_compute_res(ngf_cmd_buffer cmd_buf) {
+  const uint32_t epoch   = cmd_buf->deferred_epoch;
+  const uint32_t cmd_idx = cmd_buf->nin_pass_cmds - 1u;
+  for (const ngfvk_bound_compute_res& bound : cmd_buf->bound_compute_res) {
+    const ngfvk_sync_res_hashtable::keyhash keyhash = {
+        ngfvk_handle_from_sync_res(&bound.res),
+        bound.res.hash};
+    ngfvk_sync_res_data* res_data = cmd_buf->local_res_states.get_prehashed(keyhash);
+    if (res_data == NULL) { continue; }
+    const bool declared = res_data->deferred_epoch == epoch && res_data->deferred_cmd_idx == ~0u;
+    res_data->deferred_epoch   = epoch;
+    res_data->deferred_cmd_idx = declared ? ~0u : cmd_idx;
+  }
+}
+
+// Adds a dispatch command to the current run of deferred commands, along with sync requests for
+// all the resources bound since the previous dispatch. If the grid size is read from an argument
+// buffer, it has to be given as `args_buf`.
+static void ngfvk_cmd_add_dispatch(
+    ngf_cmd_buffer          cmd_buf,
+    const ngfvk_render_cmd* cmd,
+    ngf_buffer              args_buf) {
   ngfi::tmp_arena().reset();
 
-  // Prepare a batch of sync requests by scanning all pending bind operations.
+  // Prepare a batch of sync requests by scanning all bind operations since the previous dispatch.
+  uint32_t nmax_pending_sync_reqs = 1u;
+  for (const ngfvk_virt_bind_range& r : cmd_buf->virt_bind_ops_ranges) {
+    nmax_pending_sync_reqs += r.count;
+  }
   ngfvk_sync_req_batch sync_req_batch;
-  ngfvk_sync_req_batch_init(cmd_buf->npending_bind_ops, &sync_req_batch);
+  ngfvk_sync_req_batch_init(nmax_pending_sync_reqs, &sync_req_batch);
 
-  for (const ngf_resource_bind_op& bind_op_ref : cmd_buf->pending_bind_ops) {
-    const ngf_resource_bind_op* bind_op  = &bind_op_ref;
-    ngfvk_sync_req              sync_req = ngfvk_sync_req_for_bind_op(
-        bind_op,
-        (ngfvk_generic_pipeline*)(cmd_buf->active_compute_pipe));
-    if (sync_req.barrier_masks.stage_mask == 0u) { continue; }
-    const ngfvk_sync_res res = ngfvk_sync_res_from_bind_op(bind_op);
-    if (res.type == NGFVK_SYNC_RES_COUNT) { continue; }
-    ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
+  for (const ngfvk_virt_bind_range& r : cmd_buf->virt_bind_ops_ranges) {
+    for (uint32_t j = 0u; j < r.count; ++j) {
+      assert(r.start[j].type == NGFVK_RENDER_CMD_BIND_RESOURCE);
+      const ngf_resource_bind_op* bind_op  = &r.start[j].data.bind_resource;
+      const ngfvk_sync_req        sync_req = ngfvk_sync_req_for_bind_op(
+          bind_op,
+          (ngfvk_generic_pipeline*)(cmd_buf->active_compute_pipe));
+      if (sync_req.barrier_masks.stage_mask == 0u) { continue; }
+      const ngfvk_sync_res res = ngfvk_sync_res_from_bind_op(bind_op);
+      if (res.type == NGFVK_SYNC_RES_COUNT) { continue; }
+      ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
+    }
+  }
+  cmd_buf->virt_bind_ops_ranges.clear();
+  if (args_buf) {
+    const ngfvk_sync_res args_buf_res = ngfvk_sync_res_from_buf(args_buf);
+    const ngfvk_sync_req args_buf_sync_req = ngfvk_sync_req_for_indirect_args();
+    ngfvk_sync_req_batch_add_with_lookup(
+        &sync_req_batch,
+        cmd_buf,
+        &args_buf_res,
+        &args_buf_sync_req);
   }
 
-  // Emit the necessary barriers prior to dispatch.
-  ngfvk_sync_req_batch_commit(&sync_req_batch, cmd_buf);
+  ngfvk_cmd_buf_add_deferred_cmd(cmd_buf, &sync_req_batch, cmd);
+
+  // Resources bound before the previous dispatch remain accessible to this one.
+  ngfvk_cmd_buf_mark_bound_compute_res(cmd_buf);
+}
 
-  // Allocate and write descriptor sets.
-  ngfvk_execute_pending_binds(cmd_buf);
+extern "C" void ngf_cmd_dispatch(
+    ngf_compute_encoder enc,
+    uint32_t            x_threadgroups,
+    uint32_t            y_threadgroups,
+    uint32_t            z_threadgroups) NGF_NOEXCEPT {
+  const ngfvk_render_cmd cmd = {
+      .data = {.dispatch = {.x = x_threadgroups, .y = y_threadgroups, .z = z_threadgroups}},
+      .type = NGFVK_RENDER_CMD_DISPATCH};
+  ngfvk_cmd_add_dispatch(NGFVK_ENC2CMDBUF(enc), &cmd, NULL);
+}
 
-  vkCmdDispatch(cmd_buf->vk_cmd_buffer, x_threadgroups, y_threadgroups, z_threadgroups);
+extern "C" void ngf_cmd_dispatch_indirect(
+    ngf_compute_encoder enc,
+    ngf_buffer          args_buf,
+    size_t              offset) NGF_NOEXCEPT {
+  assert(args_buf);
+  const ngfvk_render_cmd cmd = {
+      .data = {.dispatch_indirect = {.args_buffer = args_buf, .offset = offset}},
+      .type = NGFVK_RENDER_CMD_DISPATCH_INDIRECT};
+  ngfvk_cmd_add_dispatch(NGFVK_ENC2CMDBUF(enc), &cmd, args_buf);
 }
 
-extern "C" void ngf_cmd_draw(
-    ngf_render_encoder enc,
-    bool               indexed,
-    uint32_t           first_element,
-    uint32_t           nelements,
-    uint32_t           ninstances) NGF_NOEXCEPT {
-  ngf_cmd_buffer cmd_buf = NGFVK_ENC2CMDBUF(enc);
+// Records a draw command into the current render pass, along with sync requests for all the
+// resources used by the draw. If the draw arguments are read from a buffer, it has to be given as
+// `args_buf`.
+static void ngfvk_cmd_add_draw(
+    ngf_cmd_buffer          cmd_buf,
+    const ngfvk_render_cmd* cmd,
+    bool                    indexed,
+    ngf_buffer              args_buf) {
+  // Barriers for immediate mode passes have all been issued when the pass began.
+  if (cmd_buf->immediate_render_pass) {
+    ngfvk_cmd_buf_add_render_cmd(cmd_buf, cmd, true);
+    return;
+  }
 
-  uint32_t nmax_pending_sync_reqs = 2u;
+  uint32_t nmax_pending_sync_reqs = 3u;
   for (const ngfvk_virt_bind_range& r : cmd_buf->virt_bind_ops_ranges) {
     nmax_pending_sync_reqs += r.count;
   }
@@ -5783,6 +9894,15 @@ extern "C" void ngf_cmd_draw(
     const ngfvk_sync_res idx_buf_res = ngfvk_sync_res_from_buf(cmd_buf->active_idx_buf);
     ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &idx_buf_res, &idx_buf_sync_req);
   }
+  if (args_buf) {
+    const ngfvk_sync_res args_buf_res = ngfvk_sync_res_from_buf(args_buf);
+    const ngfvk_sync_req args_buf_sync_req = ngfvk_sync_req_for_indirect_args();
+    ngfvk_sync_req_batch_add_with_lookup(
+        &sync_req_batch,
+        cmd_buf,
+        &args_buf_res,
+        &args_buf_sync_req);
+  }
   cmd_buf->active_attr_buf = NULL;
   cmd_buf->active_idx_buf  = NULL;
 
@@ -5801,15 +9921,97 @@ extern "C" void ngf_cmd_draw(
   cmd_buf->virt_bind_ops_ranges.clear();
   ngfvk_sync_req_batch_process(&sync_req_batch, cmd_buf);
 
+  ngfvk_cmd_buf_add_render_cmd(cmd_buf, cmd, true);
+}
+
+extern "C" void ngf_cmd_draw(
+    ngf_render_encoder enc,
+    bool               indexed,
+    uint32_t           first_element,
+    uint32_t           nelements,
+    uint32_t           ninstances) NGF_NOEXCEPT {
+  const ngf_draw_info draw = {
+      .first_element  = first_element,
+      .nelements      = nelements,
+      .base_vertex    = 0,
+      .ninstances     = ninstances,
+      .first_instance = 0u};
+  ngf_cmd_draw_ext(enc, indexed, &draw);
+}
+
+extern "C" void
+ngf_cmd_draw_ext(ngf_render_encoder enc, bool indexed, const ngf_draw_info* draw) NGF_NOEXCEPT {
+  assert(draw);
+  const ngfvk_render_cmd cmd = {
+      .data = {.draw = {.info = *draw, .indexed = indexed}},
+      .type = NGFVK_RENDER_CMD_DRAW};
+  ngfvk_cmd_add_draw(NGFVK_ENC2CMDBUF(enc), &cmd, indexed, NULL);
+}
+
+extern "C" void ngf_cmd_multi_draw(
+    ngf_render_encoder   enc,
+    bool                 indexed,
+    const ngf_draw_info* draws,
+    uint32_t             ndraws) NGF_NOEXCEPT {
+  if (ndraws == 0u) { return; }
+  assert(draws);
+  auto draws_copy = ngfi::frame_alloc<ngf_draw_info>(ndraws);
+  if (draws_copy == NULL) {
+    NGFI_DIAG_ERROR("failed to allocate memory for a multi-draw command");
+    return;
+  }
+  memcpy(draws_copy, draws, sizeof(ngf_draw_info) * ndraws);
+  const ngfvk_render_cmd cmd = {
+      .data = {.multi_draw = {.draws = draws_copy, .ndraws = ndraws, .indexed = indexed}},
+      .type = NGFVK_RENDER_CMD_MULTI_DRAW};
+  ngfvk_cmd_add_draw(NGFVK_ENC2CMDBUF(enc), &cmd, indexed, NULL);
+}
+
+static void ngfvk_cmd_draw_indirect(
+    ngf_render_encoder enc,
+    bool               indexed,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) {
+  assert(args_buf);
+  if (ndraws > ngfvk::global::phys_device_caps.max_draw_indirect_count) {
+    NGFI_DIAG_ERROR(
+        "indirect draw count %d exceeds the device limit of %d",
+        ndraws,
+        ngfvk::global::phys_device_caps.max_draw_indirect_count);
+    return;
+  }
+  const uint32_t packed_stride =
+      indexed ? sizeof(ngf_draw_indexed_indirect_args) : sizeof(ngf_draw_indirect_args);
   const ngfvk_render_cmd cmd = {
       .data =
-          {.draw =
-               {.first_element = first_element,
-                .nelements     = nelements,
-                .ninstances    = ninstances,
-                .indexed       = indexed}},
-      .type = NGFVK_RENDER_CMD_DRAW};
-  ngfvk_cmd_buf_add_render_cmd(cmd_buf, &cmd, true);
+          {.draw_indirect =
+               {.args_buffer = args_buf,
+                .offset      = offset,
+                .ndraws      = ndraws,
+                .stride      = stride > 0u ? stride : packed_stride,
+                .indexed     = indexed}},
+      .type = NGFVK_RENDER_CMD_DRAW_INDIRECT};
+  ngfvk_cmd_add_draw(NGFVK_ENC2CMDBUF(enc), &cmd, indexed, args_buf);
+}
+
+extern "C" void ngf_cmd_draw_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT {
+  ngfvk_cmd_draw_indirect(enc, false, args_buf, offset, ndraws, stride);
+}
+
+extern "C" void ngf_cmd_draw_indexed_indirect(
+    ngf_render_encoder enc,
+    ngf_buffer         args_buf,
+    size_t             offset,
+    uint32_t           ndraws,
+    uint32_t           stride) NGF_NOEXCEPT {
+  ngfvk_cmd_draw_indirect(enc, true, args_buf, offset, ndraws, stride);
 }
 
 extern "C" void
@@ -5822,13 +10024,75 @@ ngf_cmd_bind_gfx_pipeline(ngf_render_encoder enc, ngf_graphics_pipeline pipeline
   buf->active_gfx_pipe = pipeline;
 }
 
-extern "C" void ngf_cmd_bind_resources(
-    ngf_render_encoder          enc,
-    const ngf_resource_bind_op* bind_operations,
-    uint32_t                    nbind_operations) NGF_NOEXCEPT {
-  ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
-  if (nbind_operations <= 0u) { return; }
+// Accounts for accesses to resources declared with ngf_cmd_use_resources or
+// ngf_cmd_use_compute_resources. Barriers are issued in front of the current run of deferred
+// commands within compute passes, and before the pass begins within render passes.
+static ngf_error ngfvk_cmd_use_resources(
+    ngf_cmd_buffer                  cmd_buf,
+    const ngf_render_pass_resource* resources,
+    uint32_t                        nresources) {
+  if (nresources == 0u) { return NGF_ERROR_OK; }
+  assert(resources);
+  if (cmd_buf->immediate_render_pass) {
+    NGFI_DIAG_ERROR("resources used within immediate mode render passes must be declared when the "
+                    "pass begins");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  for (uint32_t i = 0u; i < nresources; ++i) {
+    const ngf_render_resource_usage usage = resources[i].usage;
+    if (usage >= NGF_RENDER_RESOURCE_USAGE_COUNT) {
+      NGFI_DIAG_ERROR("invalid resource usage %d", usage);
+      return NGF_ERROR_INVALID_ENUM;
+    }
+    if (cmd_buf->compute_pass_active && (usage == NGF_RENDER_RESOURCE_USAGE_ATTRIB_BUFFER ||
+                                         usage == NGF_RENDER_RESOURCE_USAGE_INDEX_BUFFER)) {
+      NGFI_DIAG_ERROR("vertex attribute and index buffers can't be used within compute passes");
+      return NGF_ERROR_INVALID_OPERATION;
+    }
+  }
+
+  ngfi::tmp_arena().reset();
+  ngfvk_sync_req_batch sync_req_batch;
+  ngfvk_sync_req_batch_init(nresources, &sync_req_batch);
+  for (uint32_t i = 0u; i < nresources; ++i) {
+    const ngf_render_pass_resource* r        = &resources[i];
+    ngfvk_sync_req                  sync_req = ngfvk_sync_req_for_declared_resource(r);
+    if (cmd_buf->compute_pass_active && r->usage != NGF_RENDER_RESOURCE_USAGE_INDIRECT_BUFFER) {
+      sync_req.barrier_masks.stage_mask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+    const ngfvk_sync_res res = ngfvk_sync_res_from_declared_resource(r);
+    ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &res, &sync_req);
+  }
+  if (cmd_buf->renderpass_active) {
+    ngfvk_sync_req_batch_process(&sync_req_batch, cmd_buf);
+  } else if (ngfvk_cmd_buf_defers_cmds(cmd_buf)) {
+    ngfvk_sync_req_batch_process_deferred(&sync_req_batch, cmd_buf, false);
+  } else {
+    ngfvk_sync_req_batch_commit(&sync_req_batch, cmd_buf);
+  }
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_cmd_use_resources(
+    ngf_render_encoder              enc,
+    const ngf_render_pass_resource* resources,
+    uint32_t                        nresources) NGF_NOEXCEPT {
+  return ngfvk_cmd_use_resources(NGFVK_ENC2CMDBUF(enc), resources, nresources);
+}
+
+extern "C" ngf_error ngf_cmd_use_compute_resources(
+    ngf_compute_encoder             enc,
+    const ngf_render_pass_resource* resources,
+    uint32_t                        nresources) NGF_NOEXCEPT {
+  return ngfvk_cmd_use_resources(NGFVK_ENC2CMDBUF(enc), resources, nresources);
+}
 
+// Adds bind operations to the deferred commands, keeping track of where they're stored, so that
+// the next draw or dispatch can issue sync requests for the bound resources.
+static void ngfvk_cmd_add_deferred_binds(
+    ngf_cmd_buffer              buf,
+    const ngf_resource_bind_op* bind_operations,
+    uint32_t                    nbind_operations) {
   ngfvk_virt_bind_range   curr_range = {.start = nullptr, .count = 0u};
   const ngfvk_render_cmd* prev_cmd   = nullptr;
 
@@ -5839,6 +10103,7 @@ extern "C" void ngf_cmd_bind_resources(
     const ngfvk_render_cmd* cmd_ptr = buf->in_pass_cmd_chnks.append(
         cmd,
         CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].res_frame_arena);
+    ++buf->nin_pass_cmds;
 
     // Check if the bound resource is marked as read-only.
     // Do not add such resources to the cmd buffer's virt_bind_ops_ranges.
@@ -5870,24 +10135,41 @@ extern "C" void ngf_cmd_bind_resources(
   }
 }
 
+extern "C" void ngf_cmd_bind_resources(
+    ngf_render_encoder          enc,
+    const ngf_resource_bind_op* bind_operations,
+    uint32_t                    nbind_operations) NGF_NOEXCEPT {
+  ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
+  if (nbind_operations <= 0u) { return; }
+
+  // Resources used within immediate mode passes are declared up front, no need to track hazards.
+  if (buf->immediate_render_pass) {
+    ngfvk_cmd_bind_resources(buf, bind_operations, nbind_operations);
+    return;
+  }
+
+  ngfvk_cmd_add_deferred_binds(buf, bind_operations, nbind_operations);
+}
+
 extern "C" void ngf_cmd_bind_compute_resources(
     ngf_compute_encoder         enc,
     const ngf_resource_bind_op* bind_operations,
     uint32_t                    nbind_operations) NGF_NOEXCEPT {
   ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
-  ngfvk_cmd_bind_resources(buf, bind_operations, nbind_operations);
+  if (nbind_operations <= 0u) { return; }
+  ngfvk_cmd_add_deferred_binds(buf, bind_operations, nbind_operations);
+  ngfvk_cmd_buf_track_bound_compute_res(buf, bind_operations, nbind_operations);
 }
 
 extern "C" void
 ngf_cmd_bind_compute_pipeline(ngf_compute_encoder enc, ngf_compute_pipeline pipeline) NGF_NOEXCEPT {
-  ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
-  if (buf->active_compute_pipe && buf->npending_bind_ops > 0u) { ngfvk_execute_pending_binds(buf); }
-
+  ngf_cmd_buffer         buf = NGFVK_ENC2CMDBUF(enc);
+  const ngfvk_render_cmd cmd = {
+      .data = {.bind_compute_pipeline =
+                   {.pipeline = pipeline, .prev_pipeline = buf->active_compute_pipe}},
+      .type = NGFVK_RENDER_CMD_BIND_COMPUTE_PIPELINE};
+  ngfvk_cmd_buf_add_ordered_cmd(buf, &cmd);
   buf->active_compute_pipe = pipeline;
-  vkCmdBindPipeline(
-      buf->vk_cmd_buffer,
-      VK_PIPELINE_BIND_POINT_COMPUTE,
-      ((ngfvk_generic_pipeline*)pipeline)->vk_pipeline);
 }
 
 extern "C" void ngf_cmd_viewport(ngf_render_encoder enc, const ngf_irect2d* r) NGF_NOEXCEPT {
@@ -5991,15 +10273,15 @@ extern "C" void ngf_cmd_copy_buffer(
       .layout = VK_IMAGE_LAYOUT_UNDEFINED};
   const ngfvk_sync_res dst_sync_res = ngfvk_sync_res_from_buf(dst);
   ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, buf, &dst_sync_res, &dst_sync_req);
-  ngfvk_sync_req_batch_commit(&sync_req_batch, buf);
 
-  const VkBufferCopy copy_region = {.srcOffset = src_offset, .dstOffset = dst_offset, .size = size};
-  vkCmdCopyBuffer(
-      buf->vk_cmd_buffer,
-      (VkBuffer)src->alloc.obj_handle,
-      (VkBuffer)dst->alloc.obj_handle,
-      1u,
-      &copy_region);
+  const ngfvk_render_cmd cmd = {
+      .data =
+          {.copy_buffer =
+               {.src    = src,
+                .dst    = dst,
+                .region = {.srcOffset = src_offset, .dstOffset = dst_offset, .size = size}}},
+      .type = NGFVK_RENDER_CMD_COPY_BUFFER};
+  ngfvk_cmd_buf_add_deferred_cmd(buf, &sync_req_batch, &cmd);
 }
 
 extern "C" void ngf_cmd_write_image(
@@ -6014,7 +10296,7 @@ extern "C" void ngf_cmd_write_image(
   if (nwrites == 0u) return;
   ngfvk_sync_req_batch sync_req_batch;
   ngfi::tmp_arena().reset();
-  ngfvk_sync_req_batch_init(2, &sync_req_batch);
+  ngfvk_sync_req_batch_init(1u + nwrites, &sync_req_batch);
   const ngfvk_sync_req src_sync_req = {
       .barrier_masks =
           {.access_mask = VK_ACCESS_TRANSFER_READ_BIT,
@@ -6027,12 +10309,14 @@ extern "C" void ngf_cmd_write_image(
           {.access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
            .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
       .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
-  const ngfvk_sync_res dst_sync_res = ngfvk_sync_res_from_img(dst);
-  ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &dst_sync_res, &dst_sync_req);
-  ngfvk_sync_req_batch_commit(&sync_req_batch, cmd_buf);
+  for (uint32_t i = 0u; i < nwrites; ++i) {
+    const ngfvk_sync_res dst_sync_res = ngfvk_sync_res_from_img_range(
+        dst,
+        {writes[i].dst_level, 1u, writes[i].dst_base_layer, writes[i].nlayers});
+    ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, cmd_buf, &dst_sync_res, &dst_sync_req);
+  }
 
-  ngfi::tmp_arena().reset();
-  auto vk_writes = ngfi::tmp_alloc<VkBufferImageCopy>(nwrites);
+  auto vk_writes = ngfi::frame_alloc<VkBufferImageCopy>(nwrites);
   if (vk_writes) {
     for (size_t i = 0u; i < nwrites; ++i) {
       const ngf_image_write* ngf_write = &writes[i];
@@ -6050,13 +10334,12 @@ extern "C" void ngf_cmd_write_image(
       vk_write->imageSubresource.baseArrayLayer = ngf_write->dst_base_layer;
       vk_write->imageSubresource.layerCount     = ngf_write->nlayers;
     }
-    vkCmdCopyBufferToImage(
-        cmd_buf->vk_cmd_buffer,
-        (VkBuffer)src->alloc.obj_handle,
-        (VkImage)dst->alloc.obj_handle,
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        nwrites,
-        vk_writes);
+    const ngfvk_render_cmd cmd = {
+        .data =
+            {.buffer_image_copy =
+                 {.buffer = src, .image = dst, .regions = vk_writes, .nregions = nwrites}},
+        .type = NGFVK_RENDER_CMD_COPY_BUFFER_TO_IMAGE};
+    ngfvk_cmd_buf_add_deferred_cmd(cmd_buf, &sync_req_batch, &cmd);
   } else {
     NGFI_DIAG_ERROR("Image write failed");
   }
@@ -6072,6 +10355,8 @@ extern "C" void ngf_cmd_copy_image_to_buffer(
     size_t              dst_offset) NGF_NOEXCEPT {
   ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(enc);
   assert(buf);
+  const uint32_t src_layer =
+      src.image->type == NGF_IMAGE_TYPE_CUBE ? 6u * src.layer + src.cubemap_face : src.layer;
   ngfvk_sync_req_batch sync_req_batch;
   ngfi::tmp_arena().reset();
   ngfvk_sync_req_batch_init(2, &sync_req_batch);
@@ -6080,7 +10365,8 @@ extern "C" void ngf_cmd_copy_image_to_buffer(
           {.access_mask = VK_ACCESS_TRANSFER_READ_BIT,
            .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
       .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
-  const ngfvk_sync_res src_sync_res = ngfvk_sync_res_from_img(src.image);
+  const ngfvk_sync_res src_sync_res =
+      ngfvk_sync_res_from_img_range(src.image, {src.mip_level, 1u, src_layer, nlayers});
   ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, buf, &src_sync_res, &src_sync_req);
   const ngfvk_sync_req dst_sync_req = {
       .barrier_masks =
@@ -6089,11 +10375,13 @@ extern "C" void ngf_cmd_copy_image_to_buffer(
       .layout = VK_IMAGE_LAYOUT_UNDEFINED};
   const ngfvk_sync_res dst_sync_res = ngfvk_sync_res_from_buf(dst);
   ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, buf, &dst_sync_res, &dst_sync_req);
-  ngfvk_sync_req_batch_commit(&sync_req_batch, buf);
 
-  const uint32_t src_layer =
-      src.image->type == NGF_IMAGE_TYPE_CUBE ? 6u * src.layer + src.cubemap_face : src.layer;
-  const VkBufferImageCopy copy_op = {
+  auto copy_op = ngfi::frame_alloc<VkBufferImageCopy>();
+  if (copy_op == NULL) {
+    NGFI_DIAG_ERROR("Image copy failed");
+    return;
+  }
+  *copy_op = {
       .bufferOffset      = dst_offset,
       .bufferRowLength   = 0u,
       .bufferImageHeight = 0u,
@@ -6105,14 +10393,12 @@ extern "C" void ngf_cmd_copy_image_to_buffer(
       .imageOffset = {.x = src_offset.x, .y = src_offset.y, .z = src_offset.z},
       .imageExtent =
           {.width = src_extent.width, .height = src_extent.height, .depth = src_extent.depth}};
-
-  vkCmdCopyImageToBuffer(
-      buf->vk_cmd_buffer,
-      (VkImage)src.image->alloc.obj_handle,
-      VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-      (VkBuffer)dst->alloc.obj_handle,
-      1u,
-      &copy_op);
+  const ngfvk_render_cmd cmd = {
+      .data =
+          {.buffer_image_copy =
+               {.buffer = dst, .image = src.image, .regions = copy_op, .nregions = 1u}},
+      .type = NGFVK_RENDER_CMD_COPY_IMAGE_TO_BUFFER};
+  ngfvk_cmd_buf_add_deferred_cmd(buf, &sync_req_batch, &cmd);
 }
 
 extern "C" ngf_error ngf_cmd_generate_mipmaps(ngf_xfer_encoder xfenc, ngf_image img) NGF_NOEXCEPT {
@@ -6124,101 +10410,454 @@ extern "C" ngf_error ngf_cmd_generate_mipmaps(ngf_xfer_encoder xfenc, ngf_image
 
   ngf_cmd_buffer buf = NGFVK_ENC2CMDBUF(xfenc);
   assert(buf);
+  if (buf->queue != NGF_QUEUE_TYPE_GRAPHICS) {
+    NGFI_DIAG_ERROR("mipmap generation is only supported by graphics queue command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
 
   // TODO: ensure the pixel format is valid for mip generation.
-  // TODO: hazard-track images on mip + level granularity.
 
-  ngfvk_sync_req sync_req = {
+  if (img->nlevels < 2u) return NGF_ERROR_OK;
+
+  // The blits depend on each other, so they're recorded right away, after any deferred commands.
+  ngfvk_cmd_buf_flush_deferred_cmds(buf);
+
+  // Level 0 is only read from, and the rest of the levels are written to first.
+  const uint32_t       nlayers       = img->nlayers;
+  const ngfvk_sync_req read_sync_req = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_TRANSFER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
+      .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+  const ngfvk_sync_req write_sync_req = {
       .barrier_masks =
           {.access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
            .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
       .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
-  ngfvk_sync_res img_res = ngfvk_sync_res_from_img(img);
-  ngfvk_handle_single_sync_req(buf, &img_res, &sync_req);
-
-  uint32_t src_w = img->extent.width, src_h = img->extent.height, src_d = img->extent.depth,
-           dst_w = 0, dst_h = 0, dst_d = 0;
-  const uint32_t nlayers = img->nlayers;
-
-  for (uint32_t src_level = 0u; src_level < img->nlevels; ++src_level) {
-    const uint32_t dst_level                    = src_level + 1u;
-    dst_w                                       = src_w > 1u ? (src_w >> 1u) : 1u;
-    dst_h                                       = src_h > 1u ? (src_h >> 1u) : 1u;
-    dst_d                                       = src_d > 1u ? (src_d >> 1u) : 1u;
-    const VkImageMemoryBarrier pre_blit_barrier = {
-        .sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
-        .pNext               = NULL,
-        .srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT,
-        .dstAccessMask       = VK_ACCESS_TRANSFER_READ_BIT,
-        .oldLayout           = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        .newLayout           = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-        .image               = (VkImage)img->alloc.obj_handle,
-        .subresourceRange    = {
-               .aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-               .baseMipLevel   = src_level,
-               .levelCount     = 1u,
-               .baseArrayLayer = 0u,
-               .layerCount     = nlayers}};
-    vkCmdPipelineBarrier(
+  ngfvk_sync_req_batch sync_req_batch;
+  ngfi::tmp_arena().reset();
+  ngfvk_sync_req_batch_init(2, &sync_req_batch);
+  const ngfvk_sync_res base_level_res = ngfvk_sync_res_from_img_range(img, {0u, 1u, 0u, nlayers});
+  const ngfvk_sync_res other_levels_res =
+      ngfvk_sync_res_from_img_range(img, {1u, img->nlevels - 1u, 0u, nlayers});
+  ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, buf, &base_level_res, &read_sync_req);
+  ngfvk_sync_req_batch_add_with_lookup(&sync_req_batch, buf, &other_levels_res, &write_sync_req);
+  ngfvk_sync_req_batch_commit(&sync_req_batch, buf);
+
+  uint32_t src_w = img->extent.width, src_h = img->extent.height, src_d = img->extent.depth;
+  for (uint32_t dst_level = 1u; dst_level < img->nlevels; ++dst_level) {
+    const uint32_t    src_level   = dst_level - 1u;
+    const uint32_t    dst_w       = src_w > 1u ? (src_w >> 1u) : 1u;
+    const uint32_t    dst_h       = src_h > 1u ? (src_h >> 1u) : 1u;
+    const uint32_t    dst_d       = src_d > 1u ? (src_d >> 1u) : 1u;
+    const VkImageBlit blit_region = {
+        .srcSubresource =
+            {.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+             .mipLevel       = src_level,
+             .baseArrayLayer = 0u,
+             .layerCount     = nlayers},
+        .srcOffsets = {{0, 0, 0}, {(int32_t)src_w, (int32_t)src_h, (int32_t)src_d}},
+        .dstSubresource =
+            {.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
+             .mipLevel       = dst_level,
+             .baseArrayLayer = 0u,
+             .layerCount     = nlayers},
+        .dstOffsets = {{0, 0, 0}, {(int32_t)dst_w, (int32_t)dst_h, (int32_t)dst_d}}};
+    vkCmdBlitImage(
         buf->vk_cmd_buffer,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        VK_PIPELINE_STAGE_TRANSFER_BIT,
-        0u,
-        0u,
-        NULL,
-        0u,
-        NULL,
-        1u,
-        &pre_blit_barrier);
-    if (src_level < img->nlevels - 1) {
-      const VkImageBlit blit_region = {
-          .srcSubresource =
-              {.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-               .mipLevel       = src_level,
-               .baseArrayLayer = 0u,
-               .layerCount     = nlayers},
-          .srcOffsets = {{0, 0, 0}, {(int32_t)src_w, (int32_t)src_h, (int32_t)src_d}},
-          .dstSubresource =
-              {.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT,
-               .mipLevel       = dst_level,
-               .baseArrayLayer = 0u,
-               .layerCount     = nlayers},
-          .dstOffsets = {{0, 0, 0}, {(int32_t)dst_w, (int32_t)dst_h, (int32_t)dst_d}}};
-      vkCmdBlitImage(
-          buf->vk_cmd_buffer,
-          (VkImage)img->alloc.obj_handle,
-          VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-          (VkImage)img->alloc.obj_handle,
-          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-          1,
-          &blit_region,
-          VK_FILTER_LINEAR);
-      src_w = dst_w;
-      src_h = dst_h;
-      src_d = dst_d;
-    }
-  }
-  ngfvk_sync_res       r             = ngfvk_sync_res_from_img(img);
-  ngfvk_sync_res_data* sync_res_data = NULL;
-  ngfvk_cmd_buf_lookup_sync_res(buf, &r, &sync_res_data);
-  sync_res_data->sync_state.active_readers_masks.stage_mask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
-  sync_res_data->sync_state.active_readers_masks.access_mask |= VK_ACCESS_TRANSFER_READ_BIT;
-  sync_res_data->sync_state.layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        (VkImage)img->alloc.obj_handle,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+        (VkImage)img->alloc.obj_handle,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        1,
+        &blit_region,
+        VK_FILTER_LINEAR);
+    src_w = dst_w;
+    src_h = dst_h;
+    src_d = dst_d;
+
+    // The level that was just written to becomes the source for the next one.
+    if (dst_level + 1u < img->nlevels) {
+      const ngfvk_sync_res dst_level_res =
+          ngfvk_sync_res_from_img_range(img, {dst_level, 1u, 0u, nlayers});
+      ngfvk_handle_single_sync_req(buf, &dst_level_res, &read_sync_req);
+    }
+  }
 
   return NGF_ERROR_OK;
 }
 
 extern "C" void
 ngf_cmd_begin_debug_group(ngf_cmd_buffer cmd_buffer, const char* name) NGF_NOEXCEPT {
+  if (ngfvk_cmd_buf_defers_cmds(cmd_buffer)) { ngfvk_cmd_buf_flush_deferred_cmds(cmd_buffer); }
   ngfvk_debug_label_begin(cmd_buffer->vk_cmd_buffer, name);
 }
 
 extern "C" void ngf_cmd_end_current_debug_group(ngf_cmd_buffer cmd_buffer) NGF_NOEXCEPT {
+  if (ngfvk_cmd_buf_defers_cmds(cmd_buffer)) { ngfvk_cmd_buf_flush_deferred_cmds(cmd_buffer); }
   ngfvk_debug_label_end(cmd_buffer->vk_cmd_buffer);
 }
 
+static uint64_t ngfvk_timestamp_ticks_to_ns(uint64_t ticks, float period) {
+  return (uint64_t)((double)ticks * (double)period);
+}
+
+// Unpacks the values written for a pipeline statistics query (in the order of the bits of
+// ngfvk::global::pipeline_statistics_flags) into the given result.
+static void ngfvk_unpack_pipeline_statistics(const uint64_t* values, ngf_query_result* result) {
+  result->input_assembly_vertices     = values[0];
+  result->input_assembly_primitives   = values[1];
+  result->vertex_shader_invocations   = values[2];
+  result->clipping_primitives         = values[3];
+  result->fragment_shader_invocations = values[4];
+  result->compute_shader_invocations  = values[5];
+}
+
+// Hands out the next query of the given type in the current frame, creating the frame's pool of
+// queries of that type if necessary.
+static ngf_error
+ngfvk_alloc_query(ngfvk_query_pool_type type, VkQueryPool* vk_pool, uint32_t* query) {
+  static const VkQueryType vk_query_types[NGFVK_QUERY_POOL_COUNT] = {
+      VK_QUERY_TYPE_OCCLUSION,
+      VK_QUERY_TYPE_PIPELINE_STATISTICS,
+      VK_QUERY_TYPE_TIMESTAMP};
+  ngfvk_frame_resources*  frame_res = &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id];
+  ngfvk_frame_query_pool* pool      = &frame_res->query_pools[type];
+  const uint32_t          capacity  = CURRENT_CONTEXT->query_pool_capacities[type];
+  if (pool->vk_pool == VK_NULL_HANDLE) {
+    const VkQueryPoolCreateInfo pool_info = {
+        .sType              = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .pNext              = NULL,
+        .flags              = 0u,
+        .queryType          = vk_query_types[type],
+        .queryCount         = capacity,
+        .pipelineStatistics = type == NGFVK_QUERY_POOL_PIPELINE_STATISTICS
+                                  ? ngfvk::global::pipeline_statistics_flags
+                                  : 0u};
+    const VkResult vk_err = vkCreateQueryPool(_vk.device, &pool_info, NULL, &pool->vk_pool);
+    if (vk_err != VK_SUCCESS) {
+      pool->vk_pool = VK_NULL_HANDLE;
+      return NGF_ERROR_OBJECT_CREATION_FAILED;
+    }
+  }
+  if (pool->nqueries >= capacity) {
+    NGFI_DIAG_ERROR("out of queries of type %d for the current frame", type);
+    return NGF_ERROR_OUT_OF_BOUNDS;
+  }
+  *vk_pool = pool->vk_pool;
+  *query   = pool->nqueries++;
+  return NGF_ERROR_OK;
+}
+
+// Looks up the pool holding the results of the given query made during the frame identified by the
+// token. Returns NGF_ERROR_TIMEOUT if the frame hasn't finished executing yet.
+static ngf_error ngfvk_query_results_pool(
+    ngf_frame_token       token,
+    ngfvk_query_pool_type type,
+    uint32_t              query,
+    VkQueryPool*          vk_pool) {
+  ngf_context ctx = CURRENT_CONTEXT;
+  if (ngfi_frame_ctx_id(token) != (uint16_t)((uintptr_t)ctx & 0xffff)) {
+    NGFI_DIAG_ERROR("frame token was generated by a different context");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+
+  // Results are kept until the frame's resources get reused by a later frame.
+  const uint64_t serial = ngfvk_frame_token_serial(ctx, token);
+  if (serial + ctx->max_inflight_frames <= ctx->frame_serial) {
+    NGFI_DIAG_ERROR("query results of the frame are no longer available");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (!ngf_is_frame_complete(token)) { return NGF_ERROR_TIMEOUT; }
+  const ngfvk_frame_query_pool* pool =
+      &ctx->frame_res[serial % ctx->max_inflight_frames].query_pools[type];
+  if (query >= pool->nqueries_reset) {
+    NGFI_DIAG_ERROR("query %d of type %d has not been submitted", query, type);
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  *vk_pool = pool->vk_pool;
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error
+ngf_cmd_write_timestamp(ngf_cmd_buffer cmd_buf, ngf_timestamp_query* query) NGF_NOEXCEPT {
+  assert(cmd_buf);
+  assert(query);
+  assert(CURRENT_CONTEXT);
+  if (cmd_buf->secondary) {
+    NGFI_DIAG_ERROR("timestamps can't be written into secondary command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if ((_vk.timestamp_queues_mask & (1u << ngfvk_effective_queue(cmd_buf->queue))) == 0u) {
+    NGFI_DIAG_ERROR("timestamps are not supported on the command buffer's queue");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (cmd_buf->renderpass_active && cmd_buf->executes_secondaries) {
+    NGFI_DIAG_ERROR("timestamps can't be written into a render pass that executes secondary "
+                    "command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+
+  VkQueryPool     vk_pool = VK_NULL_HANDLE;
+  const ngf_error err     = ngfvk_alloc_query(NGFVK_QUERY_POOL_TIMESTAMP, &vk_pool, query);
+  if (err != NGF_ERROR_OK) { return err; }
+  const ngfvk_render_cmd cmd = {
+      .data = {.query = {.pool = vk_pool, .query = *query, .flags = 0u}},
+      .type = NGFVK_RENDER_CMD_WRITE_TIMESTAMP};
+  // Within passes that defer their commands, the timestamp has to be written in order with them.
+  ngfvk_cmd_buf_add_ordered_cmd(cmd_buf, &cmd);
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_get_timestamp(
+    ngf_frame_token     token,
+    ngf_timestamp_query query,
+    uint64_t*           timestamp_ns) NGF_NOEXCEPT {
+  assert(timestamp_ns);
+  assert(CURRENT_CONTEXT);
+  VkQueryPool     vk_pool = VK_NULL_HANDLE;
+  const ngf_error err =
+      ngfvk_query_results_pool(token, NGFVK_QUERY_POOL_TIMESTAMP, query, &vk_pool);
+  if (err != NGF_ERROR_OK) { return err; }
+
+  uint64_t       ticks  = 0u;
+  const VkResult vk_err = vkGetQueryPoolResults(
+      _vk.device,
+      vk_pool,
+      query,
+      1u,
+      sizeof(ticks),
+      &ticks,
+      sizeof(ticks),
+      VK_QUERY_RESULT_64_BIT);
+  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OPERATION_FAILED; }
+  *timestamp_ns = ngfvk_timestamp_ticks_to_ns(ticks, _vk.timestamp_period);
+  return NGF_ERROR_OK;
+}
+
+// Begins a query of the given type on the command buffer, validating that no other query of the
+// same type is active on it.
+static ngf_error
+ngfvk_cmd_begin_query(ngf_cmd_buffer cmd_buf, ngf_query_type type, ngf_query* query) {
+  assert(cmd_buf);
+  assert(query);
+  assert(CURRENT_CONTEXT);
+  if (type >= NGF_QUERY_TYPE_COUNT) {
+    NGFI_DIAG_ERROR("invalid query type %d", type);
+    return NGF_ERROR_INVALID_ENUM;
+  }
+  if (cmd_buf->secondary) {
+    NGFI_DIAG_ERROR("queries can't be made in secondary command buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (cmd_buf->active_queries_mask & (1u << type)) {
+    NGFI_DIAG_ERROR("a query of type %d is already active on the command buffer", type);
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (type == NGF_QUERY_TYPE_PIPELINE_STATISTICS &&
+      (!ngfvk::global::phys_device_caps.supports_pipeline_statistics_queries ||
+       ngfvk_effective_queue(cmd_buf->queue) != NGF_QUEUE_TYPE_GRAPHICS)) {
+    NGFI_DIAG_ERROR("pipeline statistics queries are not supported on the command buffer's queue");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  if (cmd_buf->renderpass_active && cmd_buf->executes_secondaries) {
+    NGFI_DIAG_ERROR("queries can't be made in a render pass that executes secondary command "
+                    "buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+
+  VkQueryPool     vk_pool = VK_NULL_HANDLE;
+  uint32_t        index   = 0u;
+  const ngf_error err     = ngfvk_alloc_query((ngfvk_query_pool_type)type, &vk_pool, &index);
+  if (err != NGF_ERROR_OK) { return err; }
+  const VkQueryControlFlags flags =
+      type == NGF_QUERY_TYPE_OCCLUSION && _vk.precise_occlusion_queries
+          ? VK_QUERY_CONTROL_PRECISE_BIT
+          : 0u;
+  const ngfvk_render_cmd cmd = {
+      .data = {.query = {.pool = vk_pool, .query = index, .flags = flags}},
+      .type = NGFVK_RENDER_CMD_BEGIN_QUERY};
+  ngfvk_cmd_buf_add_ordered_cmd(cmd_buf, &cmd);
+  cmd_buf->active_queries_mask |= (1u << type);
+  if (cmd_buf->renderpass_active || cmd_buf->compute_pass_active) {
+    cmd_buf->pass_queries_mask |= (1u << type);
+  }
+  query->type  = type;
+  query->index = index;
+  return NGF_ERROR_OK;
+}
+
+static ngf_error ngfvk_cmd_end_query(ngf_cmd_buffer cmd_buf, ngf_query query) {
+  assert(cmd_buf);
+  assert(CURRENT_CONTEXT);
+  if (query.type >= NGF_QUERY_TYPE_COUNT ||
+      (cmd_buf->active_queries_mask & (1u << query.type)) == 0u) {
+    NGFI_DIAG_ERROR("no query of type %d is active on the command buffer", query.type);
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const ngfvk_frame_resources* frame_res =
+      &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id];
+  const ngfvk_render_cmd cmd = {
+      .data =
+          {.query =
+               {.pool  = frame_res->query_pools[query.type].vk_pool,
+                .query = query.index,
+                .flags = 0u}},
+      .type = NGFVK_RENDER_CMD_END_QUERY};
+  ngfvk_cmd_buf_add_ordered_cmd(cmd_buf, &cmd);
+  cmd_buf->active_queries_mask &= ~(1u << query.type);
+  cmd_buf->pass_queries_mask &= ~(1u << query.type);
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error
+ngf_cmd_begin_query(ngf_render_encoder enc, ngf_query_type type, ngf_query* query) NGF_NOEXCEPT {
+  return ngfvk_cmd_begin_query(NGFVK_ENC2CMDBUF(enc), type, query);
+}
+
+extern "C" ngf_error ngf_cmd_end_query(ngf_render_encoder enc, ngf_query query) NGF_NOEXCEPT {
+  return ngfvk_cmd_end_query(NGFVK_ENC2CMDBUF(enc), query);
+}
+
+extern "C" ngf_error
+ngf_cmd_begin_compute_query(ngf_compute_encoder enc, ngf_query* query) NGF_NOEXCEPT {
+  return ngfvk_cmd_begin_query(NGFVK_ENC2CMDBUF(enc), NGF_QUERY_TYPE_PIPELINE_STATISTICS, query);
+}
+
+extern "C" ngf_error ngf_cmd_end_compute_query(ngf_compute_encoder enc, ngf_query query)
+    NGF_NOEXCEPT {
+  return ngfvk_cmd_end_query(NGFVK_ENC2CMDBUF(enc), query);
+}
+
+extern "C" ngf_error
+ngf_get_query_result(ngf_frame_token token, ngf_query query, ngf_query_result* result)
+    NGF_NOEXCEPT {
+  assert(result);
+  assert(CURRENT_CONTEXT);
+  if (query.type >= NGF_QUERY_TYPE_COUNT) {
+    NGFI_DIAG_ERROR("invalid query type %d", query.type);
+    return NGF_ERROR_INVALID_ENUM;
+  }
+  VkQueryPool     vk_pool = VK_NULL_HANDLE;
+  const ngf_error err =
+      ngfvk_query_results_pool(token, (ngfvk_query_pool_type)query.type, query.index, &vk_pool);
+  if (err != NGF_ERROR_OK) { return err; }
+
+  uint64_t       values[ngfvk::global::npipeline_statistics] = {0u};
+  const uint32_t nvalues =
+      query.type == NGF_QUERY_TYPE_PIPELINE_STATISTICS ? ngfvk::global::npipeline_statistics : 1u;
+  const VkResult vk_err = vkGetQueryPoolResults(
+      _vk.device,
+      vk_pool,
+      query.index,
+      1u,
+      sizeof(uint64_t) * nvalues,
+      values,
+      sizeof(uint64_t) * nvalues,
+      VK_QUERY_RESULT_64_BIT);
+  if (vk_err != VK_SUCCESS) { return NGF_ERROR_OPERATION_FAILED; }
+  memset(result, 0, sizeof(*result));
+  if (query.type == NGF_QUERY_TYPE_OCCLUSION) {
+    result->samples_passed = values[0];
+  } else {
+    ngfvk_unpack_pipeline_statistics(values, result);
+  }
+  return NGF_ERROR_OK;
+}
+
+// Writes a descriptor into a free slot of the bindless resource heap.
+static ngf_error ngfvk_register_bindless(
+    ngf_bindless_resource_type    type,
+    const VkDescriptorImageInfo*  image_info,
+    const VkDescriptorBufferInfo* buffer_info,
+    uint32_t*                     index) {
+  assert(index);
+  ngfvk_bindless_heap* heap = &_vk.bindless_heap;
+  if (heap->vk_set == VK_NULL_HANDLE) {
+    NGFI_DIAG_ERROR("bindless resources are not supported by the device");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  pthread_mutex_lock(&heap->mu);
+  const uint32_t idx = ngfvk_bindless_slots_alloc(&heap->slots[type]);
+  if (idx == ~0u) {
+    pthread_mutex_unlock(&heap->mu);
+    NGFI_DIAG_ERROR("bindless resource heap has no free slots for resources of type %d", type);
+    return NGF_ERROR_OUT_OF_MEM;
+  }
+  // The slot isn't accessed by any pending work, so it may be written even while the heap is in
+  // use.
+  const VkWriteDescriptorSet vk_write = {
+      .sType            = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+      .pNext            = NULL,
+      .dstSet           = heap->vk_set,
+      .dstBinding       = (uint32_t)type,
+      .dstArrayElement  = idx,
+      .descriptorCount  = 1u,
+      .descriptorType   = ngfvk_bindless_desc_type(type),
+      .pImageInfo       = image_info,
+      .pBufferInfo      = buffer_info,
+      .pTexelBufferView = NULL};
+  vkUpdateDescriptorSets(_vk.device, 1u, &vk_write, 0u, NULL);
+  pthread_mutex_unlock(&heap->mu);
+  *index = idx;
+  return NGF_ERROR_OK;
+}
+
+extern "C" ngf_error ngf_register_bindless_image(ngf_image image, uint32_t* index) NGF_NOEXCEPT {
+  assert(image);
+  if (!(image->usage_flags & NGF_IMAGE_USAGE_SAMPLE_FROM)) {
+    NGFI_DIAG_ERROR("images in the bindless resource heap must be created for sampling");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const VkDescriptorImageInfo image_info = {
+      .sampler     = VK_NULL_HANDLE,
+      .imageView   = image->vkview,
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  return ngfvk_register_bindless(NGF_BINDLESS_RESOURCE_IMAGE, &image_info, NULL, index);
+}
+
+extern "C" ngf_error
+ngf_register_bindless_sampler(ngf_sampler sampler, uint32_t* index) NGF_NOEXCEPT {
+  assert(sampler);
+  const VkDescriptorImageInfo image_info = {
+      .sampler     = sampler->vksampler,
+      .imageView   = VK_NULL_HANDLE,
+      .imageLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+  return ngfvk_register_bindless(NGF_BINDLESS_RESOURCE_SAMPLER, &image_info, NULL, index);
+}
+
+extern "C" ngf_error
+ngf_register_bindless_buffer(const ngf_buffer_slice* slice, uint32_t* index) NGF_NOEXCEPT {
+  assert(slice);
+  assert(slice->buffer);
+  if (!(slice->buffer->usage_flags & NGF_BUFFER_USAGE_STORAGE_BUFFER)) {
+    NGFI_DIAG_ERROR("buffers in the bindless resource heap must be created as storage buffers");
+    return NGF_ERROR_INVALID_OPERATION;
+  }
+  const VkDescriptorBufferInfo buffer_info = {
+      .buffer = (VkBuffer)slice->buffer->alloc.obj_handle,
+      .offset = slice->offset,
+      .range  = slice->range};
+  return ngfvk_register_bindless(NGF_BINDLESS_RESOURCE_STORAGE_BUFFER, NULL, &buffer_info, index);
+}
+
+extern "C" void
+ngf_release_bindless_index(ngf_bindless_resource_type type, uint32_t index) NGF_NOEXCEPT {
+  assert(CURRENT_CONTEXT);
+  ngfvk_bindless_heap* heap = &_vk.bindless_heap;
+  pthread_mutex_lock(&heap->mu);
+  const bool valid =
+      type < NGF_BINDLESS_RESOURCE_TYPE_COUNT && index < heap->slots[type].nallocated;
+  pthread_mutex_unlock(&heap->mu);
+  if (!valid) {
+    NGFI_DIAG_ERROR("attempt to release an invalid bindless resource heap index %d", index);
+    return;
+  }
+  // Frames in flight may still access the slot, so it's only reused once the current one is done.
+  ngfvk_bindless_slot slot = {.type = (uint32_t)type, .index = index};
+  CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id].retire.append(slot);
+}
+
 extern "C" ngf_error ngf_create_texel_buffer_view(
     const ngf_texel_buffer_view_info* info,
     ngf_texel_buffer_view*            result) NGF_NOEXCEPT {
@@ -6265,6 +10904,89 @@ extern "C" void ngf_buffer_flush_range(ngf_buffer buf, size_t offset, size_t siz
 extern "C" void ngf_buffer_unmap(ngf_buffer) NGF_NOEXCEPT {  // vk buffers are persistently mapped.
 }
 
+// Creates a host-writeable buffer for staging uploads. Such buffers are only ever read by the
+// device, so they are exempt from hazard tracking.
+static ngf_error ngfvk_create_upload_buffer(size_t size, ngf_buffer* result) {
+  const ngf_buffer_info info = {
+      .size         = size,
+      .storage_type = NGF_BUFFER_STORAGE_HOST_WRITEABLE,
+      .buffer_usage = NGF_BUFFER_USAGE_XFER_SRC | NGF_BUFFER_USAGE_UNIFORM_BUFFER};
+  auto maybe_buf = ngf_buffer_t::make(info);
+  if (maybe_buf.has_error()) { return maybe_buf.error(); }
+  *result                                   = maybe_buf.value().release();
+  (*result)->mapped_offset                  = 0u;
+  (*result)->sync_state.skip_hazard_tracking = true;
+  return NGF_ERROR_OK;
+}
+
+// Carves a region of the given size and alignment out of the unused part of a staging buffer,
+// starting at `*used`. Returns false if there isn't enough space left.
+static bool ngfvk_upload_suballoc(
+    size_t* used,
+    size_t  capacity,
+    size_t  size,
+    size_t  alignment,
+    size_t* offset) {
+  const size_t aligned_offset = (*used + alignment - 1u) & ~(alignment - 1u);
+  if (aligned_offset < *used || aligned_offset > capacity || size > capacity - aligned_offset) {
+    return false;
+  }
+  *offset = aligned_offset;
+  *used   = aligned_offset + size;
+  return true;
+}
+
+extern "C" ngf_error
+ngf_upload_alloc(size_t size, size_t alignment, ngf_upload_region* region) NGF_NOEXCEPT {
+  assert(region);
+  assert(CURRENT_CONTEXT);
+  if (size == 0u) {
+    NGFI_DIAG_ERROR("upload regions must not be empty");
+    return NGF_ERROR_INVALID_SIZE;
+  }
+  if ((alignment & (alignment - 1u)) != 0u) {
+    NGFI_DIAG_ERROR("upload region alignment must be a power of two");
+    return NGF_ERROR_INVALID_SIZE;
+  }
+  alignment = NGFI_MAX(alignment, ngfvk::global::min_upload_alignment);
+
+  ngfvk_frame_resources* frame_res = &CURRENT_CONTEXT->frame_res[CURRENT_CONTEXT->frame_id];
+  if (frame_res->upload_buffer == nullptr && size <= CURRENT_CONTEXT->upload_buffer_size) {
+    const ngf_error err =
+        ngfvk_create_upload_buffer(CURRENT_CONTEXT->upload_buffer_size, &frame_res->upload_buffer);
+    if (err != NGF_ERROR_OK) { return err; }
+  }
+
+  if (frame_res->upload_buffer != nullptr &&
+      ngfvk_upload_suballoc(
+          &frame_res->upload_buffer_offset,
+          frame_res->upload_buffer->size,
+          size,
+          alignment,
+          &region->offset)) {
+    region->buffer = frame_res->upload_buffer;
+  } else {
+    // Doesn't fit, use a dedicated buffer that lives until the frame is retired.
+    const ngf_error err = ngfvk_create_upload_buffer(size, &region->buffer);
+    if (err != NGF_ERROR_OK) { return err; }
+    frame_res->retire.append(region->buffer);
+    region->offset = 0u;
+  }
+  region->size = size;
+  region->data = (uint8_t*)region->buffer->alloc.mapped_data + region->offset;
+  return NGF_ERROR_OK;
+}
+
+extern "C" void ngf_upload_end(const ngf_upload_region* region) NGF_NOEXCEPT {
+  assert(region);
+  vmaFlushAllocation(_vk.allocator, region->buffer->alloc.vma_alloc, region->offset, region->size);
+}
+
+extern "C" ngf_error ngf_uniform_alloc(size_t size, ngf_upload_region* region) NGF_NOEXCEPT {
+  const size_t alignment = ngfvk::global::phys_device_caps.uniform_buffer_offset_alignment;
+  return ngf_upload_alloc(size, alignment, region);
+}
+
 extern "C" ngf_error
 ngf_create_image_view(const ngf_image_view_info* info, ngf_image_view* result) NGF_NOEXCEPT {
   assert(info);
@@ -6365,6 +11087,17 @@ static ngf_error ngfvk_set_bytes_impl(
         NGF_MAX_ENCODER_INLINE_BYTES);
     return NGF_ERROR_INVALID_SIZE;
   }
+  // Within compute passes, the values have to be pushed in order with the deferred commands.
+  if (ngfvk_cmd_buf_defers_cmds(cmd_buf)) {
+    auto data_copy = ngfi::frame_alloc<uint8_t>(size_bytes);
+    if (data_copy == NULL) { return NGF_ERROR_OUT_OF_MEM; }
+    memcpy(data_copy, data, size_bytes);
+    const ngfvk_render_cmd cmd = {
+        .data = {.set_bytes = {.data = data_copy, .size = static_cast<uint32_t>(size_bytes)}},
+        .type = NGFVK_RENDER_CMD_SET_BYTES};
+    ngfvk_cmd_buf_add_ordered_cmd(cmd_buf, &cmd);
+    return NGF_ERROR_OK;
+  }
   vkCmdPushConstants(
       cmd_buf->vk_cmd_buffer,
       CURRENT_CONTEXT->vk_default_push_layout,
@@ -6432,6 +11165,8 @@ extern "C" uintptr_t ngf_get_vk_buffer_handle(ngf_buffer buffer) NGF_NOEXCEPT {
 }
 
 extern "C" uintptr_t ngf_get_vk_cmd_buffer_handle(ngf_cmd_buffer cmd_buffer) NGF_NOEXCEPT {
+  // Commands recorded through the handle have to come after the ones recorded so far.
+  if (ngfvk_cmd_buf_defers_cmds(cmd_buffer)) { ngfvk_cmd_buf_flush_deferred_cmds(cmd_buffer); }
   return (uintptr_t)(cmd_buffer->vk_cmd_buffer);
 }
 
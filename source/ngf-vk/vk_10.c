@@ -55,6 +55,7 @@ VK_HIDE_SYMBOL PFN_vkBindBufferMemory vkBindBufferMemory;
 VK_HIDE_SYMBOL PFN_vkBindImageMemory vkBindImageMemory;
 VK_HIDE_SYMBOL PFN_vkCmdBeginQuery vkCmdBeginQuery;
 VK_HIDE_SYMBOL PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass;
+VK_HIDE_SYMBOL PFN_vkCmdBeginRendering vkCmdBeginRendering;
 VK_HIDE_SYMBOL PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
 VK_HIDE_SYMBOL PFN_vkCmdBindIndexBuffer vkCmdBindIndexBuffer;
 VK_HIDE_SYMBOL PFN_vkCmdBindPipeline vkCmdBindPipeline;
@@ -74,14 +75,18 @@ VK_HIDE_SYMBOL PFN_vkCmdDraw vkCmdDraw;
 VK_HIDE_SYMBOL PFN_vkCmdDrawIndexed vkCmdDrawIndexed;
 VK_HIDE_SYMBOL PFN_vkCmdDrawIndexedIndirect vkCmdDrawIndexedIndirect;
 VK_HIDE_SYMBOL PFN_vkCmdDrawIndirect vkCmdDrawIndirect;
+VK_HIDE_SYMBOL PFN_vkCmdDrawMultiEXT vkCmdDrawMultiEXT;
+VK_HIDE_SYMBOL PFN_vkCmdDrawMultiIndexedEXT vkCmdDrawMultiIndexedEXT;
 VK_HIDE_SYMBOL PFN_vkCmdEndQuery vkCmdEndQuery;
 VK_HIDE_SYMBOL PFN_vkCmdEndRenderPass vkCmdEndRenderPass;
+VK_HIDE_SYMBOL PFN_vkCmdEndRendering vkCmdEndRendering;
 VK_HIDE_SYMBOL PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 VK_HIDE_SYMBOL PFN_vkCmdFillBuffer vkCmdFillBuffer;
 VK_HIDE_SYMBOL PFN_vkCmdNextSubpass vkCmdNextSubpass;
 VK_HIDE_SYMBOL PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
 VK_HIDE_SYMBOL PFN_vkCmdPipelineBarrier2 vkCmdPipelineBarrier2;
 VK_HIDE_SYMBOL PFN_vkCmdPushConstants vkCmdPushConstants;
+VK_HIDE_SYMBOL PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR;
 VK_HIDE_SYMBOL PFN_vkCmdResetEvent vkCmdResetEvent;
 VK_HIDE_SYMBOL PFN_vkCmdResetQueryPool vkCmdResetQueryPool;
 VK_HIDE_SYMBOL PFN_vkCmdResolveImage vkCmdResolveImage;
@@ -89,6 +94,7 @@ VK_HIDE_SYMBOL PFN_vkCmdSetBlendConstants vkCmdSetBlendConstants;
 VK_HIDE_SYMBOL PFN_vkCmdSetDepthBias vkCmdSetDepthBias;
 VK_HIDE_SYMBOL PFN_vkCmdSetDepthBounds vkCmdSetDepthBounds;
 VK_HIDE_SYMBOL PFN_vkCmdSetEvent vkCmdSetEvent;
+VK_HIDE_SYMBOL PFN_vkCmdSetEvent2 vkCmdSetEvent2;
 VK_HIDE_SYMBOL PFN_vkCmdSetLineWidth vkCmdSetLineWidth;
 VK_HIDE_SYMBOL PFN_vkCmdSetScissor vkCmdSetScissor;
 VK_HIDE_SYMBOL PFN_vkCmdSetStencilCompareMask vkCmdSetStencilCompareMask;
@@ -97,6 +103,7 @@ VK_HIDE_SYMBOL PFN_vkCmdSetStencilWriteMask vkCmdSetStencilWriteMask;
 VK_HIDE_SYMBOL PFN_vkCmdSetViewport vkCmdSetViewport;
 VK_HIDE_SYMBOL PFN_vkCmdUpdateBuffer vkCmdUpdateBuffer;
 VK_HIDE_SYMBOL PFN_vkCmdWaitEvents vkCmdWaitEvents;
+VK_HIDE_SYMBOL PFN_vkCmdWaitEvents2 vkCmdWaitEvents2;
 VK_HIDE_SYMBOL PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp;
 VK_HIDE_SYMBOL PFN_vkCreateBuffer vkCreateBuffer;
 VK_HIDE_SYMBOL PFN_vkCreateBufferView vkCreateBufferView;
@@ -168,13 +175,19 @@ VK_HIDE_SYMBOL PFN_vkResetFences vkResetFences;
 VK_HIDE_SYMBOL PFN_vkSetEvent vkSetEvent;
 VK_HIDE_SYMBOL PFN_vkUnmapMemory vkUnmapMemory;
 VK_HIDE_SYMBOL PFN_vkUpdateDescriptorSets vkUpdateDescriptorSets;
+VK_HIDE_SYMBOL PFN_vkCreateDescriptorUpdateTemplate vkCreateDescriptorUpdateTemplate;
+VK_HIDE_SYMBOL PFN_vkDestroyDescriptorUpdateTemplate vkDestroyDescriptorUpdateTemplate;
+VK_HIDE_SYMBOL PFN_vkUpdateDescriptorSetWithTemplate vkUpdateDescriptorSetWithTemplate;
 VK_HIDE_SYMBOL PFN_vkWaitForFences vkWaitForFences;
+VK_HIDE_SYMBOL PFN_vkWaitSemaphores vkWaitSemaphores;
+VK_HIDE_SYMBOL PFN_vkGetSemaphoreCounterValue vkGetSemaphoreCounterValue;
 VK_HIDE_SYMBOL PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
 VK_HIDE_SYMBOL PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
 VK_HIDE_SYMBOL PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
 VK_HIDE_SYMBOL PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
 VK_HIDE_SYMBOL PFN_vkQueuePresentKHR vkQueuePresentKHR;
 VK_HIDE_SYMBOL PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
+VK_HIDE_SYMBOL PFN_vkGetPhysicalDeviceProperties2KHR vkGetPhysicalDeviceProperties2KHR;
 VK_HIDE_SYMBOL PFN_vkDestroyDebugUtilsMessengerEXT    vkDestroyDebugUtilsMessengerEXT;
 
 
@@ -229,6 +242,7 @@ void vkl_init_instance(VkInstance inst) {
   vkGetPhysicalDeviceSurfaceFormatsKHR = (PFN_vkGetPhysicalDeviceSurfaceFormatsKHR)vkGetInstanceProcAddr(inst, "vkGetPhysicalDeviceSurfaceFormatsKHR");
   vkGetPhysicalDeviceSurfaceCapabilitiesKHR = (PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR)vkGetInstanceProcAddr(inst, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR");
   vkGetPhysicalDeviceFeatures2KHR = (PFN_vkGetPhysicalDeviceFeatures2KHR)vkGetInstanceProcAddr(inst, "vkGetPhysicalDeviceFeatures2KHR");
+  vkGetPhysicalDeviceProperties2KHR = (PFN_vkGetPhysicalDeviceProperties2KHR)vkGetInstanceProcAddr(inst, "vkGetPhysicalDeviceProperties2KHR");
   vkDestroyDebugUtilsMessengerEXT = (PFN_vkDestroyDebugUtilsMessengerEXT)vkGetInstanceProcAddr(
       inst,
       "vkDestroyDebugUtilsMessengerEXT");
@@ -238,7 +252,13 @@ void vkl_init_instance(VkInstance inst) {
       (PFN_vkCmdEndDebugUtilsLabelEXT)vkGetInstanceProcAddr(inst, "vkCmdEndDebugUtilsLabelEXT");
 }
 
-void vkl_init_device(VkDevice dev, bool sync2_supported) {
+void vkl_init_device(
+    VkDevice dev,
+    bool     sync2_supported,
+    bool     dynamic_rendering_supported,
+    bool     timeline_semaphores_supported,
+    bool     multi_draw_supported,
+    bool     push_descriptor_supported) {
   vkAllocateCommandBuffers =
       (PFN_vkAllocateCommandBuffers)vkGetDeviceProcAddr(dev, "vkAllocateCommandBuffers");
   vkAllocateDescriptorSets =
@@ -399,6 +419,15 @@ void vkl_init_device(VkDevice dev, bool sync2_supported) {
   vkUnmapMemory = (PFN_vkUnmapMemory)vkGetDeviceProcAddr(dev, "vkUnmapMemory");
   vkUpdateDescriptorSets =
       (PFN_vkUpdateDescriptorSets)vkGetDeviceProcAddr(dev, "vkUpdateDescriptorSets");
+  vkCreateDescriptorUpdateTemplate = (PFN_vkCreateDescriptorUpdateTemplate)vkGetDeviceProcAddr(
+      dev,
+      "vkCreateDescriptorUpdateTemplate");
+  vkDestroyDescriptorUpdateTemplate = (PFN_vkDestroyDescriptorUpdateTemplate)vkGetDeviceProcAddr(
+      dev,
+      "vkDestroyDescriptorUpdateTemplate");
+  vkUpdateDescriptorSetWithTemplate = (PFN_vkUpdateDescriptorSetWithTemplate)vkGetDeviceProcAddr(
+      dev,
+      "vkUpdateDescriptorSetWithTemplate");
   vkWaitForFences      = (PFN_vkWaitForFences)vkGetDeviceProcAddr(dev, "vkWaitForFences");
   vkCreateSwapchainKHR = (PFN_vkCreateSwapchainKHR)vkGetDeviceProcAddr(dev, "vkCreateSwapchainKHR");
   vkDestroySwapchainKHR =
@@ -410,5 +439,27 @@ void vkl_init_device(VkDevice dev, bool sync2_supported) {
   vkQueuePresentKHR = (PFN_vkQueuePresentKHR)vkGetDeviceProcAddr(dev, "vkQueuePresentKHR");
   if (sync2_supported) {
     vkCmdPipelineBarrier2 = (PFN_vkCmdPipelineBarrier2)vkGetDeviceProcAddr(dev, "vkCmdPipelineBarrier2KHR");
+    vkCmdSetEvent2 = (PFN_vkCmdSetEvent2)vkGetDeviceProcAddr(dev, "vkCmdSetEvent2KHR");
+    vkCmdWaitEvents2 = (PFN_vkCmdWaitEvents2)vkGetDeviceProcAddr(dev, "vkCmdWaitEvents2KHR");
+  }
+  if (dynamic_rendering_supported) {
+    vkCmdBeginRendering =
+        (PFN_vkCmdBeginRendering)vkGetDeviceProcAddr(dev, "vkCmdBeginRenderingKHR");
+    vkCmdEndRendering = (PFN_vkCmdEndRendering)vkGetDeviceProcAddr(dev, "vkCmdEndRenderingKHR");
+  }
+  if (timeline_semaphores_supported) {
+    vkWaitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(dev, "vkWaitSemaphoresKHR");
+    vkGetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(
+        dev,
+        "vkGetSemaphoreCounterValueKHR");
+  }
+  if (multi_draw_supported) {
+    vkCmdDrawMultiEXT = (PFN_vkCmdDrawMultiEXT)vkGetDeviceProcAddr(dev, "vkCmdDrawMultiEXT");
+    vkCmdDrawMultiIndexedEXT =
+        (PFN_vkCmdDrawMultiIndexedEXT)vkGetDeviceProcAddr(dev, "vkCmdDrawMultiIndexedEXT");
+  }
+  if (push_descriptor_supported) {
+    vkCmdPushDescriptorSetKHR =
+        (PFN_vkCmdPushDescriptorSetKHR)vkGetDeviceProcAddr(dev, "vkCmdPushDescriptorSetKHR");
   }
 }
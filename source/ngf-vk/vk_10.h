@@ -83,6 +83,7 @@ extern PFN_vkBindBufferMemory vkBindBufferMemory;
 extern PFN_vkBindImageMemory vkBindImageMemory;
 extern PFN_vkCmdBeginQuery vkCmdBeginQuery;
 extern PFN_vkCmdBeginRenderPass vkCmdBeginRenderPass;
+extern PFN_vkCmdBeginRendering vkCmdBeginRendering;
 extern PFN_vkCmdBindDescriptorSets vkCmdBindDescriptorSets;
 extern PFN_vkCmdBindIndexBuffer vkCmdBindIndexBuffer;
 extern PFN_vkCmdBindPipeline vkCmdBindPipeline;
@@ -102,14 +103,18 @@ extern PFN_vkCmdDraw vkCmdDraw;
 extern PFN_vkCmdDrawIndexed vkCmdDrawIndexed;
 extern PFN_vkCmdDrawIndexedIndirect vkCmdDrawIndexedIndirect;
 extern PFN_vkCmdDrawIndirect vkCmdDrawIndirect;
+extern PFN_vkCmdDrawMultiEXT vkCmdDrawMultiEXT;
+extern PFN_vkCmdDrawMultiIndexedEXT vkCmdDrawMultiIndexedEXT;
 extern PFN_vkCmdEndQuery vkCmdEndQuery;
 extern PFN_vkCmdEndRenderPass vkCmdEndRenderPass;
+extern PFN_vkCmdEndRendering vkCmdEndRendering;
 extern PFN_vkCmdExecuteCommands vkCmdExecuteCommands;
 extern PFN_vkCmdFillBuffer vkCmdFillBuffer;
 extern PFN_vkCmdNextSubpass vkCmdNextSubpass;
 extern PFN_vkCmdPipelineBarrier vkCmdPipelineBarrier;
 extern PFN_vkCmdPipelineBarrier2 vkCmdPipelineBarrier2;
 extern PFN_vkCmdPushConstants vkCmdPushConstants;
+extern PFN_vkCmdPushDescriptorSetKHR vkCmdPushDescriptorSetKHR;
 extern PFN_vkCmdResetEvent vkCmdResetEvent;
 extern PFN_vkCmdResetQueryPool vkCmdResetQueryPool;
 extern PFN_vkCmdResolveImage vkCmdResolveImage;
@@ -117,6 +122,7 @@ extern PFN_vkCmdSetBlendConstants vkCmdSetBlendConstants;
 extern PFN_vkCmdSetDepthBias vkCmdSetDepthBias;
 extern PFN_vkCmdSetDepthBounds vkCmdSetDepthBounds;
 extern PFN_vkCmdSetEvent vkCmdSetEvent;
+extern PFN_vkCmdSetEvent2 vkCmdSetEvent2;
 extern PFN_vkCmdSetLineWidth vkCmdSetLineWidth;
 extern PFN_vkCmdSetScissor vkCmdSetScissor;
 extern PFN_vkCmdSetStencilCompareMask vkCmdSetStencilCompareMask;
@@ -125,6 +131,7 @@ extern PFN_vkCmdSetStencilWriteMask vkCmdSetStencilWriteMask;
 extern PFN_vkCmdSetViewport vkCmdSetViewport;
 extern PFN_vkCmdUpdateBuffer vkCmdUpdateBuffer;
 extern PFN_vkCmdWaitEvents vkCmdWaitEvents;
+extern PFN_vkCmdWaitEvents2 vkCmdWaitEvents2;
 extern PFN_vkCmdWriteTimestamp vkCmdWriteTimestamp;
 extern PFN_vkCreateBuffer vkCreateBuffer;
 extern PFN_vkCreateBufferView vkCreateBufferView;
@@ -196,17 +203,29 @@ extern PFN_vkResetFences vkResetFences;
 extern PFN_vkSetEvent vkSetEvent;
 extern PFN_vkUnmapMemory vkUnmapMemory;
 extern PFN_vkUpdateDescriptorSets vkUpdateDescriptorSets;
+extern PFN_vkCreateDescriptorUpdateTemplate vkCreateDescriptorUpdateTemplate;
+extern PFN_vkDestroyDescriptorUpdateTemplate vkDestroyDescriptorUpdateTemplate;
+extern PFN_vkUpdateDescriptorSetWithTemplate vkUpdateDescriptorSetWithTemplate;
 extern PFN_vkWaitForFences vkWaitForFences;
+extern PFN_vkWaitSemaphores vkWaitSemaphores;
+extern PFN_vkGetSemaphoreCounterValue vkGetSemaphoreCounterValue;
 extern PFN_vkCreateSwapchainKHR vkCreateSwapchainKHR;
 extern PFN_vkDestroySwapchainKHR vkDestroySwapchainKHR;
 extern PFN_vkGetSwapchainImagesKHR vkGetSwapchainImagesKHR;
 extern PFN_vkAcquireNextImageKHR vkAcquireNextImageKHR;
 extern PFN_vkQueuePresentKHR vkQueuePresentKHR;
 extern PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
+extern PFN_vkGetPhysicalDeviceProperties2KHR vkGetPhysicalDeviceProperties2KHR;
 
 bool vkl_init_loader(void);
 void vkl_init_instance(VkInstance instance);
-void vkl_init_device(VkDevice device, bool sync2_supported);
+void vkl_init_device(
+    VkDevice device,
+    bool     sync2_supported,
+    bool     dynamic_rendering_supported,
+    bool     timeline_semaphores_supported,
+    bool     multi_draw_supported,
+    bool     push_descriptor_supported);
 
 #ifdef __cplusplus
 }
@@ -1336,3 +1336,17 @@ UTEST (frame_token, encode_decode) {
   ASSERT_EQ(test_max_inflight_frames, ngfi_frame_max_inflight_frames(test_token));
   ASSERT_EQ(test_frame_id, ngfi_frame_id(test_token));
 }
+
+UTEST (frame_token, serial) {
+  const uintptr_t test_token   = ngfi_encode_frame_token(65534u, 3u, 2u);
+  const uintptr_t serial_token = ngfi_frame_token_with_serial(test_token, 0xfffffffeu);
+  ASSERT_EQ(65534u, ngfi_frame_ctx_id(serial_token));
+  ASSERT_EQ(3u, ngfi_frame_max_inflight_frames(serial_token));
+  ASSERT_EQ(2u, ngfi_frame_id(serial_token));
+  if (sizeof(uintptr_t) > 4u) {
+    ASSERT_EQ(0xfffffffeu, ngfi_frame_serial(serial_token));
+    ASSERT_EQ(5u, ngfi_frame_serial(ngfi_frame_token_with_serial(serial_token, 5u)));
+  } else {
+    ASSERT_EQ(0u, ngfi_frame_serial(serial_token));
+  }
+}
@@ -396,6 +396,34 @@ UTEST(vk_sync, barrier_buffer_CwGrCr) {
       VK_IMAGE_LAYOUT_UNDEFINED);
 }
 
+UTEST(vk_sync, barrier_indirect_args_CwIrIr) {
+  ngfvk_sync_state sync_state = empty_sync_state();
+  test_barrier(
+      &sync_state,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT,
+      0,
+      0,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_UNDEFINED);
+  test_barrier(
+      &sync_state,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      VK_ACCESS_SHADER_WRITE_BIT,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_UNDEFINED);
+  test_barrier(
+      &sync_state,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+      0,
+      0,
+      VK_IMAGE_LAYOUT_UNDEFINED,
+      VK_IMAGE_LAYOUT_UNDEFINED);
+}
+
 UTEST(vk_sync, req_merge_concurrent_reads) {
   ngfvk_sync_req dst_req = {{0, 0}, VK_IMAGE_LAYOUT_UNDEFINED};
   static const ngfvk_sync_req src_reqs[] = {
@@ -611,8 +639,1697 @@ UTEST(vk_sync, stg_access_map) {
       BITMASK3x8(0b000, 0b000, 0b000, 0b000, 0b000, 0b000, 0b000, 0b000),
       VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
       VK_ACCESS_SHADER_READ_BIT);
+  test_stg_access_mask(
+      1u << 24u,
+      VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+      VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
 #undef BITMASK3x8
   // clang-format: on
 }
 
+static ngfvk_pipeline_cache_id test_pipeline_cache_id() {
+  ngfvk_pipeline_cache_id id;
+  memset(&id, 0, sizeof(id));
+  id.vendor_id      = 0x10de;
+  id.device_id      = 0x2684;
+  id.driver_version = 42u;
+  for (uint8_t i = 0u; i < VK_UUID_SIZE; ++i) {
+    id.cache_uuid[i]  = i;
+    id.driver_uuid[i] = (uint8_t)(0xffu - i);
+  }
+  return id;
+}
+
+// Builds a serialized pipeline cache with `ndata_bytes` bytes of driver data (including the
+// driver's header) as it would be produced by ngf_pipeline_cache_serialize.
+static void test_pipeline_cache_blob(
+    const ngfvk_pipeline_cache_id& id,
+    uint8_t*                       blob,
+    size_t                         ndata_bytes) {
+  ngfvk_pipeline_cache_blob_header header;
+  memset(&header, 0, sizeof(header));
+  header.magic     = ngfvk::global::pipeline_cache_magic;
+  header.version   = ngfvk::global::pipeline_cache_version;
+  header.id        = id;
+  header.data_size = ndata_bytes;
+  memcpy(blob, &header, sizeof(header));
+  VkPipelineCacheHeaderVersionOne vk_header;
+  vk_header.headerSize    = sizeof(vk_header);
+  vk_header.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+  vk_header.vendorID      = id.vendor_id;
+  vk_header.deviceID      = id.device_id;
+  memcpy(vk_header.pipelineCacheUUID, id.cache_uuid, VK_UUID_SIZE);
+  memcpy(blob + sizeof(header), &vk_header, sizeof(vk_header));
+}
+
+UTEST(vk_pipeline_cache, blob_compatible) {
+  const ngfvk_pipeline_cache_id id = test_pipeline_cache_id();
+  uint8_t blob[sizeof(ngfvk_pipeline_cache_blob_header) + sizeof(VkPipelineCacheHeaderVersionOne) + 16u];
+  test_pipeline_cache_blob(id, blob, sizeof(blob) - sizeof(ngfvk_pipeline_cache_blob_header));
+  ASSERT_TRUE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &id));
+}
+
+UTEST(vk_pipeline_cache, blob_truncated) {
+  const ngfvk_pipeline_cache_id id = test_pipeline_cache_id();
+  uint8_t blob[sizeof(ngfvk_pipeline_cache_blob_header) + sizeof(VkPipelineCacheHeaderVersionOne) + 16u];
+  test_pipeline_cache_blob(id, blob, sizeof(blob) - sizeof(ngfvk_pipeline_cache_blob_header));
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob) - 1u, &id));
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, 4u, &id));
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(nullptr, 0u, &id));
+}
+
+UTEST(vk_pipeline_cache, blob_bad_magic) {
+  const ngfvk_pipeline_cache_id id = test_pipeline_cache_id();
+  uint8_t blob[sizeof(ngfvk_pipeline_cache_blob_header) + sizeof(VkPipelineCacheHeaderVersionOne)];
+  test_pipeline_cache_blob(id, blob, sizeof(VkPipelineCacheHeaderVersionOne));
+  blob[0] ^= 0xffu;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &id));
+}
+
+UTEST(vk_pipeline_cache, blob_device_or_driver_mismatch) {
+  const ngfvk_pipeline_cache_id id = test_pipeline_cache_id();
+  uint8_t blob[sizeof(ngfvk_pipeline_cache_blob_header) + sizeof(VkPipelineCacheHeaderVersionOne)];
+  test_pipeline_cache_blob(id, blob, sizeof(VkPipelineCacheHeaderVersionOne));
+
+  ngfvk_pipeline_cache_id other_id = id;
+  other_id.vendor_id++;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &other_id));
+  other_id = id;
+  other_id.device_id++;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &other_id));
+  other_id = id;
+  other_id.driver_version++;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &other_id));
+  other_id = id;
+  other_id.driver_uuid[3] = 0u;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &other_id));
+  other_id = id;
+  other_id.cache_uuid[7] = 0u;
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &other_id));
+}
+
+UTEST(vk_pipeline_cache, blob_driver_header_mismatch) {
+  const ngfvk_pipeline_cache_id id = test_pipeline_cache_id();
+  uint8_t blob[sizeof(ngfvk_pipeline_cache_blob_header) + sizeof(VkPipelineCacheHeaderVersionOne)];
+  test_pipeline_cache_blob(id, blob, sizeof(VkPipelineCacheHeaderVersionOne));
+  VkPipelineCacheHeaderVersionOne vk_header;
+  memcpy(&vk_header, blob + sizeof(ngfvk_pipeline_cache_blob_header), sizeof(vk_header));
+  vk_header.deviceID++;
+  memcpy(blob + sizeof(ngfvk_pipeline_cache_blob_header), &vk_header, sizeof(vk_header));
+  ASSERT_FALSE(ngfvk_pipeline_cache_blob_is_compatible(blob, sizeof(blob), &id));
+}
+
+UTEST(vk_pipeline, orphaned_objects_deferred_without_context) {
+  ASSERT_TRUE(CURRENT_CONTEXT == NULL);
+  pthread_mutex_init(&_vk.orphans.mu, NULL);
+  pthread_mutex_init(&_vk.layout_cache.mu, NULL);
+  {
+    // The pipeline holds the only reference to its layouts, so they get released along with it.
+    auto set_layout_a    = ngfi::alloc<ngfvk_shared_set_layout>();
+    auto set_layout_b    = ngfi::alloc<ngfvk_shared_set_layout>();
+    auto pipeline_layout = ngfi::alloc<ngfvk_shared_pipeline_layout>();
+
+    set_layout_a->refcount          = 1u;
+    set_layout_a->vk_handle         = (VkDescriptorSetLayout)(uintptr_t)0x40;
+    set_layout_b->refcount          = 1u;
+    set_layout_b->vk_handle         = (VkDescriptorSetLayout)(uintptr_t)0x50;
+    pipeline_layout->refcount       = 1u;
+    pipeline_layout->vk_handle      = (VkPipelineLayout)(uintptr_t)0x20;
+    pipeline_layout->set_layouts    = ngfi::fixed_array<ngfvk_shared_set_layout*> {2u};
+    pipeline_layout->set_layouts[0] = set_layout_a;
+    pipeline_layout->set_layouts[1] = set_layout_b;
+
+    ngfvk_generic_pipeline pipeline {};
+    pipeline.vk_pipeline        = (VkPipeline)(uintptr_t)0x10;
+    pipeline.shared_layout      = pipeline_layout;
+    pipeline.vk_pipeline_layout = pipeline_layout->vk_handle;
+    pipeline.compat_render_pass = (VkRenderPass)(uintptr_t)0x30;
+  }
+  ASSERT_EQ(1u, _vk.orphans.pipelines.size());
+  ASSERT_EQ(1u, _vk.orphans.pipeline_layouts.size());
+  ASSERT_EQ(2u, _vk.orphans.set_layouts.size());
+  ASSERT_EQ(1u, _vk.orphans.render_passes.size());
+  ASSERT_TRUE(_vk.orphans.pipelines[0] == (VkPipeline)(uintptr_t)0x10);
+  ASSERT_TRUE(_vk.orphans.pipeline_layouts[0] == (VkPipelineLayout)(uintptr_t)0x20);
+  ASSERT_TRUE(_vk.orphans.set_layouts[0] == (VkDescriptorSetLayout)(uintptr_t)0x40);
+  ASSERT_TRUE(_vk.orphans.set_layouts[1] == (VkDescriptorSetLayout)(uintptr_t)0x50);
+  ASSERT_TRUE(_vk.orphans.render_passes[0] == (VkRenderPass)(uintptr_t)0x30);
+  _vk.orphans.pipelines.clear();
+  _vk.orphans.pipeline_layouts.clear();
+  _vk.orphans.set_layouts.clear();
+  _vk.orphans.render_passes.clear();
+  pthread_mutex_destroy(&_vk.layout_cache.mu);
+  pthread_mutex_destroy(&_vk.orphans.mu);
+}
+
+static ngfvk_desc_write_key test_buffer_write_key(uint32_t binding, uintptr_t buffer) {
+  ngf_buffer_t buf {};
+  buf.alloc.obj_handle                   = buffer;
+  const ngfvk_desc_binding binding_props = {
+      .type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      .ndescs_in_binding = 1u};
+  ngf_resource_bind_op bind_op = {};
+  bind_op.target_binding       = binding;
+  bind_op.type                 = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+  bind_op.info.buffer.buffer   = &buf;
+  bind_op.info.buffer.range    = 256u;
+  ngfvk_desc_write_key key;
+  uint32_t             dynamic_offset;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &key, &dynamic_offset);
+  return key;
+}
+
+UTEST(vk_desc_set_cache, write_keys) {
+  const ngfvk_desc_write_key a = test_buffer_write_key(0u, 0x100);
+  const ngfvk_desc_write_key b = test_buffer_write_key(0u, 0x100);
+  const ngfvk_desc_write_key c = test_buffer_write_key(1u, 0x100);
+  const ngfvk_desc_write_key d = test_buffer_write_key(0u, 0x200);
+  ASSERT_EQ(0, memcmp(&a, &b, sizeof(a)));
+  ASSERT_NE(0, memcmp(&a, &c, sizeof(a)));
+  ASSERT_NE(0, memcmp(&a, &d, sizeof(a)));
+
+  // Objects with destructors are placed in raw storage so that no Vulkan calls are made.
+  auto img            = (ngf_image_t*)calloc(1u, sizeof(ngf_image_t));
+  auto samp           = (ngf_sampler_t*)calloc(1u, sizeof(ngf_sampler_t));
+  img->vkview         = (VkImageView)(uintptr_t)0x400;
+  img->vkview_arrayed = (VkImageView)(uintptr_t)0x410;
+  samp->vksampler     = (VkSampler)(uintptr_t)0x300;
+  ngfvk_desc_binding binding_props = {
+      .type              = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      .ndescs_in_binding = 1u};
+  ngf_resource_bind_op bind_op              = {};
+  bind_op.type                              = NGF_DESCRIPTOR_IMAGE_AND_SAMPLER;
+  bind_op.info.image_sampler.resource.image = img;
+  bind_op.info.image_sampler.sampler        = samp;
+  ngfvk_desc_write_key img_key_a, img_key_b, img_key_c;
+  uint32_t             dynamic_offset;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &img_key_a, &dynamic_offset);
+  ASSERT_EQ((uint64_t)0x400, img_key_a.handles[0]);
+  ASSERT_EQ((uint64_t)0x300, img_key_a.handles[1]);
+  ASSERT_EQ((uint32_t)VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, img_key_a.image_layout);
+  samp->vksampler = (VkSampler)(uintptr_t)0x500;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &img_key_b, &dynamic_offset);
+  ASSERT_NE(0, memcmp(&img_key_a, &img_key_b, sizeof(img_key_a)));
+  binding_props.is_multilayered_image = true;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &img_key_c, &dynamic_offset);
+  ASSERT_EQ((uint64_t)0x410, img_key_c.handles[0]);
+  free(img);
+  free(samp);
+}
+
+UTEST(vk_desc_set_cache, payload_from_keys) {
+  const ngfvk_desc_write_key buf_key = test_buffer_write_key(2u, 0x100);
+  ngfvk_desc_payload_slot    slot;
+  ngfvk_desc_payload_slot_from_key(&buf_key, &slot);
+  ASSERT_TRUE(slot.buffer.buffer == (VkBuffer)(uintptr_t)0x100);
+  ASSERT_EQ((VkDeviceSize)0u, slot.buffer.offset);
+  ASSERT_EQ((VkDeviceSize)256u, slot.buffer.range);
+
+  ngfi::tmp_arena().reset();
+  const auto           set = (VkDescriptorSet)(uintptr_t)0x30;
+  VkWriteDescriptorSet write;
+  ngfvk_desc_write_from_key(&buf_key, set, &write);
+  ASSERT_TRUE(write.dstSet == set);
+  ASSERT_EQ(2u, write.dstBinding);
+  ASSERT_EQ(1u, write.descriptorCount);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, write.descriptorType);
+  ASSERT_TRUE(write.pBufferInfo->buffer == (VkBuffer)(uintptr_t)0x100);
+  ASSERT_EQ((VkDeviceSize)256u, write.pBufferInfo->range);
+
+  ngfvk_desc_write_key img_key = {};
+  img_key.type                 = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+  img_key.handles[0]           = 0x400;
+  img_key.image_layout         = VK_IMAGE_LAYOUT_GENERAL;
+  ngfvk_desc_payload_slot_from_key(&img_key, &slot);
+  ASSERT_TRUE(slot.image.imageView == (VkImageView)(uintptr_t)0x400);
+  ASSERT_TRUE(slot.image.sampler == VK_NULL_HANDLE);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_GENERAL, slot.image.imageLayout);
+}
+
+UTEST(vk_desc_set_cache, payload_slot_assignment) {
+  // Payload slots are assigned in binding order, skipping unused bindings.
+  ngfvk_desc_set_layout layout {};
+  layout.binding_properties                      = ngfi::fixed_array<ngfvk_desc_binding> {3u};
+  layout.binding_properties[0].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  layout.binding_properties[0].ndescs_in_binding = 2u;
+  layout.binding_properties[2].type              = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  layout.binding_properties[2].ndescs_in_binding = 4u;
+  ASSERT_EQ(6u, ngfvk_assign_desc_payload_slots(&layout));
+  ASSERT_EQ(0u, layout.binding_properties[0].first_payload_slot);
+  ASSERT_EQ(2u, layout.binding_properties[1].first_payload_slot);
+  ASSERT_EQ(2u, layout.binding_properties[2].first_payload_slot);
+}
+
+UTEST(vk_desc_set_cache, find_and_insert) {
+  ngfvk_desc_set_cache cache {};
+  cache.storage.set_block_size(4096u);
+  const auto layout_a = (VkDescriptorSetLayout)(uintptr_t)0x10;
+  const auto layout_b = (VkDescriptorSetLayout)(uintptr_t)0x20;
+  const auto set      = (VkDescriptorSet)(uintptr_t)0x30;
+
+  const ngfvk_desc_write_key writes[2] = {
+      test_buffer_write_key(0u, 0x100),
+      test_buffer_write_key(1u, 0x200)};
+  const uint64_t hash = ngfvk_desc_set_contents_hash(layout_a, writes, 2u);
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, writes, 2u) == VK_NULL_HANDLE);
+  ngfvk_desc_set_cache_insert(&cache, hash, layout_a, writes, 2u, set);
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, writes, 2u) == set);
+
+  // Same hash, different contents or layout must not match.
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, writes, 1u) == VK_NULL_HANDLE);
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_b, writes, 2u) == VK_NULL_HANDLE);
+  const ngfvk_desc_write_key other_writes[2] = {writes[0], test_buffer_write_key(1u, 0x300)};
+  ASSERT_TRUE(
+      ngfvk_desc_set_cache_find(&cache, hash, layout_a, other_writes, 2u) == VK_NULL_HANDLE);
+  ASSERT_NE(hash, ngfvk_desc_set_contents_hash(layout_a, other_writes, 2u));
+  ASSERT_NE(hash, ngfvk_desc_set_contents_hash(layout_b, writes, 2u));
+
+  // Colliding entries are chained.
+  const auto other_set = (VkDescriptorSet)(uintptr_t)0x40;
+  ngfvk_desc_set_cache_insert(&cache, hash, layout_a, other_writes, 2u, other_set);
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, writes, 2u) == set);
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, other_writes, 2u) == other_set);
+
+  cache.entries.clear();
+  cache.storage.reset();
+  ASSERT_TRUE(ngfvk_desc_set_cache_find(&cache, hash, layout_a, writes, 2u) == VK_NULL_HANDLE);
+}
+
+static ngf_descriptor_pool_info test_desc_pool_info(uint32_t size, bool adaptive) {
+  ngf_descriptor_pool_info info = {};
+  info.sets_per_pool            = size;
+  for (uint32_t i = 0u; i < NGF_DESCRIPTOR_TYPE_COUNT; ++i) { info.descriptors_per_pool[i] = size; }
+  info.adaptive = adaptive;
+  return info;
+}
+
+UTEST(vk_desc_pools, capacity_from_config) {
+  ngfvk_desc_pools_list pools {};
+  pools.config                                            = test_desc_pool_info(16u, false);
+  pools.config.descriptors_per_pool[NGF_DESCRIPTOR_IMAGE] = 0u;
+  ngfvk_desc_set_layout layout {};
+  layout.counts[NGF_DESCRIPTOR_UNIFORM_BUFFER] = 40u;
+  layout.counts[NGF_DESCRIPTOR_IMAGE]          = 2u;
+
+  // Usage history is ignored unless the pools adapt.
+  pools.high_water.sets = 1000u;
+  const ngfvk_desc_pool_capacity capacity = ngfvk_desc_pool_capacity_for(&pools, &layout);
+  ASSERT_EQ(16u, capacity.sets);
+  ASSERT_EQ(40u, capacity.descriptors[NGF_DESCRIPTOR_UNIFORM_BUFFER]);
+  ASSERT_EQ(2u, capacity.descriptors[NGF_DESCRIPTOR_IMAGE]);
+  ASSERT_EQ(16u, capacity.descriptors[NGF_DESCRIPTOR_SAMPLER]);
+}
+
+UTEST(vk_desc_pools, capacity_from_high_water) {
+  ngfvk_desc_pools_list pools {};
+  pools.config = test_desc_pool_info(16u, true);
+  ngfvk_desc_set_layout layout {};
+  layout.counts[NGF_DESCRIPTOR_UNIFORM_BUFFER] = 1u;
+
+  // Without any history, the configured sizes are used.
+  ngfvk_desc_pool_capacity capacity = ngfvk_desc_pool_capacity_for(&pools, &layout);
+  ASSERT_EQ(16u, capacity.sets);
+  ASSERT_EQ(16u, capacity.descriptors[NGF_DESCRIPTOR_SAMPLER]);
+
+  pools.high_water.sets                                        = 80u;
+  pools.high_water.descriptors[NGF_DESCRIPTOR_UNIFORM_BUFFER]  = 160u;
+  pools.frame_usage.sets                                       = 40u;
+  pools.frame_usage.descriptors[NGF_DESCRIPTOR_UNIFORM_BUFFER] = 40u;
+  capacity = ngfvk_desc_pool_capacity_for(&pools, &layout);
+  ASSERT_EQ(60u, capacity.sets);
+  ASSERT_EQ(160u, capacity.descriptors[NGF_DESCRIPTOR_UNIFORM_BUFFER]);
+  // Types that haven't been used get no capacity.
+  ASSERT_EQ(0u, capacity.descriptors[NGF_DESCRIPTOR_SAMPLER]);
+
+  // Usage above the target also falls back onto the configured size.
+  pools.frame_usage.sets = 200u;
+  capacity               = ngfvk_desc_pool_capacity_for(&pools, &layout);
+  ASSERT_EQ(16u, capacity.sets);
+}
+
+UTEST(vk_desc_pools, reset_records_usage) {
+  ngfvk_desc_pools_list pools {};
+  pools.config = test_desc_pool_info(16u, true);
+  pools.set_cache.storage.set_block_size(1024u);
+  pools.frame_usage.sets                              = 16u;
+  pools.frame_usage.descriptors[NGF_DESCRIPTOR_IMAGE] = 24u;
+  pools.npools_created                                = 1u;
+
+  ngf_descriptor_pool_stats stats = {};
+  ngfvk_reset_desc_pools_list(&pools, &stats);
+  ASSERT_EQ(1u, stats.npools_created);
+  ASSERT_EQ(16u, stats.nsets_allocated);
+  ASSERT_EQ(24u, stats.ndescriptors_allocated[NGF_DESCRIPTOR_IMAGE]);
+  ASSERT_EQ(16u, pools.high_water.sets);
+  ASSERT_EQ(24u, pools.high_water.descriptors[NGF_DESCRIPTOR_IMAGE]);
+  ASSERT_EQ(0u, pools.frame_usage.sets);
+  ASSERT_EQ(0u, pools.npools_created);
+
+  // Resetting again without any use in between changes nothing.
+  ngfvk_reset_desc_pools_list(&pools, &stats);
+  ASSERT_EQ(1u, stats.npools_created);
+  ASSERT_EQ(16u, stats.nsets_allocated);
+  ASSERT_EQ(16u, pools.high_water.sets);
+
+  // High-water marks decay slowly when usage drops.
+  pools.frame_usage.sets = 2u;
+  ngfvk_reset_desc_pools_list(&pools, NULL);
+  ASSERT_EQ(14u, pools.high_water.sets);
+  ASSERT_EQ(21u, pools.high_water.descriptors[NGF_DESCRIPTOR_IMAGE]);
+}
+
+UTEST(vk_layout_cache, acquire_existing) {
+  pthread_mutex_init(&_vk.orphans.mu, NULL);
+  pthread_mutex_init(&_vk.layout_cache.mu, NULL);
+
+  // A pipeline-specific layout with a uniform buffer at binding 0 and an image at binding 2.
+  ngfvk_desc_set_layout layout {};
+  layout.binding_properties                      = ngfi::fixed_array<ngfvk_desc_binding> {3u};
+  layout.binding_properties[0].type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+  layout.binding_properties[0].ndescs_in_binding = 1u;
+  layout.binding_properties[2].type              = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  layout.binding_properties[2].ndescs_in_binding = 1u;
+  layout.binding_properties[2].is_cubemap        = true;
+  ngfvk_assign_desc_payload_slots(&layout);
+
+  // Pre-populate the cache with a matching set layout, so that no Vulkan objects get created.
+  const ngfvk_set_layout_key_binding key[3] = {
+      {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1u, 0u},
+      {0u, 0u, 0u},
+      {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1u, 2u}};
+  auto shared_set       = ngfi::alloc<ngfvk_shared_set_layout>();
+  shared_set->hash      = ngfvk_set_layout_key_hash(key, 3u, false, false);
+  shared_set->refcount  = 1u;
+  shared_set->key       = ngfi::fixed_array<ngfvk_set_layout_key_binding> {3u};
+  shared_set->vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x40;
+  memcpy(shared_set->key.data(), key, sizeof(key));
+  ASSERT_TRUE(ngfvk_link_cache_entry(&_vk.layout_cache.set_layouts, shared_set));
+
+  ngfi::tmp_arena().reset();
+  ASSERT_TRUE(ngfvk_acquire_shared_set_layout(&layout, NULL) == shared_set);
+  ASSERT_EQ(2u, shared_set->refcount);
+  ASSERT_TRUE(layout.vk_handle == shared_set->vk_handle);
+
+  // A pipeline layout made of the same set layouts is shared as well. It already holds a reference
+  // to the set layout, so the one passed in by the caller is dropped.
+  auto shared_pipeline_layout            = ngfi::alloc<ngfvk_shared_pipeline_layout>();
+  shared_pipeline_layout->hash           = ngfvk_pipeline_layout_key_hash(&shared_set, 1u);
+  shared_pipeline_layout->refcount       = 1u;
+  shared_pipeline_layout->set_layouts    = ngfi::fixed_array<ngfvk_shared_set_layout*> {1u};
+  shared_pipeline_layout->set_layouts[0] = shared_set;
+  shared_pipeline_layout->vk_handle      = (VkPipelineLayout)(uintptr_t)0x20;
+  ASSERT_TRUE(ngfvk_link_cache_entry(&_vk.layout_cache.pipeline_layouts, shared_pipeline_layout));
+  ASSERT_TRUE(ngfvk_acquire_shared_pipeline_layout(&shared_set, 1u) == shared_pipeline_layout);
+  ASSERT_EQ(2u, shared_pipeline_layout->refcount);
+  ASSERT_EQ(1u, shared_set->refcount);
+
+  // Objects are only disposed of once the last reference is gone.
+  ngfvk_release_shared_pipeline_layout(shared_pipeline_layout);
+  ASSERT_EQ(0u, _vk.orphans.pipeline_layouts.size());
+  ngfvk_release_shared_pipeline_layout(shared_pipeline_layout);
+  ASSERT_EQ(1u, _vk.orphans.pipeline_layouts.size());
+  ASSERT_EQ(1u, _vk.orphans.set_layouts.size());
+  ASSERT_TRUE(
+      *_vk.layout_cache.set_layouts.get(ngfvk_set_layout_key_hash(key, 3u, false, false)) == NULL);
+
+  _vk.orphans.pipeline_layouts.clear();
+  _vk.orphans.set_layouts.clear();
+  _vk.layout_cache.set_layouts.clear();
+  _vk.layout_cache.pipeline_layouts.clear();
+  pthread_mutex_destroy(&_vk.layout_cache.mu);
+  pthread_mutex_destroy(&_vk.orphans.mu);
+}
+
+UTEST(vk_layout_cache, no_template_for_partially_bound) {
+  pthread_mutex_init(&_vk.orphans.mu, NULL);
+  pthread_mutex_init(&_vk.layout_cache.mu, NULL);
+  const PFN_vkCreateDescriptorSetLayout      create_set_layout = vkCreateDescriptorSetLayout;
+  const PFN_vkCreateDescriptorUpdateTemplate create_template   = vkCreateDescriptorUpdateTemplate;
+  vkCreateDescriptorSetLayout = [](VkDevice,
+                                   const VkDescriptorSetLayoutCreateInfo*,
+                                   const VkAllocationCallbacks*,
+                                   VkDescriptorSetLayout* layout) {
+    *layout = (VkDescriptorSetLayout)(uintptr_t)0x40;
+    return VK_SUCCESS;
+  };
+  vkCreateDescriptorUpdateTemplate = [](VkDevice,
+                                        const VkDescriptorUpdateTemplateCreateInfo*,
+                                        const VkAllocationCallbacks*,
+                                        VkDescriptorUpdateTemplate*) {
+    return VK_ERROR_INITIALIZATION_FAILED;
+  };
+
+  // Partially bound sets are written with individual writes of the bound descriptors only, so no
+  // template or dummy payload is prepared for them.
+  ngfvk_desc_set_layout layout {};
+  layout.binding_properties                      = ngfi::fixed_array<ngfvk_desc_binding> {1u};
+  layout.binding_properties[0].type              = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  layout.binding_properties[0].ndescs_in_binding = 4u;
+  layout.nall_descs                              = 4u;
+  layout.is_partially_bound                      = true;
+  ngfvk_assign_desc_payload_slots(&layout);
+  ngfi::tmp_arena().reset();
+  ngfvk_shared_set_layout* shared = ngfvk_acquire_shared_set_layout(&layout, NULL);
+  ASSERT_TRUE(shared != NULL);
+  ASSERT_TRUE(shared->is_partially_bound);
+  ASSERT_TRUE(layout.vk_update_template == VK_NULL_HANDLE);
+  ASSERT_TRUE(layout.dummy_payload == NULL);
+
+  // Otherwise, a template is attempted, starting with the dummy payload.
+  ngfvk_desc_set_layout full_layout {};
+  full_layout.binding_properties    = ngfi::fixed_array<ngfvk_desc_binding> {1u};
+  full_layout.binding_properties[0] = layout.binding_properties[0];
+  full_layout.nall_descs            = 4u;
+  ngfi::tmp_arena().reset();
+  ngfvk_shared_set_layout* full_shared = ngfvk_acquire_shared_set_layout(&full_layout, NULL);
+  ASSERT_TRUE(full_shared != NULL && full_shared != shared);
+  ASSERT_FALSE(full_shared->is_partially_bound);
+  ASSERT_TRUE(full_layout.dummy_payload != NULL);
+
+  ngfvk_release_shared_set_layouts(&shared, 1u);
+  ngfvk_release_shared_set_layouts(&full_shared, 1u);
+  vkCreateDescriptorSetLayout      = create_set_layout;
+  vkCreateDescriptorUpdateTemplate = create_template;
+  _vk.orphans.set_layouts.clear();
+  _vk.orphans.update_templates.clear();
+  _vk.layout_cache.set_layouts.clear();
+  pthread_mutex_destroy(&_vk.layout_cache.mu);
+  pthread_mutex_destroy(&_vk.orphans.mu);
+}
+
+UTEST(vk_layout_cache, skip_bound_desc_sets) {
+  ngfvk_desc_set_layout layouts_a[2] = {}, layouts_b[2] = {}, layouts_c[1] = {};
+  layouts_a[0].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x10;
+  layouts_a[1].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x20;
+  layouts_b[0].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x10;
+  layouts_b[1].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x30;
+  layouts_c[0].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x40;
+  const auto set_x       = (VkDescriptorSet)(uintptr_t)0x100;
+  const auto set_y       = (VkDescriptorSet)(uintptr_t)0x200;
+
+  ngfvk_bound_desc_sets bound {};
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_x, 0u, layouts_a));
+  ngfvk_track_bound_desc_set(&bound, set_x, 0u, layouts_a, 2u);
+  ngfvk_track_bound_desc_set(&bound, set_y, 1u, layouts_a, 2u);
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_x, 0u, layouts_a));
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_y, 1u, layouts_a));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_y, 0u, layouts_a));
+
+  // Pipelines sharing the layout of set 0 keep it bound, but not the sets past that.
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_x, 0u, layouts_b));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_y, 1u, layouts_b));
+  ngfvk_track_bound_desc_set(&bound, set_y, 1u, layouts_b, 2u);
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_x, 0u, layouts_b));
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_y, 1u, layouts_b));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_y, 1u, layouts_a));
+
+  // Binding with an incompatible layout for set 0 disturbs everything.
+  ngfvk_track_bound_desc_set(&bound, set_y, 0u, layouts_c, 1u);
+  ASSERT_TRUE(ngfvk_is_desc_set_bound(&bound, set_y, 0u, layouts_c));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_x, 0u, layouts_a));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&bound, set_y, 1u, layouts_b));
+}
+
+UTEST(vk_layout_cache, execute_secondaries_unbinds_desc_sets) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_cmd_buffer         buf        = cmd_buf.value().get();
+  ngfvk_desc_set_layout  layouts[1] = {};
+  const auto             set        = (VkDescriptorSet)(uintptr_t)0x100;
+  const auto             secondary  = (VkCommandBuffer)(uintptr_t)0x200;
+  const ngfvk_render_cmd cmd        = {
+      .data = {.execute_secondaries = {.cmd_bufs = &secondary, .ncmd_bufs = 1u}},
+      .type = NGFVK_RENDER_CMD_EXECUTE_SECONDARIES};
+  layouts[0].vk_handle = (VkDescriptorSetLayout)(uintptr_t)0x10;
+  ngfvk_track_bound_desc_set(&buf->bound_gfx_desc_sets, set, 0u, layouts, 1u);
+  ngfvk_track_bound_desc_set(&buf->bound_compute_desc_sets, set, 0u, layouts, 1u);
+
+  // Sets bound before the secondaries execute have to be bound again afterwards.
+  const PFN_vkCmdExecuteCommands execute_commands = vkCmdExecuteCommands;
+  vkCmdExecuteCommands = [](VkCommandBuffer, uint32_t, const VkCommandBuffer*) {};
+  ngfvk_cmd_buf_record_render_cmd(buf, &cmd);
+  vkCmdExecuteCommands = execute_commands;
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&buf->bound_gfx_desc_sets, set, 0u, layouts));
+  ASSERT_FALSE(ngfvk_is_desc_set_bound(&buf->bound_compute_desc_sets, set, 0u, layouts));
+}
+
+static ngfi::unique_ptr<ngf_render_target_t> test_render_target(ngf_image_format color_format) {
+  // Default render targets are created without making any Vulkan calls.
+  auto rt = ngfi::move(ngf_render_target_t::make(64u, 64u, 2u).value());
+
+  rt->attachment_descs[0].format             = color_format;
+  rt->attachment_descs[0].type               = NGF_ATTACHMENT_COLOR;
+  rt->attachment_descs[0].sample_count       = NGF_SAMPLE_COUNT_1;
+  rt->attachment_descs[1].format             = NGF_IMAGE_FORMAT_DEPTH32;
+  rt->attachment_descs[1].type               = NGF_ATTACHMENT_DEPTH;
+  rt->attachment_descs[1].sample_count       = NGF_SAMPLE_COUNT_1;
+  rt->attachment_compat_pass_descs[0].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  rt->attachment_compat_pass_descs[1].layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+  return rt;
+}
+
+UTEST(vk_renderpass_cache, shared_between_targets) {
+  pthread_mutex_init(&_vk.orphans.mu, NULL);
+  pthread_mutex_init(&_vk.renderpass_cache.mu, NULL);
+  auto rt_a = test_render_target(NGF_IMAGE_FORMAT_RGBA8);
+  auto rt_b = test_render_target(NGF_IMAGE_FORMAT_RGBA8);
+  auto rt_c = test_render_target(NGF_IMAGE_FORMAT_BGRA8);
+
+  // Pre-populate the cache, so that no Vulkan objects get created.
+  const uint64_t                  ops_key = 0x12u;
+  ngfvk_renderpass_attachment_key keys[2];
+  ngfvk_renderpass_attachment_keys(rt_a.get(), keys);
+  auto entry         = ngfi::alloc<ngfvk_renderpass_cache_entry>();
+  entry->hash        = ngfvk_renderpass_key_hash(keys, 2u, ops_key);
+  entry->ops_key     = ops_key;
+  entry->attachments = ngfi::fixed_array<ngfvk_renderpass_attachment_key> {2u};
+  entry->renderpass  = (VkRenderPass)(uintptr_t)0x30;
+  memcpy(entry->attachments.data(), keys, sizeof(keys));
+  ASSERT_TRUE(ngfvk_link_cache_entry(&_vk.renderpass_cache.entries, entry));
+
+  // Targets with identical attachments share the render pass, and each holds one reference to it.
+  ngfi::tmp_arena().reset();
+  ASSERT_TRUE(ngfvk_lookup_renderpass(rt_a.get(), ops_key) == entry->renderpass);
+  ASSERT_TRUE(ngfvk_lookup_renderpass(rt_a.get(), ops_key) == entry->renderpass);
+  ASSERT_TRUE(ngfvk_lookup_renderpass(rt_b.get(), ops_key) == entry->renderpass);
+  ASSERT_EQ(2u, entry->refcount);
+  ASSERT_TRUE(rt_a->renderpasses.load()->next == NULL);
+
+  // A different attachment format or different load/store ops need a different render pass.
+  ngfvk_renderpass_attachment_key other_keys[2];
+  ngfvk_renderpass_attachment_keys(rt_c.get(), other_keys);
+  ASSERT_NE(entry->hash, ngfvk_renderpass_key_hash(other_keys, 2u, ops_key));
+  ASSERT_NE(entry->hash, ngfvk_renderpass_key_hash(keys, 2u, ops_key + 1u));
+
+  // The render pass is evicted along with the last target using it.
+  const uint64_t entry_hash = entry->hash;
+  rt_a                      = ngfi::unique_ptr<ngf_render_target_t> {};
+  ASSERT_EQ(1u, entry->refcount);
+  ASSERT_EQ(0u, _vk.orphans.render_passes.size());
+  rt_b = ngfi::unique_ptr<ngf_render_target_t> {};
+  ASSERT_EQ(1u, _vk.orphans.render_passes.size());
+  ASSERT_TRUE(_vk.orphans.render_passes[0] == (VkRenderPass)(uintptr_t)0x30);
+  ASSERT_TRUE(*_vk.renderpass_cache.entries.get(entry_hash) == NULL);
+
+  rt_c = ngfi::unique_ptr<ngf_render_target_t> {};
+  _vk.orphans.render_passes.clear();
+  _vk.renderpass_cache.entries.clear();
+  pthread_mutex_destroy(&_vk.renderpass_cache.mu);
+  pthread_mutex_destroy(&_vk.orphans.mu);
+}
+
+UTEST(vk_immediate_pass, declared_resource_sync_reqs) {
+  ngf_buffer_t buf {};
+  buf.hash  = 0x1234u;
+  auto img  = (ngf_image_t*)calloc(1u, sizeof(ngf_image_t));
+  img->hash = 0x5678u;
+
+  const ngf_render_pass_resource attribs = {
+      .usage  = NGF_RENDER_RESOURCE_USAGE_ATTRIB_BUFFER,
+      .buffer = &buf,
+      .image  = NULL};
+  ngfvk_sync_req req = ngfvk_sync_req_for_declared_resource(&attribs);
+  ngfvk_sync_res res = ngfvk_sync_res_from_declared_resource(&attribs);
+  ASSERT_EQ((VkAccessFlags)VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, req.barrier_masks.access_mask);
+  ASSERT_EQ((VkPipelineStageFlags)VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, req.barrier_masks.stage_mask);
+  ASSERT_EQ(NGFVK_SYNC_RES_BUFFER, res.type);
+  ASSERT_TRUE(res.data.buf == &buf);
+
+  // Shader accesses may happen in any graphics stage, since pipelines aren't known up front.
+  const ngf_render_pass_resource storage = {
+      .usage  = NGF_RENDER_RESOURCE_USAGE_STORAGE_BUFFER,
+      .buffer = &buf,
+      .image  = NULL};
+  req = ngfvk_sync_req_for_declared_resource(&storage);
+  ASSERT_EQ(
+      (VkAccessFlags)(VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT),
+      req.barrier_masks.access_mask);
+  ASSERT_EQ(
+      (VkPipelineStageFlags)(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+      req.barrier_masks.stage_mask);
+
+  const ngf_render_pass_resource image = {
+      .usage  = NGF_RENDER_RESOURCE_USAGE_IMAGE,
+      .buffer = NULL,
+      .image  = img};
+  req = ngfvk_sync_req_for_declared_resource(&image);
+  res = ngfvk_sync_res_from_declared_resource(&image);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, req.layout);
+  ASSERT_EQ(NGFVK_SYNC_RES_IMAGE, res.type);
+  ASSERT_TRUE(res.data.img == img);
+  ASSERT_EQ((uint64_t)0x5678u, res.hash);
+  free(img);
+}
+
+UTEST(vk_secondary_cmd_buf, sync_state_merge) {
+  ngfvk_sync_state dst          = empty_sync_state();
+  dst.active_readers_masks      = {VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT};
+  dst.per_stage_readers_mask    = 0x1u;
+  dst.skip_hazard_tracking      = true;
+  dst.queue                     = NGF_QUEUE_TYPE_COMPUTE;
+  ngfvk_sync_state reader       = empty_sync_state();
+  reader.active_readers_masks   = {VK_ACCESS_UNIFORM_READ_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT};
+  reader.per_stage_readers_mask = 0x2u;
+
+  // Reads add up.
+  ngfvk_sync_state_merge(&dst, &reader);
+  ASSERT_EQ(
+      (VkAccessFlags)(VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT),
+      dst.active_readers_masks.access_mask);
+  ASSERT_EQ(0x3u, dst.per_stage_readers_mask);
+
+  // A write replaces everything but the hazard tracking flag and the queue.
+  ngfvk_sync_state writer  = empty_sync_state();
+  writer.last_writer_masks = {VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+  writer.layout            = VK_IMAGE_LAYOUT_GENERAL;
+  ngfvk_sync_state_merge(&dst, &writer);
+  ASSERT_EQ((VkAccessFlags)VK_ACCESS_SHADER_WRITE_BIT, dst.last_writer_masks.access_mask);
+  ASSERT_EQ((VkAccessFlags)0u, dst.active_readers_masks.access_mask);
+  ASSERT_EQ(0u, dst.per_stage_readers_mask);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_GENERAL, dst.layout);
+  ASSERT_TRUE(dst.skip_hazard_tracking);
+  ASSERT_EQ(NGF_QUEUE_TYPE_COMPUTE, (ngf_queue_type)dst.queue);
+}
+
+UTEST(vk_secondary_cmd_buf, merge_into_primary) {
+  const ngf_cmd_buffer_info primary_info   = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  const ngf_cmd_buffer_info secondary_info = {.level = NGF_CMD_BUFFER_LEVEL_SECONDARY};
+  auto                      primary        = ngf_cmd_buffer_t::make(primary_info);
+  auto                      secondary_a    = ngf_cmd_buffer_t::make(secondary_info);
+  auto                      secondary_b    = ngf_cmd_buffer_t::make(secondary_info);
+  ASSERT_FALSE(primary.has_error() || secondary_a.has_error() || secondary_b.has_error());
+  ASSERT_FALSE(primary.value()->secondary);
+  ASSERT_TRUE(secondary_a.value()->secondary);
+
+  ngf_buffer_t read_buf {};
+  ngf_buffer_t write_buf {};
+  read_buf.hash  = 0x1234u;
+  write_buf.hash = 0x5678u;
+  const ngfvk_sync_res read_res  = ngfvk_sync_res_from_buf(&read_buf);
+  const ngfvk_sync_res write_res = ngfvk_sync_res_from_buf(&write_buf);
+  const ngfvk_sync_req vs_read   = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+  const ngfvk_sync_req fs_read = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+  const ngfvk_sync_req fs_write = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+  // Secondary A reads one buffer in the vertex stage and writes another one, secondary B reads the
+  // first buffer in the fragment stage.
+  ngfvk_sync_req_batch batch;
+  ngfvk_sync_req_batch_init(2u, &batch);
+  ngfvk_sync_req_batch_add_with_lookup(&batch, secondary_a.value().get(), &read_res, &vs_read);
+  ngfvk_sync_req_batch_add_with_lookup(&batch, secondary_a.value().get(), &write_res, &fs_write);
+  ngfvk_sync_req_batch_process(&batch, secondary_a.value().get());
+  ngfvk_sync_req_batch_init(1u, &batch);
+  ngfvk_sync_req_batch_add_with_lookup(&batch, secondary_b.value().get(), &read_res, &fs_read);
+  ngfvk_sync_req_batch_process(&batch, secondary_b.value().get());
+
+  ngfvk_cmd_buf_merge_secondary(primary.value().get(), secondary_a.value().get());
+  ngfvk_cmd_buf_merge_secondary(primary.value().get(), secondary_b.value().get());
+
+  // The primary expects the resources in the state needed by the secondaries' first accesses, and
+  // ends up in the state left by the last access.
+  ngf_cmd_buffer       primary_buf = primary.value().get();
+  ngfvk_sync_res_data* read_data   = NULL;
+  ngfvk_sync_res_data* write_data  = NULL;
+  ASSERT_FALSE(ngfvk_cmd_buf_lookup_sync_res(primary_buf, &read_res, &read_data));
+  ASSERT_FALSE(ngfvk_cmd_buf_lookup_sync_res(primary_buf, &write_res, &write_data));
+  ASSERT_EQ(
+      (VkPipelineStageFlags)(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+      read_data->whole.expected_sync_req.barrier_masks.stage_mask);
+  ASSERT_EQ(
+      (VkPipelineStageFlags)(VK_PIPELINE_STAGE_VERTEX_SHADER_BIT |
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+      read_data->whole.sync_state.active_readers_masks.stage_mask);
+  ASSERT_EQ(
+      (VkAccessFlags)VK_ACCESS_SHADER_WRITE_BIT,
+      write_data->whole.expected_sync_req.barrier_masks.access_mask);
+  ASSERT_EQ(
+      (VkPipelineStageFlags)VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      write_data->whole.sync_state.last_writer_masks.stage_mask);
+  ASSERT_EQ(0u, primary_buf->pending_barriers.npending_buf_bars);
+  ASSERT_EQ(0u, primary_buf->pending_barriers.npending_img_bars);
+  ngfi::tmp_arena().reset();
+}
+
+UTEST(vk_async_compute, queue_transfer) {
+  // Resources that haven't been accessed yet, or are read-only, aren't transferred.
+  ngfvk_sync_state state = empty_sync_state();
+  ASSERT_FALSE(ngfvk_sync_needs_queue_transfer(&state, NGF_QUEUE_TYPE_COMPUTE));
+  state.last_writer_masks = {VK_ACCESS_SHADER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+  state.layout            = VK_IMAGE_LAYOUT_GENERAL;
+  ASSERT_FALSE(ngfvk_sync_needs_queue_transfer(&state, NGF_QUEUE_TYPE_GRAPHICS));
+  ASSERT_TRUE(ngfvk_sync_needs_queue_transfer(&state, NGF_QUEUE_TYPE_COMPUTE));
+  state.skip_hazard_tracking = true;
+  ASSERT_FALSE(ngfvk_sync_needs_queue_transfer(&state, NGF_QUEUE_TYPE_COMPUTE));
+  state.skip_hazard_tracking = false;
+
+  // An image written by the fragment stage on the graphics queue is read by a compute shader on
+  // the compute queue, in a different layout.
+  const ngfvk_sync_req cs_read = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  ngfvk_barrier_data release;
+  ngfvk_barrier_data acquire;
+  ngfvk_sync_queue_transfer(&state, &cs_read, 0u, 1u, &release, &acquire);
+
+  ASSERT_EQ((VkPipelineStageFlags)VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, release.src_stage_mask);
+  ASSERT_EQ((VkAccessFlags)VK_ACCESS_SHADER_WRITE_BIT, release.src_access_mask);
+  ASSERT_EQ((VkPipelineStageFlags)0u, release.dst_stage_mask);
+  ASSERT_EQ((VkAccessFlags)0u, release.dst_access_mask);
+  ASSERT_EQ((VkPipelineStageFlags)0u, acquire.src_stage_mask);
+  ASSERT_EQ((VkPipelineStageFlags)VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, acquire.dst_stage_mask);
+  ASSERT_EQ((VkAccessFlags)VK_ACCESS_SHADER_READ_BIT, acquire.dst_access_mask);
+  for (const ngfvk_barrier_data* barrier : {&release, &acquire}) {
+    ASSERT_EQ(VK_IMAGE_LAYOUT_GENERAL, barrier->src_layout);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, barrier->dst_layout);
+    ASSERT_EQ(0u, ngfvk_barrier_src_queue_family(barrier));
+    ASSERT_EQ(1u, ngfvk_barrier_dst_queue_family(barrier));
+  }
+
+  // The layout transition done by the transfer counts as the last write, and the compute shader's
+  // read has seen it.
+  ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, state.layout);
+  ASSERT_EQ(
+      (VkPipelineStageFlags)VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+      state.last_writer_masks.stage_mask);
+  ngfvk_barrier_data barrier;
+  ASSERT_FALSE(ngfvk_sync_barrier(&state, &cs_read, &barrier));
+
+  // Barriers that don't transfer ownership ignore queue families.
+  ASSERT_EQ(VK_QUEUE_FAMILY_IGNORED, ngfvk_barrier_src_queue_family(&barrier));
+  ASSERT_EQ(VK_QUEUE_FAMILY_IGNORED, ngfvk_barrier_dst_queue_family(&barrier));
+}
+
+UTEST(vk_async_compute, render_pass_requires_graphics_queue) {
+  const ngf_cmd_buffer_info secondary_compute_info = {
+      .level = NGF_CMD_BUFFER_LEVEL_SECONDARY,
+      .queue = NGF_QUEUE_TYPE_COMPUTE};
+  ASSERT_TRUE(ngf_cmd_buffer_t::make(secondary_compute_info).has_error());
+
+  const ngf_cmd_buffer_info compute_info = {
+      .level = NGF_CMD_BUFFER_LEVEL_PRIMARY,
+      .queue = NGF_QUEUE_TYPE_COMPUTE};
+  auto compute_buf = ngf_cmd_buffer_t::make(compute_info);
+  ASSERT_FALSE(compute_buf.has_error());
+  ASSERT_EQ(NGF_QUEUE_TYPE_COMPUTE, compute_buf.value()->queue);
+
+  const ngf_render_pass_info pass_info = {};
+  ngf_render_encoder         enc;
+  ASSERT_EQ(
+      NGF_ERROR_INVALID_OPERATION,
+      ngf_cmd_begin_render_pass(compute_buf.value().get(), &pass_info, &enc));
+}
+
+UTEST(vk_async_transfer, dedicated_transfer_family) {
+  VkQueueFamilyProperties props;
+  memset(&props, 0, sizeof(props));
+  props.queueFlags                  = VK_QUEUE_TRANSFER_BIT | VK_QUEUE_SPARSE_BINDING_BIT;
+  props.minImageTransferGranularity = {1u, 1u, 1u};
+  ASSERT_TRUE(ngfvk_is_dedicated_transfer_family(&props));
+
+  // Families that can do more than transfers are used for other queues.
+  props.queueFlags |= VK_QUEUE_COMPUTE_BIT;
+  ASSERT_FALSE(ngfvk_is_dedicated_transfer_family(&props));
+
+  // Families restricted to copying whole mip levels are not usable for arbitrary uploads.
+  props.queueFlags                  = VK_QUEUE_TRANSFER_BIT;
+  props.minImageTransferGranularity = {0u, 0u, 0u};
+  ASSERT_FALSE(ngfvk_is_dedicated_transfer_family(&props));
+}
+
+UTEST(vk_async_transfer, transfer_passes_only) {
+  const ngf_cmd_buffer_info transfer_info = {
+      .level = NGF_CMD_BUFFER_LEVEL_PRIMARY,
+      .queue = NGF_QUEUE_TYPE_TRANSFER};
+  auto transfer_buf = ngf_cmd_buffer_t::make(transfer_info);
+  ASSERT_FALSE(transfer_buf.has_error());
+
+  const ngf_compute_pass_info compute_pass_info = {};
+  ngf_compute_encoder         compute_enc;
+  ASSERT_EQ(
+      NGF_ERROR_INVALID_OPERATION,
+      ngf_cmd_begin_compute_pass(transfer_buf.value().get(), &compute_pass_info, &compute_enc));
+  const ngf_render_pass_info render_pass_info = {};
+  ngf_render_encoder         render_enc;
+  ASSERT_EQ(
+      NGF_ERROR_INVALID_OPERATION,
+      ngf_cmd_begin_render_pass(transfer_buf.value().get(), &render_pass_info, &render_enc));
+}
+
+UTEST(vk_async_transfer, submit_acquire_from_two_queues) {
+  // A graphics cmd buffer reads a buffer last written on the compute queue and another one last
+  // written on the transfer queue, so both of them have to be released before it executes.
+  ngfvk_sync_state global_states[2]  = {empty_sync_state(), empty_sync_state()};
+  global_states[0].queue             = NGF_QUEUE_TYPE_COMPUTE;
+  global_states[0].last_writer_masks = {
+      VK_ACCESS_SHADER_WRITE_BIT,
+      VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  global_states[1].queue             = NGF_QUEUE_TYPE_TRANSFER;
+  global_states[1].last_writer_masks = {
+      VK_ACCESS_TRANSFER_WRITE_BIT,
+      VK_PIPELINE_STAGE_TRANSFER_BIT};
+  ngfvk_sync_track track;
+  memset(&track, 0, sizeof(track));
+  track.accessed          = true;
+  track.sync_state        = empty_sync_state();
+  track.expected_sync_req = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_UNDEFINED};
+
+  // Reproduce the sequence of batches and command buffer handles a frame with a prologue, this
+  // cmd buffer and a presentation transition submits.
+  const uint32_t     ncmd_bufs = 1u;
+  ngfvk_submit_batch batches[16];
+  uint32_t           nbatches                              = 0u;
+  uint32_t           nhandles                              = 0u;
+  uint64_t           timeline_values[NGF_QUEUE_TYPE_COUNT] = {0u};
+  ngfvk_submit_batch_for_queue(
+      batches,
+      &nbatches,
+      timeline_values,
+      nhandles++,
+      NGF_QUEUE_TYPE_GRAPHICS,
+      NULL);
+
+  uint32_t release_queues_mask = 0u;
+  for (ngfvk_sync_state& global_state : global_states) {
+    ngf_queue_type     release_queue;
+    ngfvk_barrier_data release;
+    ngfvk_barrier_data patch;
+    ngfvk_sync_reconcile(
+        &global_state,
+        &track,
+        NGF_QUEUE_TYPE_GRAPHICS,
+        &release_queue,
+        &release,
+        &patch);
+    ASSERT_NE(NGF_QUEUE_TYPE_COUNT, release_queue);
+    release_queues_mask |= 1u << release_queue;
+  }
+  ASSERT_EQ(
+      (1u << NGF_QUEUE_TYPE_COMPUTE) | (1u << NGF_QUEUE_TYPE_TRANSFER),
+      release_queues_mask);
+
+  uint64_t wait_values[NGF_QUEUE_TYPE_COUNT] = {0u};
+  for (uint32_t q = 0u; q < NGF_QUEUE_TYPE_COUNT; ++q) {
+    if ((release_queues_mask & (1u << q)) == 0u) { continue; }
+    ngfvk_submit_batch* release_batch = ngfvk_submit_batch_for_queue(
+        batches,
+        &nbatches,
+        timeline_values,
+        nhandles++,
+        (ngf_queue_type)q,
+        NULL);
+    wait_values[q] = release_batch->signal_value;
+  }
+  ngfvk_submit_batch_for_queue(
+      batches,
+      &nbatches,
+      timeline_values,
+      nhandles,
+      NGF_QUEUE_TYPE_GRAPHICS,
+      wait_values);
+  nhandles += 2u;  // Patch barriers and the cmd buffer itself.
+  ngfvk_submit_batch_for_queue(
+      batches,
+      &nbatches,
+      timeline_values,
+      nhandles++,
+      NGF_QUEUE_TYPE_GRAPHICS,
+      NULL);
+
+  ASSERT_EQ(4u, nbatches);
+  ASSERT_EQ(6u, nhandles);
+  ASSERT_LE(nbatches, ngfvk_submit_max_batches(ncmd_bufs));
+  ASSERT_LE(nhandles, ngfvk_submit_max_cmd_buf_handles(ncmd_bufs));
+  ASSERT_EQ(NGF_QUEUE_TYPE_COMPUTE, batches[1].queue);
+  ASSERT_EQ(NGF_QUEUE_TYPE_TRANSFER, batches[2].queue);
+  ASSERT_EQ(1u, batches[3].wait_values[NGF_QUEUE_TYPE_COMPUTE]);
+  ASSERT_EQ(1u, batches[3].wait_values[NGF_QUEUE_TYPE_TRANSFER]);
+}
+
+UTEST(vk_upload_ring, suballoc) {
+  size_t used   = 0u;
+  size_t offset = ~(size_t)0u;
+  ASSERT_TRUE(ngfvk_upload_suballoc(&used, 256u, 10u, 16u, &offset));
+  ASSERT_EQ(0u, offset);
+  ASSERT_EQ(10u, used);
+
+  // Subsequent regions are aligned.
+  ASSERT_TRUE(ngfvk_upload_suballoc(&used, 256u, 100u, 64u, &offset));
+  ASSERT_EQ(64u, offset);
+  ASSERT_EQ(164u, used);
+
+  // Requests that don't fit in the remaining space fail without consuming it.
+  ASSERT_FALSE(ngfvk_upload_suballoc(&used, 256u, 100u, 16u, &offset));
+  ASSERT_EQ(164u, used);
+  ASSERT_FALSE(ngfvk_upload_suballoc(&used, 256u, ~(size_t)0u, 16u, &offset));
+  ASSERT_TRUE(ngfvk_upload_suballoc(&used, 256u, 80u, 16u, &offset));
+  ASSERT_EQ(176u, offset);
+  ASSERT_EQ(256u, used);
+}
+
+UTEST(vk_dynamic_uniforms, assign_dynamic_offset_slots) {
+  ngfvk_desc_set_layout set_layout;
+  memset((void*)&set_layout, 0, sizeof(set_layout));
+  set_layout.binding_properties = ngfi::fixed_array<ngfvk_desc_binding> {5u};
+  memset(set_layout.binding_properties.data(), 0, 5u * sizeof(ngfvk_desc_binding));
+  const VkDescriptorType types[] = {
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+      VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER};
+  const uint32_t ndescs[] = {1u, 1u, 4u, 1u, 1u};
+  for (uint32_t b = 0u; b < 5u; ++b) {
+    set_layout.binding_properties[b].type              = types[b];
+    set_layout.binding_properties[b].ndescs_in_binding = ndescs[b];
+  }
+
+  // Only single uniform buffers are switched over, up to the given number of them.
+  ngfvk_assign_dynamic_offset_slots(&set_layout, 2u);
+  ASSERT_EQ(2u, set_layout.ndynamic_offsets);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, set_layout.binding_properties[0].type);
+  ASSERT_EQ(0u, set_layout.binding_properties[0].dynamic_offset_idx);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_layout.binding_properties[1].type);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, set_layout.binding_properties[2].type);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, set_layout.binding_properties[3].type);
+  ASSERT_EQ(1u, set_layout.binding_properties[3].dynamic_offset_idx);
+  ASSERT_EQ(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, set_layout.binding_properties[4].type);
+}
+
+UTEST(vk_dynamic_uniforms, write_keys_ignore_dynamic_offset) {
+  ngf_buffer_t buf {};
+  buf.alloc.obj_handle                   = 0x100;
+  const ngfvk_desc_binding binding_props = {
+      .type              = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+      .ndescs_in_binding = 1u};
+  ngf_resource_bind_op bind_op = {};
+  bind_op.type                 = NGF_DESCRIPTOR_UNIFORM_BUFFER;
+  bind_op.info.buffer.buffer   = &buf;
+  bind_op.info.buffer.offset   = 256u;
+  bind_op.info.buffer.range    = 64u;
+  ngfvk_desc_write_key key_a, key_b;
+  uint32_t             offset_a, offset_b;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &key_a, &offset_a);
+  bind_op.info.buffer.offset = 512u;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &key_b, &offset_b);
+  ASSERT_EQ(0, memcmp(&key_a, &key_b, sizeof(key_a)));
+  ASSERT_EQ(0u, key_a.offset);
+  ASSERT_EQ(64u, key_a.range);
+  ASSERT_EQ(256u, offset_a);
+  ASSERT_EQ(512u, offset_b);
+
+  // Whole-size ranges keep the offset in the descriptor.
+  bind_op.info.buffer.range = VK_WHOLE_SIZE;
+  ngfvk_desc_write_key_from_bind_op(&bind_op, &binding_props, &key_a, &offset_a);
+  ASSERT_EQ(512u, key_a.offset);
+  ASSERT_EQ(0u, offset_a);
+}
+
+UTEST(vk_timestamps, ticks_to_ns) {
+  ASSERT_EQ(1000u, ngfvk_timestamp_ticks_to_ns(1000u, 1.0f));
+  ASSERT_EQ(625u, ngfvk_timestamp_ticks_to_ns(1250u, 0.5f));
+  // Large tick counts must not overflow or lose precision in the conversion.
+  ASSERT_EQ(40000000000000ull, ngfvk_timestamp_ticks_to_ns(1000000000000ull, 40.0f));
+}
+
+UTEST(vk_multi_draw, batch_size) {
+  const ngf_draw_info draws[] = {
+      {0u, 3u, 0, 1u, 0u},
+      {3u, 6u, 3, 1u, 0u},
+      {9u, 3u, 9, 1u, 0u},
+      {12u, 3u, 0, 2u, 0u},
+      {15u, 3u, 0, 2u, 1u},
+      {18u, 3u, 0, 2u, 1u}};
+  // Draws sharing instance parameters are batched together.
+  ASSERT_EQ(3u, ngfvk_multi_draw_batch_size(&draws[0], 6u, 1024u));
+  ASSERT_EQ(1u, ngfvk_multi_draw_batch_size(&draws[3], 3u, 1024u));
+  ASSERT_EQ(2u, ngfvk_multi_draw_batch_size(&draws[4], 2u, 1024u));
+  // Batches never exceed the given limit, or the number of remaining draws.
+  ASSERT_EQ(2u, ngfvk_multi_draw_batch_size(&draws[0], 6u, 2u));
+  ASSERT_EQ(1u, ngfvk_multi_draw_batch_size(&draws[0], 6u, 1u));
+  ASSERT_EQ(1u, ngfvk_multi_draw_batch_size(&draws[2], 1u, 1024u));
+}
+
+UTEST(vk_queries, unpack_pipeline_statistics) {
+  const uint64_t values[ngfvk::global::npipeline_statistics] = {10u, 20u, 30u, 40u, 50u, 60u};
+  ngf_query_result result = {};
+  ngfvk_unpack_pipeline_statistics(values, &result);
+  ASSERT_EQ(0u, result.samples_passed);
+  ASSERT_EQ(10u, result.input_assembly_vertices);
+  ASSERT_EQ(20u, result.input_assembly_primitives);
+  ASSERT_EQ(30u, result.vertex_shader_invocations);
+  ASSERT_EQ(40u, result.clipping_primitives);
+  ASSERT_EQ(50u, result.fragment_shader_invocations);
+  ASSERT_EQ(60u, result.compute_shader_invocations);
+}
+
+UTEST(vk_queries, render_pass_ends_with_open_query) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_cmd_buffer buf       = cmd_buf.value().get();
+  buf->state               = ngfi::CMD_BUFFER_STATE_RECORDING;
+  buf->renderpass_active   = true;
+  buf->active_queries_mask = 1u << NGF_QUERY_TYPE_OCCLUSION;
+  buf->pass_queries_mask   = 1u << NGF_QUERY_TYPE_OCCLUSION;
+
+  // The pass stays active until the query is ended.
+  ngf_render_encoder enc   = {};
+  enc.pvt_data_donotuse.d0 = (uintptr_t)buf;
+  ASSERT_EQ(NGF_ERROR_INVALID_OPERATION, ngf_cmd_end_render_pass(enc));
+  ASSERT_TRUE(buf->renderpass_active);
+}
+
+UTEST(vk_queries, compute_pass_ends_with_open_query) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_cmd_buffer buf       = cmd_buf.value().get();
+  buf->state               = ngfi::CMD_BUFFER_STATE_RECORDING;
+  buf->compute_pass_active = true;
+  buf->active_queries_mask = 1u << NGF_QUERY_TYPE_PIPELINE_STATISTICS;
+  buf->pass_queries_mask   = 1u << NGF_QUERY_TYPE_PIPELINE_STATISTICS;
+
+  // The pass stays active until the query is ended.
+  ngf_compute_encoder enc  = {};
+  enc.pvt_data_donotuse.d0 = (uintptr_t)buf;
+  ASSERT_EQ(NGF_ERROR_INVALID_OPERATION, ngf_cmd_end_compute_pass(enc));
+  ASSERT_TRUE(buf->compute_pass_active);
+}
+
+UTEST(vk_bindless, slots_alloc) {
+  ngfvk_bindless_slots slots;
+  slots.capacity   = 3u;
+  slots.nallocated = 0u;
+  ASSERT_EQ(0u, ngfvk_bindless_slots_alloc(&slots));
+  ASSERT_EQ(1u, ngfvk_bindless_slots_alloc(&slots));
+  ASSERT_EQ(2u, ngfvk_bindless_slots_alloc(&slots));
+  ASSERT_EQ(~0u, ngfvk_bindless_slots_alloc(&slots));
+  // Released indices are handed out again.
+  slots.free_indices.push_back(1u);
+  ASSERT_EQ(1u, ngfvk_bindless_slots_alloc(&slots));
+  ASSERT_EQ(~0u, ngfvk_bindless_slots_alloc(&slots));
+}
+
+UTEST(vk_bindless, heap_binding_convention) {
+  SpvReflectDescriptorBinding d;
+  memset(&d, 0, sizeof(d));
+  d.binding         = 0u;
+  d.descriptor_type = SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+  d.count           = 0u;
+  ASSERT_TRUE(ngfvk_is_bindless_heap_binding(&d));
+  // Fixed-size arrays aren't part of the heap.
+  d.count = 16u;
+  ASSERT_FALSE(ngfvk_is_bindless_heap_binding(&d));
+  // Each binding holds one type of resource.
+  d.count   = 0u;
+  d.binding = 1u;
+  ASSERT_FALSE(ngfvk_is_bindless_heap_binding(&d));
+  d.descriptor_type = SPV_REFLECT_DESCRIPTOR_TYPE_SAMPLER;
+  ASSERT_TRUE(ngfvk_is_bindless_heap_binding(&d));
+  d.binding         = 2u;
+  d.descriptor_type = SPV_REFLECT_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+  ASSERT_TRUE(ngfvk_is_bindless_heap_binding(&d));
+  d.binding = 3u;
+  ASSERT_FALSE(ngfvk_is_bindless_heap_binding(&d));
+}
+
+UTEST(vk_bindless, layout_limits) {
+  const ngfvk_bindless_layout_limits saved_limits = _vk.bindless_layout_limits;
+  uint32_t saved_capacities[NGF_BINDLESS_RESOURCE_TYPE_COUNT];
+  memcpy(saved_capacities, _vk.bindless_heap_capacities, sizeof(saved_capacities));
+  _vk.bindless_layout_limits = {
+      .sampled_images  = 1000u,
+      .samplers        = 100u,
+      .storage_buffers = 1000u,
+      .resources       = 2010u};
+  _vk.bindless_heap_capacities[NGF_BINDLESS_RESOURCE_IMAGE]          = 990u;
+  _vk.bindless_heap_capacities[NGF_BINDLESS_RESOURCE_SAMPLER]        = 90u;
+  _vk.bindless_heap_capacities[NGF_BINDLESS_RESOURCE_STORAGE_BUFFER] = 990u;
+
+  ngfvk_desc_set_layout layouts[2]                   = {};
+  layouts[1].is_bindless                              = true;
+  layouts[0].counts[NGF_DESCRIPTOR_IMAGE_AND_SAMPLER] = 10u;
+  layouts[0].counts[NGF_DESCRIPTOR_STORAGE_BUFFER]    = 10u;
+  layouts[0].counts[NGF_DESCRIPTOR_UNIFORM_BUFFER]    = 10u;
+  ASSERT_TRUE(ngfvk_fits_bindless_layout_limits(layouts, 2u));
+
+  // Combined image/samplers count as both sampled images and samplers.
+  layouts[0].counts[NGF_DESCRIPTOR_IMAGE_AND_SAMPLER] = 11u;
+  ASSERT_FALSE(ngfvk_fits_bindless_layout_limits(layouts, 2u));
+  layouts[0].counts[NGF_DESCRIPTOR_IMAGE_AND_SAMPLER] = 10u;
+
+  // Uniform buffers only count towards the limit on all resources.
+  layouts[0].counts[NGF_DESCRIPTOR_UNIFORM_BUFFER] = 11u;
+  ASSERT_FALSE(ngfvk_fits_bindless_layout_limits(layouts, 2u));
+
+  // Layouts without the heap aren't subject to these limits.
+  ASSERT_TRUE(ngfvk_fits_bindless_layout_limits(layouts, 1u));
+
+  _vk.bindless_layout_limits = saved_limits;
+  memcpy(_vk.bindless_heap_capacities, saved_capacities, sizeof(saved_capacities));
+}
+
+UTEST(vk_push_descriptors, set_index) {
+  const bool saved     = _vk.push_descriptors;
+  _vk.push_descriptors = true;
+  ASSERT_EQ(~0u, ngfvk_push_desc_set_index(0u));
+  ASSERT_EQ(0u, ngfvk_push_desc_set_index(1u));
+  ASSERT_EQ(2u, ngfvk_push_desc_set_index(4u));
+  // Only the lowest flagged set gets pushed.
+  ASSERT_EQ(1u, ngfvk_push_desc_set_index(0x6u));
+  ASSERT_EQ(31u, ngfvk_push_desc_set_index(1u << 31u));
+  // Without device support, sets are never pushed.
+  _vk.push_descriptors = false;
+  ASSERT_EQ(~0u, ngfvk_push_desc_set_index(1u));
+  _vk.push_descriptors = saved;
+}
+
+UTEST(vk_push_descriptors, layout_key_hash) {
+  ngfvk_set_layout_key_binding key[2] = {
+      {.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, .ndescs = 1u, .image_flags = 0u},
+      {.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, .ndescs = 1u, .image_flags = 0u}};
+  // Push and regular layouts with identical bindings are distinct cache entries.
+  ASSERT_NE(
+      ngfvk_set_layout_key_hash(key, 2u, false, false),
+      ngfvk_set_layout_key_hash(key, 2u, true, false));
+  ASSERT_EQ(
+      ngfvk_set_layout_key_hash(key, 2u, true, false),
+      ngfvk_set_layout_key_hash(key, 2u, true, false));
+  // So are layouts that permit partially bound bindings.
+  ASSERT_NE(
+      ngfvk_set_layout_key_hash(key, 2u, false, false),
+      ngfvk_set_layout_key_hash(key, 2u, false, true));
+}
+
+UTEST(vk_subres_sync, ranges) {
+  const ngfvk_subres_range a = {0u, 2u, 0u, 1u};
+  ASSERT_TRUE(ngfvk_subres_ranges_overlap(a, {1u, 2u, 0u, 1u}));
+  ASSERT_FALSE(ngfvk_subres_ranges_overlap(a, {2u, 1u, 0u, 1u}));
+  ASSERT_FALSE(ngfvk_subres_ranges_overlap(a, {0u, 2u, 1u, 1u}));
+  const ngfvk_subres_range u = ngfvk_subres_range_union({0u, 1u, 0u, 1u}, {1u, 1u, 1u, 1u});
+  ASSERT_EQ(0u, u.base_level);
+  ASSERT_EQ(2u, u.nlevels);
+  ASSERT_EQ(0u, u.base_layer);
+  ASSERT_EQ(2u, u.nlayers);
+
+  // Ranges are clamped to the image's bounds.
+  ngf_image_t img {};
+  img.nlevels              = 4u;
+  img.nlayers              = 6u;
+  const ngfvk_sync_res res = ngfvk_sync_res_from_img_range(&img, {3u, 5u, 4u, 10u});
+  ASSERT_EQ(3u, res.range.base_level);
+  ASSERT_EQ(1u, res.range.nlevels);
+  ASSERT_EQ(4u, res.range.base_layer);
+  ASSERT_EQ(2u, res.range.nlayers);
+}
+
+UTEST(vk_subres_sync, barrier_builder) {
+  ngf_image_t img {};
+  img.nlevels = 3u;
+  img.nlayers = 2u;
+  ngfi::arena        arena {1024u};
+  ngfvk_barrier_data barrier;
+  memset(&barrier, 0, sizeof(barrier));
+  barrier.src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT;
+  barrier.dst_access_mask = VK_ACCESS_SHADER_READ_BIT;
+  barrier.src_layout      = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+  barrier.dst_layout      = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  // Identical barriers for all subresources end up as a single barrier.
+  ngfvk_pending_barrier_list   list {};
+  ngfvk_subres_barrier_builder builder;
+  ngfvk_subres_barrier_builder_init(&builder, &list, arena, &img);
+  for (uint32_t level = 0u; level < img.nlevels; ++level) {
+    for (uint32_t layer = 0u; layer < img.nlayers; ++layer) {
+      ngfvk_subres_barrier_builder_add(&builder, &barrier, level, layer);
+    }
+  }
+  ngfvk_subres_barrier_builder_flush(&builder);
+  ASSERT_EQ(1u, list.npending_img_bars);
+  const ngfvk_subres_range whole = (*list.barriers.begin()).res.range;
+  ASSERT_EQ(3u, whole.nlevels);
+  ASSERT_EQ(2u, whole.nlayers);
+
+  // Skipping a subresource splits the barrier.
+  ngfvk_pending_barrier_list split_list {};
+  ngfvk_subres_barrier_builder_init(&builder, &split_list, arena, &img);
+  for (uint32_t level = 0u; level < img.nlevels; ++level) {
+    for (uint32_t layer = 0u; layer < img.nlayers; ++layer) {
+      if (level != 1u || layer != 1u) {
+        ngfvk_subres_barrier_builder_add(&builder, &barrier, level, layer);
+      }
+    }
+  }
+  ngfvk_subres_barrier_builder_flush(&builder);
+  ASSERT_EQ(3u, split_list.npending_img_bars);
+  auto                     it     = split_list.barriers.begin();
+  const ngfvk_subres_range first  = (*it).res.range;
+  const ngfvk_subres_range second = (*++it).res.range;
+  ASSERT_EQ(1u, first.nlevels);
+  ASSERT_EQ(2u, first.nlayers);
+  ASSERT_EQ(1u, second.base_level);
+  ASSERT_EQ(1u, second.nlayers);
+}
+
+UTEST(vk_subres_sync, track_collapse) {
+  ngf_image_t img {};
+  img.nlevels = 2u;
+  img.nlayers = 1u;
+  ngfi::arena         arena {1024u};
+  ngfvk_sync_res_data res_data;
+  memset(&res_data, 0, sizeof(res_data));
+  res_data.res_type   = NGFVK_SYNC_RES_IMAGE;
+  res_data.res_handle = (uintptr_t)&img;
+  const ngfvk_sync_req read = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_SHADER_READ_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT},
+      .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+  const ngfvk_sync_req write = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
+      .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+  ngfvk_barrier_data barrier;
+
+  // First accesses are only recorded as expected, and don't need barriers within the cmd buffer.
+  ASSERT_TRUE(ngfvk_sync_res_data_expand(&res_data, arena));
+  ASSERT_FALSE(ngfvk_sync_track_process(&res_data.subres[1], &read, &barrier));
+  ngfvk_sync_res_data_collapse(&res_data);
+  ASSERT_TRUE(res_data.subres != NULL);
+  ASSERT_FALSE(ngfvk_sync_track_process(&res_data.subres[0], &read, &barrier));
+  ngfvk_sync_res_data_collapse(&res_data);
+  ASSERT_TRUE(res_data.subres == NULL);
+  ASSERT_TRUE(res_data.whole.accessed);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, res_data.whole.expected_sync_req.layout);
+
+  // Subsequent accesses do.
+  ngfvk_sync_res_data_expand(&res_data, arena);
+  ASSERT_TRUE(ngfvk_sync_track_process(&res_data.subres[0], &write, &barrier));
+  ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, barrier.src_layout);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, barrier.dst_layout);
+  ASSERT_EQ(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, res_data.subres[1].sync_state.layout);
+}
+
+UTEST(vk_subres_sync, expand_failure) {
+  ngf_image_t img {};
+  img.nlevels = 2u;
+  img.nlayers = 1u;
+  ngfi::arena         empty_arena;
+  ngfvk_sync_res_data res_data;
+  memset(&res_data, 0, sizeof(res_data));
+  res_data.res_type   = NGFVK_SYNC_RES_IMAGE;
+  res_data.res_handle = (uintptr_t)&img;
+
+  // The data is left as it was if per-subresource tracking can't be allocated.
+  ASSERT_FALSE(ngfvk_sync_res_data_expand(&res_data, empty_arena));
+  ASSERT_TRUE(res_data.subres == NULL);
+}
+
+UTEST(vk_subres_sync, batch_merges_overlapping_ranges) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_image_t img {};
+  img.nlevels                = 2u;
+  img.nlayers                = 2u;
+  img.hash                   = 0x1234u;
+  const ngfvk_sync_req write = {
+      .barrier_masks =
+          {.access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+           .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
+      .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+  const ngfvk_sync_res level0 = ngfvk_sync_res_from_img_range(&img, {0u, 1u, 0u, 2u});
+  const ngfvk_sync_res level1 = ngfvk_sync_res_from_img_range(&img, {1u, 1u, 0u, 2u});
+  const ngfvk_sync_res layer1 = ngfvk_sync_res_from_img_range(&img, {0u, 2u, 1u, 1u});
+
+  // Requests for disjoint subresources are kept apart.
+  ngfvk_sync_req_batch batch;
+  ngfvk_sync_req_batch_init(3u, &batch);
+  ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, cmd_buf.value().get(), &level0, &write));
+  ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, cmd_buf.value().get(), &level1, &write));
+  ASSERT_EQ(2u, batch.npending_sync_reqs);
+
+  ASSERT_EQ(0u, batch.owner_idx[0]);
+  ASSERT_EQ(1u, batch.owner_idx[1]);
+
+  // A request overlapping both of them joins them into one group, keeping all of the ranges.
+  ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, cmd_buf.value().get(), &layer1, &write));
+  ASSERT_EQ(3u, batch.npending_sync_reqs);
+  ASSERT_EQ(batch.owner_idx[0], batch.owner_idx[1]);
+  ASSERT_EQ(batch.owner_idx[0], batch.owner_idx[2]);
+  ASSERT_EQ(1u, batch.pending_ranges[2].nlayers);
+
+  // A request within one of the pending ranges doesn't add another one.
+  ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, cmd_buf.value().get(), &level0, &write));
+  ASSERT_EQ(3u, batch.npending_sync_reqs);
+  ngfi::tmp_arena().reset();
+}
+
+UTEST(vk_deferred_cmds, barriers_depend_on_run) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_cmd_buffer buf = cmd_buf.value().get();
+  ngf_buffer_t   in_run {};
+  ngf_buffer_t   outside_run {};
+  in_run.hash      = 0x1u;
+  outside_run.hash = 0x2u;
+  const ngfvk_sync_res in_run_res      = ngfvk_sync_res_from_buf(&in_run);
+  const ngfvk_sync_res outside_run_res = ngfvk_sync_res_from_buf(&outside_run);
+  ngfvk_sync_res_data* res_data        = NULL;
+  ngfvk_cmd_buf_lookup_sync_res(buf, &in_run_res, &res_data);
+  res_data->deferred_epoch = buf->deferred_epoch;
+  ngfvk_cmd_buf_lookup_sync_res(buf, &outside_run_res, &res_data);
+  res_data->deferred_epoch = buf->deferred_epoch - 1u;
+
+  // Barriers guarding resources that the run doesn't access can be hoisted in front of it.
+  ngfi::arena                arena {1024u};
+  ngfvk_pending_barrier_list barriers {};
+  ngfvk_barrier_data         barrier {};
+  barrier.res = outside_run_res;
+  barriers.barriers.append(barrier, arena);
+  ASSERT_FALSE(ngfvk_cmd_buf_barriers_depend_on_deferred(buf, &barriers));
+
+  // Barriers guarding resources accessed within the run can't.
+  barrier.res = in_run_res;
+  barriers.barriers.append(barrier, arena);
+  ASSERT_TRUE(ngfvk_cmd_buf_barriers_depend_on_deferred(buf, &barriers));
+
+  // Once the run is recorded, they can start a new one.
+  ++buf->deferred_epoch;
+  ASSERT_FALSE(ngfvk_cmd_buf_barriers_depend_on_deferred(buf, &barriers));
+}
+
+UTEST(vk_deferred_cmds, split_barriers) {
+  const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+  auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+  ASSERT_FALSE(cmd_buf.has_error());
+  ngf_cmd_buffer buf = cmd_buf.value().get();
+  ngf_buffer_t   in_run {};
+  ngf_buffer_t   outside_run {};
+  in_run.hash      = 0x1u;
+  outside_run.hash = 0x2u;
+  const ngfvk_sync_res in_run_res      = ngfvk_sync_res_from_buf(&in_run);
+  const ngfvk_sync_res outside_run_res = ngfvk_sync_res_from_buf(&outside_run);
+  ngfvk_sync_res_data* in_run_data     = NULL;
+  ngfvk_sync_res_data* res_data        = NULL;
+  ngfvk_cmd_buf_lookup_sync_res(buf, &in_run_res, &in_run_data);
+  in_run_data->deferred_epoch   = buf->deferred_epoch;
+  in_run_data->deferred_cmd_idx = 1u;
+  ngfvk_cmd_buf_lookup_sync_res(buf, &outside_run_res, &res_data);
+  res_data->deferred_epoch = buf->deferred_epoch - 1u;
+
+  ngfi::arena                arena {1024u};
+  ngfvk_pending_barrier_list barriers {};
+  ngfvk_pending_barrier_list split {};
+  ngfvk_barrier_data         barrier {};
+  barrier.res = outside_run_res;
+  barriers.barriers.append(barrier, arena);
+  barrier.res = in_run_res;
+  barriers.barriers.append(barrier, arena);
+  barriers.npending_buf_bars = 2u;
+
+  // Nothing follows the last access to the guarded resource within the run.
+  buf->nin_pass_cmds = 2u;
+  ASSERT_EQ(~0u, ngfvk_cmd_buf_split_barriers(buf, &barriers, &split, arena));
+  ASSERT_EQ(2u, barriers.npending_buf_bars);
+  ASSERT_EQ(0u, split.npending_buf_bars);
+
+  // It isn't known which commands access the guarded resource.
+  buf->nin_pass_cmds            = 3u;
+  in_run_data->deferred_cmd_idx = ~0u;
+  ASSERT_EQ(~0u, ngfvk_cmd_buf_split_barriers(buf, &barriers, &split, arena));
+  ASSERT_EQ(2u, barriers.npending_buf_bars);
+
+  // Only the barrier guarding the resource accessed within the run is split.
+  in_run_data->deferred_cmd_idx = 1u;
+  ASSERT_EQ(1u, ngfvk_cmd_buf_split_barriers(buf, &barriers, &split, arena));
+  ASSERT_EQ(1u, barriers.npending_buf_bars);
+  ASSERT_EQ(1u, split.npending_buf_bars);
+  ASSERT_EQ(&outside_run, (*barriers.barriers.begin()).res.data.buf);
+  ASSERT_EQ(&in_run, (*split.barriers.begin()).res.data.buf);
+}
+
+// Makes a context that only provides a frame arena current, for recording deferred commands without
+// a device. The context is never destroyed, since that would release device objects.
+static void make_frame_arena_context_current() {
+  alignas(ngf_context_t) static unsigned char storage[sizeof(ngf_context_t)];
+  static ngf_context_t*                       ctx = NULL;
+  if (ctx == NULL) {
+    ctx            = new (storage) ngf_context_t {};
+    ctx->frame_res = ngfi::fixed_array<ngfvk_frame_resources> {1u};
+    ctx->frame_res[0].res_frame_arena.set_block_size(1024);
+    ctx->frame_id = 0u;
+  }
+  CURRENT_CONTEXT = ctx;
+}
+
+// Makes a compute pipeline whose only set has the given number of read-only storage buffers.
+static void make_storage_buffer_pipeline(ngfvk_generic_pipeline* pipeline, uint32_t nbindings) {
+  ngfvk_desc_set_layout* set_layout = pipeline->descriptor_set_layouts.emplace_back();
+  set_layout->binding_properties    = ngfi::fixed_array<ngfvk_desc_binding> {nbindings};
+  memset(set_layout->binding_properties.data(), 0, nbindings * sizeof(ngfvk_desc_binding));
+  for (ngfvk_desc_binding& binding : set_layout->binding_properties) {
+    binding.type              = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    binding.stage_accessors   = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    binding.readonly          = true;
+    binding.ndescs_in_binding = 1u;
+  }
+}
+
+static ngf_resource_bind_op storage_buffer_bind_op(uint32_t binding, ngf_buffer buf) {
+  ngf_resource_bind_op bind_op = {};
+  bind_op.target_binding       = binding;
+  bind_op.type                 = NGF_DESCRIPTOR_STORAGE_BUFFER;
+  bind_op.info.buffer.buffer   = buf;
+  bind_op.info.buffer.range    = 256u;
+  return bind_op;
+}
+
+UTEST(vk_deferred_cmds, bound_compute_res_stay_in_run) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer         buf = cmd_buf.value().get();
+    ngfvk_generic_pipeline pipeline {};
+    make_storage_buffer_pipeline(&pipeline, 2u);
+    ngf_buffer_t x {};
+    ngf_buffer_t y {};
+    x.hash = 0x1u;
+    y.hash = 0x2u;
+
+    // X is bound once, and read by both dispatches, the second of which starts a new run.
+    buf->state = ngfi::CMD_BUFFER_STATE_READY;
+    const ngf_compute_pass_info pass_info = {};
+    ngf_compute_encoder         enc;
+    ASSERT_EQ(NGF_ERROR_OK, ngf_cmd_begin_compute_pass(buf, &pass_info, &enc));
+    ngf_cmd_bind_compute_pipeline(enc, (ngf_compute_pipeline)&pipeline);
+    const ngf_resource_bind_op bind_x = storage_buffer_bind_op(0u, &x);
+    ngf_cmd_bind_compute_resources(enc, &bind_x, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+    ngfvk_cmd_buf_reset_render_cmds(buf);
+    ++buf->deferred_epoch;
+    const ngf_resource_bind_op bind_y = storage_buffer_bind_op(1u, &y);
+    ngf_cmd_bind_compute_resources(enc, &bind_y, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+
+    // Barriers guarding X can't be hoisted in front of the second run, nor split.
+    ngfi::arena                arena {1024u};
+    ngfvk_pending_barrier_list barriers {};
+    ngfvk_pending_barrier_list split {};
+    ngfvk_barrier_data         barrier {};
+    barrier.res = ngfvk_sync_res_from_buf(&x);
+    barriers.barriers.append(barrier, arena);
+    barriers.npending_buf_bars = 1u;
+    ASSERT_TRUE(ngfvk_cmd_buf_barriers_depend_on_deferred(buf, &barriers));
+    ASSERT_EQ(~0u, ngfvk_cmd_buf_split_barriers(buf, &barriers, &split, arena));
+
+    // Once X is replaced by Y, it isn't accessed by the run that follows.
+    ngfvk_cmd_buf_reset_render_cmds(buf);
+    ++buf->deferred_epoch;
+    const ngf_resource_bind_op bind_y_over_x = storage_buffer_bind_op(0u, &y);
+    ngf_cmd_bind_compute_resources(enc, &bind_y_over_x, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+    ASSERT_FALSE(ngfvk_cmd_buf_barriers_depend_on_deferred(buf, &barriers));
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
+UTEST(vk_deferred_cmds, split_after_last_dispatch_with_bound_res) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer         buf = cmd_buf.value().get();
+    ngfvk_generic_pipeline pipeline {};
+    make_storage_buffer_pipeline(&pipeline, 2u);
+    ngf_buffer_t x {};
+    ngf_buffer_t y {};
+    ngf_buffer_t z {};
+    x.hash = 0x1u;
+    y.hash = 0x2u;
+    z.hash = 0x3u;
+
+    // X stays bound for the first two dispatches, and gets replaced before the third one.
+    buf->state = ngfi::CMD_BUFFER_STATE_READY;
+    const ngf_compute_pass_info pass_info = {};
+    ngf_compute_encoder         enc;
+    ASSERT_EQ(NGF_ERROR_OK, ngf_cmd_begin_compute_pass(buf, &pass_info, &enc));
+    ngf_cmd_bind_compute_pipeline(enc, (ngf_compute_pipeline)&pipeline);
+    const ngf_resource_bind_op bind_x = storage_buffer_bind_op(0u, &x);
+    ngf_cmd_bind_compute_resources(enc, &bind_x, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+    const ngf_resource_bind_op bind_y = storage_buffer_bind_op(1u, &y);
+    ngf_cmd_bind_compute_resources(enc, &bind_y, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+    const uint32_t             last_x_access_idx = buf->nin_pass_cmds - 1u;
+    const ngf_resource_bind_op bind_z_over_x     = storage_buffer_bind_op(0u, &z);
+    ngf_cmd_bind_compute_resources(enc, &bind_z_over_x, 1u);
+    ngf_cmd_dispatch(enc, 1u, 1u, 1u);
+
+    // Barriers guarding X are split after the last dispatch that could access it, not after the
+    // one that bound it.
+    ngfi::arena                arena {1024u};
+    ngfvk_pending_barrier_list barriers {};
+    ngfvk_pending_barrier_list split {};
+    ngfvk_barrier_data         barrier {};
+    barrier.res = ngfvk_sync_res_from_buf(&x);
+    barriers.barriers.append(barrier, arena);
+    barriers.npending_buf_bars = 1u;
+    ASSERT_EQ(4u, last_x_access_idx);
+    ASSERT_EQ(last_x_access_idx, ngfvk_cmd_buf_split_barriers(buf, &barriers, &split, arena));
+    ASSERT_EQ(1u, split.npending_buf_bars);
+
+    // Nothing follows the last dispatch that could access Y.
+    ngfvk_pending_barrier_list y_barriers {};
+    barrier.res = ngfvk_sync_res_from_buf(&y);
+    y_barriers.barriers.append(barrier, arena);
+    y_barriers.npending_buf_bars = 1u;
+    ASSERT_EQ(~0u, ngfvk_cmd_buf_split_barriers(buf, &y_barriers, &split, arena));
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
+UTEST(vk_queries, no_timestamps_in_secondaries) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_SECONDARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer buf     = cmd_buf.value().get();
+    buf->state             = ngfi::CMD_BUFFER_STATE_RECORDING;
+    buf->renderpass_active = true;
+
+    ngf_timestamp_query query = 0u;
+    ASSERT_EQ(NGF_ERROR_INVALID_OPERATION, ngf_cmd_write_timestamp(buf, &query));
+    ASSERT_EQ(0u, buf->nin_pass_cmds);
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
+UTEST(vk_queries, no_queries_in_secondaries) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_SECONDARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer buf     = cmd_buf.value().get();
+    buf->state             = ngfi::CMD_BUFFER_STATE_RECORDING;
+    buf->renderpass_active = true;
+
+    ngf_render_encoder enc   = {};
+    enc.pvt_data_donotuse.d0 = (uintptr_t)buf;
+    ngf_query query          = {};
+    ASSERT_EQ(
+        NGF_ERROR_INVALID_OPERATION,
+        ngf_cmd_begin_query(enc, NGF_QUERY_TYPE_OCCLUSION, &query));
+    ASSERT_EQ(0u, buf->active_queries_mask);
+    ASSERT_EQ(0u, buf->nin_pass_cmds);
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
+UTEST(vk_queries, submit_with_open_query) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer buf       = cmd_buf.value().get();
+    buf->state               = ngfi::CMD_BUFFER_STATE_RECORDING;
+    buf->parent_frame        = CURRENT_CONTEXT->current_frame_token;
+    buf->active_queries_mask = 1u << NGF_QUERY_TYPE_OCCLUSION;
+
+    // The command buffer can still be recorded into to end the query.
+    ASSERT_EQ(NGF_ERROR_INVALID_OPERATION, ngf_submit_cmd_buffers(1u, &buf));
+    ASSERT_EQ(ngfi::CMD_BUFFER_STATE_RECORDING, buf->state);
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
+UTEST(vk_subres_sync, batch_skips_uncovered_subresources) {
+  make_frame_arena_context_current();
+  {
+    const ngf_cmd_buffer_info info    = {.level = NGF_CMD_BUFFER_LEVEL_PRIMARY};
+    auto                      cmd_buf = ngf_cmd_buffer_t::make(info);
+    ASSERT_FALSE(cmd_buf.has_error());
+    ngf_cmd_buffer buf = cmd_buf.value().get();
+    ngf_image_t    img {};
+    img.nlevels                = 2u;
+    img.nlayers                = 2u;
+    img.hash                   = 0x1234u;
+    const ngfvk_sync_req write = {
+        .barrier_masks =
+            {.access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+             .stage_mask  = VK_PIPELINE_STAGE_TRANSFER_BIT},
+        .layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+    const ngfvk_sync_res level0 = ngfvk_sync_res_from_img_range(&img, {0u, 1u, 0u, 2u});
+    const ngfvk_sync_res layer1 = ngfvk_sync_res_from_img_range(&img, {0u, 2u, 1u, 1u});
+
+    // The overlapping ranges span the whole image, but leave layer 0 of level 1 untouched.
+    ngfvk_sync_req_batch batch;
+    ngfvk_sync_req_batch_init(2u, &batch);
+    ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, buf, &level0, &write));
+    ASSERT_TRUE(ngfvk_sync_req_batch_add_with_lookup(&batch, buf, &layer1, &write));
+    ngfvk_sync_req_batch_process(&batch, buf);
+
+    ngfvk_sync_res_data* res_data = NULL;
+    ngfvk_cmd_buf_lookup_sync_res(buf, &level0, &res_data);
+    ASSERT_EQ(~0u, res_data->pending_sync_req_idx);
+    ASSERT_TRUE(res_data->subres != NULL);
+    ASSERT_TRUE(res_data->subres[0].accessed);
+    ASSERT_TRUE(res_data->subres[1].accessed);
+    ASSERT_FALSE(res_data->subres[2].accessed);
+    ASSERT_TRUE(res_data->subres[3].accessed);
+    ASSERT_EQ(VK_IMAGE_LAYOUT_UNDEFINED, res_data->subres[2].sync_state.layout);
+    ngfi::tmp_arena().reset();
+  }
+  CURRENT_CONTEXT = NULL;
+}
+
 UTEST_MAIN()